@@ -0,0 +1,96 @@
+#include "AlbumTable.h"
+#include "HashUtils.h"
+#include "MemoryReport.h"
+
+#include <algorithm>
+
+size_t AlbumTable::KeyHash::operator()(const Key &key) const {
+  const BStringHash hash;
+  return (hash(key.name) * 31 + hash(key.artist)) * 31 + (size_t)key.year;
+}
+
+uint32 AlbumTable::Add(const MediaItem &item) {
+  if (item.album.IsEmpty())
+    return kNoAlbum;
+
+  auto inserted = fIds.emplace(Key{item.album, item.albumArtist, item.year},
+                               (uint32)fAlbums.size() + 1);
+  if (inserted.second) {
+    Album album;
+    album.id = inserted.first->second;
+    album.name = item.album;
+    album.artist = item.albumArtist;
+    album.year = item.year;
+    fAlbums.push_back(album);
+  }
+
+  Album &album = fAlbums[inserted.first->second - 1];
+  if (album.trackCount++ == 0)
+    fCount++;
+  album.duration += item.duration;
+  album.discCount = std::max({album.discCount, item.disc, item.discTotal});
+  if (album.coverPath.IsEmpty())
+    album.coverPath = item.path;
+  return album.id;
+}
+
+void AlbumTable::Remove(const MediaItem &item) {
+  Album *album = _Find(item.albumId);
+  if (!album || album->trackCount == 0)
+    return;
+
+  album->duration -= item.duration;
+  if (--album->trackCount == 0) {
+    fCount--;
+    album->duration = 0;
+    album->discCount = 0;
+  }
+  // The next track added stands in for the cover.
+  if (album->coverPath == item.path)
+    album->coverPath = "";
+}
+
+void AlbumTable::Move(const MediaItem &item, const BString &to) {
+  Album *album = _Find(item.albumId);
+  if (album && album->coverPath == item.path)
+    album->coverPath = to;
+}
+
+void AlbumTable::Clear() {
+  fAlbums.clear();
+  fIds.clear();
+  fCount = 0;
+}
+
+const Album *AlbumTable::Find(uint32 id) const {
+  if (id == kNoAlbum || id > fAlbums.size())
+    return nullptr;
+  const Album &album = fAlbums[id - 1];
+  return album.trackCount > 0 ? &album : nullptr;
+}
+
+uint32 AlbumTable::IdOf(const BString &name, const BString &artist,
+                        int32 year) const {
+  auto it = fIds.find(Key{name, artist, year});
+  if (it == fIds.end() || !Find(it->second))
+    return kNoAlbum;
+  return it->second;
+}
+
+void AlbumTable::AccountMemory(MemoryReport &report) const {
+  size_t bytes = fAlbums.capacity() * sizeof(Album) +
+                 fIds.bucket_count() * MemoryReport::kHashBucket;
+  // Names share their buffers with the tracks; the keys with the albums.
+  for (const Album &album : fAlbums)
+    bytes += report.String(album.name) + report.String(album.artist) +
+             report.String(album.coverPath);
+  bytes += fIds.size() * (MemoryReport::kHashNode + MemoryReport::kAllocation +
+                          sizeof(std::pair<const Key, uint32>));
+  report.Add(MEMORY_LIBRARY, "Album table", fCount, bytes);
+}
+
+Album *AlbumTable::_Find(uint32 id) {
+  if (id == kNoAlbum || id > fAlbums.size())
+    return nullptr;
+  return &fAlbums[id - 1];
+}
@@ -0,0 +1,126 @@
+#ifndef ALBUM_TABLE_H
+#define ALBUM_TABLE_H
+
+#include "MediaItem.h"
+
+#include <String.h>
+#include <SupportDefs.h>
+
+#include <unordered_map>
+#include <vector>
+
+class MemoryReport;
+
+/**
+ * @struct Album
+ * @brief One album of the library and what its tracks add up to.
+ */
+struct Album {
+  uint32 id = 0;
+  BString name;
+  BString artist; ///< Album artist; empty if the tracks have none.
+  int32 year = 0;
+  int32 discCount = 0;  ///< Highest disc number or disc total seen.
+  int32 trackCount = 0; ///< 0 once all tracks are gone.
+  int64 duration = 0;   ///< Seconds.
+  /** Track whose embedded cover stands for the album; empty if that track
+   * left and no other was added since. */
+  BString coverPath;
+};
+
+/**
+ * @struct AlbumRef
+ * @brief Names one album in a filter result: sorted by name and year, told
+ * apart by ID.
+ */
+struct AlbumRef {
+  BString name;
+  int32 year = 0;
+  uint32 id = 0; ///< 0 for tracks that are not filed in an AlbumTable.
+
+  bool operator==(const AlbumRef &other) const {
+    return id == other.id && year == other.year && name == other.name;
+  }
+  bool operator<(const AlbumRef &other) const {
+    if (name != other.name)
+      return name < other.name;
+    if (year != other.year)
+      return year < other.year;
+    return id < other.id;
+  }
+};
+
+/**
+ * @class AlbumTable
+ * @brief The albums of a library, keyed by name, album artist and year.
+ *
+ * Tracks are filed as they enter the library and refer to their album by
+ * MediaItem::albumId, so comparing albums is comparing IDs. Grouping by the
+ * album artist keeps compilations together even though their track artists
+ * differ, and keeps apart equally named albums of different artists.
+ * Tracks without an album name are not filed; their ID is kNoAlbum.
+ *
+ * IDs are never reused: an album whose last track was removed keeps its ID
+ * and gets it back if a track with the same key is added again.
+ */
+class AlbumTable {
+public:
+  static const uint32 kNoAlbum = 0;
+
+  /**
+   * @brief Files a track under its album, creating the album if needed.
+   * @return The album ID for the track, or kNoAlbum.
+   */
+  uint32 Add(const MediaItem &item);
+
+  /** @brief Takes a track out of the album it was filed under. */
+  void Remove(const MediaItem &item);
+
+  /** @brief Follows a track to its new path. */
+  void Move(const MediaItem &item, const BString &to);
+
+  void Clear();
+
+  /** @return The album, or nullptr if @p id is unknown or has no tracks. */
+  const Album *Find(uint32 id) const;
+
+  /** @return The ID of the album, or kNoAlbum. */
+  uint32 IdOf(const BString &name, const BString &artist, int32 year) const;
+
+  /** @return Number of albums with tracks. */
+  size_t Count() const { return fCount; }
+
+  /** @brief Calls @p function with every album that has tracks. */
+  template <typename Function> void ForEach(Function function) const {
+    for (const Album &album : fAlbums) {
+      if (album.trackCount > 0)
+        function(album);
+    }
+  }
+
+  void AccountMemory(MemoryReport &report) const;
+
+private:
+  struct Key {
+    BString name;
+    BString artist;
+    int32 year;
+
+    bool operator==(const Key &other) const {
+      return year == other.year && name == other.name &&
+             artist == other.artist;
+    }
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key &key) const;
+  };
+
+  Album *_Find(uint32 id);
+
+  std::vector<Album> fAlbums; ///< By ID - 1.
+  std::unordered_map<Key, uint32, KeyHash> fIds;
+  size_t fCount = 0;
+};
+
+#endif // ALBUM_TABLE_H
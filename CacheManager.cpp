@@ -1,14 +1,21 @@
 #include "CacheManager.h"
 #include "Debug.h"
+#include "DuplicateFinder.h"
 #include "MediaScanner.h"
+#include "MemoryReport.h"
+#include "MessageStats.h"
 #include "Messages.h"
+#include "Trace.h"
+#include <Autolock.h>
 #include <Directory.h>
 #include <Entry.h>
 #include <File.h>
 #include <FindDirectory.h>
+#include <MessageQueue.h>
 #include <Path.h>
 #include <algorithm>
 #include <fstream>
+#include <memory>
 #include <set>
 #include <string>
 #include <unistd.h>
@@ -75,7 +82,9 @@ void CacheManager::LoadDirectories(std::vector<BString> &outDirs) {
  * 3. Mark existing known files as missing if they are gone from disk (quick
  * check).
  *
- * Note: Real sync happens via Scanners reporting back.
+ * Note: Real sync happens via Scanners reporting back. Missing files are
+ * only reported to the UI once all scanners are done, since a scanner may
+ * still find them moved.
  */
 void CacheManager::StartScan() {
   std::vector<BString> dirs;
@@ -137,17 +146,13 @@ void CacheManager::StartScan() {
     if (!e.Exists() && !entry.missing) {
       entry.missing = true;
       DEBUG_PRINT("[CacheManager] Mark missing: %s\n", path.String());
-
-      if (fTarget.IsValid()) {
-        BMessage gone(MSG_MEDIA_ITEM_REMOVED);
-        gone.AddString("path", path);
-        fTarget.SendMessage(&gone);
-      }
+      fPendingRemovals.push_back(path);
     }
   }
 
   // If no scanners were started (e.g. no dirs), finish immediately
   if (fActiveScanners == 0) {
+    PostPendingRemovals();
     SaveCache();
     if (fTarget.IsValid()) {
       BMessage done(MSG_SCAN_DONE);
@@ -156,35 +161,68 @@ void CacheManager::StartScan() {
   }
 }
 
+void CacheManager::ArchiveEntry(const MediaItem &entry, BMessage &out) {
+  out.AddString("path", entry.path);
+  out.AddString("base", entry.base);
+  out.AddString("title", entry.title);
+  out.AddString("artist", entry.artist);
+  out.AddString("album", entry.album);
+  out.AddString("albumArtist", entry.albumArtist);
+  out.AddString("genre", entry.genre);
+  out.AddInt32("year", entry.year);
+  out.AddInt32("track", entry.track);
+  out.AddInt32("disc", entry.disc);
+  out.AddInt32("discTotal", entry.discTotal);
+  out.AddInt32("duration", entry.duration);
+  out.AddInt32("bitrate", entry.bitrate);
+  out.AddInt64("size", entry.size);
+  out.AddInt64("mtime", entry.mtime);
+  out.AddInt64("inode", entry.inode);
+  out.AddInt64("device", entry.device);
+  out.AddInt64("partialHash", entry.partialHash);
+  out.AddBool("missing", entry.missing);
+
+  out.AddString("mbAlbumId", entry.mbAlbumId);
+  out.AddString("mbArtistId", entry.mbArtistId);
+  out.AddString("mbTrackId", entry.mbTrackId);
+}
+
+void CacheManager::UnarchiveEntry(const BMessage &in, MediaItem &out) {
+  out.path = in.GetString("path", "");
+  out.base = in.GetString("base", "");
+  out.title = in.GetString("title", "");
+  out.artist = in.GetString("artist", "");
+  out.album = in.GetString("album", "");
+  out.albumArtist = in.GetString("albumArtist", "");
+  out.genre = in.GetString("genre", "");
+  out.year = in.GetInt32("year", 0);
+  out.track = in.GetInt32("track", 0);
+  out.disc = in.GetInt32("disc", 0);
+  out.discTotal = in.GetInt32("discTotal", 0);
+  out.duration = in.GetInt32("duration", 0);
+  out.bitrate = in.GetInt32("bitrate", 0);
+  out.size = in.GetInt64("size", 0);
+  out.mtime = in.GetInt64("mtime", 0);
+  out.inode = in.GetInt64("inode", 0);
+  out.device = in.GetInt64("device", 0);
+  out.partialHash = in.GetInt64("partialHash", 0);
+  out.missing = in.GetBool("missing", false);
+
+  out.mbAlbumId = in.GetString("mbAlbumId", "");
+  out.mbArtistId = in.GetString("mbArtistId", "");
+  out.mbTrackId = in.GetString("mbTrackId", "");
+}
+
 /**
  * @brief Saves the current in-memory cache to disk.
  * The cache is flattened into a BMessage and saved to 'media.cache'.
  */
 void CacheManager::SaveCache() {
+  TRACE_SPAN("cache", "SaveCache");
   BMessage archive;
   for (auto &[key, entry] : fEntries) {
     BMessage item;
-    item.AddString("path", entry.path);
-    item.AddString("base", entry.base);
-    item.AddString("title", entry.title);
-    item.AddString("artist", entry.artist);
-    item.AddString("album", entry.album);
-    item.AddString("genre", entry.genre);
-    item.AddInt32("year", entry.year);
-    item.AddInt32("track", entry.track);
-    item.AddInt32("disc", entry.disc);
-    item.AddInt32("duration", entry.duration);
-    item.AddInt32("bitrate", entry.bitrate);
-    item.AddInt64("size", entry.size);
-    item.AddInt64("mtime", entry.mtime);
-    item.AddInt64("inode", entry.inode);
-    item.AddBool("missing", entry.missing);
-
-    item.AddBool("missing", entry.missing);
-
-    item.AddString("mbAlbumId", entry.mbAlbumId);
-    item.AddString("mbArtistId", entry.mbArtistId);
-    item.AddString("mbTrackId", entry.mbTrackId);
+    ArchiveEntry(entry, item);
     archive.AddMessage("entry", &item);
   }
 
@@ -202,6 +240,7 @@ void CacheManager::SaveCache() {
  * @brief Loads the cache from disk into memory.
  */
 void CacheManager::LoadCache() {
+  TRACE_SPAN("cache", "LoadCache");
   fEntries.clear();
 
   BFile file(fCachePath, B_READ_ONLY);
@@ -222,37 +261,34 @@ void CacheManager::LoadCache() {
     if (archive.FindMessage("entry", i, &item) != B_OK)
       break;
 
-    entry.path = item.GetString("path", "");
-    entry.base = item.GetString("base", "");
-    entry.title = item.GetString("title", "");
-    entry.artist = item.GetString("artist", "");
-    entry.album = item.GetString("album", "");
-    entry.genre = item.GetString("genre", "");
-    entry.year = item.GetInt32("year", 0);
-    entry.track = item.GetInt32("track", 0);
-    entry.disc = item.GetInt32("disc", 0);
-    entry.duration = item.GetInt32("duration", 0);
-    entry.bitrate = item.GetInt32("bitrate", 0);
-    entry.size = item.GetInt64("size", 0);
-    entry.mtime = item.GetInt64("mtime", 0);
-    entry.inode = item.GetInt64("inode", 0);
-    entry.missing = item.GetBool("missing", false);
-
-    entry.mbAlbumId = item.GetString("mbAlbumId", "");
-    entry.mbArtistId = item.GetString("mbArtistId", "");
-    entry.mbTrackId = item.GetString("mbTrackId", "");
-
+    UnarchiveEntry(item, entry);
     fEntries[entry.path] = entry;
   }
 
   DEBUG_PRINT("[CacheManager] LoadCache: Loaded %zu items\n", fEntries.size());
 
   if (fTarget.IsValid()) {
+    // Copy the items on this thread so the window only has to take them.
+    {
+      BAutolock lock(fLoadedEntriesLock);
+      fLoadedEntries = AllEntries();
+      fHasLoadedEntries = true;
+    }
     BMessage msg(MSG_CACHE_LOADED);
     fTarget.SendMessage(&msg);
   }
 }
 
+bool CacheManager::TakeLoadedEntries(std::vector<MediaItem> &out) {
+  BAutolock lock(fLoadedEntriesLock);
+  if (!fHasLoadedEntries)
+    return false;
+  out = std::move(fLoadedEntries);
+  fLoadedEntries = std::vector<MediaItem>();
+  fHasLoadedEntries = false;
+  return true;
+}
+
 /**
  * @brief Returns a copy of all current media items.
  * @return std::vector<MediaItem>
@@ -267,6 +303,36 @@ std::vector<MediaItem> CacheManager::AllEntries() const {
   return out;
 }
 
+void CacheManager::AccountMemory(MemoryReport &report) {
+  report.Add(MEMORY_LIBRARY, "CacheManager entries", fEntries.size(),
+             report.Items(fEntries));
+  {
+    BAutolock lock(fLoadedEntriesLock);
+    if (fHasLoadedEntries) {
+      report.Add(MEMORY_LIBRARY, "CacheManager entries for the window",
+                 fLoadedEntries.size(), report.Items(fLoadedEntries));
+    }
+  }
+
+  int32 count = 0;
+  const size_t bytes = MessageStats::QueuedBytes(MessageQueue(), &count);
+  report.Add(MEMORY_QUEUES, "CacheManager queue", count, bytes);
+}
+
+/**
+ * @brief Times every message handled by the looper.
+ */
+void CacheManager::DispatchMessage(BMessage *msg, BHandler *handler) {
+  const uint32 what = msg->what;
+  const bigtime_t start = system_time();
+  const bigtime_t wait = MessageStats::WaitTime(msg, start);
+
+  BLooper::DispatchMessage(msg, handler);
+
+  fMessageStats.Record(what, wait, system_time() - start,
+                       MessageQueue()->CountMessages());
+}
+
 /**
  * @brief Main message loop for the CacheManager looper.
  * Handles loading, batch updates, and scanning notifications.
@@ -279,6 +345,7 @@ void CacheManager::MessageReceived(BMessage *msg) {
     break;
 
   case MSG_MEDIA_BATCH: {
+    TRACE_SPAN("cache", "MediaBatch");
     type_code type;
     int32 count = 0;
     if (msg->GetInfo("path", &type, &count) != B_OK)
@@ -287,6 +354,7 @@ void CacheManager::MessageReceived(BMessage *msg) {
     const char *baseStr = nullptr;
     msg->FindString("base", &baseStr);
 
+    int32 moves = 0;
     for (int32 i = 0; i < count; i++) {
       MediaItem e;
       if (baseStr)
@@ -301,17 +369,22 @@ void CacheManager::MessageReceived(BMessage *msg) {
         e.artist = tmp;
       if (msg->FindString("album", i, &tmp) == B_OK)
         e.album = tmp;
+      if (msg->FindString("albumArtist", i, &tmp) == B_OK)
+        e.albumArtist = tmp;
       if (msg->FindString("genre", i, &tmp) == B_OK)
         e.genre = tmp;
 
       msg->FindInt32("year", i, &e.year);
       msg->FindInt32("track", i, &e.track);
       msg->FindInt32("disc", i, &e.disc);
+      msg->FindInt32("discTotal", i, &e.discTotal);
       msg->FindInt32("duration", i, &e.duration);
       msg->FindInt32("bitrate", i, &e.bitrate);
       msg->FindInt64("size", i, &e.size);
       msg->FindInt64("mtime", i, &e.mtime);
       msg->FindInt64("inode", i, &e.inode);
+      msg->FindInt64("device", i, &e.device);
+      msg->FindInt64("partial_hash", i, &e.partialHash);
 
       if (msg->FindString("mbAlbumId", i, &tmp) == B_OK)
         e.mbAlbumId = tmp;
@@ -320,13 +393,23 @@ void CacheManager::MessageReceived(BMessage *msg) {
       if (msg->FindString("mbTrackId", i, &tmp) == B_OK)
         e.mbTrackId = tmp;
 
+      // The scanner matched this file to a vanished one; drop the old key.
+      if (msg->FindString("moved_from", i, &tmp) == B_OK && tmp[0] != '\0' &&
+          fEntries.erase(tmp) > 0) {
+        moves++;
+      }
+
       AddOrUpdateEntry(e);
     }
 
-    DEBUG_PRINT("[CacheManager] Processed batch of %d items\n", (int)count);
+    DEBUG_PRINT("[CacheManager] Processed batch of %d items (%ld moved)\n",
+                (int)count, (long)moves);
+    TRACE_COUNTER("cache", "entries", fEntries.size());
 
-    if (fTarget.IsValid())
+    if (fTarget.IsValid()) {
+      MessageStats::Stamp(msg);
       fTarget.SendMessage(msg);
+    }
     break;
   }
 
@@ -344,12 +427,15 @@ void CacheManager::MessageReceived(BMessage *msg) {
       e.artist = tmpStr;
     if (msg->FindString("album", &tmpStr) == B_OK)
       e.album = tmpStr;
+    if (msg->FindString("albumArtist", &tmpStr) == B_OK)
+      e.albumArtist = tmpStr;
     if (msg->FindString("genre", &tmpStr) == B_OK)
       e.genre = tmpStr;
 
     msg->FindInt32("year", &e.year);
     msg->FindInt32("track", &e.track);
     msg->FindInt32("disc", &e.disc);
+    msg->FindInt32("discTotal", &e.discTotal);
     msg->FindInt32("duration", &e.duration);
     msg->FindInt32("bitrate", &e.bitrate);
     msg->FindInt64("size", &e.size);
@@ -395,6 +481,7 @@ void CacheManager::MessageReceived(BMessage *msg) {
     if (--fActiveScanners <= 0) {
       DEBUG_PRINT(
           "[CacheManager] all scanners finished, writing media.cache\\n");
+      PostPendingRemovals();
       SaveCache();
 
       if (fTarget.IsValid()) {
@@ -406,11 +493,41 @@ void CacheManager::MessageReceived(BMessage *msg) {
     break;
   }
 
+  case MSG_FIND_DUPLICATES:
+    FindDuplicates();
+    break;
+
+  case MSG_DUPLICATES_FOUND:
+    fFindingDuplicates = false;
+    if (fTarget.IsValid())
+      fTarget.SendMessage(msg);
+    break;
+
   default:
     BLooper::MessageReceived(msg);
   }
 }
 
+/**
+ * @brief Tells the UI about the files found missing at the start of the scan.
+ *
+ * Files the scanners found under a new path were dropped from the cache
+ * and arrived with the batch as moves, so they are not reported.
+ */
+void CacheManager::PostPendingRemovals() {
+  for (const auto &path : fPendingRemovals) {
+    auto it = fEntries.find(path);
+    if (it == fEntries.end() || !it->second.missing)
+      continue;
+    if (fTarget.IsValid()) {
+      BMessage gone(MSG_MEDIA_ITEM_REMOVED);
+      gone.AddString("path", path);
+      fTarget.SendMessage(&gone);
+    }
+  }
+  fPendingRemovals.clear();
+}
+
 /**
  * @brief Updates or inserts a media item into the internal map.
  * Also checks for potential conflicts or data integrity issues (warns on DB ID
@@ -433,6 +550,58 @@ void CacheManager::AddOrUpdateEntry(const MediaItem &entry) {
   }
 }
 
+namespace {
+
+/** Input of a duplicate search, owned by its worker thread. */
+struct DuplicateJob {
+  std::vector<MediaItem> items;
+  BMessenger reply;
+};
+
+/**
+ * @brief Worker thread: groups duplicates and reports them to the looper.
+ */
+status_t DuplicateThread(void *data) {
+  std::unique_ptr<DuplicateJob> job(static_cast<DuplicateJob *>(data));
+  std::vector<DuplicateGroup> groups = DuplicateFinder::Find(job->items);
+
+  BMessage result(MSG_DUPLICATES_FOUND);
+  for (size_t g = 0; g < groups.size(); g++) {
+    for (const auto &path : groups[g].paths) {
+      result.AddString("path", path);
+      result.AddInt32("group", (int32)g);
+    }
+    result.AddBool("exact", groups[g].exact);
+  }
+  job->reply.SendMessage(&result);
+  return B_OK;
+}
+
+} // namespace
+
+/**
+ * @brief Starts a duplicate search over a snapshot of the cache.
+ *
+ * The search runs on its own low-priority thread, so scanner batches keep
+ * being processed meanwhile. The result arrives as MSG_DUPLICATES_FOUND and
+ * is forwarded to the UI. Requests while a search is running are ignored.
+ */
+void CacheManager::FindDuplicates() {
+  if (fFindingDuplicates)
+    return;
+
+  auto *job = new DuplicateJob{AllEntries(), BMessenger(this)};
+  thread_id thread =
+      spawn_thread(DuplicateThread, "DuplicateFinder", B_LOW_PRIORITY, job);
+  if (thread < 0) {
+    delete job;
+    return;
+  }
+
+  fFindingDuplicates = true;
+  resume_thread(thread);
+}
+
 /**
  * @brief Marks all entries belonging to a specific base path as "missing".
  * This is used when a configured directory is not found/mounted.
@@ -2,13 +2,17 @@
 #define CACHE_MANAGER_H
 
 #include "MediaItem.h"
+#include "MessageStats.h"
 #include "Messages.h"
+#include <Locker.h>
 #include <Looper.h>
 #include <Messenger.h>
 #include <String.h>
 #include <map>
 #include <vector>
 
+class MemoryReport;
+
 /**
  * @class CacheManager
  * @brief Manages the central media library cache.
@@ -41,13 +45,35 @@ public:
    */
   void SaveCache();
 
+  /**
+   * @brief Uses another cache file instead of the one in the settings.
+   *
+   * For tools and benchmarks that must not touch the user's library.
+   */
+  void SetCachePath(const BString &path) { fCachePath = path; }
+
+  /** @name Entry archiving
+   * The format of one entry in 'media.cache', also used for other files that
+   * store media items.
+   */
+  ///@{
+  static void ArchiveEntry(const MediaItem &entry, BMessage &out);
+  static void UnarchiveEntry(const BMessage &in, MediaItem &out);
+  ///@}
+
   /**
    * @brief Starts the scanning process for all configured directories.
    */
   void StartScan();
 
+  void DispatchMessage(BMessage *msg, BHandler *handler) override;
   void MessageReceived(BMessage *msg) override;
 
+  /**
+   * @brief Queue wait and handler times of this looper's messages.
+   */
+  const MessageStats &Stats() const { return fMessageStats; }
+
   const std::map<BString, MediaItem> &Entries() const { return fEntries; }
 
   /**
@@ -56,10 +82,30 @@ public:
    */
   std::vector<MediaItem> AllEntries() const;
 
-private:
+  /**
+   * @brief Hands over the copy of the entries made by the last load.
+   *
+   * LoadCache() copies the entries on the cache thread before it sends
+   * MSG_CACHE_LOADED; the receiver takes them here. A copy nobody takes is
+   * freed with the CacheManager.
+   *
+   * @return False if there is no copy waiting.
+   */
+  bool TakeLoadedEntries(std::vector<MediaItem> &out);
+
+  /**
+   * @brief Adds the entries and the message queue to @p report.
+   * The looper must be locked.
+   */
+  void AccountMemory(MemoryReport &report);
+
   void AddOrUpdateEntry(const MediaItem &entry);
+
+private:
   void LoadDirectories(std::vector<BString> &outDirs);
   void MarkBaseOffline(const BString &basePath);
+  void FindDuplicates();
+  void PostPendingRemovals();
 
   /** @name Data */
   ///@{
@@ -67,6 +113,14 @@ private:
   BMessenger fTarget;
   BString fCachePath;
   int32 fActiveScanners{0};
+  /** Paths found gone at scan start; reported once moves are known. */
+  std::vector<BString> fPendingRemovals;
+  bool fFindingDuplicates{false};
+  /** Copy of the entries waiting for the window; see TakeLoadedEntries(). */
+  std::vector<MediaItem> fLoadedEntries;
+  bool fHasLoadedEntries{false};
+  BLocker fLoadedEntriesLock{"loaded entries"};
+  MessageStats fMessageStats{"CacheManager"};
   ///@}
 };
 
@@ -1,7 +1,12 @@
 
 #include "ContentColumnView.h"
 #include "MainWindow.h"
+#include "MemoryReport.h"
 #include "Messages.h"
+#include "PlaylistIndex.h"
+#include "Trace.h"
+#include "UIWorkQueue.h"
+#include "ViewSnapshot.h"
 #include <Catalog.h>
 #include <Entry.h>
 #include <Font.h>
@@ -14,7 +19,9 @@
 #include <PopUpMenu.h>
 #include <View.h>
 #include <Window.h>
+#include <algorithm>
 #include <cinttypes>
+#include <cstring>
 
 #undef B_TRANSLATION_CONTEXT
 #define B_TRANSLATION_CONTEXT "ContentColumnView"
@@ -37,13 +44,18 @@ static float CalculateRowHeight() {
 
 class MediaRow : public BRow {
 public:
-  explicit MediaRow(const MediaItem &mi)
-      : BRow(CalculateRowHeight()), fItem(mi) {}
+  MediaRow(const MediaItem &mi, int32 position)
+      : BRow(CalculateRowHeight()), fItem(mi), fPosition(position) {}
 
   const MediaItem &Item() const { return fItem; }
 
+  /** Position in the playlist or library shown; -1 if unknown. */
+  int32 Position() const { return fPosition; }
+  void SetPosition(int32 position) { fPosition = position; }
+
 private:
   MediaItem fItem;
+  int32 fPosition;
 };
 
 /**
@@ -432,23 +444,19 @@ void ContentColumnView::SetNowPlayingPath(const BString &path) {
     BString oldPath = fNowPlayingPath;
     fNowPlayingPath = path;
 
-    // Invalidate specific rows that need redrawing
-    for (int32 i = 0; i < CountRows(); ++i) {
-      MediaRow *mr = dynamic_cast<MediaRow *>(RowAt(i));
-      if (mr) {
-        // Invalidate old playing row and new playing row
-        if (mr->Item().path == oldPath || mr->Item().path == path) {
-          InvalidateRow(mr);
-        }
-      }
+    // Invalidate old playing row and new playing row
+    for (const BString *p : {&oldPath, &path}) {
+      auto range = fRowsByPath.equal_range(*p);
+      for (auto it = range.first; it != range.second; ++it)
+        InvalidateRow(it->second);
     }
   }
 }
 
 ContentColumnView::~ContentColumnView() {}
 
-void ContentColumnView::AddEntry(const MediaItem &mi) {
-  MediaRow *row = new MediaRow(mi);
+void ContentColumnView::AddEntry(const MediaItem &mi, int32 position) {
+  MediaRow *row = new MediaRow(mi, position);
   bool m = mi.missing;
 
   // Pass mi.path to each StatusStringField for now-playing detection
@@ -474,55 +482,208 @@ void ContentColumnView::AddEntry(const MediaItem &mi) {
   row->SetField(new StatusStringField(mi.path, m, mi.path), 10);
 
   AddRow(row);
+  fRowsByPath.emplace(row->Item().path, row);
 }
 
-void ContentColumnView::AddEntries(const std::vector<MediaItem> &items) {
-  fPendingItems = items;
+void ContentColumnView::AddEntries(std::vector<MediaItem> items,
+                                   std::vector<uint32> positions) {
+  fPendingItems = std::move(items);
+  fPendingPositions = std::move(positions);
   fPendingIndex = 0;
-  _AddBatch(50);
+  fRowsByPath.reserve(CountRows() + fPendingItems.size());
+  if (!fWorkQueue) {
+    _AddRows(B_INFINITE_TIMEOUT);
+    return;
+  }
+  fWorkQueue->Add(kRowsJob,
+                  [this](bigtime_t deadline) { return _AddRows(deadline); });
 }
 
-void ContentColumnView::_AddBatch(size_t count) {
-  if (fPendingIndex >= fPendingItems.size())
-    return;
+/**
+ * @brief Adds pending rows until @p deadline has passed.
+ * @return True while rows are left.
+ */
+bool ContentColumnView::_AddRows(bigtime_t deadline) {
+  TRACE_SPAN("view", "AddRows");
 
-  bool bulk = (count > 100);
   BWindow *win = Window();
-  if (bulk && win)
+  if (win)
     win->DisableUpdates();
-
   SetSortingEnabled(false);
 
-  size_t end = fPendingIndex + count;
-  if (end > fPendingItems.size())
-    end = fPendingItems.size();
-
-  for (size_t i = fPendingIndex; i < end; ++i) {
-    AddEntry(fPendingItems[i]);
-  }
+  do {
+    const size_t end =
+        std::min(fPendingIndex + kRowsPerCheck, fPendingItems.size());
+    for (; fPendingIndex < end; fPendingIndex++) {
+      AddEntry(fPendingItems[fPendingIndex],
+               fPendingIndex < fPendingPositions.size()
+                   ? (int32)fPendingPositions[fPendingIndex]
+                   : -1);
+    }
+  } while (fPendingIndex < fPendingItems.size() && system_time() < deadline);
 
-  fPendingIndex = end;
   SetSortingEnabled(true);
-
-  if (bulk && win)
+  if (win)
     win->EnableUpdates();
 
-  if (fPendingIndex < fPendingItems.size()) {
-    if (Looper())
-      Looper()->PostMessage(kMsgChunkAdd, this);
-  } else {
-    if (Looper())
-      Looper()->PostMessage(MSG_COUNT_UPDATED);
-  }
+  if (fPendingIndex < fPendingItems.size())
+    return true;
+
+  fPendingItems.clear();
+  fPendingPositions.clear();
+  fPendingIndex = 0;
+  if (Looper())
+    Looper()->PostMessage(MSG_COUNT_UPDATED);
+  return false;
 }
 
 void ContentColumnView::ClearEntries() {
+  fPendingItems.clear();
+  fPendingPositions.clear();
+  fPendingIndex = 0;
+  if (fWorkQueue)
+    fWorkQueue->Cancel(kRowsJob);
+  fRowsByPath.clear();
   Clear();
   RefreshScrollbars();
 }
 
 void ContentColumnView::RefreshScrollbars() { InvalidateLayout(); }
 
+bool ContentColumnView::MoveRow(int32 fromIndex, int32 toIndex) {
+  const int32 count = CountRows();
+  if (fromIndex < 0 || fromIndex >= count || toIndex < 0 || toIndex >= count ||
+      fromIndex == toIndex)
+    return false;
+
+  BRow *row = RowAt(fromIndex);
+  if (!row)
+    return false;
+
+  const int32 from = PositionAt(fromIndex);
+  const int32 to = PositionAt(toIndex);
+
+  RemoveRow(row);
+  AddRow(row, toIndex);
+
+  if (from < 0 || to < 0 || from == to)
+    return true;
+
+  // The entry moves from one playlist position to the other and the entries
+  // in between shift by one. A filtered or sorted view does not show them
+  // next to each other, so every row is renumbered by position, not index.
+  auto moved = [from, to](int32 position) {
+    if (position == from)
+      return to;
+    if (from < to && position > from && position <= to)
+      return position - 1;
+    if (from > to && position >= to && position < from)
+      return position + 1;
+    return position;
+  };
+  for (int32 i = 0; i < CountRows(); i++) {
+    if (MediaRow *mr = dynamic_cast<MediaRow *>(RowAt(i)))
+      mr->SetPosition(moved(mr->Position()));
+  }
+  for (size_t i = fPendingIndex; i < fPendingPositions.size(); i++)
+    fPendingPositions[i] = (uint32)moved((int32)fPendingPositions[i]);
+  return true;
+}
+
+int32 ContentColumnView::RemoveSelectedRows(std::vector<MediaItem> &outItems,
+                                            std::vector<int32> &outPositions) {
+  TRACE_SPAN("view", "RemoveSelectedRows");
+  if (!CurrentSelection())
+    return 0;
+
+  const int32 count = CountRows();
+  std::vector<MediaRow *> selected; ///< In view order.
+  std::vector<int32> removed;       ///< Known positions, ascending once sorted.
+  for (int32 i = 0; i < count; i++) {
+    MediaRow *row = dynamic_cast<MediaRow *>(RowAt(i));
+    if (!row || !row->IsSelected())
+      continue;
+    selected.push_back(row);
+    outItems.push_back(row->Item());
+    outPositions.push_back(row->Position());
+    if (row->Position() >= 0)
+      removed.push_back(row->Position());
+  }
+  if (selected.empty())
+    return 0;
+  std::sort(removed.begin(), removed.end());
+
+  auto shifted = [&removed](int32 position) {
+    if (position < 0)
+      return position;
+    return position - (int32)(std::lower_bound(removed.begin(), removed.end(),
+                                               position) -
+                              removed.begin());
+  };
+
+  BWindow *win = Window();
+  if (win)
+    win->DisableUpdates();
+
+  BView *outline = ScrollView();
+  const float scrollOffset = outline ? outline->Bounds().top : 0.0f;
+
+  // RemoveRow() searches the row list, so removing a large part of the view
+  // row by row is quadratic. Rebuilding from the remaining rows is linear,
+  // but re-creates every field, so a few rows are still removed in place.
+  const int32 removedCount = (int32)selected.size();
+  if (removedCount > kRebuildThreshold && removedCount * 4 > count) {
+    std::vector<MediaItem> keep;
+    std::vector<int32> keepPositions;
+    keep.reserve(count - removedCount);
+    keepPositions.reserve(count - removedCount);
+    for (int32 i = 0; i < count; i++) {
+      const MediaRow *row = dynamic_cast<const MediaRow *>(RowAt(i));
+      if (!row || row->IsSelected())
+        continue;
+      keep.push_back(row->Item());
+      keepPositions.push_back(row->Position());
+    }
+
+    fRowsByPath.clear();
+    Clear();
+    SetSortingEnabled(false);
+    for (size_t k = 0; k < keep.size(); k++)
+      AddEntry(keep[k], shifted(keepPositions[k]));
+    SetSortingEnabled(true);
+  } else {
+    for (MediaRow *row : selected) {
+      auto range = fRowsByPath.equal_range(row->Item().path);
+      for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == row) {
+          fRowsByPath.erase(it);
+          break;
+        }
+      }
+      RemoveRow(row);
+      delete row;
+    }
+    if (!removed.empty()) {
+      for (int32 i = 0; i < CountRows(); i++) {
+        if (MediaRow *row = dynamic_cast<MediaRow *>(RowAt(i)))
+          row->SetPosition(shifted(row->Position()));
+      }
+    }
+  }
+
+  // Rows still to be added follow the playlist as well.
+  for (size_t i = fPendingIndex; i < fPendingPositions.size(); i++)
+    fPendingPositions[i] = (uint32)shifted((int32)fPendingPositions[i]);
+
+  if (outline)
+    outline->ScrollTo(outline->Bounds().left, scrollOffset);
+  if (win)
+    win->EnableUpdates();
+
+  RefreshScrollbars();
+  return removedCount;
+}
+
 bool ContentColumnView::InitiateDrag(BPoint point, bool wasSelected) {
   BMessage dragMsg(B_SIMPLE_DATA);
 
@@ -667,6 +828,11 @@ void ContentColumnView::MessageReceived(BMessage *msg) {
       mw->GetPlaylistNames(reply, true);
     }
 
+    // Playlists that already contain the clicked track get a check mark.
+    std::vector<BString> containing;
+    if (const MediaItem *clicked = ItemAt(IndexOf(row)))
+      containing = PlaylistIndex::PlaylistsContaining(clicked->path);
+
     int32 count = 0;
     reply.GetInfo("name", nullptr, &count);
     if (count == 0) {
@@ -680,7 +846,10 @@ void ContentColumnView::MessageReceived(BMessage *msg) {
           BMessage *m = new BMessage(MSG_ADD_TO_PLAYLIST);
           AppendSelectedIndices(this, *m);
           m->AddString("playlist", pname);
-          addSub->AddItem(new BMenuItem(pname, m));
+          auto *item = new BMenuItem(pname, m);
+          item->SetMarked(std::find(containing.begin(), containing.end(),
+                                    BString(pname)) != containing.end());
+          addSub->AddItem(item);
         }
       }
     }
@@ -734,10 +903,6 @@ void ContentColumnView::MessageReceived(BMessage *msg) {
     break;
   }
 
-  case kMsgChunkAdd:
-    _AddBatch(200);
-    break;
-
   case B_COLORS_UPDATED: {
     SetColor(B_COLOR_BACKGROUND, ui_color(B_LIST_BACKGROUND_COLOR));
     SetColor(B_COLOR_TEXT, ui_color(B_LIST_ITEM_TEXT_COLOR));
@@ -799,6 +964,11 @@ const MediaItem *ContentColumnView::SelectedItem() const {
   return nullptr;
 }
 
+int32 ContentColumnView::PositionAt(int32 index) const {
+  const MediaRow *row = dynamic_cast<const MediaRow *>(RowAt(index));
+  return row ? row->Position() : -1;
+}
+
 const MediaItem *ContentColumnView::ItemAt(int32 index) const {
   const BRow *r = RowAt(index);
   if (!r)
@@ -810,6 +980,150 @@ const MediaItem *ContentColumnView::ItemAt(int32 index) const {
   return nullptr;
 }
 
+const MediaItem *ContentColumnView::FindItem(const BString &path) const {
+  const MediaRow *row = dynamic_cast<const MediaRow *>(_RowForPath(path));
+  return row ? &row->Item() : nullptr;
+}
+
+int32 ContentColumnView::RemovePath(const BString &path) {
+  auto range = fRowsByPath.equal_range(path);
+  std::vector<BRow *> rows;
+  for (auto it = range.first; it != range.second; ++it)
+    rows.push_back(it->second);
+  fRowsByPath.erase(range.first, range.second);
+
+  for (BRow *row : rows) {
+    RemoveRow(row);
+    delete row;
+  }
+  return (int32)rows.size();
+}
+
+BRow *ContentColumnView::_RowForPath(const BString &path) const {
+  auto it = fRowsByPath.find(path);
+  return it != fRowsByPath.end() ? it->second : nullptr;
+}
+
+bool ContentColumnView::SelectPath(const BString &path) {
+  if (path.IsEmpty())
+    return false;
+
+  BRow *row = _RowForPath(path);
+  if (!row)
+    return false;
+
+  DeselectAll();
+  AddToSelection(row);
+  SetFocusRow(row);
+  ScrollTo(row);
+  return true;
+}
+
+/**
+ * @brief Selects the rows of @p paths and scrolls to the first.
+ *
+ * A path listed n times selects n of its rows.
+ */
+void ContentColumnView::_SelectPaths(const std::vector<BString> &paths) {
+  DeselectAll();
+  BRow *first = nullptr;
+  for (const BString &path : paths) {
+    auto range = fRowsByPath.equal_range(path);
+    for (auto it = range.first; it != range.second; ++it) {
+      if (it->second->IsSelected())
+        continue;
+      AddToSelection(it->second);
+      if (!first)
+        first = it->second;
+      break;
+    }
+  }
+  if (!first)
+    return;
+
+  SetFocusRow(first);
+  ScrollTo(first);
+}
+
+void ContentColumnView::SaveSnapshot(ViewSnapshot &out) {
+  out.rows.clear();
+  out.selectedPaths.clear();
+  for (BRow *row = CurrentSelection(); row; row = CurrentSelection(row)) {
+    if (const MediaRow *mr = dynamic_cast<const MediaRow *>(row))
+      out.selectedPaths.push_back(mr->Item().path);
+  }
+
+  BView *outline = ScrollView();
+  if (!outline)
+    return;
+
+  const BRect visible = outline->Bounds();
+  out.scrollOffset = visible.top;
+
+  BRow *first = RowAt(BPoint(visible.left, visible.top));
+  float height = 0.0f;
+  for (int32 i = first ? IndexOf(first) : 0;
+       i < CountRows() && height <= visible.Height() &&
+       (int32)out.rows.size() < ViewSnapshot::kMaxRows;
+       i++) {
+    if (const MediaItem *item = ItemAt(i))
+      out.rows.push_back(*item);
+    height += RowAt(i)->Height();
+  }
+}
+
+void ContentColumnView::ShowSnapshot(const ViewSnapshot &snapshot) {
+  for (const MediaItem &item : snapshot.rows)
+    AddEntry(item);
+  _SelectPaths(snapshot.selectedPaths);
+}
+
+void ContentColumnView::RestoreSnapshotPosition(const ViewSnapshot &snapshot) {
+  // Scroll first; selecting only scrolls if the row is not already visible.
+  if (BView *outline = ScrollView())
+    outline->ScrollTo(outline->Bounds().left, snapshot.scrollOffset);
+  _SelectPaths(snapshot.selectedPaths);
+}
+
+void ContentColumnView::AccountMemory(MemoryReport &report) const {
+  const int32 rows = CountRows();
+  size_t bytes = 0;
+  for (int32 i = 0; i < rows; i++) {
+    const MediaRow *row = dynamic_cast<const MediaRow *>(RowAt(i));
+    if (!row)
+      continue;
+    bytes += sizeof(MediaRow) - sizeof(MediaItem) + MemoryReport::kAllocation +
+             report.Item(row->Item());
+
+    for (int32 f = 0; f < CountColumns(); f++) {
+      const BField *field = row->GetField(f);
+      if (const auto *text = dynamic_cast<const StatusStringField *>(field)) {
+        bytes += sizeof(StatusStringField) + MemoryReport::kAllocation +
+                 report.String(text->String(), strlen(text->String())) +
+                 report.String(text->Path());
+      } else if (field) {
+        bytes += sizeof(StatusIntegerField) + MemoryReport::kAllocation;
+      }
+    }
+  }
+  report.Add(MEMORY_VIEW_ROWS, "Track list rows", rows, bytes);
+
+  // The keys share their buffers with the rows' paths.
+  report.Add(MEMORY_VIEW_ROWS, "Track list path index", fRowsByPath.size(),
+             fRowsByPath.size() *
+                     (MemoryReport::kHashNode + MemoryReport::kAllocation +
+                      sizeof(std::pair<const BString, BRow *>)) +
+                 fRowsByPath.bucket_count() * MemoryReport::kHashBucket);
+
+  // Added items stay in the queue until the last one is added.
+  if (fPendingIndex < fPendingItems.size()) {
+    report.Add(MEMORY_VIEW_ROWS, "Track list rows to add",
+               fPendingItems.size(),
+               report.Items(fPendingItems) +
+                   fPendingPositions.capacity() * sizeof(uint32));
+  }
+}
+
 bool ContentColumnView::IsRowMissing(BRow *row) const {
   MediaRow *mrow = dynamic_cast<MediaRow *>(row);
   if (mrow) {
@@ -1,15 +1,20 @@
 #ifndef CONTENT_COLUMN_VIEW_H
 #define CONTENT_COLUMN_VIEW_H
 
+#include "HashUtils.h"
 #include "MediaItem.h"
 #include "Messages.h"
 #include <ColumnListView.h>
 #include <ColumnTypes.h>
 #include <MessageFilter.h>
 #include <PopUpMenu.h>
-#include <map>
+#include <unordered_map>
 #include <vector>
 
+class MemoryReport;
+class UIWorkQueue;
+struct ViewSnapshot;
+
 /**
  * @class ContentColumnView
  * @brief The main list view displaying the audio library.
@@ -29,23 +34,104 @@ public:
 
   /**
    * @brief Adds a single media item to the view.
+   * @param position Position of the entry in the playlist or library the
+   * view shows, or -1 if unknown.
    */
-  void AddEntry(const MediaItem &mi);
+  void AddEntry(const MediaItem &mi, int32 position = -1);
 
   /**
-   * @brief Adds a list of items asynchronously (chunked).
+   * @brief Replaces the rows still to be added by @p items.
+   *
+   * The rows are added by a job on the work queue, under its time budget;
+   * MSG_COUNT_UPDATED is posted once all are in. Without a work queue they
+   * are added right away.
+   *
+   * @param positions Position of each item in the playlist or library the
+   * view shows; may be empty.
    */
-  void AddEntries(const std::vector<MediaItem> &items);
+  void AddEntries(std::vector<MediaItem> items,
+                  std::vector<uint32> positions = {});
+
+  /** @brief Sets the queue AddEntries() adds rows from. */
+  void SetWorkQueue(UIWorkQueue *queue) { fWorkQueue = queue; }
 
   void ClearEntries();
   void RefreshScrollbars();
 
+  /**
+   * @brief Moves a row to a new index, reusing the existing row object.
+   *
+   * The moved row takes over the position of the row at @p toIndex and the
+   * rows between the two positions shift by one, wherever the view shows
+   * them.
+   *
+   * @return False if either index is out of range.
+   */
+  bool MoveRow(int32 fromIndex, int32 toIndex);
+
+  /**
+   * @brief Removes all selected rows.
+   *
+   * A few rows are removed in place; when a large share of the view is
+   * selected, the view is rebuilt from the remaining rows instead.
+   * The positions of the rows that stay are renumbered as if the removed
+   * entries were gone from the playlist.
+   *
+   * @param outItems Receives the tracks of the removed rows, in view order.
+   * @param outPositions Receives their positions, -1 where unknown.
+   * @return Number of rows removed.
+   */
+  int32 RemoveSelectedRows(std::vector<MediaItem> &outItems,
+                           std::vector<int32> &outPositions);
+
   static constexpr uint32 kMsgShowCtx = MSG_SHOW_CONTEXT_MENU;
 
   const MediaItem *SelectedItem() const;
   const MediaItem *ItemAt(int32 index) const;
+
+  /**
+   * @brief Position in the playlist or library of the row at @p index.
+   * @return -1 if the index is out of range or the position is unknown.
+   */
+  int32 PositionAt(int32 index) const;
+
+  /**
+   * @brief Finds the track of @p path without walking the rows.
+   * @return The first row's track if the path is listed twice, or nullptr.
+   */
+  const MediaItem *FindItem(const BString &path) const;
+
+  /**
+   * @brief Removes the rows of @p path.
+   * @return Number of rows removed.
+   */
+  int32 RemovePath(const BString &path);
   bool IsRowMissing(BRow *row) const;
 
+  /**
+   * @brief Selects the row of @p path and scrolls to it.
+   * @return False if no row has this path.
+   */
+  bool SelectPath(const BString &path);
+
+  /** @name View snapshot */
+  ///@{
+  /**
+   * @brief Stores the rows on screen, the selection and the scroll position.
+   */
+  void SaveSnapshot(ViewSnapshot &out);
+
+  /**
+   * @brief Shows the rows of @p snapshot; used before the library is loaded.
+   */
+  void ShowSnapshot(const ViewSnapshot &snapshot);
+
+  /**
+   * @brief Restores the selection and scroll position once all rows are in.
+   */
+  void RestoreSnapshotPosition(const ViewSnapshot &snapshot);
+  ///@}
+
   /**
    * @brief Sets the path of the currently playing track.
    * The row with this path will be rendered in bold.
@@ -53,6 +139,12 @@ public:
   void SetNowPlayingPath(const BString &path);
   const BString &NowPlayingPath() const { return fNowPlayingPath; }
 
+  /**
+   * @brief Adds the estimated size of the rows, their fields and the rows
+   * still waiting to be added to @p report.
+   */
+  void AccountMemory(MemoryReport &report) const;
+
 protected:
   bool InitiateDrag(BPoint point, bool wasSelected) override;
   void KeyDown(const char *bytes, int32 numBytes) override;
@@ -73,18 +165,28 @@ private:
   ///@}
 
   void ShowContextMenu(BPoint screenWhere);
-  /**
-   * @note fRowMap seemed unused in the .cpp, but keeping declaration if needed
-   * later.
-   */
-  std::map<BRow *, MediaItem> fRowMap;
+
+  /** @name Path index */
+  ///@{
+  /// Rows by track path. A playlist may list a path more than once.
+  std::unordered_multimap<BString, BRow *, BStringHash> fRowsByPath;
+  BRow *_RowForPath(const BString &path) const;
+  void _SelectPaths(const std::vector<BString> &paths);
+  ///@}
+
+  /** Above this many removed rows, RemoveSelectedRows() may rebuild. */
+  static constexpr int32 kRebuildThreshold = 256;
 
   /** @name Chunked loading state */
   ///@{
   std::vector<MediaItem> fPendingItems;
+  std::vector<uint32> fPendingPositions; ///< Empty, or one per item.
   size_t fPendingIndex = 0;
-  void _AddBatch(size_t count);
-  static constexpr uint32 kMsgChunkAdd = 'chnk';
+  UIWorkQueue *fWorkQueue = nullptr;
+  bool _AddRows(bigtime_t deadline);
+  static constexpr const char *kRowsJob = "content rows";
+  /** Rows added between two looks at the clock. */
+  static constexpr size_t kRowsPerCheck = 32;
   ///@}
 
   /** @name Internal drag-drop reordering */
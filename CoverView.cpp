@@ -13,6 +13,10 @@ CoverView::~CoverView() {
   fBitmap = nullptr;
 }
 
+size_t CoverView::BitmapBytes() const {
+  return fBitmap ? sizeof(BBitmap) + fBitmap->BitsLength() : 0;
+}
+
 /**
  * @brief Updates the displayed cover image.
  * Makes a defensive copy of the provided bitmap.
@@ -25,6 +25,11 @@ public:
    */
   void SetBitmap(BBitmap *bmp);
 
+  /**
+   * @brief Bytes held by the displayed bitmap, 0 if there is none.
+   */
+  size_t BitmapBytes() const;
+
   void Draw(BRect update) override;
   void GetPreferredSize(float *w, float *h) override;
 
@@ -0,0 +1,3 @@
+#include "Debug.h"
+
+bool gIsDebug = false;
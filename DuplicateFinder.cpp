@@ -0,0 +1,370 @@
+#include "DuplicateFinder.h"
+#include "Debug.h"
+
+#include <File.h>
+#include <OS.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+
+/** Bytes hashed at the start, in the middle and at the end of a file. */
+static const off_t kSampleBlock = 8 * 1024;
+
+/** MinHash signature layout: kBands bands of kRows minimums each. */
+static const int kBands = 8;
+static const int kRows = 4;
+
+/**
+ * Upper bound of comparisons per track within one LSH bucket, so a bucket of
+ * thousands of identically tagged tracks cannot turn quadratic.
+ */
+static const size_t kMaxBucketCompare = 64;
+
+namespace {
+
+/**
+ * @brief Disjoint-set forest over library positions.
+ */
+class UnionFind {
+public:
+  explicit UnionFind(size_t count) : fParent(count) {
+    for (size_t i = 0; i < count; i++)
+      fParent[i] = (uint32)i;
+  }
+
+  uint32 Find(uint32 i) {
+    while (fParent[i] != i) {
+      fParent[i] = fParent[fParent[i]];
+      i = fParent[i];
+    }
+    return i;
+  }
+
+  void Union(uint32 a, uint32 b) {
+    a = Find(a);
+    b = Find(b);
+    if (a != b)
+      fParent[std::max(a, b)] = std::min(a, b);
+  }
+
+private:
+  std::vector<uint32> fParent;
+};
+
+/**
+ * @brief Finalizer of SplitMix64; spreads the bits of @p x.
+ */
+uint64 Mix64(uint64 x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+/**
+ * @brief Returns the sorted, unique hashes of the character trigrams of @p key.
+ */
+std::vector<uint32> Shingles(const BString &key) {
+  BString padded;
+  padded << " " << key << " ";
+
+  const char *s = padded.String();
+  const int32 len = padded.Length();
+
+  std::vector<uint32> out;
+  out.reserve(len);
+  for (int32 i = 0; i + 3 <= len; i++) {
+    uint32 h = 2166136261u;
+    for (int32 k = 0; k < 3; k++) {
+      h ^= (uint8)s[i + k];
+      h *= 16777619u;
+    }
+    out.push_back(h);
+  }
+  std::sort(out.begin(), out.end());
+  out.erase(std::unique(out.begin(), out.end()), out.end());
+  return out;
+}
+
+/**
+ * @brief Jaccard similarity of two sorted shingle sets.
+ */
+float Similarity(const std::vector<uint32> &a, const std::vector<uint32> &b) {
+  if (a.empty() || b.empty())
+    return 0.0f;
+
+  size_t common = 0;
+  auto ia = a.begin();
+  auto ib = b.begin();
+  while (ia != a.end() && ib != b.end()) {
+    if (*ia < *ib) {
+      ++ia;
+    } else if (*ib < *ia) {
+      ++ib;
+    } else {
+      ++common;
+      ++ia;
+      ++ib;
+    }
+  }
+  return (float)common / (float)(a.size() + b.size() - common);
+}
+
+/**
+ * @brief Computes the LSH band hashes of a shingle set.
+ *
+ * Each of the kBands * kRows MinHash functions is the shingle hash mixed with
+ * its own seed; a band hash combines the band's kRows minimums.
+ */
+void BandHashes(const std::vector<uint32> &shingles, uint64 *out) {
+  uint32 mins[kBands * kRows];
+  std::fill(std::begin(mins), std::end(mins), UINT32_MAX);
+
+  for (uint32 s : shingles) {
+    for (int f = 0; f < kBands * kRows; f++) {
+      const uint32 h =
+          (uint32)Mix64((uint64)s + (uint64)(f + 1) * 0x9e3779b97f4a7c15ULL);
+      mins[f] = std::min(mins[f], h);
+    }
+  }
+
+  for (int b = 0; b < kBands; b++) {
+    uint64 h = (uint64)b;
+    for (int r = 0; r < kRows; r++)
+      h = Mix64(h ^ mins[b * kRows + r]);
+    out[b] = h;
+  }
+}
+
+} // namespace
+
+uint64 DuplicateFinder::SampledHash(const char *path, off_t size) {
+  BFile file(path, B_READ_ONLY);
+  if (file.InitCheck() != B_OK)
+    return 0;
+
+  uint64 hash = 14695981039346656037ULL;
+  auto mix = [&hash](const uint8 *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+      hash ^= data[i];
+      hash *= 1099511628211ULL;
+    }
+  };
+
+  const off_t offsets[] = {0, std::max<off_t>(0, size / 2 - kSampleBlock / 2),
+                           std::max<off_t>(0, size - kSampleBlock)};
+
+  std::vector<uint8> block(kSampleBlock);
+  for (off_t offset : offsets) {
+    ssize_t n = file.ReadAt(offset, block.data(), block.size());
+    if (n < 0)
+      return 0;
+    mix(block.data(), n);
+  }
+
+  mix(reinterpret_cast<const uint8 *>(&size), sizeof(size));
+  return hash != 0 ? hash : 1;
+}
+
+BString DuplicateFinder::NormalizedKey(const MediaItem &item) {
+  if (item.title.IsEmpty())
+    return BString();
+
+  BString raw;
+  raw << item.artist << " " << item.title;
+  raw.ToLower();
+
+  BString key;
+  bool pendingSpace = false;
+  for (int32 i = 0; i < raw.Length(); i++) {
+    const uint8 c = (uint8)raw[i];
+    // Keep letters, digits and all UTF-8 sequences; the rest separates words.
+    if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c >= 0x80) {
+      if (pendingSpace && !key.IsEmpty())
+        key << ' ';
+      key << (char)c;
+      pendingSpace = false;
+    } else {
+      pendingSpace = true;
+    }
+  }
+  return key;
+}
+
+std::vector<DuplicateGroup>
+DuplicateFinder::Find(const std::vector<MediaItem> &items,
+                      const DuplicateOptions &options) {
+  const bigtime_t start = system_time();
+  const uint32 count = (uint32)items.size();
+  UnionFind sets(count);
+
+  // Content hash per track; only set for tracks that share their size.
+  std::vector<uint64> content(count, 0);
+
+  // 1. Exact duplicates: same size, then same partial and sampled hash.
+  std::vector<uint32> order;
+  order.reserve(count);
+  for (uint32 i = 0; i < count; i++) {
+    if (!items[i].missing && items[i].size > 0)
+      order.push_back(i);
+  }
+  std::sort(order.begin(), order.end(), [&items](uint32 a, uint32 b) {
+    if (items[a].size != items[b].size)
+      return items[a].size < items[b].size;
+    return items[a].partialHash < items[b].partialHash;
+  });
+
+  size_t filesRead = 0;
+  for (size_t runStart = 0; runStart < order.size();) {
+    const int64 size = items[order[runStart]].size;
+    size_t runEnd = runStart + 1;
+    while (runEnd < order.size() && items[order[runEnd]].size == size)
+      runEnd++;
+
+    if (runEnd - runStart >= 2) {
+      // If every partial hash is known, tracks whose partial hash is unique
+      // within the run cannot be duplicates and need not be read.
+      bool allKnown = true;
+      for (size_t k = runStart; k < runEnd && allKnown; k++)
+        allKnown = items[order[k]].partialHash != 0;
+
+      std::vector<std::pair<uint64, uint32>> sampled;
+      for (size_t k = runStart; k < runEnd; k++) {
+        const MediaItem &item = items[order[k]];
+        if (allKnown) {
+          const bool samePrev = k > runStart &&
+                                items[order[k - 1]].partialHash ==
+                                    item.partialHash;
+          const bool sameNext = k + 1 < runEnd &&
+                                items[order[k + 1]].partialHash ==
+                                    item.partialHash;
+          if (!samePrev && !sameNext)
+            continue;
+        }
+
+        const uint64 hash = SampledHash(item.path.String(), size);
+        filesRead++;
+        if (hash != 0)
+          sampled.emplace_back(hash, order[k]);
+      }
+
+      std::sort(sampled.begin(), sampled.end());
+      for (size_t k = 1; k < sampled.size(); k++) {
+        if (sampled[k].first != sampled[k - 1].first)
+          continue;
+        content[sampled[k - 1].second] = sampled[k - 1].first;
+        content[sampled[k].second] = sampled[k].first;
+        sets.Union(sampled[k - 1].second, sampled[k].second);
+      }
+    }
+    runStart = runEnd;
+  }
+
+  // 2. Near duplicates: MinHash/LSH over artist + title, then duration.
+  size_t candidates = 0;
+  if (options.nearDuplicates) {
+    std::vector<BString> keys(count);
+    std::vector<uint64> bands((size_t)count * kBands, 0);
+    std::vector<uint32> eligible;
+    eligible.reserve(count);
+
+    for (uint32 i = 0; i < count; i++) {
+      const MediaItem &item = items[i];
+      if (item.missing || item.duration <= 0)
+        continue;
+      keys[i] = NormalizedKey(item);
+      if (keys[i].IsEmpty())
+        continue;
+      BandHashes(Shingles(keys[i]), &bands[(size_t)i * kBands]);
+      eligible.push_back(i);
+    }
+
+    auto byDuration = [&items](uint32 a, uint32 b) {
+      return items[a].duration < items[b].duration;
+    };
+
+    std::vector<std::pair<uint64, uint32>> buckets;
+    buckets.reserve(eligible.size());
+    for (int b = 0; b < kBands; b++) {
+      buckets.clear();
+      for (uint32 i : eligible)
+        buckets.emplace_back(bands[(size_t)i * kBands + b], i);
+      std::sort(buckets.begin(), buckets.end());
+
+      for (size_t runStart = 0; runStart < buckets.size();) {
+        size_t runEnd = runStart + 1;
+        while (runEnd < buckets.size() &&
+               buckets[runEnd].first == buckets[runStart].first)
+          runEnd++;
+
+        if (runEnd - runStart >= 2) {
+          std::vector<uint32> members;
+          members.reserve(runEnd - runStart);
+          for (size_t k = runStart; k < runEnd; k++)
+            members.push_back(buckets[k].second);
+          std::sort(members.begin(), members.end(), byDuration);
+
+          for (size_t x = 0; x < members.size(); x++) {
+            const uint32 a = members[x];
+            std::vector<uint32> shinglesA;
+            const size_t last =
+                std::min(members.size(), x + 1 + kMaxBucketCompare);
+            for (size_t y = x + 1; y < last; y++) {
+              const uint32 other = members[y];
+              if (items[other].duration - items[a].duration >
+                  options.durationTolerance)
+                break;
+              if (sets.Find(a) == sets.Find(other))
+                continue;
+
+              candidates++;
+              if (shinglesA.empty())
+                shinglesA = Shingles(keys[a]);
+              if (Similarity(shinglesA, Shingles(keys[other])) >=
+                  options.minSimilarity)
+                sets.Union(a, other);
+            }
+          }
+        }
+        runStart = runEnd;
+      }
+    }
+  }
+
+  // 3. Collect groups in library order.
+  std::vector<uint32> groupSize(count, 0);
+  for (uint32 i = 0; i < count; i++)
+    groupSize[sets.Find(i)]++;
+
+  std::vector<DuplicateGroup> groups;
+  std::unordered_map<uint32, size_t> groupOf;
+  std::unordered_map<uint32, uint64> firstContent;
+  for (uint32 i = 0; i < count; i++) {
+    const uint32 root = sets.Find(i);
+    if (groupSize[root] < 2)
+      continue;
+
+    auto it = groupOf.find(root);
+    if (it == groupOf.end()) {
+      it = groupOf.emplace(root, groups.size()).first;
+      groups.emplace_back();
+      groups.back().exact = content[i] != 0;
+      firstContent[root] = content[i];
+    }
+
+    DuplicateGroup &group = groups[it->second];
+    group.paths.push_back(items[i].path);
+    if (content[i] != firstContent[root])
+      group.exact = false;
+  }
+
+  DEBUG_PRINT("[DuplicateFinder] %zu Gruppen in %u Titeln (%zu Dateien "
+              "gelesen, %zu Kandidaten) in %lld ms\n",
+              groups.size(), (unsigned)count, filesRead, candidates,
+              (long long)((system_time() - start) / 1000));
+  return groups;
+}
@@ -0,0 +1,71 @@
+#ifndef DUPLICATE_FINDER_H
+#define DUPLICATE_FINDER_H
+
+#include "MediaItem.h"
+
+#include <String.h>
+#include <SupportDefs.h>
+
+#include <vector>
+
+/**
+ * @struct DuplicateGroup
+ * @brief Library tracks that are copies or encodes of the same recording.
+ */
+struct DuplicateGroup {
+  std::vector<BString> paths; ///< Members in library order.
+  bool exact = false;         ///< All files have the same size and content.
+};
+
+/**
+ * @struct DuplicateOptions
+ * @brief Tuning for the near-duplicate pass.
+ */
+struct DuplicateOptions {
+  bool nearDuplicates = true; ///< Also compare artist/title, not only files.
+  int32 durationTolerance = 3; ///< Max. length difference in seconds.
+  float minSimilarity = 0.8f;  ///< Min. Jaccard similarity of artist + title.
+};
+
+/**
+ * @class DuplicateFinder
+ * @brief Finds duplicate tracks in a library snapshot.
+ *
+ * Exact duplicates are found by bucketing on file size, then on the partial
+ * hash the scanner already stored, and confirming with a hash of the first,
+ * middle and last block. Only files that share a size are opened.
+ *
+ * Near duplicates (the same recording in another format or bitrate) are found
+ * with MinHash over character trigrams of the normalized artist and title.
+ * Locality-sensitive hashing on bands of the signature yields candidate pairs,
+ * which are checked for their real similarity and a matching duration. No step
+ * compares all pairs of tracks, so the pass scales to very large libraries.
+ *
+ * Runs without locks or messaging and is meant to be called on a worker
+ * thread with a copy of the library.
+ */
+class DuplicateFinder {
+public:
+  /**
+   * @brief Groups duplicate tracks.
+   * @param items The library snapshot.
+   * @param options Tuning for the near-duplicate pass.
+   * @return Groups with at least two members, ordered by their first member.
+   */
+  static std::vector<DuplicateGroup>
+  Find(const std::vector<MediaItem> &items,
+       const DuplicateOptions &options = DuplicateOptions());
+
+  /**
+   * @brief Hashes the size and the first, middle and last block of a file.
+   * @return The hash, or 0 if the file could not be read.
+   */
+  static uint64 SampledHash(const char *path, off_t size);
+
+  /**
+   * @brief Returns "artist title" in lower case with punctuation removed.
+   */
+  static BString NormalizedKey(const MediaItem &item);
+};
+
+#endif // DUPLICATE_FINDER_H
@@ -0,0 +1,262 @@
+#include "FacetIndex.h"
+#include "MemoryReport.h"
+
+#include <algorithm>
+#include <numeric>
+
+// --- TrackSet ---
+
+TrackSet::TrackSet(size_t size, bool all)
+    : fWords((size + 63) / 64, all ? ~uint64_t(0) : 0), fSize(size) {
+  if (all && size % 64 != 0)
+    fWords.back() = (uint64_t(1) << (size % 64)) - 1;
+}
+
+void TrackSet::AddAll(const std::vector<uint32> &postings) {
+  for (uint32 track : postings)
+    Add(track);
+}
+
+void TrackSet::Intersect(const TrackSet &other) {
+  for (size_t w = 0; w < fWords.size(); w++)
+    fWords[w] &= other.fWords[w];
+}
+
+size_t TrackSet::Count() const {
+  size_t count = 0;
+  for (uint64_t word : fWords)
+    count += (size_t)__builtin_popcountll(word);
+  return count;
+}
+
+// --- FacetIndex ---
+
+void FacetIndex::Build(std::vector<const MediaItem *> tracks) {
+  Clear();
+  fTracks = std::move(tracks);
+
+  for (int f = 0; f < kFacetCount; f++) {
+    const Facet facet = (Facet)f;
+    FacetData &data = fFacets[f];
+
+    // Number the values in order of appearance first...
+    std::vector<int32> firstSeen(fTracks.size());
+    for (size_t t = 0; t < fTracks.size(); t++) {
+      Key key = _KeyOf(facet, *fTracks[t]);
+      auto inserted = data.ids.emplace(key, (int32)data.values.size());
+      if (inserted.second)
+        data.values.push_back(std::move(key));
+      firstSeen[t] = inserted.first->second;
+    }
+
+    // ...then renumber them in sorted order, so ID order is value order.
+    std::vector<int32> order(data.values.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&data](int32 a, int32 b) {
+      return data.values[a] < data.values[b];
+    });
+
+    std::vector<int32> renumbered(order.size());
+    std::vector<Key> sorted;
+    sorted.reserve(order.size());
+    for (size_t id = 0; id < order.size(); id++) {
+      renumbered[order[id]] = (int32)id;
+      sorted.push_back(std::move(data.values[order[id]]));
+    }
+    data.values = std::move(sorted);
+    for (auto &entry : data.ids)
+      entry.second = renumbered[entry.second];
+
+    data.postings.resize(data.values.size());
+    data.trackValues.resize(fTracks.size());
+    for (size_t t = 0; t < fTracks.size(); t++) {
+      const int32 id = renumbered[firstSeen[t]];
+      data.trackValues[t] = id;
+      data.postings[id].push_back((uint32)t);
+    }
+  }
+
+  const std::vector<Key> &albums = fFacets[kAlbum].values;
+  for (int32 id = 0; id < (int32)albums.size(); id++) {
+    if (albums[id].album != AlbumTable::kNoAlbum)
+      fAlbumValues.emplace(albums[id].album, id);
+  }
+
+  // One pass over the tracks for the numbers and the text, as reading
+  // them is what costs.
+  std::vector<int32> numbers[kNumberCount];
+  for (std::vector<int32> &byTrack : numbers)
+    byTrack.resize(fTracks.size());
+  for (size_t t = 0; t < fTracks.size(); t++) {
+    const MediaItem &item = *fTracks[t];
+    for (int n = 0; n < kNumberCount; n++)
+      numbers[n][t] = _NumberOf((Number)n, item);
+    fText.Add({&item.title, &item.artist, &item.album});
+  }
+  for (int n = 0; n < kNumberCount; n++)
+    _BuildNumber((Number)n, numbers[n]);
+}
+
+void FacetIndex::Clear() {
+  fTracks.clear();
+  for (FacetData &data : fFacets)
+    data = FacetData();
+  fAlbumValues.clear();
+  for (NumberData &data : fNumbers)
+    data = NumberData();
+  fText.Clear();
+}
+
+int32 FacetIndex::Find(Facet facet, const BString &value) const {
+  const FacetData &data = fFacets[facet];
+  auto it = data.ids.find({value, 0, AlbumTable::kNoAlbum});
+  return it != data.ids.end() ? it->second : -1;
+}
+
+int32 FacetIndex::FindAlbum(uint32 album) const {
+  auto it = fAlbumValues.find(album);
+  return it != fAlbumValues.end() ? it->second : -1;
+}
+
+int32 FacetIndex::FindAlbums(const BString &name, int32 &first) const {
+  const std::vector<Key> &values = fFacets[kAlbum].values;
+  auto begin = std::lower_bound(values.begin(), values.end(), name,
+                                [](const Key &key, const BString &n) {
+                                  return key.value < n;
+                                });
+  auto end = begin;
+  while (end != values.end() && end->value == name)
+    ++end;
+
+  first = (int32)(begin - values.begin());
+  return (int32)(end - begin);
+}
+
+size_t FacetIndex::CountInRange(Number number, int64 low, int64 high) const {
+  size_t first, end;
+  _Range(number, low, high, first, end);
+  return end - first;
+}
+
+void FacetIndex::AddRange(Number number, int64 low, int64 high,
+                          TrackSet &set) const {
+  size_t first, end;
+  _Range(number, low, high, first, end);
+  const std::vector<uint32> &tracks = fNumbers[number].tracks;
+  for (size_t i = first; i < end; i++)
+    set.Add(tracks[i]);
+}
+
+void FacetIndex::AccountMemory(MemoryReport &report) const {
+  size_t values = 0;
+  size_t bytes = fTracks.capacity() * sizeof(const MediaItem *);
+  for (const FacetData &data : fFacets) {
+    values += data.values.size();
+    // The value strings share their buffers with the library's items.
+    bytes += data.values.capacity() * sizeof(Key) +
+             data.ids.size() * (MemoryReport::kHashNode +
+                                MemoryReport::kAllocation +
+                                sizeof(std::pair<const Key, int32>)) +
+             data.ids.bucket_count() * MemoryReport::kHashBucket +
+             data.trackValues.capacity() * sizeof(int32);
+    for (const std::vector<uint32> &postings : data.postings) {
+      bytes += sizeof(postings) + MemoryReport::kAllocation +
+               postings.capacity() * sizeof(uint32);
+    }
+  }
+  bytes += fAlbumValues.size() * (MemoryReport::kHashNode +
+                                  MemoryReport::kAllocation +
+                                  sizeof(std::pair<const uint32, int32>)) +
+           fAlbumValues.bucket_count() * MemoryReport::kHashBucket;
+  for (const NumberData &data : fNumbers) {
+    bytes += data.values.capacity() * sizeof(int32) +
+             data.tracks.capacity() * sizeof(uint32);
+  }
+  report.Add(MEMORY_LIBRARY, "Column browser index", values, bytes);
+  fText.AccountMemory(report);
+}
+
+FacetIndex::Key FacetIndex::_KeyOf(Facet facet, const MediaItem &item) {
+  switch (facet) {
+  case kGenre:
+    return {item.genre, 0, AlbumTable::kNoAlbum};
+  case kArtist:
+    return {item.artist, 0, AlbumTable::kNoAlbum};
+  case kAlbum:
+  default:
+    if (item.album.IsEmpty())
+      return {item.album, 0, AlbumTable::kNoAlbum};
+    return {item.album, item.year, item.albumId};
+  }
+}
+
+/**
+ * @brief Sorts the tracks by one number, given by track position.
+ *
+ * Years, durations and bitrates span few values, so a counting sort usually
+ * does; positions stay ascending within a value either way.
+ */
+void FacetIndex::_BuildNumber(Number number,
+                              const std::vector<int32> &byTrack) {
+  NumberData &data = fNumbers[number];
+  const size_t count = byTrack.size();
+  data.values.resize(count);
+  data.tracks.resize(count);
+  if (count == 0)
+    return;
+
+  int64 low = INT32_MAX, high = INT32_MIN;
+  for (int32 value : byTrack) {
+    low = std::min<int64>(low, value);
+    high = std::max<int64>(high, value);
+  }
+
+  if (high - low <= (int64)count + 65536) {
+    std::vector<uint32> starts((size_t)(high - low) + 2);
+    for (int32 value : byTrack)
+      starts[(size_t)(value - low) + 1]++;
+    std::partial_sum(starts.begin(), starts.end(), starts.begin());
+    for (size_t t = 0; t < count; t++)
+      data.tracks[starts[(size_t)(byTrack[t] - low)]++] = (uint32)t;
+  } else {
+    std::iota(data.tracks.begin(), data.tracks.end(), 0);
+    std::stable_sort(data.tracks.begin(), data.tracks.end(),
+                     [&byTrack](uint32 a, uint32 b) {
+                       return byTrack[a] < byTrack[b];
+                     });
+  }
+
+  for (size_t i = 0; i < count; i++)
+    data.values[i] = byTrack[data.tracks[i]];
+}
+
+int32 FacetIndex::_NumberOf(Number number, const MediaItem &item) {
+  switch (number) {
+  case kYear:
+    return item.year;
+  case kDuration:
+    return item.duration;
+  case kBitrate:
+  default:
+    return item.bitrate;
+  }
+}
+
+/**
+ * @brief Positions in the sorted values of a number column that lie in the
+ * range; empty if the range is.
+ */
+void FacetIndex::_Range(Number number, int64 low, int64 high, size_t &first,
+                        size_t &end) const {
+  const std::vector<int32> &values = fNumbers[number].values;
+  first = end = 0;
+  if (low > high || low > INT32_MAX || high < INT32_MIN)
+    return;
+
+  const int32 from = (int32)std::max<int64>(low, INT32_MIN);
+  const int32 to = (int32)std::min<int64>(high, INT32_MAX);
+  first = (size_t)(std::lower_bound(values.begin(), values.end(), from) -
+                   values.begin());
+  end = (size_t)(std::upper_bound(values.begin() + first, values.end(), to) -
+                 values.begin());
+}
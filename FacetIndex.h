@@ -0,0 +1,202 @@
+#ifndef FACET_INDEX_H
+#define FACET_INDEX_H
+
+#include "AlbumTable.h"
+#include "HashUtils.h"
+#include "MediaItem.h"
+#include "TextSearch.h"
+
+#include <String.h>
+#include <SupportDefs.h>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class MemoryReport;
+
+/**
+ * @class TrackSet
+ * @brief A set of track positions stored as one bit per track.
+ *
+ * Used to combine posting lists: a selection ORs the postings of its values
+ * into a set, and the sets of the columns are ANDed 64 tracks at a time.
+ */
+class TrackSet {
+public:
+  /**
+   * @param size Number of tracks.
+   * @param all True to start with every track in the set.
+   */
+  explicit TrackSet(size_t size = 0, bool all = false);
+
+  size_t Size() const { return fSize; }
+  void Add(size_t track) { fWords[track / 64] |= uint64_t(1) << (track % 64); }
+  bool Contains(size_t track) const {
+    return (fWords[track / 64] >> (track % 64)) & 1;
+  }
+
+  /** @brief Adds every track of a sorted posting list. */
+  void AddAll(const std::vector<uint32> &postings);
+
+  /** @brief Keeps only the tracks that are also in @p other. */
+  void Intersect(const TrackSet &other);
+
+  size_t Count() const;
+
+  /** @brief Calls @p function with each track in ascending order. */
+  template <typename Function> void ForEach(Function function) const {
+    for (size_t w = 0; w < fWords.size(); w++) {
+      for (uint64_t bits = fWords[w]; bits != 0; bits &= bits - 1)
+        function(w * 64 + (size_t)__builtin_ctzll(bits));
+    }
+  }
+
+private:
+  std::vector<uint64_t> fWords;
+  size_t fSize;
+};
+
+/**
+ * @class FacetIndex
+ * @brief Posting lists of the genre, artist and album values of a track list.
+ *
+ * Every distinct value of a column gets an ID; IDs are ordered like the
+ * values. Albums are told apart by their AlbumTable ID and ordered by name
+ * and year; tracks that are not filed in a table fall back to name and
+ * year. For each value the
+ * index keeps the sorted positions of its tracks, and for each track the
+ * IDs of its values, so a column's counts are one pass over the tracks in
+ * scope.
+ *
+ * Year, duration and bitrate are kept as the tracks sorted by value, so the
+ * tracks in a range are a binary search away. Title, artist and album are
+ * also kept as one TextSearch entry per track.
+ *
+ * The index stores pointers to the tracks; they must stay valid until the
+ * next Build() or Clear().
+ */
+class FacetIndex {
+public:
+  enum Facet { kGenre, kArtist, kAlbum, kFacetCount };
+  enum Number { kYear, kDuration, kBitrate, kNumberCount };
+
+  /** @brief Indexes @p tracks, replacing what was indexed before. */
+  void Build(std::vector<const MediaItem *> tracks);
+  void Clear();
+
+  const std::vector<const MediaItem *> &Tracks() const { return fTracks; }
+  size_t CountTracks() const { return fTracks.size(); }
+
+  /** @name Values */
+  ///@{
+  int32 CountValues(Facet facet) const {
+    return (int32)fFacets[facet].values.size();
+  }
+  const BString &Value(Facet facet, int32 id) const {
+    return fFacets[facet].values[id].value;
+  }
+  /** @brief Year of an album value; 0 for the other columns. */
+  int32 Year(Facet facet, int32 id) const {
+    return fFacets[facet].values[id].year;
+  }
+  /** @brief AlbumTable ID of an album value. */
+  uint32 AlbumId(int32 id) const { return fFacets[kAlbum].values[id].album; }
+
+  /**
+   * @brief Looks up a value; an empty value stands for untagged tracks.
+   *
+   * Of the albums, only the untagged value can be found this way; see
+   * FindAlbum() and FindAlbums().
+   *
+   * @return The value's ID, or -1 if no track has it.
+   */
+  int32 Find(Facet facet, const BString &value) const;
+
+  /** @return The ID of the value for an AlbumTable album, or -1. */
+  int32 FindAlbum(uint32 album) const;
+
+  /**
+   * @brief IDs of all album values with this name, whatever their year
+   * and album artist.
+   * @param[out] first First ID.
+   * @return Number of IDs, which follow each other.
+   */
+  int32 FindAlbums(const BString &name, int32 &first) const;
+  ///@}
+
+  /** @brief Positions of the tracks with this value, ascending. */
+  const std::vector<uint32> &Postings(Facet facet, int32 id) const {
+    return fFacets[facet].postings[id];
+  }
+
+  /** @brief ID of the value of one track. */
+  int32 ValueOf(Facet facet, size_t track) const {
+    return fFacets[facet].trackValues[track];
+  }
+
+  /** @name Number ranges; both bounds are inclusive */
+  ///@{
+  /** @brief Number of tracks with a value in the range. */
+  size_t CountInRange(Number number, int64 low, int64 high) const;
+  /** @brief Adds the tracks with a value in the range to @p set. */
+  void AddRange(Number number, int64 low, int64 high, TrackSet &set) const;
+  ///@}
+
+  /** @brief Title, artist and album of each track, by track position. */
+  const TextSearch &Text() const { return fText; }
+
+  void AccountMemory(MemoryReport &report) const;
+
+private:
+  struct Key {
+    BString value;
+    int32 year;
+    uint32 album; ///< Albums only.
+
+    bool operator==(const Key &other) const {
+      return album == other.album && year == other.year &&
+             value == other.value;
+    }
+    bool operator<(const Key &other) const {
+      if (value != other.value)
+        return value < other.value;
+      if (year != other.year)
+        return year < other.year;
+      return album < other.album;
+    }
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key &key) const {
+      return (BStringHash()(key.value) * 31 + (size_t)key.year) * 31 +
+             key.album;
+    }
+  };
+
+  struct FacetData {
+    std::vector<Key> values; ///< By ID, sorted.
+    std::unordered_map<Key, int32, KeyHash> ids;
+    std::vector<std::vector<uint32>> postings; ///< By ID.
+    std::vector<int32> trackValues;            ///< By track position.
+  };
+
+  struct NumberData {
+    std::vector<int32> values;  ///< Ascending.
+    std::vector<uint32> tracks; ///< Track position of each value.
+  };
+
+  static Key _KeyOf(Facet facet, const MediaItem &item);
+  void _BuildNumber(Number number, const std::vector<int32> &byTrack);
+  static int32 _NumberOf(Number number, const MediaItem &item);
+  void _Range(Number number, int64 low, int64 high, size_t &first,
+              size_t &end) const;
+
+  std::vector<const MediaItem *> fTracks;
+  FacetData fFacets[kFacetCount];
+  NumberData fNumbers[kNumberCount];
+  TextSearch fText;
+  std::unordered_map<uint32, int32> fAlbumValues; ///< Album ID -> value ID.
+};
+
+#endif // FACET_INDEX_H
@@ -0,0 +1,30 @@
+#ifndef HASH_UTILS_H
+#define HASH_UTILS_H
+
+#include <String.h>
+
+#include <functional>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+/**
+ * @struct BStringHash
+ * @brief Hash functor so BString can key unordered containers.
+ */
+struct BStringHash {
+  size_t operator()(const BString &s) const {
+    return std::hash<std::string_view>()(
+        std::string_view(s.String(), (size_t)s.Length()));
+  }
+};
+
+/** @name Hashed BString containers */
+///@{
+using BStringSet = std::unordered_set<BString, BStringHash>;
+
+template <typename T>
+using BStringMap = std::unordered_map<BString, T, BStringHash>;
+///@}
+
+#endif // HASH_UTILS_H
@@ -119,6 +119,10 @@ void InfoPanel::ClearCover() {
     fCoverView->SetBitmap(nullptr);
 }
 
+size_t InfoPanel::CoverBytes() const {
+  return fCoverView ? fCoverView->BitmapBytes() : 0;
+}
+
 void InfoPanel::MessageReceived(BMessage *msg) {
   switch (msg->what) {
   case B_COLORS_UPDATED:
@@ -59,6 +59,11 @@ public:
    */
   void ClearCover();
 
+  /**
+   * @brief Bytes held by the displayed cover.
+   */
+  size_t CoverBytes() const;
+
   void MessageReceived(BMessage *msg) override;
 
 private:
@@ -0,0 +1,417 @@
+#include "LibraryFilter.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+/**
+ * @brief A search term the index can answer, with the number of tracks
+ * that meet it.
+ */
+struct Lookup {
+  const SearchTerm *term;
+  size_t count = 0;
+  FacetIndex::Facet facet = FacetIndex::kFacetCount; ///< Text terms only.
+  std::vector<int32> values; ///< Text terms: IDs of the matching values.
+};
+
+FacetIndex::Number NumberOf(SearchTerm::Field field) {
+  switch (field) {
+  case SearchTerm::kYear:
+    return FacetIndex::kYear;
+  case SearchTerm::kDuration:
+    return FacetIndex::kDuration;
+  default:
+    return FacetIndex::kBitrate;
+  }
+}
+
+/**
+ * @brief Sizes up a positive term on an indexed field.
+ * @return False if the term has to be tested track by track.
+ */
+bool PlanLookup(const FacetIndex &index, const SearchTerm &term,
+                Lookup &lookup) {
+  if (term.negated)
+    return false;
+  lookup.term = &term;
+
+  switch (term.field) {
+  case SearchTerm::kGenre:
+    lookup.facet = FacetIndex::kGenre;
+    break;
+  case SearchTerm::kArtist:
+    lookup.facet = FacetIndex::kArtist;
+    break;
+  case SearchTerm::kAlbum:
+    lookup.facet = FacetIndex::kAlbum;
+    break;
+  case SearchTerm::kYear:
+  case SearchTerm::kDuration:
+  case SearchTerm::kBitrate:
+    break;
+  default:
+    return false;
+  }
+
+  if (term.IsNumber()) {
+    lookup.count =
+        index.CountInRange(NumberOf(term.field), term.low, term.high);
+    return true;
+  }
+
+  // A column has far fewer distinct values than tracks.
+  for (int32 id = 0; id < index.CountValues(lookup.facet); id++) {
+    if (index.Value(lookup.facet, id).IFindFirst(term.text) >= 0) {
+      lookup.values.push_back(id);
+      lookup.count += index.Postings(lookup.facet, id).size();
+    }
+  }
+  return true;
+}
+
+/** A TextSearch over all tracks takes about as long as testing a word on
+ * one track in this many. */
+const size_t kTestTracksPerTextSearch = 32;
+
+} // namespace
+
+void LibraryTotals::Add(const MediaItem &item) {
+  count++;
+  duration += item.duration;
+  size += item.size;
+  genres[item.genre]++;
+  artists[item.artist]++;
+  albums[item.album]++;
+}
+
+void LibraryTotals::Remove(const MediaItem &item) {
+  count--;
+  duration -= item.duration;
+  size -= item.size;
+
+  auto drop = [](BStringMap<int32> &counts, const BString &value) {
+    auto it = counts.find(value);
+    if (it != counts.end() && --it->second <= 0)
+      counts.erase(it);
+  };
+  drop(genres, item.genre);
+  drop(artists, item.artist);
+  drop(albums, item.album);
+}
+
+void LibraryFilter::Apply(const std::vector<const MediaItem *> &source,
+                          const LibraryQuery &query,
+                          LibraryFilterResult &out) {
+  out = LibraryFilterResult();
+  out.items.reserve(source.size());
+  out.positions.reserve(source.size());
+
+  for (size_t position = 0; position < source.size(); position++) {
+    const MediaItem *src = source[position];
+    const MediaItem &it = *src;
+    if (!query.search.Matches(it))
+      continue;
+
+    if (it.genre.IsEmpty())
+      out.untaggedGenre++;
+    else
+      out.genres[it.genre]++;
+
+    if (!query.genre.Matches(it.genre))
+      continue;
+
+    if (it.artist.IsEmpty())
+      out.untaggedArtist++;
+    else
+      out.artists[it.artist]++;
+
+    if (!query.artist.Matches(it.artist))
+      continue;
+
+    if (it.album.IsEmpty())
+      out.untaggedAlbum++;
+    else
+      out.albums[AlbumRef{it.album, it.year, it.albumId}]++;
+
+    if (!query.album.Matches(it.album, it.year, it.albumId))
+      continue;
+
+    out.items.push_back(src);
+    out.positions.push_back((uint32)position);
+    out.totals.Add(it);
+  }
+}
+
+void LibraryFilter::Apply(const FacetIndex &index, const LibraryQuery &query,
+                          LibraryFilterResult &out) {
+  out = LibraryFilterResult();
+  const std::vector<const MediaItem *> &tracks = index.Tracks();
+
+  // Tracks left by the columns so far; empty while that is all of them.
+  std::optional<TrackSet> scope = _Search(index, query.search);
+
+  const FacetIndex::Facet facets[] = {FacetIndex::kGenre, FacetIndex::kArtist,
+                                      FacetIndex::kAlbum};
+  const FacetSelection *selections[] = {&query.genre, &query.artist,
+                                        &query.album};
+  for (int i = 0; i < 3; i++) {
+    _Count(index, facets[i], scope ? &*scope : nullptr, out);
+    if (selections[i]->IsAny())
+      continue;
+
+    TrackSet selected = _Selected(index, facets[i], *selections[i]);
+    if (scope)
+      scope->Intersect(selected);
+    else
+      scope = std::move(selected);
+  }
+
+  if (!scope) {
+    out.items = tracks;
+    out.positions.resize(tracks.size());
+    std::iota(out.positions.begin(), out.positions.end(), 0);
+  } else {
+    const size_t count = scope->Count();
+    out.items.reserve(count);
+    out.positions.reserve(count);
+    scope->ForEach([&](size_t t) {
+      out.items.push_back(tracks[t]);
+      out.positions.push_back((uint32)t);
+    });
+  }
+  _Totals(index, scope ? &*scope : nullptr, out);
+}
+
+/**
+ * @brief The tracks meeting the search, or nothing if that is all of them.
+ *
+ * Index lookups are intersected smallest first. Once a lookup would bring
+ * in many times more tracks than are left, testing the term on those
+ * tracks is cheaper, so it joins the terms that are tested anyway.
+ */
+std::optional<TrackSet> LibraryFilter::_Search(const FacetIndex &index,
+                                               const SearchQuery &search) {
+  const std::vector<const MediaItem *> &tracks = index.Tracks();
+  if (search.IsEmpty())
+    return std::nullopt;
+
+  std::vector<Lookup> lookups;
+  std::vector<const SearchTerm *> tests;
+  for (const SearchTerm &term : search.Terms()) {
+    Lookup lookup;
+    if (PlanLookup(index, term, lookup))
+      lookups.push_back(std::move(lookup));
+    else
+      tests.push_back(&term);
+  }
+  std::stable_sort(lookups.begin(), lookups.end(),
+                   [](const Lookup &a, const Lookup &b) {
+                     return a.count < b.count;
+                   });
+
+  std::optional<TrackSet> scope;
+  size_t left = tracks.size();
+  for (const Lookup &lookup : lookups) {
+    if (scope && lookup.count / 8 > left) {
+      tests.push_back(lookup.term);
+      continue;
+    }
+
+    TrackSet found(tracks.size());
+    if (lookup.term->IsNumber()) {
+      index.AddRange(NumberOf(lookup.term->field), lookup.term->low,
+                     lookup.term->high, found);
+    } else {
+      for (int32 id : lookup.values)
+        found.AddAll(index.Postings(lookup.facet, id));
+    }
+
+    if (scope)
+      scope->Intersect(found);
+    else
+      scope = std::move(found);
+    left = scope->Count();
+  }
+
+  // Free words are found in the folded text of all tracks, unless so few
+  // tracks are left that testing them is cheaper.
+  for (auto it = tests.begin(); it != tests.end();) {
+    const SearchTerm *term = *it;
+    if (term->field != SearchTerm::kAny || term->negated ||
+        left < tracks.size() / kTestTracksPerTextSearch) {
+      ++it;
+      continue;
+    }
+
+    std::vector<uint32> matches;
+    index.Text().Find(term->text, matches);
+    TrackSet found(tracks.size());
+    found.AddAll(matches);
+    if (scope)
+      scope->Intersect(found);
+    else
+      scope = std::move(found);
+    left = scope->Count();
+    it = tests.erase(it);
+  }
+
+  if (tests.empty())
+    return scope;
+
+  std::stable_sort(tests.begin(), tests.end(),
+                   [](const SearchTerm *a, const SearchTerm *b) {
+                     return a->Cost() < b->Cost();
+                   });
+  auto passes = [&tests](const MediaItem &item) {
+    for (const SearchTerm *term : tests) {
+      if (!term->Matches(item))
+        return false;
+    }
+    return true;
+  };
+
+  TrackSet tested(tracks.size());
+  if (scope) {
+    scope->ForEach([&](size_t t) {
+      if (passes(*tracks[t]))
+        tested.Add(t);
+    });
+  } else {
+    for (size_t t = 0; t < tracks.size(); t++) {
+      if (passes(*tracks[t]))
+        tested.Add(t);
+    }
+  }
+  return tested;
+}
+
+/**
+ * @brief Number of tracks in @p scope per value of a column; a null scope
+ * stands for all tracks.
+ */
+std::vector<int32> LibraryFilter::_ValueCounts(const FacetIndex &index,
+                                               FacetIndex::Facet facet,
+                                               const TrackSet *scope) {
+  const int32 values = index.CountValues(facet);
+  std::vector<int32> counts(values);
+  if (scope) {
+    scope->ForEach([&](size_t t) { counts[index.ValueOf(facet, t)]++; });
+  } else {
+    for (int32 id = 0; id < values; id++)
+      counts[id] = (int32)index.Postings(facet, id).size();
+  }
+  return counts;
+}
+
+/**
+ * @brief Fills the totals of the result. The per-value counts come from the
+ * index, which saves a hash update per track and column.
+ */
+void LibraryFilter::_Totals(const FacetIndex &index, const TrackSet *scope,
+                            LibraryFilterResult &out) {
+  LibraryTotals &totals = out.totals;
+  totals.count = (int32)out.items.size();
+  for (const MediaItem *item : out.items) {
+    totals.duration += item->duration;
+    totals.size += item->size;
+  }
+
+  const FacetIndex::Facet facets[] = {FacetIndex::kGenre, FacetIndex::kArtist,
+                                      FacetIndex::kAlbum};
+  BStringMap<int32> *maps[] = {&totals.genres, &totals.artists,
+                               &totals.albums};
+  for (int i = 0; i < 3; i++) {
+    const std::vector<int32> counts = _ValueCounts(index, facets[i], scope);
+    for (int32 id = 0; id < (int32)counts.size(); id++) {
+      // Albums of several years add up under their name.
+      if (counts[id] > 0)
+        (*maps[i])[index.Value(facets[i], id)] += counts[id];
+    }
+  }
+}
+
+/**
+ * @brief The tracks matching one column's selection, as a union of the
+ * postings of the selected values.
+ */
+TrackSet LibraryFilter::_Selected(const FacetIndex &index,
+                                  FacetIndex::Facet facet,
+                                  const FacetSelection &selection) {
+  TrackSet selected(index.CountTracks());
+  if (selection.untagged) {
+    const int32 id = index.Find(facet, "");
+    if (id >= 0)
+      selected.AddAll(index.Postings(facet, id));
+  }
+
+  for (const FacetValue &v : selection.values) {
+    if (facet == FacetIndex::kAlbum && v.album != AlbumTable::kNoAlbum) {
+      const int32 id = index.FindAlbum(v.album);
+      if (id >= 0)
+        selected.AddAll(index.Postings(facet, id));
+      continue;
+    }
+    if (v.value.IsEmpty())
+      continue;
+
+    if (facet == FacetIndex::kAlbum) {
+      int32 first = 0;
+      const int32 count = index.FindAlbums(v.value, first);
+      for (int32 id = first; id < first + count; id++) {
+        if (v.year < 0 || index.Year(facet, id) == v.year)
+          selected.AddAll(index.Postings(facet, id));
+      }
+    } else {
+      const int32 id = index.Find(facet, v.value);
+      if (id >= 0)
+        selected.AddAll(index.Postings(facet, id));
+    }
+  }
+  return selected;
+}
+
+/**
+ * @brief Adds a column's values and their track counts within @p scope to
+ * @p out; a null scope stands for all tracks.
+ */
+void LibraryFilter::_Count(const FacetIndex &index, FacetIndex::Facet facet,
+                           const TrackSet *scope, LibraryFilterResult &out) {
+  const int32 values = index.CountValues(facet);
+  const std::vector<int32> counts = _ValueCounts(index, facet, scope);
+
+  std::map<BString, int32> *named = nullptr;
+  int32 *untagged = nullptr;
+  switch (facet) {
+  case FacetIndex::kGenre:
+    named = &out.genres;
+    untagged = &out.untaggedGenre;
+    break;
+  case FacetIndex::kArtist:
+    named = &out.artists;
+    untagged = &out.untaggedArtist;
+    break;
+  default:
+    untagged = &out.untaggedAlbum;
+    break;
+  }
+
+  // IDs are in value order, so every value is appended at the end.
+  for (int32 id = 0; id < values; id++) {
+    if (counts[id] == 0)
+      continue;
+
+    const BString &value = index.Value(facet, id);
+    if (value.IsEmpty()) {
+      *untagged = counts[id];
+    } else if (named) {
+      named->emplace_hint(named->end(), value, counts[id]);
+    } else {
+      out.albums.emplace_hint(
+          out.albums.end(),
+          AlbumRef{value, index.Year(facet, id), index.AlbumId(id)},
+          counts[id]);
+    }
+  }
+}
@@ -0,0 +1,163 @@
+#ifndef LIBRARY_FILTER_H
+#define LIBRARY_FILTER_H
+
+#include "AlbumTable.h"
+#include "FacetIndex.h"
+#include "HashUtils.h"
+#include "MediaItem.h"
+#include "SearchQuery.h"
+
+#include <String.h>
+#include <SupportDefs.h>
+
+#include <map>
+#include <optional>
+#include <vector>
+
+/**
+ * @struct FacetValue
+ * @brief One selected value of a browser column.
+ */
+struct FacetValue {
+  BString value;
+  int32 year = -1; ///< Albums only: required year, or -1 for any.
+  /** Albums only: the album's AlbumTable ID, which then decides alone; 0 to
+   * match by name and year. */
+  uint32 album = AlbumTable::kNoAlbum;
+};
+
+/**
+ * @struct FacetSelection
+ * @brief The selected entries of one browser column.
+ *
+ * A track matches if it matches any of them. With nothing selected, or
+ * "Show all", every track matches.
+ */
+struct FacetSelection {
+  bool untagged = false;          ///< Tracks with an empty field.
+  std::vector<FacetValue> values; ///< Tracks whose field equals one of these.
+
+  bool IsAny() const { return !untagged && values.empty(); }
+
+  bool Matches(const BString &field, int32 itemYear = 0,
+               uint32 itemAlbum = AlbumTable::kNoAlbum) const {
+    if (IsAny())
+      return true;
+    if (field.IsEmpty())
+      return untagged;
+    for (const FacetValue &v : values) {
+      if (v.album != AlbumTable::kNoAlbum) {
+        if (itemAlbum == v.album)
+          return true;
+      } else if (field == v.value && (v.year < 0 || itemYear == v.year)) {
+        return true;
+      }
+    }
+    return false;
+  }
+};
+
+/**
+ * @struct LibraryQuery
+ * @brief Column selections and search narrowing the browser.
+ */
+struct LibraryQuery {
+  FacetSelection genre;
+  FacetSelection artist;
+  FacetSelection album;
+  SearchQuery search; ///< The search field, parsed.
+};
+
+/**
+ * @struct LibraryTotals
+ * @brief Running totals over a set of tracks.
+ *
+ * Updated as tracks enter and leave the set, so showing them never needs a
+ * pass over the tracks.
+ */
+struct LibraryTotals {
+  int32 count = 0;
+  int64 duration = 0; ///< Seconds.
+  int64 size = 0;     ///< Bytes.
+
+  /** @name Tracks per column value; untagged tracks count under "" */
+  ///@{
+  BStringMap<int32> genres;
+  BStringMap<int32> artists;
+  BStringMap<int32> albums;
+  ///@}
+
+  void Add(const MediaItem &item);
+  void Remove(const MediaItem &item);
+};
+
+/**
+ * @struct LibraryFilterResult
+ * @brief What the browser columns and the track list show for a query.
+ *
+ * Each column lists the values left by the columns before it: genres are
+ * narrowed by the search only, artists also by the genre, and albums
+ * also by the artist. Every value comes with the number of these tracks
+ * that have it.
+ */
+struct LibraryFilterResult {
+  std::map<BString, int32> genres; ///< Genre -> tracks.
+  int32 untaggedGenre = 0;
+
+  std::map<BString, int32> artists; ///< Artist -> tracks.
+  int32 untaggedArtist = 0;
+
+  std::map<AlbumRef, int32> albums; ///< Album -> tracks.
+  int32 untaggedAlbum = 0;
+
+  std::vector<const MediaItem *> items; ///< Matching tracks in source order.
+  /** Position of each of @ref items in the source, which tells apart the
+   * entries of a track that a playlist lists twice. */
+  std::vector<uint32> positions;
+  LibraryTotals totals;                 ///< Totals over @ref items.
+};
+
+/**
+ * @class LibraryFilter
+ * @brief The column browser's filtering, without any views.
+ */
+class LibraryFilter {
+public:
+  /**
+   * @brief Evaluates a query over the tracks in scope.
+   * @param source Tracks of the library or the active playlist.
+   * @param query Column selections and search text.
+   * @param out Receives the column contents and the matching tracks.
+   */
+  static void Apply(const std::vector<const MediaItem *> &source,
+                    const LibraryQuery &query, LibraryFilterResult &out);
+
+  /**
+   * @brief Evaluates a query from the posting lists of @p index.
+   *
+   * Gives the same result as a scan of the indexed tracks. Search terms on
+   * genre, artist, album, year, duration and bitrate are looked up, most
+   * selective first. Free words are found in the index's TextSearch while
+   * many tracks are left; the other terms are only tested on the tracks
+   * the lookups leave. The selections are unions of postings, intersected
+   * a word at a time, and the counts are a pass over the tracks left in
+   * each column's scope.
+   */
+  static void Apply(const FacetIndex &index, const LibraryQuery &query,
+                    LibraryFilterResult &out);
+
+private:
+  static std::optional<TrackSet> _Search(const FacetIndex &index,
+                                         const SearchQuery &search);
+  static TrackSet _Selected(const FacetIndex &index, FacetIndex::Facet facet,
+                            const FacetSelection &selection);
+  static void _Count(const FacetIndex &index, FacetIndex::Facet facet,
+                     const TrackSet *scope, LibraryFilterResult &out);
+  static void _Totals(const FacetIndex &index, const TrackSet *scope,
+                      LibraryFilterResult &out);
+  static std::vector<int32> _ValueCounts(const FacetIndex &index,
+                                         FacetIndex::Facet facet,
+                                         const TrackSet *scope);
+};
+
+#endif // LIBRARY_FILTER_H
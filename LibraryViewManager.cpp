@@ -1,9 +1,13 @@
 #include "LibraryViewManager.h"
 #include "ContentColumnView.h"
 #include "Debug.h"
+#include "LibraryFilter.h"
 #include "MediaItem.h"
+#include "MemoryReport.h"
 #include "Messages.h"
 #include "SimpleColumnView.h"
+#include "Trace.h"
+#include "UIWorkQueue.h"
 #include <ColumnListView.h>
 #include <ColumnTypes.h>
 #include <Entry.h>
@@ -13,6 +17,9 @@
 #include <Window.h>
 #include <algorithm>
 #include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <memory>
 #include <set>
 
 #include <Catalog.h>
@@ -25,6 +32,110 @@ static const BString kLabelNoGenre = B_TRANSLATE("No Genre");
 static const BString kLabelNoArtist = B_TRANSLATE("No Artist");
 static const BString kLabelNoAlbum = B_TRANSLATE("No Album");
 
+namespace {
+
+/** New contents of the browser columns, applied one column at a time. */
+struct FacetUpdate {
+  std::vector<SimpleItem> genres;
+  std::vector<SimpleItem> artists;
+  std::vector<SimpleItem> albums;
+  BString selGenre;
+  BString selArtist;
+  BString selAlbum;
+  BString selAlbumData;
+  int32 next = 0; ///< Index of the next column to update.
+};
+
+const char *kFacetsJob = "browser columns";
+
+SimpleItem CountedItem(const BString &text, int32 count,
+                       const BString &data = "") {
+  SimpleItem item;
+  item.text = text;
+  item.path = data;
+  item.count = count;
+  return item;
+}
+
+/**
+ * @brief The texts of the selected entries, to tell whether the selection
+ * of a column changed.
+ */
+BString SelectionKey(SimpleColumnView *view) {
+  BString key;
+  for (int32 index : view->Selection())
+    key << view->ItemAt(index) << "\n";
+  return key;
+}
+
+/**
+ * @brief Translates the selected entries of a column into a query.
+ *
+ * "Show all" among them selects everything.
+ */
+FacetSelection SelectionOf(SimpleColumnView *view,
+                           const BString &untaggedLabel) {
+  FacetSelection facet;
+  for (int32 index : view->Selection()) {
+    const BString &text = view->ItemAt(index);
+    if (text == kLabelAll)
+      return FacetSelection();
+    if (text == untaggedLabel) {
+      facet.untagged = true;
+      continue;
+    }
+
+    FacetValue value;
+    value.value = text;
+    // The album column's hidden data is the album ID. Entries added while
+    // scanning have none and match by name.
+    const BString &data = view->PathAt(index);
+    if (!data.IsEmpty())
+      value.album = (uint32)strtoul(data.String(), nullptr, 10);
+    facet.values.push_back(value);
+  }
+  return facet;
+}
+
+/**
+ * @brief Replaces the items of a browser column, keeping its selection.
+ *
+ * The view keeps the selected item if its text is still listed. Otherwise
+ * the selection is looked up again by its data, then by its text.
+ */
+void UpdateFacetView(SimpleColumnView *view, std::vector<SimpleItem> newItems,
+                     const BString &currentSelText,
+                     const BString &currentSelData) {
+  if (!view->SetItems(std::move(newItems)))
+    return;
+
+  // Restore Selection
+  if (view->CurrentSelection() >= 0 || currentSelText.IsEmpty())
+    return;
+
+  // Try matching by data first (more precise)
+  if (!currentSelData.IsEmpty()) {
+    for (int32 i = 0; i < view->CountItems(); i++) {
+      if (view->PathAt(i) == currentSelData) {
+        view->Select(i);
+        view->ScrollToSelection();
+        return;
+      }
+    }
+  }
+
+  // Fallback to text match
+  for (int32 i = 0; i < view->CountItems(); i++) {
+    if (view->ItemAt(i) == currentSelText) {
+      view->Select(i);
+      view->ScrollToSelection();
+      return;
+    }
+  }
+}
+
+} // namespace
+
 /**
  * @brief Constructs the LibraryViewManager.
  *
@@ -44,14 +155,17 @@ LibraryViewManager::LibraryViewManager(BMessenger target) : fTarget(target) {
   fGenreView = new SimpleColumnView("genre");
   fGenreView->SetSelectionMessage(MSG_SELECTION_CHANGED_GENRE);
   fGenreView->SetTarget(fTarget);
+  fGenreView->SetMultipleSelection(true);
 
   fArtistView = new SimpleColumnView("artist");
   fArtistView->SetSelectionMessage(MSG_SELECTION_CHANGED_ARTIST);
   fArtistView->SetTarget(fTarget);
+  fArtistView->SetMultipleSelection(true);
 
   fAlbumView = new SimpleColumnView("album");
   fAlbumView->SetSelectionMessage(MSG_SELECTION_CHANGED_ALBUM);
   fAlbumView->SetTarget(fTarget);
+  fAlbumView->SetMultipleSelection(true);
 
   fContentView = new ContentColumnView("content");
 }
@@ -68,12 +182,54 @@ ContentColumnView *LibraryViewManager::ContentView() const {
   return fContentView;
 }
 
+void LibraryViewManager::SetWorkQueue(UIWorkQueue *queue) {
+  fWorkQueue = queue;
+  fContentView->SetWorkQueue(queue);
+}
+
 const std::vector<BString> &LibraryViewManager::ActivePaths() const {
   return fActivePaths;
 }
 
 void LibraryViewManager::SetActivePaths(const std::vector<BString> &paths) {
   fActivePaths = paths;
+  fActiveSet.clear();
+  fActiveSet.reserve(paths.size());
+  fActiveSet.insert(paths.begin(), paths.end());
+  fIndexStale = true;
+}
+
+void LibraryViewManager::SetActiveEntries(
+    const std::vector<PlaylistEntry> &entries) {
+  std::vector<BString> paths;
+  paths.reserve(entries.size());
+  fActiveInfo.clear();
+  fMissingPaths.clear();
+  for (const auto &e : entries) {
+    paths.push_back(e.path);
+    if (!e.title.IsEmpty() || e.duration >= 0)
+      fActiveInfo[e.path] = e;
+  }
+  SetActivePaths(paths);
+}
+
+void LibraryViewManager::SetMissingPaths(const std::vector<BString> &paths) {
+  fMissingPaths.clear();
+  fMissingPaths.insert(paths.begin(), paths.end());
+  fIndexStale = true;
+}
+
+void LibraryViewManager::MoveActivePath(int32 fromIndex, int32 toIndex) {
+  const int32 count = (int32)fActivePaths.size();
+  if (fromIndex < 0 || fromIndex >= count || toIndex < 0 || toIndex >= count)
+    return;
+
+  auto first = fActivePaths.begin();
+  if (fromIndex < toIndex)
+    std::rotate(first + fromIndex, first + fromIndex + 1, first + toIndex + 1);
+  else
+    std::rotate(first + toIndex, first + fromIndex, first + fromIndex + 1);
+  fIndexStale = true;
 }
 
 BString LibraryViewManager::SelectedText(SimpleColumnView *v) {
@@ -100,11 +256,50 @@ BString LibraryViewManager::SelectedData(SimpleColumnView *v) {
  * @brief Resets all filters and clears the content view.
  */
 void LibraryViewManager::ResetFilters() {
+  if (fWorkQueue)
+    fWorkQueue->Cancel(kFacetsJob);
   fGenreView->Clear();
   fArtistView->Clear();
   fAlbumView->Clear();
-  fContentView->ClearEntries();
+  ClearContent();
   fActivePaths.clear();
+  fActiveSet.clear();
+  fActiveInfo.clear();
+  fMissingPaths.clear();
+  fIndexStale = true;
+}
+
+void LibraryViewManager::ClearContent() {
+  fContentView->ClearEntries();
+  fTotals = LibraryTotals();
+}
+
+/**
+ * @brief Removes the track list rows of @p path, if there are any.
+ */
+bool LibraryViewManager::RemoveEntry(const BString &path) {
+  const MediaItem *mi = fContentView->FindItem(path);
+  if (!mi)
+    return false;
+
+  const MediaItem removed = *mi;
+  const int32 count = fContentView->RemovePath(path);
+  for (int32 i = 0; i < count; i++)
+    fTotals.Remove(removed);
+  return true;
+}
+
+int32 LibraryViewManager::RemoveSelectedRows(std::vector<BString> &outPaths,
+                                             std::vector<int32> &outPositions) {
+  std::vector<MediaItem> removed;
+  const int32 count = fContentView->RemoveSelectedRows(removed, outPositions);
+
+  outPaths.reserve(outPaths.size() + removed.size());
+  for (const MediaItem &mi : removed) {
+    fTotals.Remove(mi);
+    outPaths.push_back(mi.path);
+  }
+  return count;
 }
 
 /**
@@ -113,20 +308,93 @@ void LibraryViewManager::ResetFilters() {
  */
 bool LibraryViewManager::IsPathAllowed(const BString &filePath,
                                        bool isLibraryMode) const {
-  return _PathAllowedByMode(filePath, isLibraryMode, fActivePaths);
+  return _PathAllowedByMode(filePath, isLibraryMode);
+}
+
+void LibraryViewManager::AccountMemory(MemoryReport &report) const {
+  fGenreView->AccountMemory(report, "Genre column");
+  fArtistView->AccountMemory(report, "Artist column");
+  fAlbumView->AccountMemory(report, "Album column");
+  fContentView->AccountMemory(report);
+  fIndex.AccountMemory(report);
+
+  if (fActivePaths.empty() && fActiveInfo.empty())
+    return;
+
+  size_t bytes = report.Strings(fActivePaths) + report.Strings(fActiveSet) +
+                 report.Strings(fMissingPaths) +
+                 fActiveInfo.bucket_count() * MemoryReport::kHashBucket;
+  for (const auto &[path, entry] : fActiveInfo) {
+    bytes += MemoryReport::kHashNode + MemoryReport::kAllocation +
+             sizeof(BString) + sizeof(PlaylistEntry) + report.String(path) +
+             report.String(entry.path) + report.String(entry.artist) +
+             report.String(entry.title);
+  }
+  report.Add(MEMORY_PLAYLISTS, "Active playlist", fActivePaths.size(), bytes);
 }
 
-bool LibraryViewManager::_PathAllowedByMode(
-    const BString &filePath, bool isLibraryMode,
-    const std::vector<BString> &activePaths) const {
+void LibraryViewManager::_UpdateIndex(const MediaLibrary &library,
+                                      bool isLibraryMode) {
+  if (!fIndexStale && fIndexedLibrary == &library &&
+      fIndexedGeneration == library.Generation() &&
+      fIndexedLibraryMode == isLibraryMode)
+    return;
+
+  TRACE_SPAN("library", "BuildFacetIndex");
+  fIndex.Clear();
+  fPlaceholders.clear();
+
+  std::vector<const MediaItem *> sourceItems;
+
+  if (isLibraryMode) {
+    sourceItems.reserve(library.Count());
+    for (const auto &mi : library)
+      sourceItems.push_back(&mi);
+  } else {
+    // Reserve up front so pointers into the placeholders stay valid.
+    fPlaceholders.reserve(fActivePaths.size());
+    sourceItems.reserve(fActivePaths.size());
+    for (const auto &p : fActivePaths) {
+      if (const MediaItem *known = library.Find(p)) {
+        sourceItems.push_back(known);
+      } else {
+        // Label tracks the library does not know from the playlist itself.
+        // Whether the file exists is checked in the background.
+        MediaItem mi;
+        mi.path = p;
+
+        auto info = fActiveInfo.find(p);
+        if (info != fActiveInfo.end()) {
+          mi.artist = info->second.artist;
+          mi.title = info->second.title;
+          if (info->second.duration > 0)
+            mi.duration = info->second.duration;
+        }
+        if (mi.title.IsEmpty()) {
+          int32 slash = p.FindLast('/');
+          mi.title = slash >= 0 ? p.String() + slash + 1 : p.String();
+        }
+
+        mi.missing = fMissingPaths.count(p) > 0;
+        fPlaceholders.push_back(mi);
+        sourceItems.push_back(&fPlaceholders.back());
+      }
+    }
+  }
+
+  fIndex.Build(std::move(sourceItems));
+  fIndexedLibrary = &library;
+  fIndexedGeneration = library.Generation();
+  fIndexedLibraryMode = isLibraryMode;
+  fIndexStale = false;
+}
+
+bool LibraryViewManager::_PathAllowedByMode(const BString &filePath,
+                                            bool isLibraryMode) const {
   if (isLibraryMode)
     return true;
 
-  for (const auto &p : activePaths) {
-    if (p == filePath)
-      return true;
-  }
-  return false;
+  return fActiveSet.count(filePath) > 0;
 }
 
 /**
@@ -137,362 +405,165 @@ bool LibraryViewManager::_PathAllowedByMode(
  * haven't changed.
  *
  * Filtering Process:
- * 1. Filter Source Items based on Library/Playlist Mode.
- * 2. Build Filter Sets (Genre, Artist, Album -> Years).
- * 3. Populate Filter Lists (Genre, Artist, Album).
- * 4. Build Final Content List.
+ * 1. Index the tracks in scope (library or playlist), if they changed.
+ * 2. Translate the column selections into a query.
+ * 3. Evaluate it on the index: column values with counts and
+ * 4. the final content list.
  * 5. Notify Target (Main Window) about totals.
  * 6. Update Content View.
  * 7. Prepare Display Items (handling "Alles anzeigen", "Kein..." and
  * Disambiguation).
  * 8. Smart Update of List Views.
  *
- * @param allItems The full database of media items.
+ * @param library The full database of media items.
  * @param isLibraryMode True if showing full library, False if showing a
  * specific playlist (ActivePaths).
  * @param currentPlaylist Name of the current playlist (for UI if needed).
  * @param filterText Search filter text.
  */
 void LibraryViewManager::UpdateFilteredViews(
-    const std::vector<MediaItem> &allItems, bool isLibraryMode,
+    const MediaLibrary &library, bool isLibraryMode,
     const BString &currentPlaylist, const BString &filterText) {
-
-  BString selGenre = SelectedText(fGenreView);
-  BString selArtist = SelectedText(fArtistView);
-  BString selAlbum = SelectedText(fAlbumView);
+  TRACE_SPAN("library", "UpdateFilteredViews");
 
   // Reset downstream selections if upstream selection changed
-  if (selGenre != fLastSelectedGenre) {
-    selArtist = "";
-    selAlbum = "";
-  } else if (selArtist != fLastSelectedArtist) {
-    selAlbum = "";
+  const BString genreKey = SelectionKey(fGenreView);
+  if (genreKey != fLastSelectedGenre) {
+    fArtistView->DeselectAll();
+    fAlbumView->DeselectAll();
+  } else if (SelectionKey(fArtistView) != fLastSelectedArtist) {
+    fAlbumView->DeselectAll();
   }
 
-  fLastSelectedGenre = selGenre;
-  fLastSelectedArtist = selArtist;
+  fLastSelectedGenre = genreKey;
+  fLastSelectedArtist = SelectionKey(fArtistView);
 
-  // 1. Filter Source Items based on Library/Playlist Mode
-  std::vector<MediaItem> sourceItems;
+  // 1. Index the tracks in scope, if they changed
+  _UpdateIndex(library, isLibraryMode);
 
-  if (isLibraryMode) {
-    sourceItems = allItems;
-  } else {
-    sourceItems.reserve(fActivePaths.size());
-    for (const auto &p : fActivePaths) {
-      auto it = std::find_if(allItems.begin(), allItems.end(),
-                             [&](const MediaItem &mi) { return mi.path == p; });
-      if (it != allItems.end()) {
-        sourceItems.push_back(*it);
-      } else {
-        // Create dummy item for missing files in playlist
-        MediaItem mi;
-        mi.path = p;
-
-        BPath bp(p.String());
-        mi.title = bp.Leaf() ? bp.Leaf() : p.String();
-
-        BEntry e(bp.Path());
-        mi.missing = !e.Exists();
-        sourceItems.push_back(mi);
-      }
-    }
-  }
-
-  fContentView->ClearEntries();
-
-  // 2. Build Filter Sets
-  std::set<BString> allGenres;
-  bool hasUntaggedGenreSrc = false;
-
-  std::set<BString> artistsForGenre;
-  bool hasUntaggedArtistForGenre = false;
-
-  // Map AlbumName -> Set of Years (for disambiguation)
-  std::map<BString, std::set<int32>> albumsForGA;
-  bool hasUntaggedAlbumForGA = false;
-
-  // -- Filter Lambdas --
-
-  auto genreOK = [&](const MediaItem &i) {
-    if (selGenre.IsEmpty() || selGenre == kLabelAll)
-      return true;
-    if (selGenre == kLabelNoGenre)
-      return i.genre.IsEmpty();
-    return i.genre == selGenre;
-  };
-
-  auto artistOK = [&](const MediaItem &i) {
-    if (selArtist.IsEmpty() || selArtist == kLabelAll)
-      return true;
-    if (selArtist == kLabelNoArtist)
-      return i.artist.IsEmpty();
-    return i.artist == selArtist;
-  };
+  ClearContent();
 
-  BString selAlbumData = SelectedData(fAlbumView);
+  // 2. Translate the column selections into a query
+  LibraryQuery query;
+  query.genre = SelectionOf(fGenreView, kLabelNoGenre);
+  query.artist = SelectionOf(fArtistView, kLabelNoArtist);
+  query.album = SelectionOf(fAlbumView, kLabelNoAlbum);
+  query.search.Parse(filterText);
 
-  auto albumOK = [&](const MediaItem &i) {
-    if (selAlbum.IsEmpty() || selAlbum == kLabelAll)
-      return true;
-    if (selAlbum == kLabelNoAlbum)
-      return i.album.IsEmpty();
+  // 3. Column values with counts and 4. Build Final Content List
+  LibraryFilterResult result;
+  LibraryFilter::Apply(fIndex, query, result);
 
-    // Check for Year disambiguation in hidden data column
-    if (!selAlbumData.IsEmpty()) {
-      int32 sep = selAlbumData.FindLast("|");
-      if (sep > 0) {
-        BString yearStr = selAlbumData.String() + sep + 1;
-        int32 targetYear = atoi(yearStr.String());
-
-        BString targetName;
-        selAlbumData.CopyInto(targetName, 0, sep);
-
-        if (i.album != targetName)
-          return false;
-        if (i.year != targetYear)
-          return false;
-
-        return true;
-      }
-    }
-
-    // Standard album name match
-    if (i.album != selAlbum)
-      return false;
-
-    return true;
-  };
-
-  auto textOK = [&](const MediaItem &i) {
-    if (filterText.IsEmpty())
-      return true;
-    if (i.title.IFindFirst(filterText) >= 0)
-      return true;
-    if (i.artist.IFindFirst(filterText) >= 0)
-      return true;
-    if (i.album.IFindFirst(filterText) >= 0)
-      return true;
-    return false;
-  };
-
-  // 3. Populate Filter Lists (Genre, Artist, Album)
-  for (const auto &it : sourceItems) {
-    if (!textOK(it))
-      continue;
-
-    if (it.genre.IsEmpty())
-      hasUntaggedGenreSrc = true;
-    else
-      allGenres.insert(it.genre);
-
-    if (genreOK(it)) {
-      if (it.artist.IsEmpty())
-        hasUntaggedArtistForGenre = true;
-      else
-        artistsForGenre.insert(it.artist);
-
-      if (artistOK(it)) {
-        if (it.album.IsEmpty())
-          hasUntaggedAlbumForGA = true;
-        else {
-          albumsForGA[it.album].insert(it.year);
-        }
-      }
-    }
-  }
-
-  // 4. Build Final Content List
   std::vector<MediaItem> finalItems;
-  finalItems.reserve(sourceItems.size());
-
-  for (const auto &it : sourceItems) {
-    if (!(genreOK(it) && artistOK(it) && albumOK(it)))
-      continue;
-    if (!textOK(it))
-      continue;
-    finalItems.push_back(it);
-  }
+  finalItems.reserve(result.items.size());
+  for (const MediaItem *it : result.items)
+    finalItems.push_back(*it);
+  fTotals = std::move(result.totals);
 
   // 5. Notify Target (Main Window) about totals
-  int32 totalCount = finalItems.size();
-  int64 totalDuration = 0;
-  for (const auto &it : finalItems) {
-    totalDuration += it.duration;
-  }
-
   if (fTarget.IsValid()) {
     BMessage previewMsg(MSG_LIBRARY_PREVIEW);
-    previewMsg.AddInt32("count", totalCount);
-    previewMsg.AddInt64("duration", totalDuration);
+    previewMsg.AddInt32("count", fTotals.count);
+    previewMsg.AddInt64("duration", fTotals.duration);
     fTarget.SendMessage(&previewMsg);
   }
 
   // 6. Update Content View
-  fContentView->AddEntries(finalItems);
+  fContentView->AddEntries(std::move(finalItems),
+                           std::move(result.positions));
 
   // 7. Prepare Display Items (handling "All", "No...", and
   // Disambiguation)
-  struct DisplayItem {
-    BString text;
-    BString data; // Hidden data (e.g. "AlbumName|2023")
+  auto facets = std::make_shared<FacetUpdate>();
+  facets->selGenre = SelectedText(fGenreView);
+  facets->selArtist = SelectedText(fArtistView);
+  facets->selAlbum = SelectedText(fAlbumView);
+  facets->selAlbumData = SelectedData(fAlbumView);
+
+  // "Show all" counts every track the column lists.
+  auto addValues = [](std::vector<SimpleItem> &items,
+                      const std::map<BString, int32> &values,
+                      int32 untagged, const BString &untaggedLabel) {
+    int32 total = untagged;
+    for (const auto &[value, count] : values)
+      total += count;
+
+    items.reserve(values.size() + 2);
+    items.push_back(CountedItem(kLabelAll, total));
+    if (untagged > 0)
+      items.push_back(CountedItem(untaggedLabel, untagged));
+    for (const auto &[value, count] : values)
+      items.push_back(CountedItem(value, count));
   };
+  addValues(facets->genres, result.genres, result.untaggedGenre,
+            kLabelNoGenre);
+  addValues(facets->artists, result.artists, result.untaggedArtist,
+            kLabelNoArtist);
+
+  std::vector<SimpleItem> &albumDisplayItems = facets->albums;
+  int32 albumTotal = result.untaggedAlbum;
+  for (const auto &[album, count] : result.albums)
+    albumTotal += count;
+  albumDisplayItems.push_back(CountedItem(kLabelAll, albumTotal));
+  if (result.untaggedAlbum > 0) {
+    albumDisplayItems.push_back(
+        CountedItem(kLabelNoAlbum, result.untaggedAlbum));
+  }
 
-  std::vector<BString> genreItems;
-  genreItems.push_back(kLabelAll);
-  if (hasUntaggedGenreSrc)
-    genreItems.push_back(kLabelNoGenre);
-  for (const auto &g : allGenres)
-    genreItems.push_back(g);
-
-  std::vector<BString> artistItems;
-  artistItems.push_back(kLabelAll);
-  if (hasUntaggedArtistForGenre)
-    artistItems.push_back(kLabelNoArtist);
-  for (const auto &a : artistsForGenre)
-    artistItems.push_back(a);
-
-  std::vector<DisplayItem> albumDisplayItems;
-  albumDisplayItems.push_back({kLabelAll, ""});
-  if (hasUntaggedAlbumForGA)
-    albumDisplayItems.push_back({kLabelNoAlbum, ""});
-
-  for (auto &[name, years] : albumsForGA) {
-    if (years.empty())
-      continue;
-
-    std::vector<int32> sortedYears(years.begin(), years.end());
-    std::sort(sortedYears.begin(),
-              sortedYears.end()); // Ensure years are sorted
-
-    if (sortedYears.size() == 1) {
-      // Single year, no visual disambiguation needed, but store data just in
-      // case
-      int32 y = sortedYears[0];
-      BString data = name;
-      data << "|" << y;
-      albumDisplayItems.push_back({name, data});
-    } else {
-      // Multiple years for same album name -> Disambiguate
-      for (int32 y : sortedYears) {
-        BString displayName = name;
-        if (y > 0) {
-          displayName << " [" << y << "]";
-        } else {
-          displayName << " [?]";
-        }
-
-        BString data = name;
-        data << "|" << y;
-        albumDisplayItems.push_back({displayName, data});
+  // Albums come sorted by name, then year; equally named ones follow each
+  // other and are told apart by album artist and year.
+  const AlbumTable &albums = library.Albums();
+  for (auto it = result.albums.begin(); it != result.albums.end(); ++it) {
+    const AlbumRef &ref = it->first;
+    const bool shared = (it != result.albums.begin() &&
+                         std::prev(it)->first.name == ref.name) ||
+                        (std::next(it) != result.albums.end() &&
+                         std::next(it)->first.name == ref.name);
+
+    BString displayName = ref.name;
+    if (shared) {
+      BString detail;
+      if (const Album *album = albums.Find(ref.id))
+        detail = album->artist;
+      if (ref.year > 0) {
+        if (!detail.IsEmpty())
+          detail << ", ";
+        detail << ref.year;
       }
+      displayName << " [" << (detail.IsEmpty() ? "?" : detail.String())
+                  << "]";
     }
-  }
-
-  // 8. Smart Update of List Views (Prevent flickering/scrolling reset if
-  // unchanged)
-  auto smartUpdateWithData =
-      [&](SimpleColumnView *view, const std::vector<DisplayItem> &newItems,
-          const BString &currentSelText, const BString &currentSelData) {
-        bool changed = false;
-        if (view->CountItems() != (int32)newItems.size()) {
-          changed = true;
-        } else {
-          for (int32 i = 0; i < (int32)newItems.size(); i++) {
-            if (view->ItemAt(i) != newItems[i].text ||
-                view->PathAt(i) != newItems[i].data) {
-              changed = true;
-              break;
-            }
-          }
-        }
-
-        if (!changed)
-          return;
-
-        view->Clear();
-        for (const auto &item : newItems) {
-          view->AddItem(item.text, item.data);
-        }
-
-        // Restore Selection
-        if (!currentSelText.IsEmpty()) {
-          bool found = false;
-
-          // Try matching by data first (more precise)
-          if (!currentSelData.IsEmpty()) {
-            for (int32 i = 0; i < view->CountItems(); i++) {
-              if (view->PathAt(i) == currentSelData) {
-                view->Select(i);
-                view->ScrollToSelection();
-                found = true;
-                break;
-              }
-            }
-          }
-
-          // Fallback to text match
-          if (!found) {
-            for (int32 i = 0; i < view->CountItems(); i++) {
-              if (view->ItemAt(i) == currentSelText) {
-                view->Select(i);
-                view->ScrollToSelection();
-                break;
-              }
-            }
-          }
-        }
-      };
-
-  auto toDisplay = [](const std::vector<BString> &strs) {
-    std::vector<DisplayItem> out;
-    for (const auto &s : strs)
-      out.push_back({s, ""});
-    return out;
-  };
-
-  smartUpdateWithData(fGenreView, toDisplay(genreItems), selGenre, "");
-  smartUpdateWithData(fArtistView, toDisplay(artistItems), selArtist, "");
-  smartUpdateWithData(fAlbumView, albumDisplayItems, selAlbum, selAlbumData);
-}
 
-/**
- * @brief Adds a single item to the views incrementally.
- * Note: Only used for real-time updates (e.g. during scan).
- */
-void LibraryViewManager::AddMediaItem(const MediaItem &item) {
-
-  fContentView->AddEntry(item);
-
-  auto addUnique = [](SimpleColumnView *v, const BString &val,
-                      const char *emptyLabel) {
-    BString text = val.IsEmpty() ? BString(emptyLabel) : val;
+    BString data;
+    if (ref.id != AlbumTable::kNoAlbum)
+      data << ref.id;
+    albumDisplayItems.push_back(CountedItem(displayName, it->second, data));
+  }
 
-    for (int32 i = 0; i < v->CountItems(); i++) {
-      if (v->ItemAt(i) == text)
-        return;
-    }
-    v->AddItem(text);
+  // 8. Update the columns from the work queue, one column per step, so the
+  // first track rows are not held up by them
+  auto updateFacets = [this, facets](bigtime_t deadline) {
+    do {
+      switch (facets->next++) {
+      case 0:
+        UpdateFacetView(fGenreView, std::move(facets->genres),
+                        facets->selGenre, "");
+        break;
+      case 1:
+        UpdateFacetView(fArtistView, std::move(facets->artists),
+                        facets->selArtist, "");
+        break;
+      case 2:
+        UpdateFacetView(fAlbumView, std::move(facets->albums),
+                        facets->selAlbum, facets->selAlbumData);
+        break;
+      }
+    } while (facets->next < 3 && system_time() < deadline);
+    return facets->next < 3;
   };
 
-  addUnique(fGenreView, item.genre, kLabelNoGenre.String());
-
-  BString selGenre = SelectedText(fGenreView);
-  bool genreMatch = (selGenre.IsEmpty() || selGenre == kLabelAll ||
-                     (selGenre == kLabelNoGenre && item.genre.IsEmpty()) ||
-                     selGenre == item.genre);
-
-  if (genreMatch) {
-    addUnique(fArtistView, item.artist, kLabelNoArtist.String());
-
-    BString selArtist = SelectedText(fArtistView);
-    bool artistMatch =
-        (selArtist.IsEmpty() || selArtist == kLabelAll ||
-         (selArtist == kLabelNoArtist && item.artist.IsEmpty()) ||
-         selArtist == item.artist);
-
-    if (artistMatch) {
-      addUnique(fAlbumView, item.album, kLabelNoAlbum.String());
-    }
-  }
+  if (fWorkQueue)
+    fWorkQueue->Add(kFacetsJob, updateFacets);
+  else
+    updateFacets(B_INFINITE_TIMEOUT);
 }
@@ -2,7 +2,11 @@
 #define LIBRARY_VIEW_MANAGER_H
 
 #include "ContentColumnView.h"
+#include "HashUtils.h"
+#include "LibraryFilter.h"
 #include "MediaItem.h"
+#include "MediaLibrary.h"
+#include "PlaylistFile.h"
 #include "SimpleColumnView.h"
 #include <Messenger.h>
 #include <String.h>
@@ -19,6 +23,12 @@
  * based on selection, and maintaining the state of the "Active Playlist"
  * filtering (fActivePaths).
  *
+ * The tracks in scope are indexed by genre, artist and album (see
+ * FacetIndex); the index is rebuilt only when the library or the scope
+ * changes, so changing a selection costs a few posting list operations.
+ * Each column can have several entries selected, and every entry shows how
+ * many tracks it has.
+ *
  * It coordinates:
  * - `SimpleColumnView`s for Genre, Artist, Album.
  * - `ContentColumnView` for the main track list.
@@ -40,34 +50,64 @@ public:
   SimpleColumnView *AlbumView() const;
   ContentColumnView *ContentView() const;
 
+  /**
+   * @brief Runs column and track list updates from @p queue instead of all
+   * at once.
+   */
+  void SetWorkQueue(UIWorkQueue *queue);
+
   /**
    * @brief Updates the filtered views based on the full database and current
    * selection.
    *
-   * This is the heavy-lifting function that filters `allItems` down to the
+   * This is the heavy-lifting function that filters `library` down to the
    * lists displayed in each column using the current genre/artist/album
    * selection and search text.
    *
-   * @param allItems Complete list of all media items in the cache.
+   * @param library Complete list of all media items in the cache.
    * @param isLibraryMode If true, shows everything. If false, filters by
    * `fActivePaths`.
    * @param currentPlaylist Name of the current playlist (used for display
    * context if needed).
    * @param filterText Search filter string (default empty).
    */
-  void UpdateFilteredViews(const std::vector<MediaItem> &allItems,
+  void UpdateFilteredViews(const MediaLibrary &library,
                            bool isLibraryMode, const BString &currentPlaylist,
                            const BString &filterText = "");
 
   /**
-   * @brief Incrementally adds a media item (used during live scanning).
+   * @brief Clears all filters and views.
    */
-  void AddMediaItem(const MediaItem &item);
+  void ResetFilters();
 
   /**
-   * @brief Clears all filters and views.
+   * @brief Removes all rows of the track list.
    */
-  void ResetFilters();
+  void ClearContent();
+
+  /**
+   * @brief Removes the rows of one track, e.g. after its file was deleted.
+   * @return False if the track list has no row for @p path.
+   */
+  bool RemoveEntry(const BString &path);
+
+  /**
+   * @brief Removes the selected rows of the track list.
+   * @param outPaths Receives the paths of the removed rows, in view order.
+   * @param outPositions Receives their positions in the active playlist,
+   * -1 where unknown.
+   * @return Number of rows removed.
+   */
+  int32 RemoveSelectedRows(std::vector<BString> &outPaths,
+                           std::vector<int32> &outPositions);
+
+  /**
+   * @brief Count, duration and size of the tracks in the track list.
+   *
+   * Covers the whole filter result right away, also while its rows are
+   * still being added.
+   */
+  const LibraryTotals &Totals() const { return fTotals; }
 
   ///@}
 
@@ -83,17 +123,45 @@ public:
   const std::vector<BString> &ActivePaths() const;
   void SetActivePaths(const std::vector<BString> &paths);
 
+  /**
+   * @brief Sets the active scope from playlist entries.
+   *
+   * The #EXTINF metadata is kept to label tracks that are not in the
+   * library, so they can be shown without touching the file system.
+   */
+  void SetActiveEntries(const std::vector<PlaylistEntry> &entries);
+
+  /**
+   * @brief Marks active tracks whose files were found to be missing.
+   */
+  void SetMissingPaths(const std::vector<BString> &paths);
+
+  /**
+   * @brief Moves one entry of the active scope, mirroring a playlist reorder.
+   */
+  void MoveActivePath(int32 fromIndex, int32 toIndex);
+
   /**
    * @brief Checks if a specific file path is allowed in the current view mode.
    */
   bool IsPathAllowed(const BString &filePath, bool isLibraryMode) const;
 
+  /**
+   * @brief Adds the browser columns, the track list and the active scope to
+   * @p report.
+   */
+  void AccountMemory(MemoryReport &report) const;
+
 private:
   /**
    * @brief Internal helper to check path allowance against active paths.
    */
-  bool _PathAllowedByMode(const BString &filePath, bool isLibraryMode,
-                          const std::vector<BString> &activePaths) const;
+  bool _PathAllowedByMode(const BString &filePath, bool isLibraryMode) const;
+
+  /**
+   * @brief Indexes the tracks in scope, unless the index is up to date.
+   */
+  void _UpdateIndex(const MediaLibrary &library, bool isLibraryMode);
 
 private:
   /** @name State */
@@ -104,13 +172,28 @@ private:
   SimpleColumnView *fArtistView;
   SimpleColumnView *fAlbumView;
   ContentColumnView *fContentView;
+  UIWorkQueue *fWorkQueue = nullptr;
 
-  std::vector<BString> fActivePaths;
+  std::vector<BString> fActivePaths; ///< Active scope in playlist order.
+  BStringSet fActiveSet;             ///< Same paths, for membership tests.
+  BStringMap<PlaylistEntry> fActiveInfo; ///< Playlist metadata by path.
+  BStringSet fMissingPaths;              ///< Active tracks not on disk.
+  LibraryTotals fTotals;                 ///< Over the track list's tracks.
 
   /// Cache last selection to avoid resetting downstream columns unnecessarily
   BString fLastSelectedGenre;
   BString fLastSelectedArtist;
   ///@}
+
+  /** @name Column browser index */
+  ///@{
+  FacetIndex fIndex;                    ///< Over the tracks in scope.
+  std::vector<MediaItem> fPlaceholders; ///< Active tracks not in the library.
+  const MediaLibrary *fIndexedLibrary = nullptr;
+  uint32 fIndexedGeneration = 0;
+  bool fIndexedLibraryMode = false;
+  bool fIndexStale = true; ///< Set when the active scope changes.
+  ///@}
 };
 
 #endif // LIBRARY_VIEW_MANAGER_H
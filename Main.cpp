@@ -1,5 +1,8 @@
 #include "Debug.h"
 #include "MainWindow.h"
+#include "MemoryReport.h"
+#include "StartupTimeline.h"
+#include "Trace.h"
 #include <Application.h>
 #include <Catalog.h>
 #include <cstring>
@@ -7,8 +10,6 @@
 #undef B_TRANSLATION_CONTEXT
 #define B_TRANSLATION_CONTEXT "Application"
 
-bool gIsDebug = false;
-
 /**
  * @class BeTonApp
  * @brief The Application class.
@@ -26,15 +27,25 @@ public:
 };
 
 int main(int argc, char **argv) {
+  StartupTimeline::Mark(STARTUP_MAIN);
+  const char *traceFile = Trace::DefaultPath();
   for (int i = 1; i < argc; ++i) {
     if (strcmp(argv[i], "--debug") == 0) {
       gIsDebug = true;
+    } else if (strcmp(argv[i], "--trace") == 0) {
+      gIsTracing = true;
+    } else if (strncmp(argv[i], "--trace=", 8) == 0) {
+      gIsTracing = true;
+      traceFile = argv[i] + 8;
+    } else if (strcmp(argv[i], "--memory-report") == 0) {
+      gPrintMemoryReport = true;
     }
   }
 
   if (!gIsDebug) {
 
-    freopen("/dev/null", "w", stdout);
+    if (!gPrintMemoryReport)
+      freopen("/dev/null", "w", stdout);
     freopen("/dev/null", "w", stderr);
   }
 
@@ -44,5 +55,9 @@ int main(int argc, char **argv) {
 
   BeTonApp app;
   app.Run();
+
+  // Still recording (from --trace or the Help menu): keep what was captured.
+  if (Trace::Enabled())
+    Trace::Export(traceFile);
   return 0;
 }
@@ -5,14 +5,19 @@
 #include "InfoPanel.h"
 #include "MatcherWindow.h"
 #include "MatchingUtils.h"
+#include "MemoryReport.h"
 #include "NamePrompt.h"
 #include "PlaylistGeneratorWindow.h"
+#include "PlaylistIndex.h"
 #include "PlaylistListView.h"
 #include "PlaylistManager.h"
 #include "PlaylistUtils.h"
 #include "PropertiesWindow.h"
 #include "SeekBarView.h"
+#include "StartupTimeline.h"
 #include "TagSync.h"
+#include "Trace.h"
+#include "UIWorkQueue.h"
 
 #include <AboutWindow.h>
 #include <Button.h>
@@ -27,6 +32,7 @@
 #include <ListView.h>
 #include <MenuBar.h>
 #include <MenuItem.h>
+#include <MessageQueue.h>
 #include <MessageRunner.h>
 #include <OS.h>
 #include <Path.h>
@@ -37,10 +43,12 @@
 #include <StatusBar.h>
 #include <StringView.h>
 #include <TextControl.h>
+#include <TextView.h>
 #include <TranslationUtils.h>
 #include <View.h>
 #include <algorithm>
 #include <cinttypes>
+#include <memory>
 #include <random>
 #include <taglib/audioproperties.h>
 #include <taglib/fileref.h>
@@ -72,6 +80,13 @@ static constexpr int32 ICON_REPEAT_GREEN = 2011;
 static constexpr int32 ICON_REPEAT_ORANGE = 2012;
 ///@}
 
+/**
+ * How long the memory report waits for the CacheManager's lock. The cache
+ * looper sends to this window synchronously, so waiting for it without a
+ * limit can deadlock.
+ */
+static constexpr bigtime_t kMemoryReportLockTimeout = 250000;
+
 /**
  * @brief Loads a vector icon from application resources and renders it to a
  * bitmap.
@@ -103,10 +118,6 @@ static BBitmap *LoadIconFromResource(int32 id, float size) {
   return bmp;
 }
 
-MainWindow *gMainWindow = nullptr;
-
-extern void AddItemToPlaylist(const BString &playlist, const BString &path);
-
 static void CollectPathsFromMessage(const BMessage *msg,
                                     std::vector<BPath> &out) {
   out.clear();
@@ -133,11 +144,25 @@ static void CollectPathsFromMessage(const BMessage *msg,
   }
 }
 
+/**
+ * @brief Records a startup milestone, and a trace event if tracing.
+ * @return True the first time @p phase is reached.
+ */
+static bool MarkStartup(const char *phase) {
+  if (!StartupTimeline::Mark(phase))
+    return false;
+  if (Trace::Enabled())
+    Trace::Instant("startup", phase);
+  return true;
+}
+
 /**
  * @brief Constructs the Main Window of the application.
  *
  * Initializes the UI, managers (Playlist, Library, Cache), and playback
- * controller. Starts the initial cache load and status updates.
+ * controller. Everything the first frame does not need, i.e. the playlist
+ * folder, the smart playlists and the cache load, is started from
+ * MSG_LAZY_LOAD once the window has been drawn.
  */
 MainWindow::MainWindow()
     : BWindow(BRect(100, 100, 400, 300), "BeTon", B_DOCUMENT_WINDOW,
@@ -151,11 +176,27 @@ MainWindow::MainWindow()
   fController->SetVolume(1.0f);
 
   fPlaylistManager = new PlaylistManager(BMessenger(this));
+  fSmartPlaylists = new SmartPlaylistManager();
+
+  SetPlaylistChangeTarget(BMessenger(this));
+  SetPlaylistMetadataLookup([this](const BString &path, PlaylistEntry &entry) {
+    const MediaItem *mi = fAllItems.Find(path);
+    if (!mi)
+      return false;
+    entry.artist = mi->artist;
+    entry.title = mi->title;
+    entry.duration = mi->duration;
+    entry.inode = mi->inode;
+    return true;
+  });
 
   fCacheManager = new CacheManager(BMessenger(this));
   fCacheManager->Run();
 
   fLibraryManager = new LibraryViewManager(BMessenger(this));
+  fWorkQueue = new UIWorkQueue();
+  AddHandler(fWorkQueue);
+  fLibraryManager->SetWorkQueue(fWorkQueue);
   fMetadataHandler = new MetadataHandler(BMessenger(fCacheManager));
 
   fInfoPanel = new InfoPanel();
@@ -173,26 +214,19 @@ MainWindow::MainWindow()
   float windowHeight = windowWidth / 1.618f; // Golden ratio
   ResizeTo(windowWidth, windowHeight);
   CenterOnScreen();
-  fPlaylistManager->LoadAvailablePlaylists();
-
-  BMessenger(fCacheManager).SendMessage(MSG_LOAD_CACHE);
-
-  fMbClient = new MusicBrainzClient("beton-app@outlook.com");
 
   fStatusLabel->SetText(B_TRANSLATE("Loading Music Library..."));
 
-  fPendingItems = fAllItems;
-  fCurrentIndex = 0;
-
-  fBatchRunner = new BMessageRunner(BMessenger(this),
-                                    new BMessage(MSG_BATCH_TIMER), 50000);
-
   RegisterWithCacheManager();
 
   BMessage msg(MSG_INIT_LIBRARY);
   PostMessage(&msg);
 
   LoadSettings();
+  _RestoreViewSnapshot();
+
+  MarkStartup(STARTUP_WINDOW_BUILT);
+  PostMessage(MSG_LAZY_LOAD);
 }
 
 /**
@@ -202,7 +236,16 @@ MainWindow::MainWindow()
  * Saves current settings before exit.
  */
 MainWindow::~MainWindow() {
+  if (gPrintMemoryReport)
+    printf("%s", _MemoryReport().String());
   SaveSettings();
+  PlaylistIndex::Save();
+  RemoveHandler(fWorkQueue);
+  delete fWorkQueue;
+  fWorkQueue = nullptr;
+  DEBUG_PRINT("%s", fMessageStats.Report().String());
+  if (fCacheManager)
+    DEBUG_PRINT("%s", fCacheManager->Stats().Report().String());
   if (fController) {
     fController->Shutdown();
     delete fController;
@@ -214,9 +257,11 @@ MainWindow::~MainWindow() {
     fCacheManager = nullptr;
   }
   delete fUpdateRunner;
-  delete fBatchRunner;
   delete fLibraryManager;
   delete fPlaylistManager;
+  delete fSmartPlaylists;
+  SetPlaylistMetadataLookup(nullptr);
+  SetPlaylistChangeTarget(BMessenger());
   delete fMetadataHandler;
   delete fMbClient;
   delete fSearchRunner;
@@ -261,6 +306,8 @@ void MainWindow::_BuildUI() {
                                       new BMessage(MSG_NEW_PLAYLIST)));
   playlistMenu->AddItem(new BMenuItem(B_TRANSLATE("Generate New Playlist"),
                                       new BMessage(MSG_NEW_SMART_PLAYLIST)));
+  playlistMenu->AddItem(new BMenuItem(B_TRANSLATE("Find Duplicates"),
+                                      new BMessage(MSG_FIND_DUPLICATES)));
   playlistMenu->AddSeparatorItem();
   playlistMenu->AddItem(new BMenuItem(B_TRANSLATE("Set Playlist Folder"),
                                       new BMessage(MSG_SET_PLAYLIST_FOLDER)));
@@ -294,6 +341,15 @@ void MainWindow::_BuildUI() {
   fMenuBar->AddItem(appearanceMenu);
 
   BMenu *helpMenu = new BMenu(B_TRANSLATE("Help"));
+  fTraceItem = new BMenuItem(B_TRANSLATE("Record Trace"),
+                             new BMessage(MSG_TOGGLE_TRACE));
+  fTraceItem->SetMarked(Trace::Enabled());
+  helpMenu->AddItem(fTraceItem);
+  helpMenu->AddItem(new BMenuItem(B_TRANSLATE("Message Statistics"),
+                                  new BMessage(MSG_SHOW_MESSAGE_STATS)));
+  helpMenu->AddItem(new BMenuItem(B_TRANSLATE("Memory Usage"),
+                                  new BMessage(MSG_SHOW_MEMORY_REPORT)));
+  helpMenu->AddSeparatorItem();
   helpMenu->AddItem(new BMenuItem(B_TRANSLATE("About BeTon" B_UTF8_ELLIPSIS),
                                   new BMessage(B_ABOUT_REQUESTED)));
   fMenuBar->AddItem(helpMenu);
@@ -325,30 +381,15 @@ void MainWindow::_BuildUI() {
     size = 24.0f;
   BSize buttonSize(size, size);
 
-  float iconSize = size * 0.65f; // Icon is 65% of button size
-  fIconPlay = LoadIconFromResource(ICON_PLAY_GRAY, iconSize);
-  fIconPause = LoadIconFromResource(ICON_PAUSE_GRAY, iconSize);
-  fIconStop = LoadIconFromResource(ICON_STOP, iconSize);
-  fIconNext = LoadIconFromResource(ICON_NEXT, iconSize);
-  fIconPrev = LoadIconFromResource(ICON_PREV, iconSize);
-  fIconShuffleOff = LoadIconFromResource(ICON_SHUFFLE_GRAY, iconSize);
-  fIconShuffleOn = LoadIconFromResource(ICON_SHUFFLE_COLOR, iconSize);
-  fIconRepeatOff = LoadIconFromResource(ICON_REPEAT_GRAY, iconSize);
-  fIconRepeatAll = LoadIconFromResource(ICON_REPEAT_GREEN, iconSize);
-  fIconRepeatOne = LoadIconFromResource(ICON_REPEAT_ORANGE, iconSize);
-
-  if (fIconPrev)
-    fBtnPrev->SetIcon(fIconPrev, 0);
-  if (fIconPlay)
-    fBtnPlayPause->SetIcon(fIconPlay, 0);
-  if (fIconStop)
-    fBtnStop->SetIcon(fIconStop, 0);
-  if (fIconNext)
-    fBtnNext->SetIcon(fIconNext, 0);
-  if (fIconShuffleOff)
-    fBtnShuffle->SetIcon(fIconShuffleOff, 0);
-  if (fIconRepeatOff)
-    fBtnRepeat->SetIcon(fIconRepeatOff, 0);
+  // Only the icons shown initially; the others are rasterized when a button
+  // first changes state.
+  fIconSize = size * 0.65f; // Icon is 65% of button size
+  _SetButtonIcon(fBtnPrev, fIconPrev, ICON_PREV);
+  _SetButtonIcon(fBtnPlayPause, fIconPlay, ICON_PLAY_GRAY);
+  _SetButtonIcon(fBtnStop, fIconStop, ICON_STOP);
+  _SetButtonIcon(fBtnNext, fIconNext, ICON_NEXT);
+  _SetButtonIcon(fBtnShuffle, fIconShuffleOff, ICON_SHUFFLE_GRAY);
+  _SetButtonIcon(fBtnRepeat, fIconRepeatOff, ICON_REPEAT_GRAY);
 
   fBtnPrev->SetExplicitSize(buttonSize);
   fBtnPlayPause->SetExplicitSize(buttonSize);
@@ -367,6 +408,12 @@ void MainWindow::_BuildUI() {
       new BTextControl("search", "", "", new BMessage(MSG_SEARCH_MODIFY));
   fSearchField->SetModificationMessage(new BMessage(MSG_SEARCH_MODIFY));
   fSearchField->SetTarget(this);
+  fSearchField->SetToolTip(
+      B_TRANSLATE("Search words, or fields such as artist:\"Miles Davis\", "
+                  "year:1955..1965, duration:>10m or bitrate:>=256.\n"
+                  "Tracks must match every word; quotes keep a phrase "
+                  "together.\n"
+                  "A leading minus excludes, as in -live."));
 
   BScrollView *playlistScroll = new BScrollView(
       "playlist_scroll", fPlaylistManager->View(), B_WILL_DRAW, false, true);
@@ -459,6 +506,23 @@ void UpdateScrollbars(BListView *listView) {
   }
 }
 
+/**
+ * @brief Times every message handled by the window.
+ *
+ * Covers view events as well as MessageReceived(); the statistics are shown
+ * by Help > Message Statistics and printed on exit in debug mode.
+ */
+void MainWindow::DispatchMessage(BMessage *msg, BHandler *handler) {
+  const uint32 what = msg->what;
+  const bigtime_t start = system_time();
+  const bigtime_t wait = MessageStats::WaitTime(msg, start);
+
+  BWindow::DispatchMessage(msg, handler);
+
+  fMessageStats.Record(what, wait, system_time() - start,
+                       MessageQueue()->CountMessages());
+}
+
 /**
  * @brief Main message loop handler.
  *
@@ -585,8 +649,7 @@ void MainWindow::MessageReceived(BMessage *msg) {
         fController->SetQueue(queue);
         fController->Play(index);
         fSongDuration = fController->Duration();
-        if (fIconPause)
-          fBtnPlayPause->SetIcon(fIconPause, 0);
+        _SetButtonIcon(fBtnPlayPause, fIconPause, ICON_PAUSE_GRAY);
       }
     } else {
       DEBUG_PRINT("[Window] MSG_PLAY: no selection\\n");
@@ -657,6 +720,38 @@ void MainWindow::MessageReceived(BMessage *msg) {
     break;
   }
 
+  case MSG_TOGGLE_TRACE: {
+    if (Trace::Enabled()) {
+      gIsTracing = false;
+      BString statusMsg;
+      if (Trace::Export(Trace::DefaultPath()) == B_OK)
+        statusMsg.SetToFormat(B_TRANSLATE("Trace written to %s"),
+                              Trace::DefaultPath());
+      else
+        statusMsg = B_TRANSLATE("Trace could not be written.");
+      UpdateStatus(statusMsg);
+    } else {
+      Trace::Clear();
+      gIsTracing = true;
+      UpdateStatus(B_TRANSLATE("Recording trace..."));
+    }
+    fTraceItem->SetMarked(Trace::Enabled());
+    break;
+  }
+
+  case MSG_SHOW_MESSAGE_STATS: {
+    BString report = StartupTimeline::Report();
+    report << "\n" << fMessageStats.Report();
+    if (fCacheManager)
+      report << "\n" << fCacheManager->Stats().Report();
+    _ShowReportWindow(B_TRANSLATE("Message Statistics"), report);
+    break;
+  }
+
+  case MSG_SHOW_MEMORY_REPORT:
+    _ShowReportWindow(B_TRANSLATE("Memory Usage"), _MemoryReport());
+    break;
+
   case B_COLORS_UPDATED: {
     if (!fUseCustomSeekBarColor) {
       fSeekBarColor = ui_color(B_CONTROL_HIGHLIGHT_COLOR);
@@ -702,31 +797,33 @@ void MainWindow::MessageReceived(BMessage *msg) {
     if (fController) {
       if (fController->IsPlaying()) {
         fController->Pause();
-        if (fIconPlay)
-          fBtnPlayPause->SetIcon(fIconPlay, 0);
+        _SetButtonIcon(fBtnPlayPause, fIconPlay, ICON_PLAY_GRAY);
       } else if (fController->IsPaused()) {
         fController->Resume();
-        if (fIconPause)
-          fBtnPlayPause->SetIcon(fIconPause, 0);
+        _SetButtonIcon(fBtnPlayPause, fIconPause, ICON_PAUSE_GRAY);
 
       } else {
         ContentColumnView *cv = fLibraryManager->ContentView();
         BRow *selRow = cv->CurrentSelection();
-        int32 index = (selRow ? cv->IndexOf(selRow) : -1);
 
-        if (index >= 0) {
+        if (selRow) {
           std::vector<std::string> queue;
           queue.reserve(cv->CountRows());
 
+          // Find the selection while building the queue; IndexOf() would
+          // walk the rows again, and missing tracks shift the index.
+          int32 index = -1;
           for (int32 i = 0; i < cv->CountRows(); ++i) {
             const MediaItem *mi = cv->ItemAt(i);
             if (!mi || mi->missing)
               continue;
 
+            if (cv->RowAt(i) == selRow)
+              index = (int32)queue.size();
             queue.push_back(mi->path.String());
           }
 
-          if (!queue.empty()) {
+          if (index >= 0) {
             DEBUG_PRINT("[Window] MSG_PLAYPAUSE: start index=%ld"
                         " (queue=%zu)\\n",
                         (long)index, queue.size());
@@ -734,8 +831,7 @@ void MainWindow::MessageReceived(BMessage *msg) {
             fController->SetQueue(queue);
             fController->Play(index);
             fSongDuration = fController->Duration();
-            if (fIconPause)
-              fBtnPlayPause->SetIcon(fIconPause, 0);
+            _SetButtonIcon(fBtnPlayPause, fIconPause, ICON_PAUSE_GRAY);
           }
         } else {
           DEBUG_PRINT("[Window] MSG_PLAYPAUSE: no selection\\n");
@@ -759,72 +855,91 @@ void MainWindow::MessageReceived(BMessage *msg) {
 
   case MSG_CACHE_LOADED: {
     DEBUG_PRINT("[MainWindow] MSG_CACHE_LOADED received\\n");
+    const bool firstLoad = MarkStartup(STARTUP_CACHE_LOADED);
     fCacheLoaded = true;
     if (fCacheManager) {
-      auto entries = fCacheManager->AllEntries();
-      fAllItems = std::move(entries);
-
-      fKnownPaths.clear();
-      for (const auto &item : fAllItems) {
-        fKnownPaths.insert(item.path);
-      }
+      // After a load the CacheManager has a copy of its entries ready.
+      std::vector<MediaItem> items;
+      if (fCacheManager->TakeLoadedEntries(items))
+        fAllItems.Assign(std::move(items));
+      else
+        fAllItems.Assign(fCacheManager->AllEntries());
 
       DEBUG_PRINT("[MainWindow] Cache populated: %zu items\\n",
-                  fAllItems.size());
+                  fAllItems.Count());
+
+      // The playlist shown by the snapshot was not loaded yet.
+      if (fRestoringView && !fIsLibraryMode)
+        _LoadActivePlaylist(fCurrentPlaylistName);
 
       UpdateFilteredViews();
       _UpdateStatusLibrary();
+
+      if (firstLoad) {
+        // Without a snapshot these are the first rows on screen.
+        UpdateIfNeeded();
+        MarkStartup(STARTUP_FIRST_ROWS);
+        DEBUG_PRINT("%s", StartupTimeline::Report().String());
+      }
     }
     break;
   }
 
-  case MSG_DELETE_ITEM: {
+  case MSG_LAZY_LOAD: {
+    // Queued by the constructor, so the window has just been shown; draw it
+    // before doing the rest of the startup work.
+    UpdateIfNeeded();
+    if (MarkStartup(STARTUP_FIRST_FRAME) &&
+        StartupTimeline::Elapsed(STARTUP_FIRST_FRAME) > kStartupFrameBudget) {
+      DEBUG_PRINT("[MainWindow] First frame after %" B_PRId64
+                  " ms, budget is %" B_PRId64 " ms\\n",
+                  StartupTimeline::Elapsed(STARTUP_FIRST_FRAME) / 1000,
+                  kStartupFrameBudget / 1000);
+    }
 
-    std::vector<BString> removedPaths;
+    if (fRestoringView && fLibraryManager->ContentView()->CountRows() > 0)
+      MarkStartup(STARTUP_FIRST_ROWS);
 
-    BRow *row = nullptr;
-    ContentColumnView *cv = fLibraryManager->ContentView();
-    while ((row = cv->CurrentSelection(row)) != nullptr) {
-      const MediaItem *mi = cv->ItemAt(cv->IndexOf(row));
-      if (mi) {
-        removedPaths.push_back(mi->path);
-      }
+    _LoadPlaylists();
+    if (fRestoringView && !fIsLibraryMode) {
+      PlaylistListView *list = fPlaylistManager->View();
+      int32 index = list->FindIndexByName(fCurrentPlaylistName);
+      if (index >= 0)
+        list->Select(index);
     }
+    fSmartPlaylists->LoadDefinitions();
+    BMessenger(fCacheManager).SendMessage(MSG_LOAD_CACHE);
+    break;
+  }
 
-    if (!removedPaths.empty() && fCurrentPlaylistName.Length() > 0) {
+  case MSG_DELETE_ITEM: {
+    if (fIsLibraryMode || fCurrentPlaylistName.IsEmpty())
+      break;
 
-      for (const auto &path : removedPaths) {
-        for (int32 i = 0; i < cv->CountRows(); i++) {
-          const MediaItem *mi = cv->ItemAt(i);
-          if (mi && mi->path == path) {
-            BRow *r = cv->RowAt(i);
-            cv->RemoveRow(r);
-            delete r;
-            break;
-          }
-        }
-      }
+    std::vector<BString> removedPaths;
+    std::vector<int32> removedPositions;
+    if (fLibraryManager->RemoveSelectedRows(removedPaths, removedPositions) ==
+        0)
+      break;
 
-      std::vector<BString> remainingPaths;
-      for (int32 i = 0; i < cv->CountRows(); i++) {
-        const MediaItem *mi = cv->ItemAt(i);
-        if (mi) {
-          remainingPaths.push_back(mi->path);
-        }
-      }
-      fPlaylistManager->SavePlaylist(fCurrentPlaylistName, remainingPaths);
-    }
+    // Update the playlist model rather than saving the view's rows, which
+    // may be narrowed by the search field.
+    if (const std::vector<BString> *content =
+            fPlaylistManager->RemovePlaylistItems(
+                fCurrentPlaylistName, removedPositions, removedPaths))
+      fLibraryManager->SetActivePaths(*content);
+    _UpdateStatusLibrary();
     break;
   }
 
   case MSG_RESCAN_FULL: {
     DEBUG_PRINT("[MainWindow] Rescan triggered\\n");
 
-    fLibraryManager->ContentView()->Clear();
+    fLibraryManager->ClearContent();
     fLibraryManager->GenreView()->Clear();
     fLibraryManager->ArtistView()->Clear();
     fLibraryManager->AlbumView()->Clear();
-    fAllItems.clear();
+    fAllItems.Clear();
 
     if (fCacheManager) {
       BMessenger(fCacheManager).SendMessage(MSG_RESCAN);
@@ -874,16 +989,8 @@ void MainWindow::MessageReceived(BMessage *msg) {
         (int)sec, (long)fNewFilesCount);
     UpdateStatus(status.String(), false);
 
-    if (fCacheManager) {
-
-      auto entries = fCacheManager->AllEntries();
-      fAllItems = std::move(entries);
-
-      fKnownPaths.clear();
-      for (const auto &item : fAllItems) {
-        fKnownPaths.insert(item.path);
-      }
-    }
+    if (fCacheManager)
+      fAllItems.Assign(fCacheManager->AllEntries());
 
     UpdateFilteredViews();
 
@@ -891,57 +998,25 @@ void MainWindow::MessageReceived(BMessage *msg) {
     break;
   }
 
-  case MSG_BATCH_TIMER: {
-    if (fCurrentIndex >= (int32)fPendingItems.size()) {
-      if (fBatchRunner) {
-        delete fBatchRunner;
-        fBatchRunner = nullptr;
-      }
-      DEBUG_PRINT("[MainWindow] Cache load finished (%zu items)\\n",
-                  fPendingItems.size());
-      _UpdateStatusLibrary();
-      break;
-    }
-
-    const int BATCH_SIZE = 200;
-    int count = 0;
-
-    while (fCurrentIndex < (int32)fPendingItems.size() && count < BATCH_SIZE) {
-      fLibraryManager->ContentView()->AddEntry(fPendingItems[fCurrentIndex]);
-      fCurrentIndex++;
-      count++;
-    }
-
-    char buf[128];
-    snprintf(buf, sizeof(buf), B_TRANSLATE("Loading cache... %ld/%zu"),
-             (long)fCurrentIndex, fPendingItems.size());
-    fStatusLabel->SetText(buf);
-    break;
-  }
-
   case MSG_SHUFFLE_TOGGLE: {
     fShuffleEnabled = !fShuffleEnabled;
-    if (fShuffleEnabled && fIconShuffleOn) {
-      fBtnShuffle->SetIcon(fIconShuffleOn, 0);
-    } else if (!fShuffleEnabled && fIconShuffleOff) {
-      fBtnShuffle->SetIcon(fIconShuffleOff, 0);
-    }
+    if (fShuffleEnabled)
+      _SetButtonIcon(fBtnShuffle, fIconShuffleOn, ICON_SHUFFLE_COLOR);
+    else
+      _SetButtonIcon(fBtnShuffle, fIconShuffleOff, ICON_SHUFFLE_GRAY);
     break;
   }
 
   case MSG_REPEAT_TOGGLE: {
     if (fRepeatMode == RepeatOff) {
       fRepeatMode = RepeatAll;
-      if (fIconRepeatAll)
-        fBtnRepeat->SetIcon(fIconRepeatAll, 0);
+      _SetButtonIcon(fBtnRepeat, fIconRepeatAll, ICON_REPEAT_GREEN);
     } else if (fRepeatMode == RepeatAll) {
       fRepeatMode = RepeatOne;
-      if (fIconRepeatOne)
-        fBtnRepeat->SetIcon(fIconRepeatOne, 0);
+      _SetButtonIcon(fBtnRepeat, fIconRepeatOne, ICON_REPEAT_ORANGE);
     } else {
       fRepeatMode = RepeatOff;
-      if (fIconRepeatOff)
-        fBtnRepeat->SetIcon(fIconRepeatOff, 0);
+      _SetButtonIcon(fBtnRepeat, fIconRepeatOff, ICON_REPEAT_GRAY);
     }
     break;
   }
@@ -961,37 +1036,7 @@ void MainWindow::MessageReceived(BMessage *msg) {
       break;
 
     int32 newIndex = (msg->what == MSG_MOVE_UP) ? index - 1 : index + 1;
-    ContentColumnView *cv = fLibraryManager->ContentView();
-    if (newIndex < 0 || newIndex >= cv->CountRows())
-      break;
-
-    fPlaylistManager->ReorderPlaylistItem(playlistName, index, newIndex);
-
-    std::vector<MediaItem> items;
-    items.reserve(cv->CountRows());
-    for (int32 i = 0; i < cv->CountRows(); ++i) {
-      const MediaItem *mi = cv->ItemAt(i);
-      if (mi)
-        items.push_back(*mi);
-    }
-
-    if (index >= 0 && index < (int32)items.size() && newIndex >= 0 &&
-        newIndex < (int32)items.size()) {
-      MediaItem temp = items[index];
-      items.erase(items.begin() + index);
-      items.insert(items.begin() + newIndex, temp);
-    }
-
-    cv->ClearEntries();
-    for (const auto &mi : items) {
-      cv->AddEntry(mi);
-    }
-
-    if (BRow *row = cv->RowAt(newIndex)) {
-      cv->DeselectAll();
-      cv->AddToSelection(row);
-      cv->ScrollTo(row);
-    }
+    _MovePlaylistRow(playlistName, index, newIndex);
     break;
   }
 
@@ -1017,43 +1062,7 @@ void MainWindow::MessageReceived(BMessage *msg) {
     if (toIndex >= cv->CountRows())
       toIndex = cv->CountRows() - 1;
 
-    fPlaylistManager->ReorderPlaylistItem(playlistName, fromIndex, toIndex);
-
-    std::vector<MediaItem> items;
-    items.reserve(cv->CountRows());
-    for (int32 i = 0; i < cv->CountRows(); ++i) {
-      const MediaItem *mi = cv->ItemAt(i);
-      if (mi)
-        items.push_back(*mi);
-    }
-
-    if (fromIndex < (int32)items.size() && toIndex < (int32)items.size()) {
-      MediaItem temp = items[fromIndex];
-      items.erase(items.begin() + fromIndex);
-      items.insert(items.begin() + toIndex, temp);
-    }
-
-    cv->DeselectAll();
-
-    cv->ClearEntries();
-    for (const auto &mi : items) {
-      cv->AddEntry(mi);
-    }
-
-    cv->Invalidate();
-    if (BView *scrollView = cv->ScrollView()) {
-      scrollView->Invalidate();
-    }
-
-    BRow *newRow = cv->RowAt(toIndex);
-    if (newRow) {
-      cv->SetFocusRow(newRow);
-      cv->AddToSelection(newRow);
-      cv->ScrollTo(newRow);
-    }
-
-    cv->Sync();
-    UpdateIfNeeded();
+    _MovePlaylistRow(playlistName, fromIndex, toIndex);
     break;
   }
 
@@ -1094,34 +1103,7 @@ void MainWindow::MessageReceived(BMessage *msg) {
     if (sourceIndex == targetIndex || sourceIndex < 0 || targetIndex < 0)
       break;
 
-    fPlaylistManager->ReorderPlaylistItem(playlistName, sourceIndex,
-                                          targetIndex);
-
-    std::vector<MediaItem> items;
-    items.reserve(cv->CountRows());
-    for (int32 i = 0; i < cv->CountRows(); ++i) {
-      const MediaItem *mi = cv->ItemAt(i);
-      if (mi)
-        items.push_back(*mi);
-    }
-
-    if (sourceIndex < (int32)items.size() &&
-        targetIndex < (int32)items.size()) {
-      MediaItem temp = items[sourceIndex];
-      items.erase(items.begin() + sourceIndex);
-      items.insert(items.begin() + targetIndex, temp);
-    }
-
-    cv->ClearEntries();
-    for (const auto &mi : items) {
-      cv->AddEntry(mi);
-    }
-
-    if (BRow *row = cv->RowAt(targetIndex)) {
-      cv->DeselectAll();
-      cv->AddToSelection(row);
-      cv->ScrollTo(row);
-    }
+    _MovePlaylistRow(playlistName, sourceIndex, targetIndex);
     break;
   }
 
@@ -1156,6 +1138,8 @@ void MainWindow::MessageReceived(BMessage *msg) {
       break;
 
     bool needsUpdate = false;
+    std::vector<size_t> changedIndices;
+    BStringMap<BString> moves;
     for (int32 i = 0; i < count; i++) {
       BString pathStr;
       if (msg->FindString("path", i, &pathStr) != B_OK)
@@ -1168,46 +1152,73 @@ void MainWindow::MessageReceived(BMessage *msg) {
       else
         path = pathStr;
 
-      auto it =
-          std::find_if(fAllItems.begin(), fAllItems.end(),
-                       [&](const MediaItem &mi) { return mi.path == path; });
-
-      MediaItem *itemToUpdate = nullptr;
-      if (it != fAllItems.end()) {
-        itemToUpdate = &(*it);
-      } else {
-        MediaItem newItem;
-        newItem.path = path;
-        fAllItems.push_back(newItem);
-        itemToUpdate = &fAllItems.back();
-      }
-
-      if (itemToUpdate) {
-        BString tmp;
-        if (msg->FindString("title", i, &tmp) == B_OK)
-          itemToUpdate->title = tmp;
-        if (msg->FindString("artist", i, &tmp) == B_OK)
-          itemToUpdate->artist = tmp;
-        if (msg->FindString("album", i, &tmp) == B_OK)
-          itemToUpdate->album = tmp;
-        if (msg->FindString("genre", i, &tmp) == B_OK)
-          itemToUpdate->genre = tmp;
-
-        int32 val;
-        if (msg->FindInt32("year", i, &val) == B_OK)
-          itemToUpdate->year = val;
-        if (msg->FindInt32("track", i, &val) == B_OK)
-          itemToUpdate->track = val;
-        if (msg->FindInt32("disc", i, &val) == B_OK)
-          itemToUpdate->disc = val;
-        if (msg->FindInt32("duration", i, &val) == B_OK)
-          itemToUpdate->duration = val;
-
-        needsUpdate = true;
-      }
+      // The scanner recognised a moved or renamed file: keep the entry and
+      // only change its path. The old one may already have been removed.
+      BString movedFrom;
+      if (msg->FindString("moved_from", i, &movedFrom) == B_OK &&
+          !movedFrom.IsEmpty() && movedFrom != path) {
+        fAllItems.Move(movedFrom, path);
+        moves[movedFrom] = path;
+      }
+
+      const MediaItem *known = fAllItems.Find(path);
+      MediaItem itemToUpdate = known ? *known : MediaItem();
+      itemToUpdate.path = path;
+
+      BString tmp;
+      if (msg->FindString("title", i, &tmp) == B_OK)
+        itemToUpdate.title = tmp;
+      if (msg->FindString("artist", i, &tmp) == B_OK)
+        itemToUpdate.artist = tmp;
+      if (msg->FindString("album", i, &tmp) == B_OK)
+        itemToUpdate.album = tmp;
+      if (msg->FindString("albumArtist", i, &tmp) == B_OK)
+        itemToUpdate.albumArtist = tmp;
+      if (msg->FindString("genre", i, &tmp) == B_OK)
+        itemToUpdate.genre = tmp;
+
+      int32 val;
+      if (msg->FindInt32("year", i, &val) == B_OK)
+        itemToUpdate.year = val;
+      if (msg->FindInt32("track", i, &val) == B_OK)
+        itemToUpdate.track = val;
+      if (msg->FindInt32("disc", i, &val) == B_OK)
+        itemToUpdate.disc = val;
+      if (msg->FindInt32("discTotal", i, &val) == B_OK)
+        itemToUpdate.discTotal = val;
+      if (msg->FindInt32("duration", i, &val) == B_OK)
+        itemToUpdate.duration = val;
+      if (msg->FindInt32("bitrate", i, &val) == B_OK)
+        itemToUpdate.bitrate = val;
+
+      int64 val64;
+      if (msg->FindInt64("size", i, &val64) == B_OK)
+        itemToUpdate.size = val64;
+      if (msg->FindInt64("mtime", i, &val64) == B_OK)
+        itemToUpdate.mtime = val64;
+      if (msg->FindInt64("inode", i, &val64) == B_OK)
+        itemToUpdate.inode = val64;
+
+      fAllItems.Put(std::move(itemToUpdate));
+      changedIndices.push_back(fAllItems.IndexOf(path));
+      needsUpdate = true;
+    }
+
+    if (!moves.empty()) {
+      fPlaylistManager->FlushPending();
+      fSmartPlaylists->PathsMoved(moves);
+      RewritePlaylistPaths(moves);
+      DEBUG_PRINT("[MainWindow] %d verschobene Dateien uebernommen\\n",
+                  (int)moves.size());
     }
 
     if (needsUpdate) {
+      std::vector<const MediaItem *> changed;
+      changed.reserve(changedIndices.size());
+      for (size_t idx : changedIndices)
+        changed.push_back(&fAllItems.ItemAt(idx));
+      _UpdateSmartPlaylists(changed);
+
       DEBUG_PRINT(
           "[MainWindow] Batch update processed (%d items). Refreshing views.\n",
           (int)count);
@@ -1229,53 +1240,45 @@ void MainWindow::MessageReceived(BMessage *msg) {
           "[MainWindow] Item update path: '%s' (Normalized from '%s')\n",
           path.String(), pathStr.String());
 
-      auto it =
-          std::find_if(fAllItems.begin(), fAllItems.end(),
-                       [&](const MediaItem &mi) { return mi.path == path; });
-
-      MediaItem *itemToUpdate = nullptr;
-
-      if (it != fAllItems.end()) {
-        itemToUpdate = &(*it);
-      } else {
-        MediaItem newItem;
-        newItem.path = path;
-        fAllItems.push_back(newItem);
-        itemToUpdate = &fAllItems.back();
-      }
-
-      if (itemToUpdate) {
-        BString tmp;
-        if (msg->FindString("title", &tmp) == B_OK)
-          itemToUpdate->title = tmp;
-        if (msg->FindString("artist", &tmp) == B_OK)
-          itemToUpdate->artist = tmp;
-        if (msg->FindString("album", &tmp) == B_OK) {
-          DEBUG_PRINT("[MainWindow] Updating Album to: %s\n", tmp.String());
-          itemToUpdate->album = tmp;
-        }
-        if (msg->FindString("genre", &tmp) == B_OK)
-          itemToUpdate->genre = tmp;
-        if (msg->FindString("comment", &tmp) == B_OK)
-          itemToUpdate->comment = tmp;
-
-        int32 val;
-        if (msg->FindInt32("year", &val) == B_OK)
-          itemToUpdate->year = val;
-        if (msg->FindInt32("track", &val) == B_OK)
-          itemToUpdate->track = val;
-        if (msg->FindInt32("trackTotal", &val) == B_OK)
-          itemToUpdate->trackTotal = val;
-        if (msg->FindInt32("disc", &val) == B_OK)
-          itemToUpdate->disc = val;
-        if (msg->FindInt32("discTotal", &val) == B_OK)
-          itemToUpdate->discTotal = val;
-        if (msg->FindInt32("duration", &val) == B_OK)
-          itemToUpdate->duration = val;
-
-        DEBUG_PRINT("[MainWindow] Calling UpdateFilteredViews...\n");
-        UpdateFilteredViews();
-      }
+      const MediaItem *known = fAllItems.Find(path);
+      MediaItem itemToUpdate = known ? *known : MediaItem();
+      itemToUpdate.path = path;
+
+      BString tmp;
+      if (msg->FindString("title", &tmp) == B_OK)
+        itemToUpdate.title = tmp;
+      if (msg->FindString("artist", &tmp) == B_OK)
+        itemToUpdate.artist = tmp;
+      if (msg->FindString("album", &tmp) == B_OK) {
+        DEBUG_PRINT("[MainWindow] Updating Album to: %s\n", tmp.String());
+        itemToUpdate.album = tmp;
+      }
+      if (msg->FindString("albumArtist", &tmp) == B_OK)
+        itemToUpdate.albumArtist = tmp;
+      if (msg->FindString("genre", &tmp) == B_OK)
+        itemToUpdate.genre = tmp;
+      if (msg->FindString("comment", &tmp) == B_OK)
+        itemToUpdate.comment = tmp;
+
+      int32 val;
+      if (msg->FindInt32("year", &val) == B_OK)
+        itemToUpdate.year = val;
+      if (msg->FindInt32("track", &val) == B_OK)
+        itemToUpdate.track = val;
+      if (msg->FindInt32("trackTotal", &val) == B_OK)
+        itemToUpdate.trackTotal = val;
+      if (msg->FindInt32("disc", &val) == B_OK)
+        itemToUpdate.disc = val;
+      if (msg->FindInt32("discTotal", &val) == B_OK)
+        itemToUpdate.discTotal = val;
+      if (msg->FindInt32("duration", &val) == B_OK)
+        itemToUpdate.duration = val;
+
+      const MediaItem &stored = fAllItems.Put(std::move(itemToUpdate));
+      _UpdateSmartPlaylists({&stored});
+
+      DEBUG_PRINT("[MainWindow] Calling UpdateFilteredViews...\n");
+      UpdateFilteredViews();
     }
     break;
   }
@@ -1285,23 +1288,8 @@ void MainWindow::MessageReceived(BMessage *msg) {
     if (msg->FindString("path", &path) == B_OK) {
       DEBUG_PRINT("[MainWindow] remove item: %s\\n", path.String());
 
-      ContentColumnView *cv = fLibraryManager->ContentView();
-      for (int32 i = 0; i < cv->CountRows(); ++i) {
-        const MediaItem *mi = cv->ItemAt(i);
-        if (mi && mi->path == path) {
-          BRow *r = cv->RowAt(i);
-          cv->RemoveRow(r);
-          delete r;
-          break;
-        }
-      }
-
-      auto it =
-          std::remove_if(fAllItems.begin(), fAllItems.end(),
-                         [&](const MediaItem &mi) { return mi.path == path; });
-      if (it != fAllItems.end()) {
-        fAllItems.erase(it, fAllItems.end());
-      }
+      fLibraryManager->RemoveEntry(path);
+      fAllItems.Remove(path);
     }
     break;
   }
@@ -1315,16 +1303,13 @@ void MainWindow::MessageReceived(BMessage *msg) {
       BString artist, title, album, genre;
       int32 year = 0;
       int32 bitrate = 0;
-      for (const auto &media : fAllItems) {
-        if (media.path == path) {
-          artist = media.artist;
-          title = media.title;
-          album = media.album;
-          genre = media.genre;
-          year = media.year;
-          bitrate = media.bitrate;
-          break;
-        }
+      if (const MediaItem *media = fAllItems.Find(path)) {
+        artist = media->artist;
+        title = media->title;
+        album = media->album;
+        genre = media->genre;
+        year = media->year;
+        bitrate = media->bitrate;
       }
 
       BString label;
@@ -1498,18 +1483,22 @@ void MainWindow::MessageReceived(BMessage *msg) {
   }
 
   case MSG_SEARCH_EXECUTE: {
+    _DropViewSnapshot();
     UpdateFilteredViews();
     break;
   }
   case MSG_SELECTION_CHANGED_GENRE: {
+    _DropViewSnapshot();
     UpdateFilteredViews();
     break;
   }
   case MSG_SELECTION_CHANGED_ALBUM: {
+    _DropViewSnapshot();
     UpdateFilteredViews();
     break;
   }
   case MSG_SELECTION_CHANGED_ARTIST: {
+    _DropViewSnapshot();
     UpdateFilteredViews();
     break;
   }
@@ -1581,16 +1570,8 @@ void MainWindow::MessageReceived(BMessage *msg) {
     BBitmap *bmp = nullptr;
     msg->FindPointer("bitmap", (void **)&bmp);
 
-    ContentColumnView *cv = fLibraryManager->ContentView();
-    BRow *row = cv->CurrentSelection();
-    bool match = false;
-    if (row) {
-      int32 idx = cv->IndexOf(row);
-      const MediaItem *mi = cv->ItemAt(idx);
-      if (mi && path == mi->path) {
-        match = true;
-      }
-    }
+    const MediaItem *mi = fLibraryManager->ContentView()->SelectedItem();
+    bool match = mi && path == mi->path;
 
     if (match && bmp && fInfoPanel) {
       if (fShowCoverArt) {
@@ -1614,32 +1595,57 @@ void MainWindow::MessageReceived(BMessage *msg) {
       break;
     }
 
+    std::vector<BString> paths;
     int32 index;
-    bool hadAny = false;
     for (int32 i = 0; msg->FindInt32("index", i, &index) == B_OK; ++i) {
       BString path = GetPathForContentItem(index);
       if (path.IsEmpty())
         continue;
+      paths.push_back(path);
+    }
+    const char *droppedPath = nullptr;
+    for (int32 i = 0; msg->FindString("path", i, &droppedPath) == B_OK; ++i)
+      paths.emplace_back(droppedPath);
 
-      DEBUG_PRINT("[MainWindow] addp: Index=%ld"
-                  ", Playlist=%s, Pfad=%s\\n",
-                  (long)index, playlist.String(), path.String());
+    fPlaylistManager->FlushPending();
+    int32 added = AddItemsToPlaylist(paths, playlist);
+    DEBUG_PRINT("[MainWindow] addp: %ld von %zu Pfaden zu '%s' hinzugefuegt\\n",
+                (long)added, paths.size(), playlist.String());
+    break;
+  }
 
-      AddItemToPlaylist(path, playlist);
-      hadAny = true;
-    }
+  case MSG_FLUSH_PLAYLISTS:
+    fPlaylistManager->FlushPending();
+    break;
 
-    if (!hadAny && msg->FindInt32("index", &index) == B_OK) {
-      BString path = GetPathForContentItem(index);
-      if (path.IsEmpty())
-        break;
+  case MSG_PLAYLIST_CHANGED: {
+    BString name;
+    if (msg->FindString("name", &name) != B_OK)
+      break;
+    if (fIsLibraryMode || name != fCurrentPlaylistName)
+      break;
+
+    _LoadActivePlaylist(name);
+    UpdateFilteredViews();
+    break;
+  }
 
-      DEBUG_PRINT("[MainWindow] addp(single): Index=%ld"
-                  ", Playlist=%s, Pfad=%s\\n",
-                  (long)index, playlist.String(), path.String());
+  case MSG_PLAYLIST_FILES_MISSING: {
+    BString name;
+    if (msg->FindString("playlist", &name) != B_OK)
+      break;
+    if (fIsLibraryMode || name != fCurrentPlaylistName)
+      break;
 
-      AddItemToPlaylist(path, playlist);
-    }
+    std::vector<BString> missing;
+    const char *path = nullptr;
+    for (int32 i = 0; msg->FindString("path", i, &path) == B_OK; i++)
+      missing.emplace_back(path);
+
+    DEBUG_PRINT("[MainWindow] %zu Dateien der Playlist '%s' fehlen\\n",
+                missing.size(), name.String());
+    fLibraryManager->SetMissingPaths(missing);
+    UpdateFilteredViews();
     break;
   }
 
@@ -1673,11 +1679,20 @@ void MainWindow::MessageReceived(BMessage *msg) {
     fIsLibraryMode = (kind == PlaylistItemKind::Library);
     fIsLibraryMode = (kind == PlaylistItemKind::Library);
 
+    // The playlist of the snapshot is selected at startup while its rows are
+    // shown; it is loaded together with the library. Any other choice ends
+    // the restore, or the snapshot's position would land in another list.
+    if (fRestoringView && !fCacheLoaded &&
+        (fSnapshot.playlist.IsEmpty() ? fIsLibraryMode
+                                      : name == fSnapshot.playlist)) {
+      break;
+    }
+    _DropViewSnapshot();
+
     if (fIsLibraryMode) {
       fLibraryManager->SetActivePaths({});
     } else {
-      std::vector<BString> paths = fPlaylistManager->LoadPlaylist(name);
-      fLibraryManager->SetActivePaths(paths);
+      _LoadActivePlaylist(name);
     }
 
     UpdateFilteredViews();
@@ -1789,16 +1804,19 @@ void MainWindow::MessageReceived(BMessage *msg) {
 
       fPlaylistManager->CreateNewPlaylist(name);
 
+      std::vector<BString> paths;
       entry_ref ref;
       int32 i = 0;
       while (fPendingPlaylistFiles.FindRef("refs", i++, &ref) == B_OK) {
         BPath path(&ref);
-        AddItemToPlaylist(path.Path(), name);
-        DEBUG_PRINT(
-            "[MainWindow] Datei '%s' zu neuer Playlist '%s' hinzugefügt\\n",
-            path.Path(), name.String());
+        paths.push_back(path.Path());
       }
       fPendingPlaylistFiles.MakeEmpty();
+
+      int32 added = AddItemsToPlaylist(paths, name);
+      DEBUG_PRINT("[MainWindow] %ld Dateien zu neuer Playlist '%s' "
+                  "hinzugefügt\\n",
+                  (long)added, name.String());
     }
     break;
   }
@@ -1851,25 +1869,13 @@ void MainWindow::MessageReceived(BMessage *msg) {
     if (msg->FindString("old", &oldName) == B_OK &&
         msg->FindString("name", &newName) == B_OK && !newName.IsEmpty()) {
 
-      BPath dirPath;
-      if (find_directory(B_USER_SETTINGS_DIRECTORY, &dirPath) == B_OK) {
-        dirPath.Append("BeTon/Playlists");
-
-        BString oldFile = oldName;
-        oldFile << ".m3u";
-        BString newFile = newName;
-        newFile << ".m3u";
-
-        BPath oldPath(dirPath.Path(), oldFile.String());
-        BPath newPath(dirPath.Path(), newFile.String());
-
-        BEntry entry(oldPath.Path());
-        if (entry.Exists() && entry.Rename(newPath.Path()) == B_OK) {
-          DEBUG_PRINT("[MainWindow] Playlist '%s' → '%s' umbenannt\\n",
-                      oldName.String(), newName.String());
+      fPlaylistManager->FlushPending();
+      if (RenamePlaylistFile(oldName, newName)) {
+        DEBUG_PRINT("[MainWindow] Playlist '%s' → '%s' umbenannt\\n",
+                    oldName.String(), newName.String());
 
-          fPlaylistManager->RenamePlaylist(oldName, newName);
-        }
+        fPlaylistManager->RenamePlaylist(oldName, newName);
+        fSmartPlaylists->Rename(oldName, newName);
       }
     }
     break;
@@ -1904,6 +1910,7 @@ void MainWindow::MessageReceived(BMessage *msg) {
     BMessenger replyTo = msg->ReturnAddress();
     UpdateStatus(B_TRANSLATE("Searching on MusicBrainz..."));
 
+    _MusicBrainz();
     LaunchThread("MBSearch", [this, artist, title, album, replyTo, gen]() {
       if (!fMbClient) {
         DEBUG_PRINT("[MainWindow] Search thread abort: fMbClient is null\\n");
@@ -2120,6 +2127,7 @@ void MainWindow::MessageReceived(BMessage *msg) {
                 recId.String(), relId.String(), files.size());
 
     int32 gen = fMbSearchGeneration;
+    _MusicBrainz();
     LaunchThread("MBApply", [this, recId, relId, files, albumMode, replyTo,
                              gen]() mutable {
       if (!fMbClient) {
@@ -2493,6 +2501,7 @@ void MainWindow::MessageReceived(BMessage *msg) {
     }
 
     int32 gen = fMbSearchGeneration;
+    _MusicBrainz();
     LaunchThread("CoverFetchMB", [this, path, replyTo, gen]() {
       DEBUG_PRINT("[MainWindow] MB Thread started for %s (Gen=%ld)\\n",
                   path.String(), (long)gen);
@@ -2621,6 +2630,9 @@ void MainWindow::MessageReceived(BMessage *msg) {
         fPlaylistPath = path.Path();
         fPlaylistManager->SetPlaylistFolderPath(fPlaylistPath);
         fPlaylistManager->LoadAvailablePlaylists();
+        LaunchThread("PlaylistIndex", [directory = PlaylistDirectory()]() {
+          PlaylistIndex::Validate(directory);
+        });
         SaveSettings();
         BString statusMsg;
         statusMsg.SetToFormat(B_TRANSLATE("Playlist-Ordner gesetzt: %s"),
@@ -2646,136 +2658,75 @@ void MainWindow::MessageReceived(BMessage *msg) {
   }
 
   case MSG_GENERATE_PLAYLIST: {
-    BString name;
-    if (msg->FindString("name", &name) != B_OK || name.IsEmpty()) {
-      name = B_TRANSLATE("Generated Playlist");
-    }
+    SmartPlaylistDefinition def = SmartPlaylistDefinition::FromMessage(*msg);
+    if (def.name.IsEmpty())
+      def.name = B_TRANSLATE("Generated Playlist");
 
-    bool shuffle = false;
-    msg->FindBool("shuffle", &shuffle);
-
-    std::vector<BMessage> rules;
-    BMessage ruleMsg;
-    int32 i = 0;
-    while (msg->FindMessage("rule", i++, &ruleMsg) == B_OK) {
-      rules.push_back(ruleMsg);
-    }
+    fPlaylistManager->FlushPending();
+    size_t count = fSmartPlaylists->Create(def, fAllItems.Items());
+    fPlaylistManager->EnsureListed(def.name);
 
-    int32 limitMode = 0;
-    msg->FindInt32("limit_mode", &limitMode);
-    int32 limitValue = 0;
-    msg->FindInt32("limit_value", &limitValue);
+    BMessage changed(MSG_PLAYLIST_CHANGED);
+    changed.AddString("name", def.name);
+    PostMessage(&changed);
 
-    std::vector<MediaItem> matches;
-    matches.reserve(fAllItems.size());
+    BString statusMsg;
+    statusMsg.SetToFormat(B_TRANSLATE("Playlist '%s' erstellt"),
+                          def.name.String());
+    if (def.shuffle)
+      statusMsg << " " << B_TRANSLATE("(Gemischt)");
+    if (def.limitMode > 0)
+      statusMsg << " " << B_TRANSLATE("(Limitiert)");
 
-    for (const auto &item : fAllItems) {
-      bool allRulesMatch = true;
-
-      for (const auto &r : rules) {
-        int32 type = 0;
-        r.FindInt32("type", &type);
-        BString val1;
-        r.FindString("val1", &val1);
-        BString val2;
-        r.FindString("val2", &val2);
-        bool exclude = false;
-        r.FindBool("exclude", &exclude);
-
-        bool currentRuleMatch = false;
-
-        if (type == 0) {
-          if (!val1.IsEmpty()) {
-            currentRuleMatch = (item.genre.ICompare(val1) == 0);
-          }
-        } else if (type == 1) {
-          if (!val1.IsEmpty()) {
-            currentRuleMatch = (item.artist.IFindFirst(val1) >= 0);
-          }
-        } else if (type == 2) {
-          int32 y1 = atoi(val1.String());
-          int32 y2 = atoi(val2.String());
-
-          if (y1 > 0 && item.year < y1)
-            currentRuleMatch = false;
-          else if (y2 > 0 && item.year > y2)
-            currentRuleMatch = false;
-          else
-            currentRuleMatch = true;
-
-          bool inRange = true;
-          if (y1 > 0 && item.year < y1)
-            inRange = false;
-          if (y2 > 0 && item.year > y2)
-            inRange = false;
-          currentRuleMatch = inRange;
-        }
+    BString countStr;
+    countStr.SetToFormat(B_TRANSLATE(": %zu Titel."), count);
+    statusMsg << countStr;
 
-        if (exclude) {
-          if (currentRuleMatch) {
-            allRulesMatch = false;
-            break;
-          }
-        } else {
-          if (!currentRuleMatch) {
-            allRulesMatch = false;
-            break;
-          }
-        }
-      }
+    UpdateStatus(statusMsg);
+    break;
+  }
 
-      if (allRulesMatch) {
-        matches.push_back(item);
-      }
+  case MSG_FIND_DUPLICATES:
+    if (fCacheManager) {
+      BMessenger(fCacheManager).SendMessage(MSG_FIND_DUPLICATES);
+      UpdateStatus(B_TRANSLATE("Searching for duplicates..."));
     }
+    break;
 
-    if (shuffle) {
-      std::random_device rd;
-      std::mt19937 g(rd());
-      std::shuffle(matches.begin(), matches.end(), g);
-    } else {
-    }
+  case MSG_DUPLICATES_FOUND: {
+    std::vector<BString> paths;
+    BString path;
+    for (int32 i = 0; msg->FindString("path", i, &path) == B_OK; i++)
+      paths.push_back(path);
 
-    if (limitMode > 0 && matches.size() > 0) {
-      if (limitMode == 1) {
-        if ((int32)matches.size() > limitValue) {
-          matches.resize(limitValue);
-        }
-      } else if (limitMode == 2) {
-        int64 maxSeconds = (int64)limitValue * 60;
-        int64 currentSeconds = 0;
-        size_t cutIndex = matches.size();
-        for (size_t k = 0; k < matches.size(); ++k) {
-          currentSeconds += matches[k].duration;
-          if (currentSeconds > maxSeconds) {
-            cutIndex = k;
-            break;
-          }
-        }
-        if (cutIndex < matches.size()) {
-          matches.resize(cutIndex);
-        }
-      }
+    int32 groups = 0;
+    int32 exact = 0;
+    bool isExact;
+    for (; msg->FindBool("exact", groups, &isExact) == B_OK; groups++) {
+      if (isExact)
+        exact++;
     }
 
-    std::vector<BString> paths;
-    paths.reserve(matches.size());
-    for (const auto &m : matches)
-      paths.push_back(m.path);
+    if (paths.empty()) {
+      UpdateStatus(B_TRANSLATE("No duplicates found."));
+      break;
+    }
 
+    // Members of a group are adjacent, so the playlist lists them side by
+    // side for comparison. A playlist of the same name, which may be the
+    // user's own, is left alone.
+    fPlaylistManager->FlushPending();
+    const BString name = UnusedPlaylistName(B_TRANSLATE("Duplicates"));
     fPlaylistManager->SavePlaylist(name, paths);
 
-    BString statusMsg;
-    statusMsg.SetToFormat(B_TRANSLATE("Playlist '%s' erstellt"), name.String());
-    if (shuffle)
-      statusMsg << " " << B_TRANSLATE("(Gemischt)");
-    if (limitMode > 0)
-      statusMsg << " " << B_TRANSLATE("(Limitiert)");
-
-    BString countStr;
-    countStr.SetToFormat(B_TRANSLATE(": %zu Titel."), matches.size());
-    statusMsg << countStr;
+    BMessage changed(MSG_PLAYLIST_CHANGED);
+    changed.AddString("name", name);
+    PostMessage(&changed);
 
+    BString statusMsg;
+    statusMsg.SetToFormat(
+        B_TRANSLATE("%ld groups of duplicates (%ld of them identical)."),
+        (long)groups, (long)exact);
     UpdateStatus(statusMsg);
     break;
   }
@@ -2807,6 +2758,12 @@ void MainWindow::MessageReceived(BMessage *msg) {
   }
 
   case MSG_COUNT_UPDATED:
+    // All rows of the loaded library are in; return to where the user was.
+    if (fRestoringView && fCacheLoaded) {
+      fRestoringView = false;
+      fLibraryManager->ContentView()->RestoreSnapshotPosition(fSnapshot);
+      fSnapshot = ViewSnapshot();
+    }
     _UpdateStatusLibrary();
     break;
 
@@ -2848,6 +2805,187 @@ status_t MainWindow::_ThreadEntry(void *data) {
   return B_OK;
 }
 
+/**
+ * @brief Makes a playlist the active scope.
+ *
+ * Tracks that are not in the library are shown with the playlist's own
+ * metadata right away; whether their files exist is checked on a worker
+ * thread, which reports back with MSG_PLAYLIST_FILES_MISSING.
+ */
+void MainWindow::_LoadActivePlaylist(const BString &name) {
+  fLibraryManager->SetActiveEntries(
+      fPlaylistManager->LoadPlaylistEntries(name));
+
+  std::vector<BString> unknown;
+  for (const auto &path : fLibraryManager->ActivePaths()) {
+    if (!fAllItems.Find(path))
+      unknown.push_back(path);
+  }
+  if (unknown.empty())
+    return;
+
+  BMessenger target(this);
+  LaunchThread("PlaylistCheck", [target, name, unknown]() {
+    BMessage reply(MSG_PLAYLIST_FILES_MISSING);
+    reply.AddString("playlist", name);
+    bool anyMissing = false;
+    for (const auto &path : unknown) {
+      BEntry entry(path.String());
+      if (!entry.Exists()) {
+        reply.AddString("path", path);
+        anyMissing = true;
+      }
+    }
+    if (anyMissing)
+      target.SendMessage(&reply);
+  });
+}
+
+/**
+ * @brief Moves one track of the shown playlist.
+ *
+ * The row object is moved within the view and the playlist model is updated
+ * in memory; the file is written later by the playlist manager. The view
+ * may be filtered or sorted, so the model is moved by the playlist
+ * positions of the two rows rather than by their view indices.
+ */
+bool MainWindow::_MovePlaylistRow(const BString &playlistName, int32 fromIndex,
+                                  int32 toIndex) {
+  ContentColumnView *cv = fLibraryManager->ContentView();
+  const int32 fromPosition = cv->PositionAt(fromIndex);
+  const int32 toPosition = cv->PositionAt(toIndex);
+  if (fromPosition < 0 || toPosition < 0)
+    return false;
+
+  if (!cv->MoveRow(fromIndex, toIndex))
+    return false;
+
+  fPlaylistManager->ReorderPlaylistItem(playlistName, fromPosition,
+                                        toPosition);
+  fLibraryManager->MoveActivePath(fromPosition, toPosition);
+
+  if (BRow *row = cv->RowAt(toIndex)) {
+    cv->DeselectAll();
+    cv->SetFocusRow(row);
+    cv->AddToSelection(row);
+    cv->ScrollTo(row);
+  }
+  return true;
+}
+
+/**
+ * @brief Collects the memory estimates of all subsystems.
+ *
+ * The CacheManager is locked while its entries are counted, and left out
+ * if it stays busy; everything else belongs to this window's thread.
+ */
+BString MainWindow::_MemoryReport() {
+  MemoryReport report;
+
+  report.Add(MEMORY_LIBRARY, "MainWindow library", fAllItems.Count(),
+             report.Library(fAllItems));
+  fAllItems.Albums().AccountMemory(report);
+  if (fCacheManager) {
+    if (fCacheManager->LockLooperWithTimeout(kMemoryReportLockTimeout) ==
+        B_OK) {
+      fCacheManager->AccountMemory(report);
+      fCacheManager->UnlockLooper();
+    } else {
+      DEBUG_PRINT("[MainWindow] CacheManager busy, left out of the memory "
+                  "report\n");
+    }
+  }
+
+  if (fLibraryManager)
+    fLibraryManager->AccountMemory(report);
+  if (fSmartPlaylists)
+    fSmartPlaylists->AccountMemory(report);
+
+  if (fInfoPanel)
+    report.Add(MEMORY_COVERS, "Info panel cover", 1, fInfoPanel->CoverBytes());
+  report.Add(MEMORY_COVERS, "MusicBrainz cover",
+             fPendingCoverBlob.size() ? 1 : 0,
+             fPendingCoverBlob.bytes.capacity());
+
+  BBitmap *icons[] = {fIconPlay,       fIconPause,     fIconStop,
+                      fIconNext,       fIconPrev,      fIconShuffleOff,
+                      fIconShuffleOn,  fIconRepeatOff, fIconRepeatAll,
+                      fIconRepeatOne};
+  size_t iconCount = 0;
+  size_t iconBytes = 0;
+  for (BBitmap *icon : icons) {
+    if (icon) {
+      iconCount++;
+      iconBytes += sizeof(BBitmap) + icon->BitsLength();
+    }
+  }
+  report.Add(MEMORY_COVERS, "Player icons", iconCount, iconBytes);
+
+  int32 queued = 0;
+  const size_t queueBytes = MessageStats::QueuedBytes(MessageQueue(), &queued);
+  report.Add(MEMORY_QUEUES, "MainWindow queue", queued, queueBytes);
+
+  MemoryCounter::AddAll(report);
+  return report.Format();
+}
+
+/**
+ * @brief Shows @p icon on @p button, rasterizing it on first use.
+ */
+void MainWindow::_SetButtonIcon(BButton *button, BBitmap *&icon,
+                                int32 resourceId) {
+  if (!icon)
+    icon = LoadIconFromResource(resourceId, fIconSize);
+  if (icon)
+    button->SetIcon(icon, 0);
+}
+
+/**
+ * @brief Returns the MusicBrainz client, creating it on first use.
+ *
+ * Must be called from the window thread, before the worker threads that
+ * use fMbClient are launched.
+ */
+MusicBrainzClient *MainWindow::_MusicBrainz() {
+  if (!fMbClient)
+    fMbClient = new MusicBrainzClient("beton-app@outlook.com");
+  return fMbClient;
+}
+
+/**
+ * @brief Shows @p text in a read-only window with a fixed-width font.
+ */
+void MainWindow::_ShowReportWindow(const char *title, const BString &text) {
+  BWindow *window =
+      new BWindow(BRect(80, 80, 840, 520), title, B_TITLED_WINDOW,
+                  B_AUTO_UPDATE_SIZE_LIMITS | B_CLOSE_ON_ESCAPE);
+  BTextView *view = new BTextView("report");
+  view->SetFontAndColor(be_fixed_font);
+  view->SetText(text.String());
+  view->MakeEditable(false);
+  BLayoutBuilder::Group<>(window, B_VERTICAL, 0)
+      .Add(new BScrollView("scroll", view, 0, true, true));
+  window->Show();
+}
+
+/**
+ * @brief Re-tests changed tracks against the live smart playlists and
+ * refreshes the view if the shown playlist changed.
+ */
+void MainWindow::_UpdateSmartPlaylists(
+    const std::vector<const MediaItem *> &changed) {
+  fPlaylistManager->FlushPending();
+
+  std::vector<BString> rewritten;
+  fSmartPlaylists->ItemsChanged(changed, rewritten);
+
+  for (const auto &name : rewritten) {
+    BMessage msg(MSG_PLAYLIST_CHANGED);
+    msg.AddString("name", name);
+    PostMessage(&msg);
+  }
+}
+
 /**
  * @brief Triggers a refresh of the library views based on current filters.
  */
@@ -2966,17 +3104,6 @@ void MainWindow::GetPlaylistNames(BMessage &out, bool onlyWritable) const {
   }
 }
 
-/**
- * @brief Adds an entry to a playlist.
- */
-void MainWindow::AddPlaylistEntry(const BString &playlistName,
-                                  const BString &label,
-                                  const BString &fullPath) {
-  if (fPlaylistManager) {
-
-    fPlaylistManager->AddPlaylistEntry(label, fullPath);
-  }
-}
 /**
  * @brief Updates the status bar text.
  *
@@ -3008,16 +3135,13 @@ void MainWindow::_UpdateStatusLibrary() {
   int32 count = 0;
   int64 totalSeconds = 0;
 
-  if (fLibraryManager && fLibraryManager->ContentView()) {
-    ContentColumnView *cv = fLibraryManager->ContentView();
-    count = cv->CountRows();
-    for (int32 i = 0; i < count; ++i) {
-      const MediaItem *mi = cv->ItemAt(i);
-      if (mi)
-        totalSeconds += mi->duration;
-    }
+  if (fLibraryManager) {
+    // Kept up to date by the library manager as rows come and go.
+    const LibraryTotals &totals = fLibraryManager->Totals();
+    count = totals.count;
+    totalSeconds = totals.duration;
   } else {
-    count = fAllItems.size();
+    count = fAllItems.Count();
     for (const auto &mi : fAllItems) {
       totalSeconds += mi.duration;
     }
@@ -3071,6 +3195,17 @@ void MainWindow::SaveSettings() {
       state.Flatten(&file);
     }
   }
+
+  // Until the library is in, the view only shows the old snapshot; keep it.
+  if (fCacheLoaded && !fRestoringView) {
+    ViewSnapshot snapshot;
+    if (!fIsLibraryMode)
+      snapshot.playlist = fCurrentPlaylistName;
+    fLibraryManager->ContentView()->SaveSnapshot(snapshot);
+    BString path = _SnapshotPath();
+    if (!path.IsEmpty())
+      snapshot.Save(path.String());
+  }
 }
 
 /**
@@ -3143,10 +3278,64 @@ void MainWindow::LoadSettings() {
     }
   }
 
-  if (fPlaylistManager && !fPlaylistPath.IsEmpty()) {
+  if (fPlaylistManager && !fPlaylistPath.IsEmpty())
     fPlaylistManager->SetPlaylistFolderPath(fPlaylistPath);
-    fPlaylistManager->LoadAvailablePlaylists();
+}
+
+/**
+ * @brief Lists the playlist folder and validates the playlist index.
+ *
+ * Runs after the first frame; the folder may hold many playlists.
+ */
+void MainWindow::_LoadPlaylists() {
+  if (fPlaylistPath.IsEmpty())
+    return;
+  fPlaylistManager->LoadAvailablePlaylists();
+  LaunchThread("PlaylistIndex", [directory = PlaylistDirectory()]() {
+    PlaylistIndex::Validate(directory);
+  });
+}
+
+BString MainWindow::_SnapshotPath() const {
+  BPath path;
+  if (find_directory(B_USER_SETTINGS_DIRECTORY, &path) != B_OK)
+    return BString();
+  path.Append("BeTon/view_snapshot");
+  return path.Path();
+}
+
+/**
+ * @brief Shows the rows saved at the last exit until the library is loaded.
+ *
+ * Called after LoadSettings(), so the rows are sorted like they were. The
+ * selection and scroll position are restored once all rows are in (see
+ * MSG_COUNT_UPDATED).
+ */
+void MainWindow::_RestoreViewSnapshot() {
+  BString path = _SnapshotPath();
+  if (path.IsEmpty() || fSnapshot.Load(path.String()) != B_OK ||
+      fSnapshot.IsEmpty())
+    return;
+
+  fRestoringView = true;
+  if (!fSnapshot.playlist.IsEmpty()) {
+    fCurrentPlaylistName = fSnapshot.playlist;
+    fIsLibraryMode = false;
   }
+  fLibraryManager->ContentView()->ShowSnapshot(fSnapshot);
+}
+
+/**
+ * @brief Gives up restoring the snapshot's selection and scroll position.
+ *
+ * Called when the user changes what the track list shows before all rows
+ * are in.
+ */
+void MainWindow::_DropViewSnapshot() {
+  if (!fRestoringView)
+    return;
+  fRestoringView = false;
+  fSnapshot = ViewSnapshot();
 }
 
 /**
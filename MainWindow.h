@@ -4,12 +4,16 @@
 #include "CacheManager.h"
 #include "LibraryViewManager.h"
 #include "MediaItem.h"
+#include "MediaLibrary.h"
 #include "MediaPlaybackController.h"
+#include "MessageStats.h"
 #include "Messages.h"
 #include "MetadataHandler.h"
 #include "MusicBrainzClient.h"
 #include "PlaylistManager.h"
+#include "SmartPlaylist.h"
 #include "TagSync.h"
+#include "ViewSnapshot.h"
 
 #include <Bitmap.h>
 #include <Button.h>
@@ -30,6 +34,7 @@
 class SeekBarView;
 class InfoPanel;
 class PropertiesWindow;
+class UIWorkQueue;
 
 /**
  * @class MainWindow
@@ -52,14 +57,13 @@ public:
   MainWindow();
   virtual ~MainWindow();
 
+  void DispatchMessage(BMessage *msg, BHandler *handler) override;
   void MessageReceived(BMessage *msg) override;
 
   /** @name Helpers used by child windows/components */
   ///@{
   BString GetPathForContentItem(int index);
   void GetPlaylistNames(BMessage &out, bool onlyWritable = true) const;
-  void AddPlaylistEntry(const BString &playlistName, const BString &label,
-                        const BString &fullPath);
 
   ///@}
 
@@ -92,10 +96,23 @@ private:
   void _BuildUI();
   void _SelectPlaylistFolder();
   void _UpdateStatusLibrary();
+  void _UpdateSmartPlaylists(const std::vector<const MediaItem *> &changed);
+  void _LoadActivePlaylist(const BString &name);
+  bool _MovePlaylistRow(const BString &playlistName, int32 fromIndex,
+                        int32 toIndex);
+  BString _MemoryReport();
+  void _SetButtonIcon(BButton *button, BBitmap *&icon, int32 resourceId);
+  void _LoadPlaylists();
+  BString _SnapshotPath() const;
+  void _RestoreViewSnapshot();
+  void _DropViewSnapshot();
+  MusicBrainzClient *_MusicBrainz();
+  void _ShowReportWindow(const char *title, const BString &text);
 
   /** @name Data & State */
   ///@{
-  std::vector<MediaItem> fAllItems; ///< Complete database cache
+  MediaLibrary fAllItems; ///< Complete database cache, indexed by path
+  MessageStats fMessageStats{"MainWindow"}; ///< Timing of handled messages
   bool fIsLibraryMode = true; ///< True = All tracks, False = Playlist view
   int32 fMbSearchGeneration =
       0; ///< Generation counter to invalidate old async searches
@@ -112,11 +129,10 @@ private:
 
   /** @name Cache Loading State */
   ///@{
-  std::vector<MediaItem> fPendingItems;
-  std::set<BString> fKnownPaths;
-  int32 fCurrentIndex{0};
   int32 fNewFilesCount{0};
   bool fCacheLoaded = false;
+  ViewSnapshot fSnapshot;      ///< Shown until the library is loaded
+  bool fRestoringView = false; ///< Snapshot rows are shown
 
   ///@}
 
@@ -162,8 +178,11 @@ private:
 
   ///@}
 
-  /** @name Player Icon Bitmaps */
+  /** @name Player Icon Bitmaps
+   * Rasterized on first use by _SetButtonIcon().
+   */
   ///@{
+  float fIconSize = 16.0f;
   BBitmap *fIconPlay{nullptr};
   BBitmap *fIconPause{nullptr};
   BBitmap *fIconStop{nullptr};
@@ -186,6 +205,7 @@ private:
   void ApplyColors();
   BMenuItem *fSelColorSystemItem = nullptr;
   BMenuItem *fSelColorMatchItem = nullptr;
+  BMenuItem *fTraceItem = nullptr;
 
   ///@}
 
@@ -199,17 +219,18 @@ private:
   ///@{
   LibraryViewManager *fLibraryManager;
   PlaylistManager *fPlaylistManager;
+  SmartPlaylistManager *fSmartPlaylists;
   MetadataHandler *fMetadataHandler;
+  UIWorkQueue *fWorkQueue; ///< Slices long view updates between messages
 
   CacheManager *fCacheManager;
-  MusicBrainzClient *fMbClient;
+  MusicBrainzClient *fMbClient{nullptr}; ///< Created by _MusicBrainz()
   MediaPlaybackController *fController;
 
   ///@}
 
   /** @name Message Runners (Timers) */
   ///@{
-  BMessageRunner *fBatchRunner{nullptr};  ///< Slow-loading UI batch timer
   BMessageRunner *fUpdateRunner{nullptr}; ///< Playback progress update timer
   BMessageRunner *fStatusRunner{nullptr}; ///< Status bar clear timer
   BMessageRunner *fSearchRunner{nullptr}; ///< Search debounce timer
@@ -2,6 +2,7 @@
 
 #include "MatcherWindow.h"
 #include "Debug.h"
+#include "MatchingUtils.h"
 #include "Messages.h"
 #include "TagSync.h"
 
@@ -360,29 +361,6 @@ void MatcherWindow::_Apply() {
   Quit();
 }
 
-/**
- * @brief Helper to calculate Levenshtein distance for fuzzy string matching.
- */
-int _LevenshteinDistance(const char *s1, const char *s2) {
-  int len1 = strlen(s1);
-  int len2 = strlen(s2);
-  std::vector<std::vector<int>> d(len1 + 1, std::vector<int>(len2 + 1));
-
-  for (int i = 0; i <= len1; i++)
-    d[i][0] = i;
-  for (int j = 0; j <= len2; j++)
-    d[0][j] = j;
-
-  for (int i = 1; i <= len1; i++) {
-    for (int j = 1; j <= len2; j++) {
-      int cost = (tolower(s1[i - 1]) == tolower(s2[j - 1])) ? 0 : 1;
-      d[i][j] =
-          std::min({d[i - 1][j] + 1, d[i][j - 1] + 1, d[i - 1][j - 1] + cost});
-    }
-  }
-  return d[len1][len2];
-}
-
 static int ParseDuration(const BString &durStr) {
   if (durStr.IsEmpty())
     return 0;
@@ -415,132 +393,38 @@ void MatcherWindow::_SmartMatch() {
     fTrackListView->MakeEmpty();
   }
 
-  struct Score {
-    int score;
-    size_t fileIdx;
-    size_t trackIdx;
-  };
-
-  std::vector<Score> allScores;
-  allScores.reserve(fFiles.size() * fTracks.size());
-
-  struct FileInfo {
-    int durationSec;
-    int trackNum;
-    BString cleanName;
-  };
-
   // Pre-calculate file info (tags, duration, clean name)
-  std::vector<FileInfo> fileInfos(fFiles.size());
+  std::vector<MatchFile> files(fFiles.size());
   for (size_t i = 0; i < fFiles.size(); i++) {
     TagData td;
     TagSync::ReadTags(BPath(fFiles[i].String()), td);
-    fileInfos[i].durationSec = td.lengthSec;
+    files[i].durationSec = td.lengthSec;
 
+    BString fn = BPath(fFiles[i].String()).Leaf();
     if (td.track > 0) {
-      fileInfos[i].trackNum = td.track;
+      files[i].trackNum = td.track;
     } else {
       // Fallback: Try reading track number from filename
-      BString fn = BPath(fFiles[i].String()).Leaf();
-      const char *s = fn.String();
-      while (*s && !isdigit(*s))
-        s++;
-      fileInfos[i].trackNum = (*s) ? atoi(s) : 0;
+      files[i].trackNum = MatchingUtils::ExtractTrackNumber(fn.String());
     }
-
-    // Heuristic: Clean filename for similarity check
-    BString fn = BPath(fFiles[i].String()).Leaf();
-    int lastDot = fn.FindLast('.');
-    if (lastDot > 0)
-      fn.Truncate(lastDot);
-
-    const char *p = fn.String();
-    while (*p &&
-           (isdigit(*p) || isspace(*p) || *p == '-' || *p == '.' || *p == '_'))
-      p++;
-    fileInfos[i].cleanName = p;
+    files[i].cleanName = MatchingUtils::CleanFileName(fn.String());
   }
 
-  // Calculate scores matrix
-  for (size_t i = 0; i < fFiles.size(); i++) {
-    for (size_t k = 0; k < fTracks.size(); k++) {
-      int score = 0;
-      const MatcherTrackInfo &trk = fTracks[k];
-      const FileInfo &file = fileInfos[i];
-
-      // 1. Duration Match
-      int trkLen = ParseDuration(trk.duration);
-      if (trkLen > 0 && file.durationSec > 0) {
-        int diff = std::abs(trkLen - file.durationSec);
-        if (diff <= 1)
-          score += 50;
-        else if (diff <= 3)
-          score += 30;
-        else if (diff <= 10)
-          score -= 20;
-        else
-          score -= 50;
-      }
-
-      // 2. Track Number Match
-      if (file.trackNum > 0 && file.trackNum == trk.index) {
-        score += 40;
-      }
-
-      // 3. Name Similarity
-      if (!file.cleanName.IsEmpty() && !trk.name.IsEmpty()) {
-        if (file.cleanName.IFindFirst(trk.name) >= 0) {
-          score += 25;
-        } else {
-          int dist =
-              _LevenshteinDistance(file.cleanName.String(), trk.name.String());
-          int maxLen = std::max(file.cleanName.Length(), trk.name.Length());
-          if (maxLen > 0) {
-            float sim = 1.0f - (float)dist / (float)maxLen;
-            if (sim > 0.8f)
-              score += 20;
-            else if (sim > 0.5f)
-              score += 10;
-          }
-        }
-      }
-
-      allScores.push_back({score, i, k});
-    }
+  std::vector<MatchTrack> tracks(fTracks.size());
+  for (size_t k = 0; k < fTracks.size(); k++) {
+    tracks[k].durationSec = ParseDuration(fTracks[k].duration);
+    tracks[k].index = fTracks[k].index;
+    tracks[k].name = fTracks[k].name;
   }
 
-  // Greedy Assignment based on score
-  std::sort(allScores.begin(), allScores.end(),
-            [](const Score &a, const Score &b) { return a.score > b.score; });
-
+  const std::vector<int> matched = MatchingUtils::AssignTracks(files, tracks);
   std::vector<MatcherTrackInfo *> assignments(fFiles.size(), nullptr);
-  std::vector<bool> fileAssigned(fFiles.size(), false);
   std::vector<bool> trackUsed(fTracks.size(), false);
-
-  for (const auto &s : allScores) {
-    if (s.score < 0)
-      break;
-
-    if (!fileAssigned[s.fileIdx] && !trackUsed[s.trackIdx]) {
-      assignments[s.fileIdx] =
-          const_cast<MatcherTrackInfo *>(&fTracks[s.trackIdx]);
-      fileAssigned[s.fileIdx] = true;
-      trackUsed[s.trackIdx] = true;
-    }
-  }
-
-  // Fill gaps sequentially for unmatched files
-  size_t trackIdx = 0;
-  for (size_t i = 0; i < fFiles.size(); i++) {
-    if (!assignments[i]) {
-      while (trackIdx < fTracks.size() && trackUsed[trackIdx])
-        trackIdx++;
-
-      if (trackIdx < fTracks.size()) {
-        assignments[i] = const_cast<MatcherTrackInfo *>(&fTracks[trackIdx]);
-        trackUsed[trackIdx] = true;
-      }
-    }
+  for (size_t i = 0; i < matched.size(); i++) {
+    if (matched[i] < 0)
+      continue;
+    assignments[i] = const_cast<MatcherTrackInfo *>(&fTracks[matched[i]]);
+    trackUsed[matched[i]] = true;
   }
 
   // Populate List View
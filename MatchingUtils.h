@@ -5,8 +5,30 @@
 #include <SupportDefs.h>
 #include <algorithm>
 #include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
 #include <vector>
 
+/**
+ * @struct MatchFile
+ * @brief What the matcher knows about a local file.
+ */
+struct MatchFile {
+  int durationSec = 0; ///< Length from the tags, 0 if unknown.
+  int trackNum = 0;    ///< Track number from the tags or the file name.
+  BString cleanName;   ///< File name without number prefix and extension.
+};
+
+/**
+ * @struct MatchTrack
+ * @brief What the matcher knows about a MusicBrainz track.
+ */
+struct MatchTrack {
+  int durationSec = 0; ///< Length, 0 if unknown.
+  int index = 0;       ///< Position on the release.
+  BString name;
+};
+
 /**
  * @class MatchingUtils
  * @brief Static helper class for string similarity and metadata extraction.
@@ -15,6 +37,7 @@
  * - Levenshtein distance calculation.
  * - String similarity scoring.
  * - Extracting track numbers from filenames.
+ * - Assigning local files to the tracks of a release.
  */
 class MatchingUtils {
 public:
@@ -94,6 +117,116 @@ public:
     int dist = LevenshteinDistance(s1, s2);
     return 1.0f - (float)dist / maxLen;
   }
+
+  /**
+   * @brief Strips the extension and a leading track number from a file name.
+   *
+   * "01 - Intro.flac" becomes "Intro".
+   */
+  static BString CleanFileName(const char *leaf) {
+    BString fn(leaf);
+    int32 lastDot = fn.FindLast('.');
+    if (lastDot > 0)
+      fn.Truncate(lastDot);
+
+    const char *p = fn.String();
+    while (*p &&
+           (isdigit(*p) || isspace(*p) || *p == '-' || *p == '.' || *p == '_'))
+      p++;
+    return BString(p);
+  }
+
+  /**
+   * @brief Weighted score of a file for a track.
+   *
+   * Duration within 1 s gives +50 (3 s: +30, 10 s: -20, more: -50), an equal
+   * track number +40, a name containing the track name +25 and otherwise a
+   * name similarity above 0.8 +20 (above 0.5: +10).
+   */
+  static int MatchScore(const MatchFile &file, const MatchTrack &track) {
+    int score = 0;
+
+    if (track.durationSec > 0 && file.durationSec > 0) {
+      int diff = std::abs(track.durationSec - file.durationSec);
+      if (diff <= 1)
+        score += 50;
+      else if (diff <= 3)
+        score += 30;
+      else if (diff <= 10)
+        score -= 20;
+      else
+        score -= 50;
+    }
+
+    if (file.trackNum > 0 && file.trackNum == track.index)
+      score += 40;
+
+    if (!file.cleanName.IsEmpty() && !track.name.IsEmpty()) {
+      if (file.cleanName.IFindFirst(track.name) >= 0) {
+        score += 25;
+      } else {
+        float sim = Similarity(file.cleanName.String(), track.name.String());
+        if (sim > 0.8f)
+          score += 20;
+        else if (sim > 0.5f)
+          score += 10;
+      }
+    }
+    return score;
+  }
+
+  /**
+   * @brief Assigns each file the best scoring free track.
+   *
+   * Pairs are taken greedily by descending score; files left without a
+   * non-negative match get the remaining tracks in order.
+   *
+   * @return Track index for each file, or -1 if there are more files than
+   * tracks.
+   */
+  static std::vector<int> AssignTracks(const std::vector<MatchFile> &files,
+                                       const std::vector<MatchTrack> &tracks) {
+    struct Score {
+      int score;
+      size_t fileIdx;
+      size_t trackIdx;
+    };
+
+    std::vector<Score> allScores;
+    allScores.reserve(files.size() * tracks.size());
+    for (size_t i = 0; i < files.size(); i++) {
+      for (size_t k = 0; k < tracks.size(); k++)
+        allScores.push_back({MatchScore(files[i], tracks[k]), i, k});
+    }
+
+    std::stable_sort(
+        allScores.begin(), allScores.end(),
+        [](const Score &a, const Score &b) { return a.score > b.score; });
+
+    std::vector<int> assignments(files.size(), -1);
+    std::vector<bool> trackUsed(tracks.size(), false);
+    for (const auto &s : allScores) {
+      if (s.score < 0)
+        break;
+      if (assignments[s.fileIdx] < 0 && !trackUsed[s.trackIdx]) {
+        assignments[s.fileIdx] = (int)s.trackIdx;
+        trackUsed[s.trackIdx] = true;
+      }
+    }
+
+    size_t trackIdx = 0;
+    for (size_t i = 0; i < files.size(); i++) {
+      if (assignments[i] >= 0)
+        continue;
+      while (trackIdx < tracks.size() && trackUsed[trackIdx])
+        trackIdx++;
+      if (trackIdx < tracks.size()) {
+        assignments[i] = (int)trackIdx;
+        trackUsed[trackIdx] = true;
+      }
+    }
+    return assignments;
+  }
 };
 
 #endif // MATCHING_UTILS_H
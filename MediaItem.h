@@ -57,10 +57,17 @@ struct MediaItem {
   int64 size = 0;   ///< File size in bytes.
   int64 mtime = 0; ///< Last modification time (for cache invalidation).
   int64 inode = 0;  ///< File system inode number (stable identifier).
+  int64 device = 0; ///< Device the inode belongs to.
+  int64 partialHash = 0; ///< Hash of the first and last 8 KiB, 0 if unknown.
   bool missing =
       false; ///< Flag indicating if file was not found during last scan.
   ///@}
 
+  /** @name Library */
+  ///@{
+  uint32 albumId = 0; ///< Album in the library's AlbumTable; 0 if none.
+  ///@}
+
   /**
    * @brief Default constructor.
    */
@@ -0,0 +1,90 @@
+#include "MediaLibrary.h"
+
+ssize_t MediaLibrary::IndexOf(const BString &path) const {
+  auto it = fIndex.find(path);
+  return it != fIndex.end() ? (ssize_t)it->second : -1;
+}
+
+const MediaItem *MediaLibrary::Find(const BString &path) const {
+  ssize_t index = IndexOf(path);
+  return index >= 0 ? &fItems[index] : nullptr;
+}
+
+MediaItem *MediaLibrary::Find(const BString &path) {
+  ssize_t index = IndexOf(path);
+  return index >= 0 ? &fItems[index] : nullptr;
+}
+
+void MediaLibrary::Assign(std::vector<MediaItem> &&items) {
+  fItems = std::move(items);
+  fIndex.clear();
+  fIndex.reserve(fItems.size());
+  _Reindex(0);
+
+  fAlbums.Clear();
+  for (MediaItem &item : fItems)
+    item.albumId = fAlbums.Add(item);
+  fGeneration++;
+}
+
+void MediaLibrary::Clear() {
+  fItems.clear();
+  fIndex.clear();
+  fAlbums.Clear();
+  fGeneration++;
+}
+
+const MediaItem &MediaLibrary::Put(MediaItem item, bool *added) {
+  fGeneration++;
+  auto it = fIndex.find(item.path);
+  if (added)
+    *added = (it == fIndex.end());
+  if (it != fIndex.end()) {
+    MediaItem &stored = fItems[it->second];
+    fAlbums.Remove(stored);
+    item.albumId = fAlbums.Add(item);
+    stored = std::move(item);
+    return stored;
+  }
+
+  item.albumId = fAlbums.Add(item);
+  fIndex.emplace(item.path, fItems.size());
+  fItems.push_back(std::move(item));
+  return fItems.back();
+}
+
+bool MediaLibrary::Move(const BString &from, const BString &to) {
+  auto it = fIndex.find(from);
+  if (it == fIndex.end() || fIndex.count(to) > 0)
+    return false;
+
+  const size_t index = it->second;
+  fIndex.erase(it);
+  fIndex.emplace(to, index);
+  fAlbums.Move(fItems[index], to);
+  fItems[index].path = to;
+  fGeneration++;
+  return true;
+}
+
+bool MediaLibrary::Remove(const BString &path) {
+  auto it = fIndex.find(path);
+  if (it == fIndex.end())
+    return false;
+
+  const size_t index = it->second;
+  fIndex.erase(it);
+  fAlbums.Remove(fItems[index]);
+  fItems.erase(fItems.begin() + index);
+  _Reindex(index);
+  fGeneration++;
+  return true;
+}
+
+/**
+ * @brief Re-records the positions of all items starting at @p from.
+ */
+void MediaLibrary::_Reindex(size_t from) {
+  for (size_t i = from; i < fItems.size(); i++)
+    fIndex[fItems[i].path] = i;
+}
@@ -0,0 +1,100 @@
+#ifndef MEDIA_LIBRARY_H
+#define MEDIA_LIBRARY_H
+
+#include "AlbumTable.h"
+#include "HashUtils.h"
+#include "MediaItem.h"
+
+#include <String.h>
+#include <SupportDefs.h>
+
+#include <vector>
+
+/**
+ * @class MediaLibrary
+ * @brief The window's copy of the library with a path index.
+ *
+ * Items are stored contiguously in cache order; a hash map from path to
+ * position makes lookups by path O(1). Pointers and references to items stay
+ * valid until the next Put, Remove, Assign or Clear.
+ *
+ * Every item is filed in the album table as it is stored, which sets its
+ * MediaItem::albumId. Tag changes must therefore go through Put(), not
+ * through the mutable accessors.
+ */
+class MediaLibrary {
+public:
+  /** @name Access */
+  ///@{
+  const std::vector<MediaItem> &Items() const { return fItems; }
+  size_t Count() const { return fItems.size(); }
+  bool IsEmpty() const { return fItems.empty(); }
+
+  const MediaItem &ItemAt(size_t index) const { return fItems[index]; }
+  MediaItem &ItemAt(size_t index) { return fItems[index]; }
+
+  std::vector<MediaItem>::const_iterator begin() const {
+    return fItems.begin();
+  }
+  std::vector<MediaItem>::const_iterator end() const { return fItems.end(); }
+  ///@}
+
+  /** @name Lookup */
+  ///@{
+  /**
+   * @brief Returns the position of the item with the given path.
+   * @return The index, or -1 if the path is not in the library.
+   */
+  ssize_t IndexOf(const BString &path) const;
+
+  const MediaItem *Find(const BString &path) const;
+  MediaItem *Find(const BString &path);
+
+  /**
+   * @brief Changes whenever items are added, removed, moved or replaced,
+   * so derived indexes can tell they are stale.
+   */
+  uint32 Generation() const { return fGeneration; }
+
+  const AlbumTable &Albums() const { return fAlbums; }
+  ///@}
+
+  /** @name Modification */
+  ///@{
+  /**
+   * @brief Replaces the whole content and rebuilds the index.
+   */
+  void Assign(std::vector<MediaItem> &&items);
+  void Clear();
+
+  /**
+   * @brief Stores @p item, replacing the item with the same path or
+   * appending it, and files it under its album.
+   * @param added Set to true if a new item was appended.
+   * @return The stored item.
+   */
+  const MediaItem &Put(MediaItem item, bool *added = nullptr);
+
+  /**
+   * @brief Changes the path of an item, keeping its position and metadata.
+   * @return False if @p from is unknown or @p to is already in the library.
+   */
+  bool Move(const BString &from, const BString &to);
+
+  /**
+   * @brief Removes the item with the given path, keeping the order of the rest.
+   * @return False if the path is not in the library.
+   */
+  bool Remove(const BString &path);
+  ///@}
+
+private:
+  void _Reindex(size_t from);
+
+  std::vector<MediaItem> fItems;
+  BStringMap<size_t> fIndex;
+  AlbumTable fAlbums;
+  uint32 fGeneration = 0;
+};
+
+#endif // MEDIA_LIBRARY_H
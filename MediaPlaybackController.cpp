@@ -1,5 +1,6 @@
 #include "MediaPlaybackController.h"
 #include "Debug.h"
+#include "Trace.h"
 
 #include <Entry.h>
 #include <Message.h>
@@ -87,6 +88,7 @@ void MediaPlaybackController::SetVolume(float percent) {
  * @param trackIndex Index of the track in fQueue to play.
  */
 void MediaPlaybackController::Play(size_t trackIndex) {
+  TRACE_SPAN("playback", "Play");
   DEBUG_PRINT("[Controller] Play(%zu) called\n", trackIndex);
 
   Stop();
@@ -335,8 +337,10 @@ void MediaPlaybackController::_PlayBuffer(
   int64 frames = frameSize > 0 ? (int64)(size / frameSize) : 0;
 
   status_t ret = B_ERROR;
-  if (self->fTrack && frames > 0)
+  if (self->fTrack && frames > 0) {
+    TRACE_SPAN("playback", "ReadFrames");
     ret = self->fTrack->ReadFrames(buffer, &frames);
+  }
 
   if (ret == B_OK && frames > 0) {
     self->fCurrentPos +=
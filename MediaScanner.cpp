@@ -1,15 +1,22 @@
 #include "MediaScanner.h"
 #include "Debug.h"
+#include "MemoryReport.h"
+#include "MessageStats.h"
 #include "Messages.h"
+#include "Trace.h"
 
 #include <Node.h>
 #include <Path.h>
 #include <stack>
 #include <sys/stat.h>
+#include <vector>
 #include <taglib/fileref.h>
 #include <taglib/tag.h>
 #include <taglib/tpropertymap.h>
 
+/** Cache copies held by running scanners. */
+static MemoryCounter sScannerCaches(MEMORY_LIBRARY, "MediaScanner caches");
+
 /**
  * @brief Constructor.
  *
@@ -51,6 +58,29 @@ MediaScanner::~MediaScanner() {
   wait_for_thread(fWorkerThread, &exitValue);
 
   delete_sem(fControlSem);
+  sScannerCaches.Remove(fCache.size(), fCacheBytes);
+}
+
+void MediaScanner::SetCache(const std::map<BString, MediaItem> &cache) {
+  sScannerCaches.Remove(fCache.size(), fCacheBytes);
+
+  fCache = cache;
+  fByInode.clear();
+  fByContent.clear();
+  for (const auto &[path, item] : fCache) {
+    if (item.inode != 0)
+      fByInode.emplace(item.inode, path);
+    if (item.partialHash != 0)
+      fByContent.emplace(std::make_pair(item.size, item.partialHash), path);
+  }
+
+  // The strings are shared with the CacheManager's copy.
+  const size_t node = MemoryReport::kMapNode + MemoryReport::kAllocation;
+  fCacheBytes =
+      fCache.size() * (node + sizeof(BString) + sizeof(MediaItem)) +
+      fByInode.size() * (node + sizeof(int64) + sizeof(BString)) +
+      fByContent.size() * (node + 2 * sizeof(int64) + sizeof(BString));
+  sScannerCaches.Add(fCache.size(), fCacheBytes);
 }
 
 /**
@@ -97,6 +127,107 @@ static bool IsSupportedAudioFile(const BString &path) {
   return false;
 }
 
+/** Bytes hashed at the start and at the end of a file. */
+static const off_t kPartialHashBlock = 8 * 1024;
+
+/**
+ * @brief Hashes the size and the first and last kPartialHashBlock bytes.
+ *
+ * Identifies a file well enough to follow it when the inode changes, e.g.
+ * after it was copied to another volume. The blocks are mostly the ones
+ * TagLib reads anyway.
+ *
+ * @return The hash (FNV-1a), or 0 if the file could not be read.
+ */
+static int64 PartialHash(const char *path, off_t size) {
+  BFile file(path, B_READ_ONLY);
+  if (file.InitCheck() != B_OK)
+    return 0;
+
+  uint64 hash = 14695981039346656037ULL;
+  auto mix = [&hash](const uint8 *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+      hash ^= data[i];
+      hash *= 1099511628211ULL;
+    }
+  };
+
+  std::vector<uint8> block(kPartialHashBlock);
+  ssize_t n = file.ReadAt(0, block.data(), block.size());
+  if (n < 0)
+    return 0;
+  mix(block.data(), n);
+
+  if (size > kPartialHashBlock) {
+    n = file.ReadAt(size - kPartialHashBlock, block.data(), block.size());
+    if (n < 0)
+      return 0;
+    mix(block.data(), n);
+  }
+
+  mix(reinterpret_cast<const uint8 *>(&size), sizeof(size));
+  return hash != 0 ? (int64)hash : 1;
+}
+
+/**
+ * @brief Looks for a cached file that now lives at a new path.
+ *
+ * A cached entry matches if its old path is gone and it has the same device
+ * and inode (a move within the volume), or the same size and partial hash
+ * (a copy to another volume followed by a delete). A matched entry is
+ * claimed, so two new files never take over the same identity.
+ *
+ * @param st Stat of the new file.
+ * @param partialHash PartialHash() of the new file.
+ * @param outOld Receives the cached entry.
+ * @return True if a match was found.
+ */
+bool MediaScanner::_FindMovedFrom(const struct stat &st, int64 partialHash,
+                                  MediaItem &outOld) {
+  auto claim = [this, &outOld](const BString &oldPath) {
+    auto cached = fCache.find(oldPath);
+    if (cached == fCache.end())
+      return false;
+
+    struct stat oldSt;
+    if (stat(oldPath.String(), &oldSt) == 0)
+      return false; // Still there; this is a copy or a hard link.
+
+    outOld = cached->second;
+    fCache.erase(cached);
+    return true;
+  };
+
+  auto range = fByInode.equal_range((int64)st.st_ino);
+  for (auto it = range.first; it != range.second; ++it) {
+    auto cached = fCache.find(it->second);
+    if (cached == fCache.end())
+      continue;
+    const MediaItem &old = cached->second;
+    if (old.device != 0 && old.device != (int64)st.st_dev)
+      continue;
+    if (old.size != st.st_size)
+      continue;
+    if (claim(it->second)) {
+      fByInode.erase(it);
+      return true;
+    }
+  }
+
+  if (partialHash == 0)
+    return false;
+
+  auto content = fByContent.equal_range(
+      std::make_pair((int64)st.st_size, partialHash));
+  for (auto it = content.first; it != content.second; ++it) {
+    if (claim(it->second)) {
+      fByContent.erase(it);
+      return true;
+    }
+  }
+  return false;
+}
+
 /**
  * @brief Processes a single file entry.
  *
@@ -104,13 +235,16 @@ static bool IsSupportedAudioFile(const BString &path) {
  * 1. Validates file extension and existence.
  * 2. FAST SKIP: Checks against `fCache` to see if file is unchanged
  * (mtime/size).
- * 3. METADATA: Extracts tags (Title, Artist, Album, Year, MBIDs) using TagLib.
- * 4. BATCHING: Adds the resulting `MediaItem` to `fBatchBuffer` and flushes if
+ * 3. MOVES: A new path whose inode or content matches a vanished cached file
+ * keeps that file's identity; if it is unchanged, its tags are not re-read.
+ * 4. METADATA: Extracts tags (Title, Artist, Album, Year, MBIDs) using TagLib.
+ * 5. BATCHING: Adds the resulting `MediaItem` to `fBatchBuffer` and flushes if
  * full.
  *
  * @param entry The file entry to process.
  */
 void MediaScanner::ProcessFile(BEntry &entry) {
+  TRACE_SPAN("scanner", "ProcessFile");
   BPath path;
 
   if (entry.GetPath(&path) != B_OK)
@@ -126,9 +260,11 @@ void MediaScanner::ProcessFile(BEntry &entry) {
     return;
 
   // 2. FAST SKIP: Check Cache
+  bool known = false;
   if (!fCache.empty()) {
     auto it = fCache.find(filePath);
     if (it != fCache.end()) {
+      known = true;
       const MediaItem &old = it->second;
       if (old.mtime == st.st_mtime && old.size == st.st_size) {
         // Unchanged -> Skip rigorous parsing
@@ -140,16 +276,44 @@ void MediaScanner::ProcessFile(BEntry &entry) {
   fFoundFiles++;
   ReportProgress();
 
+  BPath parentPath;
+  BString itemBase = fBasePath;
+  if (path.GetParent(&parentPath) == B_OK)
+    itemBase = parentPath.Path();
+
+  const int64 partialHash = PartialHash(path.Path(), st.st_size);
+
+  // 3. MOVES: Check whether a vanished file was moved here
+  MediaItem movedFrom;
+  bool moved = !known && _FindMovedFrom(st, partialHash, movedFrom);
+  if (moved && movedFrom.mtime == st.st_mtime) {
+    // Same file under a new name -> keep the stored tags
+    MediaItem item = movedFrom;
+    item.path = filePath;
+    item.base = itemBase;
+    item.inode = st.st_ino;
+    item.device = st.st_dev;
+    item.partialHash = partialHash;
+    item.missing = false;
+
+    DEBUG_PRINT("[MediaScanner] Moved: %s -> %s\n", movedFrom.path.String(),
+                filePath.String());
+    _QueueItem(item, movedFrom.path);
+    return;
+  }
+
   // Metadata Extraction
-  BString title, artist, album, genre;
+  BString title, artist, album, albumArtist, genre;
   int32 year = 0;
   int32 track = 0;
   int32 disc = 0;
+  int32 discTotal = 0;
   int32 bitrate = 0;
   int32 duration = 0;
   BString mbTrackId, mbAlbumId, mbArtistId;
 
   try {
+    TRACE_SPAN("scanner", "ReadTags");
     TagLib::FileRef f(path.Path());
 
     if (!f.isNull() && f.tag()) {
@@ -167,6 +331,10 @@ void MediaScanner::ProcessFile(BEntry &entry) {
         TagLib::StringList l = props["DISCNUMBER"];
         if (!l.isEmpty()) {
           disc = l.front().toInt();
+          // "1/2" carries the disc total
+          const int slash = l.front().find("/");
+          if (slash >= 0)
+            discTotal = l.front().substr(slash + 1).toInt();
         }
       }
 
@@ -179,6 +347,13 @@ void MediaScanner::ProcessFile(BEntry &entry) {
         }
       };
 
+      getProp("ALBUMARTIST", albumArtist);
+      if (discTotal == 0 && props.contains("DISCTOTAL")) {
+        TagLib::StringList l = props["DISCTOTAL"];
+        if (!l.isEmpty())
+          discTotal = l.front().toInt();
+      }
+
       BString localMbTrackId, localMbAlbumId, localMbArtistId;
       getProp("MUSICBRAINZ_TRACKID", localMbTrackId);
       getProp("MUSICBRAINZ_ALBUMID", localMbAlbumId);
@@ -208,36 +383,52 @@ void MediaScanner::ProcessFile(BEntry &entry) {
 
   // Build MediaItem
   MediaItem item;
-  BPath parentPath;
-  if (path.GetParent(&parentPath) == B_OK) {
-    item.base = parentPath.Path();
-  } else {
-    item.base = fBasePath;
-  }
+  item.base = itemBase;
   item.path = filePath;
   item.title = title;
   item.artist = artist;
   item.album = album;
+  item.albumArtist = albumArtist;
   item.genre = genre;
   item.year = year;
   item.track = track;
   item.disc = disc;
+  item.discTotal = discTotal;
   item.duration = duration;
   item.bitrate = bitrate;
   item.size = st.st_size;
   item.mtime = st.st_mtime;
   item.inode = st.st_ino;
+  item.device = st.st_dev;
+  item.partialHash = partialHash;
   item.mbTrackId = mbTrackId;
   item.mbAlbumId = mbAlbumId;
   item.mbArtistId = mbArtistId;
 
-  item.mbArtistId = mbArtistId;
+  if (moved) {
+    // Moved and modified: keep IDs the new tags do not carry
+    if (item.mbTrackId.IsEmpty())
+      item.mbTrackId = movedFrom.mbTrackId;
+    if (item.mbAlbumId.IsEmpty())
+      item.mbAlbumId = movedFrom.mbAlbumId;
+    if (item.mbArtistId.IsEmpty())
+      item.mbArtistId = movedFrom.mbArtistId;
+  }
+
+  _QueueItem(item, moved ? movedFrom.path : BString());
+}
 
+/**
+ * @brief Adds an item to the batch and flushes the batch if full.
+ * @param movedFrom Previous path of a moved file, or an empty string.
+ */
+void MediaScanner::_QueueItem(const MediaItem &item, const BString &movedFrom) {
   // Batch Logic (send to CacheManager)
   bool needsFlush = false;
 
   fBatchLock.Lock();
   fBatchBuffer.push_back(item);
+  fBatchMovedFrom.push_back(movedFrom);
   if (fBatchBuffer.size() >= 100) {
     needsFlush = true;
   }
@@ -254,6 +445,7 @@ void MediaScanner::ProcessFile(BEntry &entry) {
  * Uses MSG_MEDIA_BATCH. Clears the buffer after sending.
  */
 void MediaScanner::FlushBatch() {
+  TRACE_SPAN("scanner", "FlushBatch");
   fBatchLock.Lock();
   if (fBatchBuffer.empty()) {
     fBatchLock.Unlock();
@@ -263,29 +455,41 @@ void MediaScanner::FlushBatch() {
   BMessage msg(MSG_MEDIA_BATCH);
   msg.AddString("base", fBasePath);
 
-  for (const auto &item : fBatchBuffer) {
+  for (size_t i = 0; i < fBatchBuffer.size(); i++) {
+    const MediaItem &item = fBatchBuffer[i];
     // Flatten key fields into message arrays
     msg.AddString("path", item.path);
     msg.AddString("item_base", item.base);
     msg.AddString("title", item.title);
     msg.AddString("artist", item.artist);
     msg.AddString("album", item.album);
+    msg.AddString("albumArtist", item.albumArtist);
     msg.AddString("genre", item.genre);
     msg.AddInt32("year", item.year);
     msg.AddInt32("track", item.track);
     msg.AddInt32("disc", item.disc);
+    msg.AddInt32("discTotal", item.discTotal);
     msg.AddInt32("duration", item.duration);
     msg.AddInt32("bitrate", item.bitrate);
     msg.AddInt64("size", item.size);
     msg.AddInt64("mtime", item.mtime);
     msg.AddInt64("inode", item.inode);
+    msg.AddInt64("device", item.device);
+    msg.AddInt64("partial_hash", item.partialHash);
+    msg.AddString("mbTrackId", item.mbTrackId);
+    msg.AddString("mbAlbumId", item.mbAlbumId);
+    msg.AddString("mbArtistId", item.mbArtistId);
+    msg.AddString("moved_from", fBatchMovedFrom[i]);
   }
 
   fBatchBuffer.clear();
+  fBatchMovedFrom.clear();
   fBatchLock.Unlock();
 
-  if (fCacheTarget.IsValid())
+  if (fCacheTarget.IsValid()) {
+    MessageStats::Stamp(&msg);
     fCacheTarget.SendMessage(&msg);
+  }
 }
 
 /**
@@ -302,6 +506,7 @@ void MediaScanner::ReportProgress() {
 
   // Limit updates to ~10Hz to avoid flooding the message queue
   if (elapsed > 100) {
+    TRACE_COUNTER("scanner", "files", fFoundFiles);
     fLastUpdate = now;
     if (fLiveTarget.IsValid()) {
       BMessage msg(MSG_SCAN_PROGRESS);
@@ -313,6 +518,7 @@ void MediaScanner::ReportProgress() {
               .count();
       msg.AddInt64("elapsed_sec", totalElapsed);
 
+      MessageStats::Stamp(&msg);
       fLiveTarget.SendMessage(&msg);
     }
   }
@@ -417,6 +623,7 @@ void MediaScanner::WorkerMethod() {
         BMessage progress(MSG_SCAN_PROGRESS);
         progress.AddInt32("dirs", fScannedDirs);
         progress.AddInt32("files", fFoundFiles);
+        MessageStats::Stamp(&progress);
         fLiveTarget.SendMessage(&progress);
       }
     }
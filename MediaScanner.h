@@ -15,6 +15,8 @@
 #include <atomic>
 #include <chrono>
 #include <map>
+#include <sys/stat.h>
+#include <utility>
 #include <vector>
 
 /**
@@ -47,12 +49,19 @@ public:
 
   /**
    * @brief Pre-loads the cache to enable incremental scanning.
+   *
+   * Also indexes the cached files by inode and by size plus partial hash,
+   * so that moved or renamed files can be recognized.
+   *
    * @param cache Map of existing file paths to MediaItems.
    */
-  void SetCache(const std::map<BString, MediaItem> &cache) { fCache = cache; }
+  void SetCache(const std::map<BString, MediaItem> &cache);
 
 private:
   void ProcessFile(BEntry &entry);
+  bool _FindMovedFrom(const struct stat &st, int64 partialHash,
+                      MediaItem &outOld);
+  void _QueueItem(const MediaItem &item, const BString &movedFrom);
   void FlushBatch();
   void ReportProgress();
 
@@ -70,7 +79,12 @@ private:
   /** @name Data */
   ///@{
   std::map<BString, MediaItem> fCache;
+  std::multimap<int64, BString> fByInode; ///< Inode -> cached path.
+  std::multimap<std::pair<int64, int64>, BString>
+      fByContent; ///< (size, partial hash) -> cached path.
+  size_t fCacheBytes = 0; ///< Estimate of the above, for the memory report.
   std::vector<MediaItem> fBatchBuffer;
+  std::vector<BString> fBatchMovedFrom; ///< Old path per batch item, or "".
   BLocker fBatchLock;
   ///@}
 
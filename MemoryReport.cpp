@@ -0,0 +1,159 @@
+#include "MemoryReport.h"
+#include "MediaLibrary.h"
+
+#include <algorithm>
+#include <cstdio>
+
+bool gPrintMemoryReport = false;
+
+void MemoryReport::Add(const char *subsystem, const char *component,
+                       size_t count, size_t bytes) {
+  fComponents.push_back({subsystem, component, count, bytes});
+}
+
+/**
+ * @brief Haiku's BString keeps a reference count and the length in front of
+ * the characters; the empty string has no buffer.
+ */
+size_t MemoryReport::String(const BString &string) {
+  return String(string.String(), string.Length());
+}
+
+size_t MemoryReport::String(const char *string, size_t length) {
+  if (length == 0)
+    return 0;
+
+  const size_t bytes = length + 1 + 2 * sizeof(int32) + kAllocation;
+  fReferencedStringBytes += bytes;
+  if (fSeenStrings.insert(string).second)
+    fStringBytes += bytes;
+  return bytes;
+}
+
+size_t MemoryReport::Item(const MediaItem &item) {
+  return sizeof(MediaItem) + String(item.path) + String(item.base) +
+         String(item.title) + String(item.artist) + String(item.album) +
+         String(item.albumArtist) + String(item.composer) +
+         String(item.genre) + String(item.comment) + String(item.mbTrackId) +
+         String(item.mbAlbumId) + String(item.mbArtistId);
+}
+
+size_t MemoryReport::Items(const std::vector<MediaItem> &items) {
+  size_t bytes = (items.capacity() - items.size()) * sizeof(MediaItem);
+  for (const MediaItem &item : items)
+    bytes += Item(item);
+  return bytes;
+}
+
+size_t MemoryReport::Items(const std::map<BString, MediaItem> &items) {
+  size_t bytes = 0;
+  for (const auto &[key, item] : items)
+    bytes += kMapNode + kAllocation + sizeof(BString) + String(key) +
+             Item(item);
+  return bytes;
+}
+
+size_t MemoryReport::Library(const MediaLibrary &library) {
+  size_t bytes = Items(library.Items());
+  // Path index: one hash node per item; the keys share the item paths.
+  for (const MediaItem &item : library)
+    bytes += kHashNode + kHashBucket + kAllocation + sizeof(BString) +
+             sizeof(size_t) + String(item.path);
+  return bytes;
+}
+
+size_t MemoryReport::Strings(const std::vector<BString> &strings) {
+  size_t bytes = strings.capacity() * sizeof(BString);
+  for (const BString &string : strings)
+    bytes += String(string);
+  return bytes;
+}
+
+size_t MemoryReport::Strings(const BStringSet &strings) {
+  size_t bytes = strings.bucket_count() * kHashBucket;
+  for (const BString &string : strings)
+    bytes += kHashNode + kAllocation + sizeof(BString) + String(string);
+  return bytes;
+}
+
+size_t MemoryReport::Total() const {
+  size_t total = 0;
+  for (const Component &component : fComponents)
+    total += component.bytes;
+  return total - fReferencedStringBytes + fStringBytes;
+}
+
+static BString FormatBytes(size_t bytes) {
+  BString text;
+  if (bytes >= 10 * 1024 * 1024)
+    text.SetToFormat("%zu MiB", bytes / (1024 * 1024));
+  else if (bytes >= 10 * 1024)
+    text.SetToFormat("%zu KiB", bytes / 1024);
+  else
+    text.SetToFormat("%zu B", bytes);
+  return text;
+}
+
+BString MemoryReport::Format() const {
+  // Subsystems in order of first appearance, components by size.
+  std::vector<BString> subsystems;
+  for (const Component &component : fComponents) {
+    if (std::find(subsystems.begin(), subsystems.end(), component.subsystem) ==
+        subsystems.end())
+      subsystems.push_back(component.subsystem);
+  }
+
+  BString out;
+  BString line;
+  for (const BString &subsystem : subsystems) {
+    std::vector<const Component *> parts;
+    size_t total = 0;
+    for (const Component &component : fComponents) {
+      if (component.subsystem == subsystem) {
+        parts.push_back(&component);
+        total += component.bytes;
+      }
+    }
+    std::sort(parts.begin(), parts.end(),
+              [](const Component *a, const Component *b) {
+                return a->bytes > b->bytes;
+              });
+
+    line.SetToFormat("%-40s %12s\n", subsystem.String(),
+                     FormatBytes(total).String());
+    out << line;
+    for (const Component *part : parts) {
+      line.SetToFormat("  %-30s %7zu %12s\n", part->name.String(),
+                       part->count, FormatBytes(part->bytes).String());
+      out << line;
+    }
+  }
+
+  line.SetToFormat("%-40s %12s\n", "String storage (distinct buffers)",
+                   FormatBytes(fStringBytes).String());
+  out << "\n" << line;
+  line.SetToFormat("%-40s %12s\n", "Total (shared strings counted once)",
+                   FormatBytes(Total()).String());
+  out << line;
+  return out;
+}
+
+// --- MemoryCounter ---
+
+static MemoryCounter *sFirstCounter = nullptr;
+
+/** Counters are static objects, so they are all created before main(). */
+MemoryCounter::MemoryCounter(const char *subsystem, const char *component)
+    : fSubsystem(subsystem), fComponent(component), fNext(sFirstCounter) {
+  sFirstCounter = this;
+}
+
+void MemoryCounter::AddAll(MemoryReport &report) {
+  for (MemoryCounter *counter = sFirstCounter; counter;
+       counter = counter->fNext) {
+    const size_t count = counter->fCount;
+    if (count > 0)
+      report.Add(counter->fSubsystem, counter->fComponent, count,
+                 counter->fBytes);
+  }
+}
@@ -0,0 +1,133 @@
+#ifndef MEMORY_REPORT_H
+#define MEMORY_REPORT_H
+
+#include "HashUtils.h"
+#include "MediaItem.h"
+
+#include <String.h>
+#include <SupportDefs.h>
+
+#include <atomic>
+#include <map>
+#include <unordered_set>
+#include <vector>
+
+class MediaLibrary;
+
+/** Print the report to stdout when the main window closes (--memory-report). */
+extern bool gPrintMemoryReport;
+
+/** @name Subsystems of the memory report */
+///@{
+#define MEMORY_LIBRARY "Library store"
+#define MEMORY_VIEW_ROWS "View rows"
+#define MEMORY_PLAYLISTS "Playlists"
+#define MEMORY_COVERS "Cover caches"
+#define MEMORY_QUEUES "Message queues"
+///@}
+
+/**
+ * @class MemoryReport
+ * @brief Estimated bytes per subsystem and component.
+ *
+ * Owners of large data add their components through estimators that know
+ * the layout of BString, MediaItem and the standard containers. Estimates
+ * count the payload plus typical allocator and node overhead; they are meant
+ * for finding the big consumers, not for exact accounting.
+ *
+ * String buffers are tracked by address: a BString copy shares its buffer,
+ * so each component reports the string bytes it references, and the report
+ * adds the distinct ones up as "String storage".
+ */
+class MemoryReport {
+public:
+  /**
+   * @brief Records one component.
+   * @param subsystem One of the MEMORY_* names.
+   * @param component What is counted, e.g. "CacheManager entries".
+   * @param count Number of elements.
+   * @param bytes Estimated bytes, including referenced strings.
+   */
+  void Add(const char *subsystem, const char *component, size_t count,
+           size_t bytes);
+
+  /** @name Estimators
+   * Return estimated bytes and remember the string buffers they reference.
+   */
+  ///@{
+  size_t String(const BString &string);
+  /** For strings owned by a BString elsewhere, e.g. BStringField::String(). */
+  size_t String(const char *string, size_t length);
+  size_t Item(const MediaItem &item);
+  size_t Items(const std::vector<MediaItem> &items);
+  size_t Items(const std::map<BString, MediaItem> &items);
+  size_t Library(const MediaLibrary &library);
+  size_t Strings(const std::vector<BString> &strings);
+  size_t Strings(const BStringSet &strings);
+  ///@}
+
+  /** @brief Sum of all components, with shared strings counted once. */
+  size_t Total() const;
+
+  /** @brief Distinct string bytes referenced by all components. */
+  size_t StringStorage() const { return fStringBytes; }
+
+  /** @brief Table of components grouped by subsystem. */
+  BString Format() const;
+
+  /** @name Container overhead
+   * Per-element bookkeeping of the node based containers (libstdc++).
+   */
+  ///@{
+  static const size_t kMapNode = 4 * sizeof(void *);  ///< Color, 3 links.
+  static const size_t kHashNode = 2 * sizeof(void *); ///< Link, cached hash.
+  static const size_t kHashBucket = sizeof(void *);
+  static const size_t kAllocation = 2 * sizeof(void *); ///< malloc header.
+  ///@}
+
+private:
+  struct Component {
+    BString subsystem;
+    BString name;
+    size_t count;
+    size_t bytes;
+  };
+
+  std::vector<Component> fComponents;
+  std::unordered_set<const void *> fSeenStrings;
+  size_t fStringBytes = 0;           ///< Distinct buffers.
+  size_t fReferencedStringBytes = 0; ///< Every reference.
+};
+
+/**
+ * @class MemoryCounter
+ * @brief Running byte count for data the report cannot reach directly.
+ *
+ * For example each MediaScanner holds a copy of the cache while it runs.
+ * Counters are static objects; all of them are added by AddAll().
+ */
+class MemoryCounter {
+public:
+  MemoryCounter(const char *subsystem, const char *component);
+
+  void Add(size_t count, size_t bytes) {
+    fCount += count;
+    fBytes += bytes;
+  }
+  void Remove(size_t count, size_t bytes) {
+    fCount -= count;
+    fBytes -= bytes;
+  }
+
+  /** @brief Adds every counter with a non-zero count to @p report. */
+  static void AddAll(MemoryReport &report);
+
+private:
+  const char *fSubsystem;
+  const char *fComponent;
+  std::atomic<size_t> fCount{0};
+  std::atomic<size_t> fBytes{0};
+  MemoryCounter *fNext;
+};
+
+#endif // MEMORY_REPORT_H
@@ -0,0 +1,161 @@
+#include "MessageStats.h"
+#include "Trace.h"
+
+#include <Autolock.h>
+#include <Message.h>
+#include <MessageQueue.h>
+
+#include <algorithm>
+#include <cctype>
+#include <vector>
+
+/** Field added by Stamp(). */
+static const char *kSentField = "beton:sent";
+
+void LatencyHistogram::Record(bigtime_t value) {
+  value = std::max<bigtime_t>(0, value);
+  fCounts[_BucketFor(value)]++;
+  fCount++;
+  fTotal += value;
+  fMax = std::max(fMax, value);
+}
+
+bigtime_t LatencyHistogram::Percentile(double quantile) const {
+  if (fCount == 0)
+    return 0;
+
+  const uint64 rank = std::max<uint64>(1, (uint64)(quantile * fCount + 0.5));
+  uint64 seen = 0;
+  for (int32 i = 0; i < kBuckets; i++) {
+    seen += fCounts[i];
+    if (seen >= rank)
+      return std::min(_UpperBound(i), fMax);
+  }
+  return fMax;
+}
+
+/**
+ * @brief Values below kSubBuckets map to themselves; larger ones to their
+ * power of two and the top kSubBits bits below the leading one.
+ */
+int32 LatencyHistogram::_BucketFor(bigtime_t value) {
+  const uint64 v =
+      std::min<uint64>((uint64)value, (2ULL << kMaxExponent) - 1);
+  if (v < (uint64)kSubBuckets)
+    return (int32)v;
+
+  const int32 exponent = 63 - __builtin_clzll(v);
+  const int32 sub = (int32)(v >> (exponent - kSubBits)) & (kSubBuckets - 1);
+  return (exponent - kSubBits + 1) * kSubBuckets + sub;
+}
+
+bigtime_t LatencyHistogram::_UpperBound(int32 bucket) {
+  if (bucket < kSubBuckets)
+    return bucket;
+
+  const int32 exponent = bucket / kSubBuckets + kSubBits - 1;
+  const int32 sub = bucket % kSubBuckets;
+  const int32 shift = exponent - kSubBits;
+  return ((bigtime_t)(kSubBuckets + sub + 1) << shift) - 1;
+}
+
+MessageStats::MessageStats(const char *name)
+    : fName(name), fLock("message stats") {}
+
+void MessageStats::Stamp(BMessage *msg) {
+  const bigtime_t now = system_time();
+  if (msg->ReplaceInt64(kSentField, now) != B_OK)
+    msg->AddInt64(kSentField, now);
+}
+
+bigtime_t MessageStats::WaitTime(const BMessage *msg, bigtime_t now) {
+  int64 sent;
+  if (msg->FindInt64(kSentField, &sent) != B_OK)
+    return -1;
+  return now - sent;
+}
+
+size_t MessageStats::QueuedBytes(BMessageQueue *queue, int32 *count) {
+  *count = 0;
+  if (!queue->Lock())
+    return 0;
+
+  *count = queue->CountMessages();
+  size_t bytes = 0;
+  for (int32 i = 0; i < *count; i++) {
+    if (BMessage *msg = queue->FindMessage(i))
+      bytes += sizeof(BMessage) + msg->FlattenedSize();
+  }
+  queue->Unlock();
+  return bytes;
+}
+
+void MessageStats::Record(uint32 what, bigtime_t wait, bigtime_t handling,
+                          int32 queueDepth) {
+  TRACE_COUNTER("looper", fName, queueDepth);
+
+  BAutolock lock(fLock);
+  Entry &entry = fEntries[what];
+  if (wait >= 0)
+    entry.wait.Record(wait);
+  entry.handling.Record(handling);
+  fQueueDepth.Record(queueDepth);
+}
+
+/**
+ * @brief Formats a message code as 'abcd', or in hex if not printable.
+ */
+static BString WhatString(uint32 what) {
+  char code[5] = {(char)(what >> 24), (char)(what >> 16), (char)(what >> 8),
+                  (char)what, '\0'};
+  for (int i = 0; i < 4; i++) {
+    if (!isprint((unsigned char)code[i])) {
+      BString hex;
+      hex.SetToFormat("0x%08" B_PRIx32, what);
+      return hex;
+    }
+  }
+  BString quoted;
+  quoted << "'" << code << "'";
+  return quoted;
+}
+
+BString MessageStats::Report() const {
+  BAutolock lock(fLock);
+
+  std::vector<std::pair<uint32, const Entry *>> sorted;
+  sorted.reserve(fEntries.size());
+  for (const auto &[what, entry] : fEntries)
+    sorted.emplace_back(what, &entry);
+  std::sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b) {
+    return a.second->handling.Total() > b.second->handling.Total();
+  });
+
+  BString out;
+  BString line;
+  line.SetToFormat("%s: queue depth p50 %lld, p99 %lld, max %lld\n", fName,
+                   (long long)fQueueDepth.Percentile(0.5),
+                   (long long)fQueueDepth.Percentile(0.99),
+                   (long long)fQueueDepth.Max());
+  out << line;
+  out << "  message      count   handler us: p50      p99      max    total"
+         "   wait us: p50      p99      max\n";
+
+  for (const auto &[what, entry] : sorted) {
+    const LatencyHistogram &h = entry->handling;
+    const LatencyHistogram &w = entry->wait;
+    line.SetToFormat("  %-12s %6llu %17lld %8lld %8lld %8lld",
+                     WhatString(what).String(), (unsigned long long)h.Count(),
+                     (long long)h.Percentile(0.5),
+                     (long long)h.Percentile(0.99), (long long)h.Max(),
+                     (long long)h.Total());
+    out << line;
+    if (w.Count() > 0) {
+      line.SetToFormat(" %14lld %8lld %8lld", (long long)w.Percentile(0.5),
+                       (long long)w.Percentile(0.99), (long long)w.Max());
+      out << line;
+    }
+    out << "\n";
+  }
+  return out;
+}
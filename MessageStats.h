@@ -0,0 +1,114 @@
+#ifndef MESSAGE_STATS_H
+#define MESSAGE_STATS_H
+
+#include <Locker.h>
+#include <OS.h>
+#include <String.h>
+#include <SupportDefs.h>
+
+#include <map>
+
+class BMessage;
+class BMessageQueue;
+
+/**
+ * @class LatencyHistogram
+ * @brief Log-linear histogram of durations in microseconds.
+ *
+ * Like an HDR histogram, every power of two is split into eight linear
+ * sub-buckets, so any recorded value is reported with at most 12.5% error
+ * while the whole range from 1 us to days fits in a few hundred counters.
+ */
+class LatencyHistogram {
+public:
+  void Record(bigtime_t value);
+
+  uint64 Count() const { return fCount; }
+  bigtime_t Total() const { return fTotal; }
+  bigtime_t Max() const { return fMax; }
+
+  /**
+   * @brief Returns the upper bound of the bucket holding the given quantile.
+   * @param quantile Between 0 and 1, e.g. 0.99.
+   */
+  bigtime_t Percentile(double quantile) const;
+
+private:
+  static const int32 kSubBits = 3;
+  static const int32 kSubBuckets = 1 << kSubBits;
+  static const int32 kMaxExponent = 40; ///< Values are clamped to 2^41 - 1.
+  static const int32 kBuckets = (kMaxExponent - kSubBits + 2) * kSubBuckets;
+
+  static int32 _BucketFor(bigtime_t value);
+  static bigtime_t _UpperBound(int32 bucket);
+
+  uint32 fCounts[kBuckets] = {};
+  uint64 fCount = 0;
+  bigtime_t fTotal = 0;
+  bigtime_t fMax = 0;
+};
+
+/**
+ * @class MessageStats
+ * @brief Per-message timing of a looper.
+ *
+ * Records, per message `what`, how long messages waited in the queue and how
+ * long their handler ran, plus the queue depth seen at each dispatch. Fed
+ * from the looper's DispatchMessage(); the report may be read from any
+ * thread.
+ *
+ * The queue wait is only known for messages their sender marked with
+ * Stamp(); BMessage itself carries no send time.
+ */
+class MessageStats {
+public:
+  /**
+   * @param name Looper name for reports and trace counters; must be a
+   * string literal.
+   */
+  explicit MessageStats(const char *name);
+
+  /**
+   * @brief Marks a message with the current time right before sending it.
+   */
+  static void Stamp(BMessage *msg);
+
+  /**
+   * @brief Returns how long a stamped message waited, or -1 if unstamped.
+   */
+  static bigtime_t WaitTime(const BMessage *msg, bigtime_t now);
+
+  /**
+   * @brief Sums the flattened size of the messages waiting in a queue.
+   * @param count Receives the number of queued messages.
+   */
+  static size_t QueuedBytes(BMessageQueue *queue, int32 *count);
+
+  /**
+   * @brief Records one dispatched message.
+   * @param what The message code.
+   * @param wait Queue wait from WaitTime(), or -1 if unknown.
+   * @param handling Time spent in the handler.
+   * @param queueDepth Messages still queued after this one.
+   */
+  void Record(uint32 what, bigtime_t wait, bigtime_t handling,
+              int32 queueDepth);
+
+  /**
+   * @brief Formats all statistics as a text table, slowest messages first.
+   */
+  BString Report() const;
+
+private:
+  struct Entry {
+    LatencyHistogram wait;
+    LatencyHistogram handling;
+  };
+
+  const char *fName;
+  mutable BLocker fLock;
+  std::map<uint32, Entry> fEntries;
+  LatencyHistogram fQueueDepth;
+};
+
+#endif // MESSAGE_STATS_H
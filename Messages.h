@@ -17,11 +17,12 @@
 #define MSG_BASE_OFFLINE 'moff'       ///< Base path is offline/unreachable.
 #define MSG_MANAGE_DIRECTORIES 'mdir' ///< Open directory manager.
 #define MSG_INIT_LIBRARY 'liby'       ///< Initialize library views.
-#define MSG_BATCH_TIMER 'batc'        ///< Batch update timer tick.
-#define MSG_LAZY_LOAD 'lzld'          ///< Lazy loading trigger.
+#define MSG_LAZY_LOAD 'lzld'          ///< Startup work after the first frame.
 #define MSG_DIR_ADD 'dadd'            ///< Add directory to library.
 #define MSG_DIR_REMOVE 'drmv'         ///< Remove directory from library.
 #define MSG_DIR_OK 'doky'             ///< Directory settings confirm.
+#define MSG_FIND_DUPLICATES 'fdup'    ///< Search the library for duplicates.
+#define MSG_DUPLICATES_FOUND 'dupf'   ///< Duplicate groups ready.
 ///@}
 
 /** @name Playback Control */
@@ -91,6 +92,9 @@
 #define MSG_NAME_PROMPT_OK 'ok__'           ///< Name entry confirmed.
 #define MSG_NAME_PROMPT_CANCEL 'cncl'       ///< Name entry cancelled.
 #define MSG_REORDER_PLAYLIST 'rord'         ///< Reorder items in playlist.
+#define MSG_PLAYLIST_CHANGED 'plch'         ///< Playlist file content changed.
+#define MSG_FLUSH_PLAYLISTS 'plfl'          ///< Write pending playlist edits.
+#define MSG_PLAYLIST_FILES_MISSING 'plms'   ///< Playlist tracks not on disk.
 ///@}
 
 /** @name Metadata & MusicBrainz */
@@ -141,6 +145,9 @@
 ///@{
 #define MSG_TEST_MODE 'tstM'       ///< Trigger test mode.
 #define MSG_REGISTER_TARGET 'regt' ///< Register messaging target.
+#define MSG_TOGGLE_TRACE 'trce'    ///< Start or stop/export a trace.
+#define MSG_SHOW_MESSAGE_STATS 'msst' ///< Show looper message timings.
+#define MSG_SHOW_MEMORY_REPORT 'mmry' ///< Show estimated memory use.
 ///@}
 
 #endif // BETON_MESSAGES_H
@@ -138,6 +138,7 @@ void MetadataHandler::SaveTags(const BMessage *msg) {
       update.AddString("title", td.title);
       update.AddString("artist", td.artist);
       update.AddString("album", td.album);
+      update.AddString("albumArtist", td.albumArtist);
       update.AddString("genre", td.genre);
       update.AddString("comment", td.comment);
       update.AddInt32("year", td.year);
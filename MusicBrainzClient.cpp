@@ -1,5 +1,6 @@
 #include "MusicBrainzClient.h"
 #include "Debug.h"
+#include "Trace.h"
 
 #include <DataIO.h>
 #include <Locker.h>
@@ -149,6 +150,7 @@ MusicBrainzClient::MusicBrainzClient(const BString &contact)
  * @brief Enforces MusicBrainz rate limiting (approx. 1 request per second).
  */
 void MusicBrainzClient::_RespectRateLimit() {
+  TRACE_SPAN("musicbrainz", "RateLimit");
   bigtime_t now = system_time();
   bigtime_t diff = now - fLastCall;
   if (diff < 1100000) {
@@ -172,6 +174,7 @@ std::vector<MBHit>
 MusicBrainzClient::SearchRecording(const BString &artist, const BString &title,
                                    const BString &albumOpt,
                                    std::function<bool()> shouldCancel) {
+  TRACE_SPAN("musicbrainz", "SearchRecording");
   std::vector<MBHit> results;
   try {
     if (shouldCancel && shouldCancel())
@@ -318,6 +321,7 @@ MusicBrainzClient::SearchRecording(const BString &artist, const BString &title,
 MBRelease
 MusicBrainzClient::GetReleaseDetails(const BString &releaseId,
                                      std::function<bool()> shouldCancel) {
+  TRACE_SPAN("musicbrainz", "GetReleaseDetails");
   MBRelease out;
   out.releaseId = releaseId;
 
@@ -459,6 +463,7 @@ int MusicBrainzClient::_FetchUrl(const BString &urlStr,
     return 301;
   }
 
+  TRACE_SPAN("musicbrainz", "FetchUrl");
   DEBUG_PRINT("[MBClient] _FetchUrl: Requesting '%s' (redirects left=%d)\\n",
               urlStr.String(), maxRedirects);
 
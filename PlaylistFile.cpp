@@ -0,0 +1,555 @@
+#include "PlaylistFile.h"
+#include "Debug.h"
+
+#include <Entry.h>
+#include <File.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <strings.h>
+
+/** Read block size; large enough that typical playlists need one syscall. */
+static const size_t kReadBlockSize = 256 * 1024;
+
+static bool IsSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+/**
+ * @brief Trims whitespace from both ends of [s, s + len).
+ */
+static void TrimRange(const char *&s, size_t &len) {
+  while (len > 0 && IsSpace(*s)) {
+    s++;
+    len--;
+  }
+  while (len > 0 && IsSpace(s[len - 1]))
+    len--;
+}
+
+static bool StartsWithNoCase(const char *s, size_t len, const char *prefix) {
+  size_t plen = strlen(prefix);
+  return len >= plen && strncasecmp(s, prefix, plen) == 0;
+}
+
+static int HexValue(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+/**
+ * @brief Removes "." and ".." components from an absolute path lexically.
+ *
+ * Avoids BPath normalization, which would touch the file system for every
+ * entry of the playlist.
+ */
+static void NormalizeLexically(std::string &path) {
+  if (path.find("/.") == std::string::npos && path.find("//") ==
+                                                   std::string::npos)
+    return;
+
+  std::vector<std::string> parts;
+  size_t pos = 0;
+  while (pos <= path.size()) {
+    size_t next = path.find('/', pos);
+    if (next == std::string::npos)
+      next = path.size();
+    std::string part = path.substr(pos, next - pos);
+    if (part == "..") {
+      if (!parts.empty())
+        parts.pop_back();
+    } else if (!part.empty() && part != ".") {
+      parts.push_back(part);
+    }
+    pos = next + 1;
+  }
+
+  std::string out;
+  out.reserve(path.size());
+  for (const auto &p : parts) {
+    out += '/';
+    out += p;
+  }
+  path = out.empty() ? "/" : out;
+}
+
+/**
+ * @brief Turns a raw playlist reference into an absolute path.
+ *
+ * Handles file:// URLs (percent-decoded), absolute paths, other URLs (kept
+ * verbatim) and paths relative to the playlist's directory.
+ */
+static void ResolvePath(const char *s, size_t len, const char *baseDir,
+                        BString &out) {
+  if (StartsWithNoCase(s, len, "file://")) {
+    s += 7;
+    len -= 7;
+    if (StartsWithNoCase(s, len, "localhost")) {
+      s += 9;
+      len -= 9;
+    }
+
+    std::string decoded;
+    decoded.reserve(len);
+    for (size_t i = 0; i < len; i++) {
+      if (s[i] == '%' && i + 2 < len) {
+        int hi = HexValue(s[i + 1]);
+        int lo = HexValue(s[i + 2]);
+        if (hi >= 0 && lo >= 0) {
+          decoded += (char)(hi * 16 + lo);
+          i += 2;
+          continue;
+        }
+      }
+      decoded += s[i];
+    }
+    out.SetTo(decoded.c_str(), decoded.size());
+    return;
+  }
+
+  if (len > 0 && s[0] == '/') {
+    out.SetTo(s, len);
+    return;
+  }
+
+  // Other URL schemes (http://, ...) are passed through untouched.
+  for (size_t i = 0; i + 2 < len; i++) {
+    if (s[i] == '/')
+      break;
+    if (s[i] == ':' && s[i + 1] == '/' && s[i + 2] == '/') {
+      out.SetTo(s, len);
+      return;
+    }
+  }
+
+  if (baseDir == nullptr || baseDir[0] == '\0') {
+    out.SetTo(s, len);
+    return;
+  }
+
+  std::string joined(baseDir);
+  if (joined.empty() || joined.back() != '/')
+    joined += '/';
+  joined.append(s, len);
+  NormalizeLexically(joined);
+  out.SetTo(joined.c_str(), joined.size());
+}
+
+/**
+ * @brief Splits an #EXTINF display string into artist and title.
+ */
+static void SplitDisplayName(const char *s, size_t len, PlaylistEntry &e) {
+  for (size_t i = 0; i + 2 < len; i++) {
+    if (s[i] == ' ' && s[i + 1] == '-' && s[i + 2] == ' ') {
+      e.artist.SetTo(s, i);
+      e.title.SetTo(s + i + 3, len - i - 3);
+      return;
+    }
+  }
+  e.title.SetTo(s, len);
+}
+
+/**
+ * @class LineParser
+ * @brief Incremental, line-oriented playlist parser shared by Read/Parse.
+ */
+class LineParser {
+public:
+  LineParser(const char *baseDir, std::vector<PlaylistEntry> &out)
+      : fBaseDir(baseDir), fOut(out) {}
+
+  void Line(const char *s, size_t len);
+  PlaylistFormat Finish();
+
+private:
+  void _M3ULine(const char *s, size_t len);
+  void _PLSLine(const char *s, size_t len);
+
+  const char *fBaseDir;
+  std::vector<PlaylistEntry> &fOut;
+
+  bool fFirstLine = true;
+  PlaylistFormat fFormat = PlaylistFormat::M3U;
+
+  /** Metadata from the last #EXTINF, applied to the next path line. */
+  PlaylistEntry fPendingInfo;
+  bool fHasPendingInfo = false;
+
+  /** PLS keys may appear in any order, so entries are collected by index. */
+  std::map<int32, PlaylistEntry> fPLSEntries;
+};
+
+void LineParser::Line(const char *s, size_t len) {
+  if (fFirstLine && len >= 3 && (uint8)s[0] == 0xEF && (uint8)s[1] == 0xBB &&
+      (uint8)s[2] == 0xBF) {
+    s += 3;
+    len -= 3;
+  }
+
+  TrimRange(s, len);
+  if (len == 0)
+    return;
+
+  if (fFirstLine) {
+    fFirstLine = false;
+    if (StartsWithNoCase(s, len, "[playlist]")) {
+      fFormat = PlaylistFormat::PLS;
+      return;
+    }
+    if (StartsWithNoCase(s, len, "#EXTM3U")) {
+      fFormat = PlaylistFormat::ExtendedM3U;
+      return;
+    }
+  }
+
+  if (fFormat == PlaylistFormat::PLS)
+    _PLSLine(s, len);
+  else
+    _M3ULine(s, len);
+}
+
+void LineParser::_M3ULine(const char *s, size_t len) {
+  if (s[0] == '#') {
+    if (StartsWithNoCase(s, len, "#EXTINF:")) {
+      s += 8;
+      len -= 8;
+
+      fPendingInfo = PlaylistEntry();
+      fHasPendingInfo = true;
+
+      const char *comma =
+          static_cast<const char *>(memchr(s, ',', len));
+      std::string durStr(s, comma ? (size_t)(comma - s) : len);
+      int32 dur = (int32)strtol(durStr.c_str(), nullptr, 10);
+      fPendingInfo.duration = dur >= 0 ? dur : -1;
+
+      if (comma) {
+        const char *name = comma + 1;
+        size_t nameLen = len - (size_t)(name - s);
+        TrimRange(name, nameLen);
+        SplitDisplayName(name, nameLen, fPendingInfo);
+      }
+    } else if (StartsWithNoCase(s, len, "#BETON-INODE:")) {
+      std::string inodeStr(s + 13, len - 13);
+      fPendingInfo.inode = strtoll(inodeStr.c_str(), nullptr, 10);
+      fHasPendingInfo = true;
+    }
+    return;
+  }
+
+  PlaylistEntry entry;
+  if (fHasPendingInfo) {
+    entry = fPendingInfo;
+    fHasPendingInfo = false;
+  }
+  ResolvePath(s, len, fBaseDir, entry.path);
+  fOut.push_back(std::move(entry));
+}
+
+void LineParser::_PLSLine(const char *s, size_t len) {
+  const char *eq = static_cast<const char *>(memchr(s, '=', len));
+  if (!eq)
+    return;
+
+  size_t keyLen = (size_t)(eq - s);
+  const char *value = eq + 1;
+  size_t valueLen = len - keyLen - 1;
+  TrimRange(value, valueLen);
+
+  // Split "File12" into key "File" and index 12.
+  size_t digits = keyLen;
+  while (digits > 0 && s[digits - 1] >= '0' && s[digits - 1] <= '9')
+    digits--;
+  if (digits == keyLen || digits == 0)
+    return;
+
+  std::string indexStr(s + digits, keyLen - digits);
+  int32 index = (int32)strtol(indexStr.c_str(), nullptr, 10);
+  PlaylistEntry &entry = fPLSEntries[index];
+
+  if (digits == 4 && strncasecmp(s, "File", 4) == 0) {
+    ResolvePath(value, valueLen, fBaseDir, entry.path);
+  } else if (digits == 5 && strncasecmp(s, "Title", 5) == 0) {
+    SplitDisplayName(value, valueLen, entry);
+  } else if (digits == 6 && strncasecmp(s, "Length", 6) == 0) {
+    std::string lenStr(value, valueLen);
+    int32 dur = (int32)strtol(lenStr.c_str(), nullptr, 10);
+    entry.duration = dur >= 0 ? dur : -1;
+  }
+}
+
+PlaylistFormat LineParser::Finish() {
+  if (fFormat == PlaylistFormat::PLS) {
+    for (auto &kv : fPLSEntries) {
+      if (!kv.second.path.IsEmpty())
+        fOut.push_back(std::move(kv.second));
+    }
+    fPLSEntries.clear();
+  }
+  return fFormat;
+}
+
+/**
+ * @brief Returns the directory part of a playlist path.
+ */
+static BString DirectoryOf(const char *path) {
+  BString dir(path);
+  int32 slash = dir.FindLast('/');
+  if (slash > 0)
+    dir.Truncate(slash);
+  else if (slash == 0)
+    dir = "/";
+  else
+    dir = "";
+  return dir;
+}
+
+/**
+ * @brief Appends one M3U line (plus #EXTINF when extended) for an entry.
+ *
+ * The inode goes into a private #BETON-INODE line, which other players skip
+ * like any unknown comment.
+ */
+static void AppendM3UEntry(const PlaylistEntry &e, bool extended,
+                           std::string &out) {
+  if (extended) {
+    char num[24];
+    snprintf(num, sizeof(num), "%ld", (long)e.duration);
+    out.append("#EXTINF:").append(num).append(",");
+    if (!e.artist.IsEmpty())
+      out.append(e.artist.String(), e.artist.Length()).append(" - ");
+    out.append(e.title.String(), e.title.Length()).append("\n");
+
+    if (e.inode != 0) {
+      snprintf(num, sizeof(num), "%lld", (long long)e.inode);
+      out.append("#BETON-INODE:").append(num).append("\n");
+    }
+  }
+  out.append(e.path.String(), e.path.Length()).append("\n");
+}
+
+namespace PlaylistFile {
+
+PlaylistFormat FormatForPath(const char *path) {
+  BString p(path);
+  if (p.IEndsWith(".pls"))
+    return PlaylistFormat::PLS;
+  return PlaylistFormat::M3U;
+}
+
+PlaylistFormat Parse(const char *data, size_t size, const char *baseDir,
+                     std::vector<PlaylistEntry> &out) {
+  LineParser parser(baseDir, out);
+
+  const char *p = data;
+  const char *end = data + size;
+  while (p < end) {
+    const char *nl = static_cast<const char *>(memchr(p, '\n', end - p));
+    const char *lineEnd = nl ? nl : end;
+    parser.Line(p, (size_t)(lineEnd - p));
+    p = nl ? nl + 1 : end;
+  }
+
+  return parser.Finish();
+}
+
+bool Read(const char *path, std::vector<PlaylistEntry> &out,
+          PlaylistFormat *format) {
+  out.clear();
+
+  BFile file(path, B_READ_ONLY);
+  if (file.InitCheck() != B_OK) {
+    DEBUG_PRINT("[PlaylistFile] Cannot open %s\n", path);
+    return false;
+  }
+
+  off_t fileSize = 0;
+  if (file.GetSize(&fileSize) == B_OK && fileSize > 0)
+    out.reserve((size_t)(fileSize / 64));
+
+  BString baseDir = DirectoryOf(path);
+  LineParser parser(baseDir.String(), out);
+
+  // Stream the file in large blocks; a partial line at the end of a block
+  // is moved to the front and completed by the next read.
+  std::vector<char> buffer(kReadBlockSize);
+  size_t carry = 0;
+  bool ok = true;
+
+  while (true) {
+    if (carry == buffer.size())
+      buffer.resize(buffer.size() * 2);
+
+    ssize_t bytesRead = file.Read(buffer.data() + carry, buffer.size() - carry);
+    if (bytesRead < 0) {
+      DEBUG_PRINT("[PlaylistFile] Read error in %s\n", path);
+      ok = false;
+      break;
+    }
+
+    size_t avail = carry + (size_t)bytesRead;
+    if (bytesRead == 0) {
+      if (avail > 0)
+        parser.Line(buffer.data(), avail);
+      break;
+    }
+
+    const char *p = buffer.data();
+    const char *end = p + avail;
+    while (true) {
+      const char *nl = static_cast<const char *>(memchr(p, '\n', end - p));
+      if (!nl)
+        break;
+      parser.Line(p, (size_t)(nl - p));
+      p = nl + 1;
+    }
+
+    carry = (size_t)(end - p);
+    if (carry > 0 && p != buffer.data())
+      memmove(buffer.data(), p, carry);
+  }
+
+  PlaylistFormat detected = parser.Finish();
+  if (format)
+    *format = detected;
+
+  DEBUG_PRINT("[PlaylistFile] %zu entries read from %s\n", out.size(), path);
+  return ok;
+}
+
+void Format(const std::vector<PlaylistEntry> &entries, PlaylistFormat format,
+            std::string &out) {
+  out.clear();
+  out.reserve(entries.size() * 96);
+
+  char num[32];
+
+  if (format == PlaylistFormat::PLS) {
+    out += "[playlist]\n";
+    int32 n = 1;
+    for (const auto &e : entries) {
+      snprintf(num, sizeof(num), "%ld", (long)n);
+      out.append("File").append(num).append("=");
+      out.append(e.path.String(), e.path.Length()).append("\n");
+
+      if (!e.title.IsEmpty()) {
+        out.append("Title").append(num).append("=");
+        if (!e.artist.IsEmpty())
+          out.append(e.artist.String(), e.artist.Length()).append(" - ");
+        out.append(e.title.String(), e.title.Length()).append("\n");
+      }
+      snprintf(num + 16, sizeof(num) - 16, "%ld", (long)e.duration);
+      out.append("Length").append(num).append("=").append(num + 16);
+      out.append("\n");
+      n++;
+    }
+    snprintf(num, sizeof(num), "%zu", entries.size());
+    out.append("NumberOfEntries=").append(num).append("\nVersion=2\n");
+    return;
+  }
+
+  if (format == PlaylistFormat::ExtendedM3U)
+    out += "#EXTM3U\n";
+
+  for (const auto &e : entries)
+    AppendM3UEntry(e, format == PlaylistFormat::ExtendedM3U, out);
+}
+
+bool Write(const char *path, const std::vector<PlaylistEntry> &entries,
+           PlaylistFormat format) {
+  std::string data;
+  Format(entries, format, data);
+
+  // Write to a sibling file first so a failed write never truncates the
+  // existing playlist.
+  BString tmpPath(path);
+  tmpPath << ".tmp";
+
+  BFile file(tmpPath.String(), B_WRITE_ONLY | B_CREATE_FILE | B_ERASE_FILE);
+  if (file.InitCheck() != B_OK) {
+    DEBUG_PRINT("[PlaylistFile] Cannot create %s\n", tmpPath.String());
+    return false;
+  }
+
+  ssize_t written = file.Write(data.data(), data.size());
+  file.Unset();
+
+  BEntry tmpEntry(tmpPath.String());
+  if (written != (ssize_t)data.size()) {
+    DEBUG_PRINT("[PlaylistFile] Short write to %s\n", tmpPath.String());
+    tmpEntry.Remove();
+    return false;
+  }
+
+  if (tmpEntry.Rename(path, true) != B_OK) {
+    DEBUG_PRINT("[PlaylistFile] Cannot replace %s\n", path);
+    tmpEntry.Remove();
+    return false;
+  }
+
+  DEBUG_PRINT("[PlaylistFile] %zu entries written to %s\n", entries.size(),
+              path);
+  return true;
+}
+
+bool Append(const char *path, const std::vector<PlaylistEntry> &entries) {
+  if (entries.empty())
+    return true;
+
+  if (FormatForPath(path) == PlaylistFormat::PLS) {
+    // PLS numbers its keys and ends with a NumberOfEntries trailer, so it
+    // cannot be extended in place.
+    std::vector<PlaylistEntry> all;
+    Read(path, all);
+    all.insert(all.end(), entries.begin(), entries.end());
+    return Write(path, all, PlaylistFormat::PLS);
+  }
+
+  BFile file(path, B_READ_WRITE | B_CREATE_FILE | B_OPEN_AT_END);
+  if (file.InitCheck() != B_OK) {
+    DEBUG_PRINT("[PlaylistFile] Cannot open %s for appending\n", path);
+    return false;
+  }
+
+  off_t size = 0;
+  file.GetSize(&size);
+
+  std::string data;
+  data.reserve(entries.size() * 96 + 1);
+
+  bool extended = (size == 0);
+  if (extended)
+    data += "#EXTM3U\n";
+  if (size > 0) {
+    char head[7];
+    if (file.ReadAt(0, head, sizeof(head)) == (ssize_t)sizeof(head))
+      extended = strncasecmp(head, "#EXTM3U", sizeof(head)) == 0;
+
+    char last = '\n';
+    file.ReadAt(size - 1, &last, 1);
+    if (last != '\n')
+      data += '\n';
+  }
+
+  for (const auto &e : entries)
+    AppendM3UEntry(e, extended, data);
+
+  ssize_t written = file.Write(data.data(), data.size());
+  if (written != (ssize_t)data.size()) {
+    DEBUG_PRINT("[PlaylistFile] Short append to %s\n", path);
+    return false;
+  }
+
+  DEBUG_PRINT("[PlaylistFile] %zu entries appended to %s\n", entries.size(),
+              path);
+  return true;
+}
+
+} // namespace PlaylistFile
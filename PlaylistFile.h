@@ -0,0 +1,105 @@
+#ifndef PLAYLIST_FILE_H
+#define PLAYLIST_FILE_H
+
+#include <String.h>
+#include <SupportDefs.h>
+
+#include <string>
+#include <vector>
+
+/**
+ * @struct PlaylistEntry
+ * @brief A single track reference read from or written to a playlist file.
+ *
+ * Only `path` is mandatory. The remaining fields carry the optional metadata
+ * of extended M3U (#EXTINF) and PLS (TitleN/LengthN) files.
+ */
+struct PlaylistEntry {
+  BString path;        ///< Absolute path to the track.
+  BString artist;      ///< Artist from #EXTINF ("Artist - Title").
+  BString title;       ///< Title from #EXTINF or PLS TitleN.
+  int32 duration = -1; ///< Duration in seconds, -1 if unknown.
+  int64 inode = 0;     ///< Inode from #BETON-INODE, 0 if unknown.
+
+  PlaylistEntry() = default;
+  PlaylistEntry(const BString &p) : path(p) {}
+};
+
+/**
+ * @enum PlaylistFormat
+ * @brief On-disk playlist formats understood by PlaylistFile.
+ */
+enum class PlaylistFormat {
+  M3U,         ///< Plain list of paths, one per line.
+  ExtendedM3U, ///< #EXTM3U header with #EXTINF metadata lines.
+  PLS          ///< INI-style [playlist] with FileN/TitleN/LengthN keys.
+};
+
+/**
+ * @namespace PlaylistFile
+ * @brief Buffered reader and writer for M3U, extended M3U and PLS playlists.
+ *
+ * Files are read in large blocks and split in place, so loading does not
+ * cost a syscall per character. Relative entries are resolved against the
+ * directory containing the playlist, and file:// URLs are decoded.
+ */
+namespace PlaylistFile {
+
+/**
+ * @brief Guesses the format from the file extension (.pls or M3U).
+ */
+PlaylistFormat FormatForPath(const char *path);
+
+/**
+ * @brief Reads a playlist file.
+ * @param path Absolute path of the playlist file.
+ * @param out Receives the entries in file order (cleared first).
+ * @param format Optional, receives the detected format.
+ * @return True if the file could be opened and read.
+ */
+bool Read(const char *path, std::vector<PlaylistEntry> &out,
+          PlaylistFormat *format = nullptr);
+
+/**
+ * @brief Parses playlist data that is already in memory.
+ * @param data Raw file contents (need not be null-terminated).
+ * @param size Number of bytes in data.
+ * @param baseDir Directory used to resolve relative entries (may be null).
+ * @param out Receives the entries (appended).
+ * @return The detected format.
+ */
+PlaylistFormat Parse(const char *data, size_t size, const char *baseDir,
+                     std::vector<PlaylistEntry> &out);
+
+/**
+ * @brief Writes a complete playlist file, replacing any existing content.
+ * @param path Absolute path of the playlist file.
+ * @param entries Entries to write.
+ * @param format Output format.
+ * @return True if all data was written.
+ */
+bool Write(const char *path, const std::vector<PlaylistEntry> &entries,
+           PlaylistFormat format = PlaylistFormat::M3U);
+
+/**
+ * @brief Appends entries to the end of a playlist without rewriting it.
+ *
+ * Creates the file if needed and keeps the existing format (#EXTINF lines
+ * are written if the file starts with #EXTM3U; a new file becomes extended
+ * M3U). PLS files cannot be extended in place and are rewritten.
+ *
+ * @param path Absolute path of the playlist file.
+ * @param entries Entries to append.
+ * @return True if all data was written.
+ */
+bool Append(const char *path, const std::vector<PlaylistEntry> &entries);
+
+/**
+ * @brief Serializes entries into a buffer in the given format.
+ */
+void Format(const std::vector<PlaylistEntry> &entries, PlaylistFormat format,
+            std::string &out);
+
+} // namespace PlaylistFile
+
+#endif // PLAYLIST_FILE_H
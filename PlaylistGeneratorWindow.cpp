@@ -40,12 +40,18 @@ BString Rule::ToString() const {
   if (exclude)
     s << B_TRANSLATE("NOT ");
 
-  if (type == 0)
+  if (type == kRuleGenre)
     s << B_TRANSLATE("Genre: ") << value;
-  else if (type == 1)
+  else if (type == kRuleArtist)
     s << B_TRANSLATE("Artist: ") << value;
-  else if (type == 2)
+  else if (type == kRuleAlbum)
+    s << B_TRANSLATE("Album: ") << value;
+  else if (type == kRuleTitle)
+    s << B_TRANSLATE("Title: ") << value;
+  else if (type == kRuleYear)
     s << B_TRANSLATE("Year: ") << value << " - " << value2;
+  else if (type == kRuleDuration)
+    s << B_TRANSLATE("Duration (Min): ") << value << " - " << value2;
 
   return s;
 }
@@ -107,6 +113,12 @@ void PlaylistGeneratorWindow::_BuildUI(const std::vector<BString> &genres) {
       new BMenuItem(B_TRANSLATE("Artist"), new BMessage(MSG_TYPE_CHANGED)));
   typeMenu->AddItem(
       new BMenuItem(B_TRANSLATE("Year"), new BMessage(MSG_TYPE_CHANGED)));
+  typeMenu->AddItem(
+      new BMenuItem(B_TRANSLATE("Album"), new BMessage(MSG_TYPE_CHANGED)));
+  typeMenu->AddItem(
+      new BMenuItem(B_TRANSLATE("Title"), new BMessage(MSG_TYPE_CHANGED)));
+  typeMenu->AddItem(new BMenuItem(B_TRANSLATE("Duration (Min)"),
+                                  new BMessage(MSG_TYPE_CHANGED)));
   typeMenu->ItemAt(0)->SetMarked(true);
   typeMenu->SetTargetForItems(this);
 
@@ -188,6 +200,9 @@ void PlaylistGeneratorWindow::_BuildUI(const std::vector<BString> &genres) {
 
   fShuffleCheck =
       new BCheckBox("Shuffle", B_TRANSLATE("Shuffle Playback"), nullptr);
+  fLiveCheck = new BCheckBox(
+      "Live", B_TRANSLATE("Keep updated as the library changes"), nullptr);
+  fLiveCheck->SetValue(B_CONTROL_ON);
 
   fGenerateBtn = new BButton("Generate", B_TRANSLATE("Generate"),
                              new BMessage(MSG_GEN_GENERATE));
@@ -235,6 +250,7 @@ void PlaylistGeneratorWindow::_BuildUI(const std::vector<BString> &genres) {
       .End()
 
       .Add(fShuffleCheck)
+      .Add(fLiveCheck)
 
       .Add(new BSeparatorView(B_HORIZONTAL))
 
@@ -257,12 +273,26 @@ void PlaylistGeneratorWindow::_UpdateInputFields() {
 
   BMenuItem *marked = fTypeField->Menu()->FindMarked();
   int32 type = marked ? fTypeField->Menu()->IndexOf(marked) : 0;
-  if (type < 0)
-    type = 0;
-  if (type > 2)
-    type = 2;
 
-  fInputCardLayout->SetVisibleItem(type);
+  fInputCardLayout->SetVisibleItem(_CardForType(type));
+}
+
+/**
+ * @brief Returns the input card used by a rule type: 0 = genre menu,
+ * 1 = text field, 2 = from/to range.
+ */
+int32 PlaylistGeneratorWindow::_CardForType(int32 type) {
+  switch (type) {
+  case kRuleArtist:
+  case kRuleAlbum:
+  case kRuleTitle:
+    return 1;
+  case kRuleYear:
+  case kRuleDuration:
+    return 2;
+  default:
+    return 0;
+  }
 }
 
 /**
@@ -273,12 +303,13 @@ void PlaylistGeneratorWindow::_AddRule() {
   r.type = fTypeField->Menu()->IndexOf(fTypeField->Menu()->FindMarked());
   r.exclude = (fExcludeCheck->Value() == B_CONTROL_ON);
 
-  if (r.type == 0) {
+  int32 card = _CardForType(r.type);
+  if (card == 0) {
     BMenuItem *item = fGenreSelect->Menu()->FindMarked();
     if (!item)
       return;
     r.value = item->Label();
-  } else if (r.type == 1) {
+  } else if (card == 1) {
     r.value = fArtistInput->Text();
     if (r.value.IsEmpty())
       return;
@@ -351,6 +382,7 @@ void PlaylistGeneratorWindow::MessageReceived(BMessage *msg) {
     }
 
     genMsg.AddBool("shuffle", fShuffleCheck->Value() == B_CONTROL_ON);
+    genMsg.AddBool("live", fLiveCheck->Value() == B_CONTROL_ON);
 
     fTarget.SendMessage(&genMsg);
     Quit();
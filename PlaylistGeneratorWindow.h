@@ -1,6 +1,8 @@
 #ifndef PLAYLIST_GENERATOR_WINDOW_H
 #define PLAYLIST_GENERATOR_WINDOW_H
 
+#include "SmartPlaylist.h"
+
 #include <Messenger.h>
 #include <String.h>
 #include <Window.h>
@@ -16,28 +18,13 @@ class BPopUpMenu;
 class BListView;
 class BCardLayout;
 
-/**
- * @struct Rule
- * @brief Represents a single filtering rule for playlist generation.
- */
-struct Rule {
-  int32 type;     ///< 0=Genre, 1=Artist, 2=Year.
-  BString value;  ///< Primary search value (e.g. "Rock", "Metallica", "1990").
-  BString value2; ///< Secondary value (e.g. "2000" for year range).
-  bool exclude;   ///< If true, the rule is negated (NOT).
-
-  /**
-   * @brief Formats the rule as a human-readable string.
-   */
-  BString ToString() const;
-};
-
 /**
  * @class PlaylistGeneratorWindow
  * @brief Window for creating dynamic or static playlists based on criteria.
  *
  * Allows the user to define rules (positive or negative) based on Genre,
- * Artist, or Year, and specify limits and sorting options.
+ * Artist, Album, Title, Year or Duration, and specify limits and sorting
+ * options.
  */
 class PlaylistGeneratorWindow : public BWindow {
 public:
@@ -57,6 +44,7 @@ private:
   void _UpdateInputFields();
   void _AddRule();
   void _RemoveRule();
+  static int32 _CardForType(int32 type);
 
   /** @name Data */
   ///@{
@@ -77,6 +65,7 @@ private:
   BMenuField *fGenreSelect;
   BCheckBox *fExcludeCheck;
   BCheckBox *fShuffleCheck;
+  BCheckBox *fLiveCheck;
   BButton *fAddRuleBtn;
   ///@}
 
@@ -0,0 +1,346 @@
+#include "PlaylistIndex.h"
+#include "Debug.h"
+#include "HashUtils.h"
+#include "PlaylistFile.h"
+#include "PlaylistUtils.h"
+
+#include <Autolock.h>
+#include <Directory.h>
+#include <Entry.h>
+#include <File.h>
+#include <FindDirectory.h>
+#include <Locker.h>
+#include <Message.h>
+#include <Path.h>
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <sys/stat.h>
+
+/**
+ * @struct PlaylistRecord
+ * @brief What the index knows about one playlist file.
+ */
+struct PlaylistRecord {
+  BString file;               ///< Absolute path of the playlist file.
+  off_t size = -1;            ///< File size when last indexed.
+  time_t mtime = 0;           ///< Modification time when last indexed.
+  std::vector<BString> paths; ///< Tracks in playlist order.
+};
+
+static BLocker sLock("playlist index");
+/// Held for a whole Save(), so two threads never write the file at once.
+static BLocker sSaveLock("playlist index save");
+static std::map<BString, PlaylistRecord> sPlaylists;
+static BStringMap<std::vector<BString>> sByPath;
+static BString sDirectory;
+static bool sLoaded = false;
+static bool sDirty = false;
+
+static BPath IndexFilePath() {
+  BPath path;
+  if (find_directory(B_USER_SETTINGS_DIRECTORY, &path) == B_OK)
+    path.Append("BeTon/playlist_index");
+  return path;
+}
+
+static bool StatFile(const BString &file, off_t &size, time_t &mtime) {
+  BEntry entry(file.String());
+  struct stat st;
+  if (entry.GetStat(&st) != B_OK)
+    return false;
+  size = st.st_size;
+  mtime = st.st_mtime;
+  return true;
+}
+
+/**
+ * @brief Adds reverse links from each path of a playlist to its name.
+ */
+static void Link(const BString &name, const std::vector<BString> &paths) {
+  for (const auto &p : paths) {
+    auto &owners = sByPath[p];
+    if (std::find(owners.begin(), owners.end(), name) == owners.end())
+      owners.push_back(name);
+  }
+}
+
+/**
+ * @brief Removes the reverse links of a playlist.
+ */
+static void Unlink(const BString &name, const std::vector<BString> &paths) {
+  for (const auto &p : paths) {
+    auto it = sByPath.find(p);
+    if (it == sByPath.end())
+      continue;
+    auto &owners = it->second;
+    owners.erase(std::remove(owners.begin(), owners.end(), name),
+                 owners.end());
+    if (owners.empty())
+      sByPath.erase(it);
+  }
+}
+
+/**
+ * @brief Replaces a playlist record. Caller must hold sLock.
+ */
+static void StoreRecord(const BString &name, PlaylistRecord &&record) {
+  auto it = sPlaylists.find(name);
+  if (it != sPlaylists.end())
+    Unlink(name, it->second.paths);
+
+  Link(name, record.paths);
+  sPlaylists[name] = std::move(record);
+  sDirty = true;
+}
+
+/**
+ * @brief Reads the stored index from disk. Caller must hold sLock.
+ */
+static void LoadStored() {
+  sLoaded = true;
+
+  BPath indexPath = IndexFilePath();
+  BFile file(indexPath.Path(), B_READ_ONLY);
+  if (file.InitCheck() != B_OK)
+    return;
+
+  BMessage archive;
+  if (archive.Unflatten(&file) != B_OK) {
+    DEBUG_PRINT("[PlaylistIndex] Index konnte nicht gelesen werden\n");
+    return;
+  }
+
+  sDirectory = archive.GetString("directory", "");
+
+  BMessage item;
+  for (int32 i = 0; archive.FindMessage("playlist", i, &item) == B_OK; i++) {
+    BString name = item.GetString("name", "");
+    if (name.IsEmpty())
+      continue;
+
+    PlaylistRecord record;
+    record.file = item.GetString("file", "");
+    record.size = item.GetInt64("size", -1);
+    record.mtime = (time_t)item.GetInt64("mtime", 0);
+
+    int32 count = 0;
+    item.GetInfo("path", nullptr, &count);
+    record.paths.reserve(count);
+    const char *p = nullptr;
+    for (int32 j = 0; item.FindString("path", j, &p) == B_OK; j++)
+      record.paths.emplace_back(p);
+
+    StoreRecord(name, std::move(record));
+  }
+
+  sDirty = false;
+  DEBUG_PRINT("[PlaylistIndex] %zu Playlists aus Index geladen\n",
+              sPlaylists.size());
+}
+
+namespace PlaylistIndex {
+
+void Validate(const BString &directory) {
+  // Find playlists whose file is new or changed since they were indexed.
+  std::map<BString, BString> stale;
+  {
+    BAutolock lock(sLock);
+    if (!sLoaded)
+      LoadStored();
+
+    if (sDirectory != directory) {
+      for (auto &[name, record] : sPlaylists)
+        Unlink(name, record.paths);
+      sPlaylists.clear();
+      sDirectory = directory;
+      sDirty = true;
+    }
+
+    std::set<BString> seen;
+    BDirectory dir(directory.String());
+    BEntry entry;
+    while (dir.InitCheck() == B_OK && dir.GetNextEntry(&entry) == B_OK) {
+      char leaf[B_FILE_NAME_LENGTH];
+      if (entry.GetName(leaf) != B_OK || !IsPlaylistFileName(leaf))
+        continue;
+
+      BString name = PlaylistNameFromFileName(leaf);
+      BPath filePath(directory.String(), leaf);
+      seen.insert(name);
+
+      struct stat st;
+      if (entry.GetStat(&st) != B_OK)
+        continue;
+
+      auto it = sPlaylists.find(name);
+      if (it != sPlaylists.end() && it->second.file == filePath.Path() &&
+          it->second.size == st.st_size && it->second.mtime == st.st_mtime)
+        continue;
+
+      stale[name] = filePath.Path();
+    }
+
+    for (auto it = sPlaylists.begin(); it != sPlaylists.end();) {
+      if (seen.count(it->first) == 0) {
+        Unlink(it->first, it->second.paths);
+        it = sPlaylists.erase(it);
+        sDirty = true;
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  // Re-read stale playlists without holding the lock.
+  for (const auto &[name, file] : stale) {
+    PlaylistRecord record;
+    record.file = file;
+    if (!StatFile(file, record.size, record.mtime))
+      continue;
+
+    std::vector<PlaylistEntry> entries;
+    PlaylistFile::Read(file.String(), entries);
+    record.paths.reserve(entries.size());
+    for (auto &e : entries)
+      record.paths.push_back(std::move(e.path));
+
+    BAutolock lock(sLock);
+    StoreRecord(name, std::move(record));
+  }
+
+  DEBUG_PRINT("[PlaylistIndex] Validiert, %zu Playlists neu gelesen\n",
+              stale.size());
+  Save();
+}
+
+void Save() {
+  // Taken before sLock, so the snapshot written last is the newest one.
+  BAutolock saveLock(sSaveLock);
+
+  BMessage archive;
+  {
+    BAutolock lock(sLock);
+    if (!sDirty)
+      return;
+
+    archive.AddString("directory", sDirectory);
+    for (const auto &[name, record] : sPlaylists) {
+      BMessage item;
+      item.AddString("name", name);
+      item.AddString("file", record.file);
+      item.AddInt64("size", record.size);
+      item.AddInt64("mtime", (int64)record.mtime);
+      for (const auto &p : record.paths)
+        item.AddString("path", p);
+      archive.AddMessage("playlist", &item);
+    }
+    sDirty = false;
+  }
+
+  // Write a sibling file and move it over the index, so a failed or
+  // interrupted write leaves the previous index intact.
+  BPath indexPath = IndexFilePath();
+  BString tmpPath(indexPath.Path());
+  tmpPath << ".tmp";
+
+  BFile file(tmpPath.String(), B_WRITE_ONLY | B_CREATE_FILE | B_ERASE_FILE);
+  bool saved = file.InitCheck() == B_OK && archive.Flatten(&file) == B_OK;
+  file.Unset();
+
+  BEntry tmpEntry(tmpPath.String());
+  if (saved)
+    saved = tmpEntry.Rename(indexPath.Path(), true) == B_OK;
+  if (!saved) {
+    DEBUG_PRINT("[PlaylistIndex] Index konnte nicht gespeichert werden\n");
+    tmpEntry.Remove();
+    BAutolock lock(sLock);
+    sDirty = true;
+  }
+}
+
+void SetPlaylist(const BString &name, const std::vector<BString> &paths) {
+  PlaylistRecord record;
+  record.file = PlaylistPathFor(name);
+  StatFile(record.file, record.size, record.mtime);
+  record.paths = paths;
+
+  BAutolock lock(sLock);
+  StoreRecord(name, std::move(record));
+}
+
+void AddToPlaylist(const BString &name, const std::vector<BString> &paths) {
+  BString file = PlaylistPathFor(name);
+
+  BAutolock lock(sLock);
+  auto it = sPlaylists.find(name);
+  if (it == sPlaylists.end() || it->second.file != file) {
+    // Not indexed yet; index the whole file so the record is complete.
+    PlaylistRecord record;
+    record.file = file;
+    StatFile(file, record.size, record.mtime);
+
+    std::vector<PlaylistEntry> entries;
+    PlaylistFile::Read(file.String(), entries);
+    for (auto &e : entries)
+      record.paths.push_back(std::move(e.path));
+
+    StoreRecord(name, std::move(record));
+    return;
+  }
+
+  PlaylistRecord &record = it->second;
+  record.paths.insert(record.paths.end(), paths.begin(), paths.end());
+  StatFile(file, record.size, record.mtime);
+  Link(name, paths);
+  sDirty = true;
+}
+
+void RemovePlaylist(const BString &name) {
+  BAutolock lock(sLock);
+  auto it = sPlaylists.find(name);
+  if (it == sPlaylists.end())
+    return;
+
+  Unlink(name, it->second.paths);
+  sPlaylists.erase(it);
+  sDirty = true;
+}
+
+void RenamePlaylist(const BString &oldName, const BString &newName) {
+  BAutolock lock(sLock);
+  auto it = sPlaylists.find(oldName);
+  if (it == sPlaylists.end())
+    return;
+
+  PlaylistRecord record = std::move(it->second);
+  Unlink(oldName, record.paths);
+  sPlaylists.erase(it);
+
+  record.file = PlaylistPathFor(newName);
+  StoreRecord(newName, std::move(record));
+}
+
+std::vector<BString> PlaylistsContaining(const BString &path) {
+  BAutolock lock(sLock);
+  auto it = sByPath.find(path);
+  if (it == sByPath.end())
+    return {};
+  return it->second;
+}
+
+std::vector<BString> PlaylistsContainingAny(const std::vector<BString> &paths) {
+  std::set<BString> names;
+  {
+    BAutolock lock(sLock);
+    for (const auto &p : paths) {
+      auto it = sByPath.find(p);
+      if (it != sByPath.end())
+        names.insert(it->second.begin(), it->second.end());
+    }
+  }
+  return std::vector<BString>(names.begin(), names.end());
+}
+
+} // namespace PlaylistIndex
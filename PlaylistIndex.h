@@ -0,0 +1,79 @@
+#ifndef PLAYLIST_INDEX_H
+#define PLAYLIST_INDEX_H
+
+#include <String.h>
+#include <SupportDefs.h>
+
+#include <vector>
+
+/**
+ * @namespace PlaylistIndex
+ * @brief Persistent reverse index from track path to playlist membership.
+ *
+ * Answers "which playlists contain this track?" without opening any
+ * playlist file. The index is kept current by the write functions in
+ * PlaylistUtils and stored as a flattened BMessage in
+ * `settings/BeTon/playlist_index`. Each playlist's size and modification
+ * time are recorded, so playlists changed outside BeTon are re-read by
+ * Validate().
+ *
+ * All functions are thread safe.
+ */
+namespace PlaylistIndex {
+
+/**
+ * @brief Loads the stored index and re-reads playlists that changed.
+ *
+ * Playlists in the current playlist folder that are new, modified or gone
+ * are added, re-read or dropped. If the stored index belongs to another
+ * folder, it is rebuilt from scratch. Intended to run on a worker thread.
+ *
+ * @param directory The playlist folder, see PlaylistDirectory(). Taken when
+ * the job is queued, as the folder setting belongs to the window thread.
+ */
+void Validate(const BString &directory);
+
+/**
+ * @brief Writes the index to disk if it changed since the last save.
+ *
+ * Safe to call from several threads; the file is replaced atomically.
+ */
+void Save();
+
+/**
+ * @brief Replaces the recorded content of a playlist after a full rewrite.
+ */
+void SetPlaylist(const BString &name, const std::vector<BString> &paths);
+
+/**
+ * @brief Records entries appended to a playlist.
+ */
+void AddToPlaylist(const BString &name, const std::vector<BString> &paths);
+
+/**
+ * @brief Forgets a deleted playlist.
+ */
+void RemovePlaylist(const BString &name);
+
+/**
+ * @brief Moves the recorded content of a renamed playlist.
+ */
+void RenamePlaylist(const BString &oldName, const BString &newName);
+
+/**
+ * @brief Returns the names of all playlists containing a track.
+ * @param path Absolute path of the track.
+ */
+std::vector<BString> PlaylistsContaining(const BString &path);
+
+/**
+ * @brief Returns the names of all playlists containing any of the tracks.
+ *
+ * Each name is reported once. Used to find the playlists affected by a
+ * batch of moved or renamed files.
+ */
+std::vector<BString> PlaylistsContainingAny(const std::vector<BString> &paths);
+
+} // namespace PlaylistIndex
+
+#endif // PLAYLIST_INDEX_H
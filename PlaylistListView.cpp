@@ -109,15 +109,16 @@ void PlaylistListView::MessageReceived(BMessage *msg) {
         break;
       }
 
-      BString playlistName = ItemAt(dropIndex);
+      // The window owns the open playlist's pending edits, so let it append.
+      BMessage add(MSG_ADD_TO_PLAYLIST);
+      add.AddString("playlist", ItemAt(dropIndex));
       entry_ref ref;
       int32 i = 0;
       while (msg->FindRef("refs", i++, &ref) == B_OK) {
         BPath path(&ref);
-        DEBUG_PRINT("[PlaylistListView] Datei '%s' → Playlist '%s'\n",
-                    path.Path(), playlistName.String());
-        AddFileToPlaylist(dropIndex, ref);
+        add.AddString("path", path.Path());
       }
+      fTarget.SendMessage(&add);
     }
 
     SetHoverIndex(-1);
@@ -228,12 +229,9 @@ void PlaylistListView::MouseMoved(BPoint point, uint32 transit,
 
 void PlaylistListView::RenameItem(const BString &oldName,
                                   const BString &newName) {
-  for (auto &item : fItems) {
-    if (item.text == oldName) {
-      item.text = newName;
-      break;
-    }
-  }
+  // Goes through SetItemText() so the item keeps its ID under the new name.
+  if (!SetItemText(FindIndexByName(oldName), newName))
+    return;
   for (auto &r : fRows) {
     if (r.label == oldName) {
       r.label = newName;
@@ -252,19 +250,6 @@ int32 PlaylistListView::CreateNewPlaylist(const char *title) {
   return index;
 }
 
-void PlaylistListView::AddFileToPlaylist(int32 index, const entry_ref &ref) {
-  if (index < 0 || index >= CountItems())
-    return;
-  if (!IsWritableAt(index))
-    return;
-
-  BString playlistName = ItemAt(index);
-  BPath path(&ref);
-  AddItemToPlaylist(path.Path(), playlistName);
-  DEBUG_PRINT("[PlaylistListView] Datei '%s' zu Playlist '%s' gespeichert\n",
-              path.Path(), playlistName.String());
-}
-
 void PlaylistListView::RemoveSelectedPlaylist() {
   int32 index = CurrentSelection();
   if (index > 0 && index < CountItems()) {
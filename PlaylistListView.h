@@ -35,7 +35,6 @@ public:
   /** @name Modification Logic */
   ///@{
   int32 CreateNewPlaylist(const char *title);
-  void AddFileToPlaylist(int32 index, const entry_ref &ref);
   void RemoveSelectedPlaylist();
   void RenameItem(const BString &oldName, const BString &newName);
 
@@ -1,43 +1,44 @@
 #include "PlaylistManager.h"
+#include "Debug.h"
+#include "HashUtils.h"
+#include "Messages.h"
 #include "PlaylistListView.h"
+#include "PlaylistUtils.h"
 #include <Directory.h>
 #include <Entry.h>
-#include <File.h>
-#include <FindDirectory.h>
-#include <Path.h>
-#include <stdio.h>
+#include <MessageRunner.h>
+#include <StorageDefs.h>
+#include <algorithm>
+
+/** Delay after the last reorder before the playlist file is rewritten. */
+static const bigtime_t kFlushDelay = 1000000;
 
 PlaylistManager::PlaylistManager(BMessenger target) : fTarget(target) {
   fPlaylistView = new PlaylistListView("playlist", fTarget);
 }
 
-PlaylistManager::~PlaylistManager() {}
+PlaylistManager::~PlaylistManager() { FlushPending(); }
 
 PlaylistListView *PlaylistManager::View() const { return fPlaylistView; }
 
 void PlaylistManager::LoadAvailablePlaylists() {
-  BPath path;
-  if (find_directory(B_USER_SETTINGS_DIRECTORY, &path) != B_OK)
-    return;
-
   if (fPlaylistBasePath.IsEmpty())
     return;
-  path.SetTo(fPlaylistBasePath);
-  BDirectory dir(path.Path());
+  BDirectory dir(fPlaylistBasePath.String());
   if (dir.InitCheck() != B_OK)
     return;
 
   BEntry entry;
   while (dir.GetNextEntry(&entry) == B_OK) {
-    BPath filePath(&entry);
-    if (!filePath.Path() || !filePath.Leaf())
+    char leaf[B_FILE_NAME_LENGTH];
+    if (entry.GetName(leaf) != B_OK || !IsPlaylistFileName(leaf))
       continue;
 
-    BString name = filePath.Leaf();
-    if (name.EndsWith(".m3u"))
-      name.Truncate(name.Length() - 4);
+    BString name = PlaylistNameFromFileName(leaf);
+    if (fPlaylistView->FindIndexByName(name) >= 0)
+      continue;
 
-    fPlaylistView->AddItem(name, filePath.Path());
+    fPlaylistView->AddItem(name, true);
   }
 }
 
@@ -47,37 +48,23 @@ void PlaylistManager::LoadAvailablePlaylists() {
  * @return std::vector<BString> List of file paths in the playlist.
  */
 std::vector<BString> PlaylistManager::LoadPlaylist(const BString &name) {
-  std::vector<BString> paths;
-  BPath dirPath;
-  if (find_directory(B_USER_SETTINGS_DIRECTORY, &dirPath) != B_OK)
-    return paths;
+  if (fPlaylistBasePath.IsEmpty())
+    return std::vector<BString>();
 
+  auto it = fPending.find(name);
+  if (it != fPending.end())
+    return it->second;
+  return ::LoadPlaylist(name);
+}
+
+std::vector<PlaylistEntry>
+PlaylistManager::LoadPlaylistEntries(const BString &name) {
   if (fPlaylistBasePath.IsEmpty())
-    return paths;
-  dirPath.SetTo(fPlaylistBasePath);
-  BString playlistFile = name;
-  playlistFile += ".m3u";
-  dirPath.Append(playlistFile.String());
-
-  BFile file(dirPath.Path(), B_READ_ONLY);
-  if (file.InitCheck() != B_OK)
-    return paths;
-
-  BString line;
-  char ch;
-  while (file.Read(&ch, 1) == 1) {
-    if (ch == '\n') {
-      line.Trim();
-      if (!line.IsEmpty() && !line.StartsWith("#")) {
-        paths.push_back(line);
-      }
-      line.Truncate(0);
-    } else {
-      line += ch;
-    }
-  }
+    return std::vector<PlaylistEntry>();
 
-  return paths;
+  if (fPending.count(name) > 0)
+    FlushPending();
+  return ::LoadPlaylistEntries(name);
 }
 
 /**
@@ -87,41 +74,25 @@ std::vector<BString> PlaylistManager::LoadPlaylist(const BString &name) {
  */
 void PlaylistManager::SavePlaylist(const BString &name,
                                    const std::vector<BString> &paths) {
-  BPath dirPath;
-  if (find_directory(B_USER_SETTINGS_DIRECTORY, &dirPath) != B_OK)
-    return;
-
   if (fPlaylistBasePath.IsEmpty())
     return;
-  dirPath.SetTo(fPlaylistBasePath);
-  create_directory(dirPath.Path(), 0777);
 
-  BString fileName = name;
-  fileName.Append(".m3u");
-  BPath playlistPath(dirPath.Path(), fileName.String());
-
-  BFile file(playlistPath.Path(), B_WRITE_ONLY | B_CREATE_FILE | B_ERASE_FILE);
-  if (file.InitCheck() != B_OK)
+  fPending.erase(name);
+  if (!::SavePlaylist(name, paths))
     return;
 
-  for (const auto &path : paths) {
-    file.Write(path.String(), path.Length());
-    file.Write("\n", 1);
-  }
-
-  printf("Playlist '%s' gespeichert (%zu Einträge)\n", name.String(),
-         paths.size());
+  EnsureListed(name);
+}
 
+/**
+ * @brief Adds a sidebar entry for a playlist written elsewhere, if missing.
+ */
+void PlaylistManager::EnsureListed(const BString &name) {
   if (fPlaylistView->FindIndexByName(name) < 0) {
-    fPlaylistView->AddItem(name, playlistPath.Path());
+    fPlaylistView->AddItem(name, true);
   }
 }
 
-void PlaylistManager::AddPlaylistEntry(const BString &name,
-                                       const BString &fullPath) {
-  fPlaylistView->AddItem(name, fullPath);
-}
-
 void PlaylistManager::GetPlaylistNames(BMessage &out, bool onlyWritable) const {
   const int32 count = fPlaylistView->CountItems();
   for (int32 i = 0; i < count; ++i) {
@@ -156,30 +127,111 @@ void PlaylistManager::RenamePlaylist(const BString &oldName,
 
 void PlaylistManager::SetPlaylistFolderPath(const BString &path) {
   fPlaylistBasePath = path;
+  SetPlaylistDirectory(path);
 }
 
 /**
- * @brief Reorders an item within a playlist and saves the change.
+ * @brief Reorders an item within a playlist.
+ *
+ * The change is applied to an in-memory copy of the playlist; the file is
+ * rewritten once no further reorders arrived for kFlushDelay, so moving a
+ * track several rows costs a single write.
+ *
  * @param name Playlist name.
  * @param fromIndex Original index.
  * @param toIndex New index.
  */
 void PlaylistManager::ReorderPlaylistItem(const BString &name, int32 fromIndex,
                                           int32 toIndex) {
-  if (fromIndex == toIndex)
+  if (fromIndex == toIndex || fPlaylistBasePath.IsEmpty())
     return;
 
-  std::vector<BString> paths = LoadPlaylist(name);
-  if (fromIndex < 0 || fromIndex >= (int32)paths.size())
-    return;
-  if (toIndex < 0 || toIndex >= (int32)paths.size())
+  auto it = fPending.find(name);
+  if (it == fPending.end())
+    it = fPending.emplace(name, ::LoadPlaylist(name)).first;
+
+  std::vector<BString> &paths = it->second;
+  const int32 count = (int32)paths.size();
+  if (fromIndex < 0 || fromIndex >= count || toIndex < 0 || toIndex >= count)
     return;
 
-  // Move the item
-  BString item = paths[fromIndex];
-  paths.erase(paths.begin() + fromIndex);
-  paths.insert(paths.begin() + toIndex, item);
+  auto first = paths.begin();
+  if (fromIndex < toIndex)
+    std::rotate(first + fromIndex, first + fromIndex + 1, first + toIndex + 1);
+  else
+    std::rotate(first + toIndex, first + fromIndex, first + fromIndex + 1);
+
+  _ScheduleFlush();
+}
+
+const std::vector<BString> *
+PlaylistManager::RemovePlaylistItems(const BString &name,
+                                     const std::vector<int32> &positions,
+                                     const std::vector<BString> &paths) {
+  if (paths.empty() || fPlaylistBasePath.IsEmpty())
+    return nullptr;
+
+  auto it = fPending.find(name);
+  if (it == fPending.end())
+    it = fPending.emplace(name, ::LoadPlaylist(name)).first;
+
+  std::vector<BString> &entries = it->second;
+
+  std::vector<bool> marked(entries.size(), false);
+  BStringMap<int32> byPath; ///< Paths whose position did not fit.
+  for (size_t k = 0; k < paths.size(); k++) {
+    const int32 position = k < positions.size() ? positions[k] : -1;
+    if (position >= 0 && position < (int32)entries.size() &&
+        !marked[position] && entries[position] == paths[k])
+      marked[position] = true;
+    else
+      byPath[paths[k]]++;
+  }
+
+  for (size_t i = 0; i < entries.size() && !byPath.empty(); i++) {
+    if (marked[i])
+      continue;
+    auto r = byPath.find(entries[i]);
+    if (r == byPath.end())
+      continue;
+    marked[i] = true;
+    if (--r->second == 0)
+      byPath.erase(r);
+  }
+
+  size_t kept = 0;
+  for (size_t i = 0; i < entries.size(); i++) {
+    if (!marked[i])
+      entries[kept++] = std::move(entries[i]);
+  }
+  if (kept == entries.size())
+    return &entries;
+
+  entries.resize(kept);
+  _ScheduleFlush();
+  return &entries;
+}
+
+void PlaylistManager::FlushPending() {
+  delete fFlushRunner;
+  fFlushRunner = nullptr;
+
+  for (const auto &[name, paths] : fPending) {
+    // Deleted or renamed meanwhile; do not bring the old file back.
+    BEntry entry(PlaylistPathFor(name).String());
+    if (!entry.Exists())
+      continue;
+
+    if (!::SavePlaylist(name, paths))
+      DEBUG_PRINT("[PlaylistManager] Playlist '%s' konnte nicht gespeichert "
+                  "werden\n",
+                  name.String());
+  }
+  fPending.clear();
+}
 
-  // Save the reordered playlist
-  SavePlaylist(name, paths);
+void PlaylistManager::_ScheduleFlush() {
+  delete fFlushRunner;
+  BMessage flush(MSG_FLUSH_PLAYLISTS);
+  fFlushRunner = new BMessageRunner(fTarget, &flush, kFlushDelay, 1);
 }
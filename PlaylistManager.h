@@ -1,11 +1,15 @@
 #ifndef PLAYLIST_MANAGER_H
 #define PLAYLIST_MANAGER_H
 
+#include "PlaylistFile.h"
+
 #include <Message.h>
 #include <Messenger.h>
 #include <String.h>
+#include <map>
 #include <vector>
 
+class BMessageRunner;
 class PlaylistListView;
 
 class PlaylistManager {
@@ -17,10 +21,18 @@ public:
 
   void LoadAvailablePlaylists();
   std::vector<BString> LoadPlaylist(const BString &name);
+
+  /**
+   * @brief Loads a playlist with its #EXTINF metadata.
+   *
+   * Pending reorders of the playlist are written first, so the result is
+   * always in the current order.
+   */
+  std::vector<PlaylistEntry> LoadPlaylistEntries(const BString &name);
   void SavePlaylist(const BString &name, const std::vector<BString> &paths);
 
-  void AddPlaylistEntry(const BString &name, const BString &fullPath);
   void CreateNewPlaylist(const BString &name);
+  void EnsureListed(const BString &name);
   void RenamePlaylist(const BString &oldName, const BString &newName);
   void SetPlaylistFolderPath(const BString &path);
   void GetPlaylistNames(BMessage &out, bool onlyWritable = true) const;
@@ -28,15 +40,47 @@ public:
 
   void ReorderPlaylistItem(const BString &name, int32 fromIndex, int32 toIndex);
 
+  /**
+   * @brief Removes entries from a playlist in one pass.
+   *
+   * Entries are removed by position, so of a track listed twice the right
+   * one goes. Where a position is unknown (-1) or no longer holds the
+   * path, the first remaining occurrence of the path is removed instead.
+   * Like reorders, the change is kept in memory and written by the next
+   * flush.
+   *
+   * @param positions Positions of the entries in the playlist.
+   * @param paths Path of each entry.
+   * @return The playlist content after removal, or nullptr if there was
+   *         nothing to remove or no playlist folder is set.
+   */
+  const std::vector<BString> *
+  RemovePlaylistItems(const BString &name, const std::vector<int32> &positions,
+                      const std::vector<BString> &paths);
+
+  /**
+   * @brief Writes playlists with pending reorders to disk.
+   *
+   * Must be called before anything else rewrites or appends to a playlist
+   * file, so the pending order does not overwrite those changes later.
+   */
+  void FlushPending();
+
   void Select(int32 index);
   int32 CountItems() const;
 
 private:
+  void _ScheduleFlush();
+
   /** @name Data */
   ///@{
   PlaylistListView *fPlaylistView;
   BMessenger fTarget;
   BString fPlaylistBasePath;
+
+  /** Playlists reordered in memory but not yet written. */
+  std::map<BString, std::vector<BString>> fPending;
+  BMessageRunner *fFlushRunner = nullptr;
   ///@}
 };
 
@@ -1,27 +1,47 @@
 #include "PlaylistUtils.h"
 #include "Debug.h"
-#include "MainWindow.h"
+#include "HashUtils.h"
+#include "Messages.h"
+#include "PlaylistIndex.h"
 
+#include <Autolock.h>
 #include <Directory.h>
 #include <Entry.h>
-#include <File.h>
 #include <FindDirectory.h>
+#include <Locker.h>
+#include <Messenger.h>
 #include <Path.h>
-#include <StringList.h>
 
 #include <cstdio>
+#include <cstring>
+#include <map>
+#include <sys/stat.h>
 
 #define PLAYLIST_FOLDER "Playlists"
 
-// Global pointer to MainWindow is needed to notify UI updates.
-extern MainWindow *gMainWindow;
+/** Receives MSG_PLAYLIST_CHANGED; usually the main window. */
+static BMessenger sChangeTarget;
+
+/** Playlist folder chosen by the user; empty means the default folder. */
+static BString sPlaylistDirectory;
+
+/** Source of #EXTINF metadata; may be empty. */
+static PlaylistMetadataLookup sMetadataLookup;
+
+/** Supported playlist extensions, in lookup order. */
+static const char *kPlaylistExtensions[] = {".m3u", ".m3u8", ".pls"};
 
 /**
- * @brief Constructs the path to the playlist directory in user settings.
- * @return BPath pointing to the 'BeTon/Playlists' folder.
+ * @brief Constructs the path to the playlist directory.
+ * @return BPath pointing to the configured folder, or 'BeTon/Playlists'
+ * in the user settings if none was configured.
  */
 static BPath GetPlaylistDirectory() {
   BPath path;
+  if (!sPlaylistDirectory.IsEmpty()) {
+    path.SetTo(sPlaylistDirectory.String());
+    return path;
+  }
   if (find_directory(B_USER_SETTINGS_DIRECTORY, &path) == B_OK) {
     path.Append("BeTon");
     path.Append(PLAYLIST_FOLDER);
@@ -29,52 +49,257 @@ static BPath GetPlaylistDirectory() {
   return path;
 }
 
+void SetPlaylistDirectory(const BString &path) { sPlaylistDirectory = path; }
+
+BString PlaylistDirectory() { return BString(GetPlaylistDirectory().Path()); }
+
+void SetPlaylistMetadataLookup(PlaylistMetadataLookup lookup) {
+  sMetadataLookup = std::move(lookup);
+}
+
+void SetPlaylistChangeTarget(const BMessenger &target) {
+  sChangeTarget = target;
+}
+
 /**
- * @brief Adds a track to a specific playlist.
+ * @brief Replaces an entry's metadata with the library's, if it knows the path.
  *
- * If the track is already in the playlist, it is not added again.
- * The playlist file (.m3u) is updated, and if the UI is available,
- * the track is added to the UI display as well.
+ * The library is re-read after retags and re-encodes, so its data wins over
+ * whatever a playlist file stored earlier.
  *
- * @param path File path of the track.
- * @param playlist Name of the playlist (without extension).
+ * @return True if the lookup knew the path.
  */
-void AddItemToPlaylist(const BString &path, const BString &playlist) {
-  DEBUG_PRINT("[PlaylistUtils] AddItemToPlaylist aufgerufen mit: %s -> %s\n",
-              path.String(), playlist.String());
-
-  std::vector<BString> items = LoadPlaylist(playlist);
-  for (const auto &item : items) {
-    if (item.Compare(path) == 0) {
-      DEBUG_PRINT("[PlaylistUtils] Pfad bereits enthalten, wird nicht erneut "
-                  "hinzugefuegt\n");
-      return;
+static bool ApplyLibraryMetadata(PlaylistEntry &entry) {
+  if (!sMetadataLookup)
+    return false;
+
+  PlaylistEntry known(entry.path);
+  if (!sMetadataLookup(entry.path, known))
+    return false;
+  entry.artist = known.artist;
+  entry.title = known.title;
+  entry.duration = known.duration;
+  entry.inode = known.inode;
+  return true;
+}
+
+/**
+ * @brief Builds a playlist entry for a path, with metadata if known.
+ */
+static PlaylistEntry EntryFor(const BString &path) {
+  PlaylistEntry entry(path);
+  ApplyLibraryMetadata(entry);
+  return entry;
+}
+
+bool IsPlaylistFileName(const char *leaf) {
+  BString name(leaf);
+  for (const char *ext : kPlaylistExtensions) {
+    if (name.IEndsWith(ext) && name.Length() > (int32)strlen(ext))
+      return true;
+  }
+  return false;
+}
+
+BString PlaylistNameFromFileName(const char *leaf) {
+  BString name(leaf);
+  for (const char *ext : kPlaylistExtensions) {
+    if (name.IEndsWith(ext)) {
+      name.Truncate(name.Length() - strlen(ext));
+      break;
     }
   }
+  return name;
+}
 
-  items.push_back(path);
-  SavePlaylist(playlist, items);
-  DEBUG_PRINT("[PlaylistUtils] Pfad hinzugefuegt und gespeichert\n");
+BString PlaylistFileName(const BString &name) {
+  BString fileName = name;
+  fileName.ReplaceAll('/', '_');
+  if (fileName.IsEmpty() || fileName == "." || fileName == "..")
+    fileName.Prepend("_");
 
-  if (gMainWindow) {
-    BString label;
+  // Leave room for the longest extension.
+  int32 length = B_FILE_NAME_LENGTH - 1 - 5;
+  if (fileName.Length() > length) {
+    while (length > 0 && (fileName.ByteAt(length) & 0xC0) == 0x80)
+      length--;
+    fileName.Truncate(length);
+  }
+  return fileName;
+}
 
-    BPath p(path.String());
-    label = p.Leaf();
+BString PlaylistPathFor(const BString &name) {
+  BPath dirPath = GetPlaylistDirectory();
 
-    gMainWindow->AddPlaylistEntry(playlist, label, path);
+  for (const char *ext : kPlaylistExtensions) {
+    BString fileName = PlaylistFileName(name);
+    fileName += ext;
+    BPath candidate(dirPath.Path(), fileName.String());
+    BEntry entry(candidate.Path());
+    if (entry.Exists())
+      return BString(candidate.Path());
   }
+
+  BString fileName = PlaylistFileName(name);
+  fileName += kPlaylistExtensions[0];
+  BPath fallback(dirPath.Path(), fileName.String());
+  return BString(fallback.Path());
+}
+
+BString UnusedPlaylistName(const BString &name) {
+  BString candidate = name;
+  for (int32 n = 2; BEntry(PlaylistPathFor(candidate).String()).Exists();
+       n++) {
+    candidate = name;
+    candidate << " " << n;
+  }
+  return candidate;
 }
 
 /**
- * @brief Retrieves the file path for a content item by its index.
- * @param index Index in the content list.
- * @return File path string.
+ * @struct PlaylistMembership
+ * @brief In-memory set of the paths contained in one playlist file.
+ *
+ * Lets additions be checked for duplicates without re-reading the file. The
+ * size and modification time of the file at the time the set was built are
+ * kept so that edits made outside BeTon are noticed.
  */
-BString GetPathForContentItem(int index) {
-  if (gMainWindow)
-    return gMainWindow->GetPathForContentItem(index);
-  return "";
+struct PlaylistMembership {
+  BStringSet paths;
+  off_t size = -1;
+  time_t mtime = 0;
+};
+
+/** Membership sets keyed by playlist file path. */
+static std::map<BString, PlaylistMembership> sMembership;
+static BLocker sMembershipLock("playlist membership");
+
+static bool StatPlaylistFile(const BString &filePath, off_t &size,
+                             time_t &mtime) {
+  BEntry entry(filePath.String());
+  struct stat st;
+  if (entry.GetStat(&st) != B_OK)
+    return false;
+  size = st.st_size;
+  mtime = st.st_mtime;
+  return true;
+}
+
+/**
+ * @brief Returns the membership set of a playlist file, (re)loading it if the
+ * file changed since it was cached. Caller must hold sMembershipLock.
+ */
+static PlaylistMembership &CachedMembership(const BString &filePath) {
+  PlaylistMembership &cache = sMembership[filePath];
+
+  off_t size = -1;
+  time_t mtime = 0;
+  if (!StatPlaylistFile(filePath, size, mtime)) {
+    cache.paths.clear();
+    cache.size = -1;
+    cache.mtime = 0;
+    return cache;
+  }
+
+  if (cache.size == size && cache.mtime == mtime)
+    return cache;
+
+  std::vector<PlaylistEntry> entries;
+  PlaylistFile::Read(filePath.String(), entries);
+
+  cache.paths.clear();
+  cache.paths.reserve(entries.size());
+  for (auto &e : entries)
+    cache.paths.insert(std::move(e.path));
+  cache.size = size;
+  cache.mtime = mtime;
+
+  DEBUG_PRINT("[PlaylistUtils] Mitgliedschaft fuer %s geladen (%zu)\n",
+              filePath.String(), cache.paths.size());
+  return cache;
+}
+
+/**
+ * @brief Drops the cached membership of a playlist file.
+ */
+static void ForgetMembership(const BString &filePath) {
+  BAutolock lock(sMembershipLock);
+  sMembership.erase(filePath);
+}
+
+/**
+ * @brief Tells the main window that a playlist's content changed.
+ */
+static void NotifyPlaylistChanged(const BString &playlist) {
+  if (!sChangeTarget.IsValid())
+    return;
+
+  BMessage msg(MSG_PLAYLIST_CHANGED);
+  msg.AddString("name", playlist);
+  sChangeTarget.SendMessage(&msg);
+}
+
+/**
+ * @brief Adds tracks to a specific playlist.
+ *
+ * Tracks already in the playlist (or repeated in @p paths) are skipped.
+ * New tracks are appended to the end of the file in a single write; the
+ * existing content is not rewritten.
+ *
+ * @param paths File paths of the tracks.
+ * @param playlist Name of the playlist (without extension).
+ * @return Number of tracks actually added.
+ */
+int32 AddItemsToPlaylist(const std::vector<BString> &paths,
+                         const BString &playlist) {
+  if (paths.empty())
+    return 0;
+
+  BPath dirPath = GetPlaylistDirectory();
+  BDirectory dir(dirPath.Path());
+  if (dir.InitCheck() != B_OK)
+    create_directory(dirPath.Path(), 0777);
+
+  BString filePath = PlaylistPathFor(playlist);
+
+  BAutolock lock(sMembershipLock);
+  PlaylistMembership &cache = CachedMembership(filePath);
+
+  std::vector<BString> addedPaths;
+  std::vector<PlaylistEntry> added;
+  for (const auto &path : paths) {
+    if (path.IsEmpty())
+      continue;
+    if (cache.paths.insert(path).second) {
+      addedPaths.push_back(path);
+      added.push_back(EntryFor(path));
+    }
+  }
+
+  DEBUG_PRINT("[PlaylistUtils] %zu von %zu Pfaden neu fuer '%s'\n",
+              added.size(), paths.size(), playlist.String());
+
+  if (added.empty())
+    return 0;
+
+  if (!PlaylistFile::Append(filePath.String(), added)) {
+    sMembership.erase(filePath);
+    return 0;
+  }
+
+  StatPlaylistFile(filePath, cache.size, cache.mtime);
+  PlaylistIndex::AddToPlaylist(playlist, addedPaths);
+
+  NotifyPlaylistChanged(playlist);
+  return (int32)added.size();
+}
+
+/**
+ * @brief Adds a single track to a specific playlist.
+ * @see AddItemsToPlaylist
+ */
+void AddItemToPlaylist(const BString &path, const BString &playlist) {
+  AddItemsToPlaylist(std::vector<BString>{path}, playlist);
 }
 
 /**
@@ -92,17 +317,16 @@ void CreatePlaylist(const BString &name) {
  * @param name Name of the playlist to delete.
  */
 void DeletePlaylist(const BString &name) {
-  BPath dirPath(GetPlaylistDirectory());
+  BString filePath = PlaylistPathFor(name);
 
-  BString fileName = name;
-  fileName += ".m3u";
-  dirPath.Append(fileName.String());
+  ForgetMembership(filePath);
 
-  BEntry entry(dirPath.Path());
+  BEntry entry(filePath.String());
   if (entry.Exists()) {
     if (entry.Remove() == B_OK) {
+      PlaylistIndex::RemovePlaylist(name);
       DEBUG_PRINT("[PlaylistUtils] Playlist '%s' geloescht (%s)\n",
-                  name.String(), dirPath.Path());
+                  name.String(), filePath.String());
     } else {
       DEBUG_PRINT(
           "[PlaylistUtils] Playlist '%s' konnte nicht geloescht werden\n",
@@ -112,58 +336,69 @@ void DeletePlaylist(const BString &name) {
 }
 
 /**
- * @brief Loads all track paths from a playlist file.
- *
- * Each line in the .m3u file is treated as a file path.
- *
- * @param name Name of the playlist.
- * @return Vector of file path strings.
+ * @brief Renames a playlist file, keeping its extension.
+ * @param oldName Current name of the playlist.
+ * @param newName New name of the playlist.
+ * @return True if the file was renamed.
  */
-std::vector<BString> LoadPlaylist(const BString &name) {
-  std::vector<BString> items;
+bool RenamePlaylistFile(const BString &oldName, const BString &newName) {
+  BString oldPath = PlaylistPathFor(oldName);
+  ForgetMembership(oldPath);
 
-  BPath dirPath = GetPlaylistDirectory();
-  BString fileName = name;
-  fileName += ".m3u";
-  dirPath.Append(fileName.String());
+  BEntry entry(oldPath.String());
+  if (!entry.Exists())
+    return false;
 
-  BFile file(dirPath.Path(), B_READ_ONLY);
-  if (file.InitCheck() != B_OK) {
-    DEBUG_PRINT("[PlaylistUtils] Datei konnte nicht geoeffnet werden: %s\n",
-                dirPath.Path());
-    return items;
-  }
+  BString ext;
+  int32 dot = oldPath.FindLast('.');
+  if (dot >= 0)
+    oldPath.CopyInto(ext, dot, oldPath.Length() - dot);
 
-  off_t fileSize = 0;
-  if (file.GetSize(&fileSize) != B_OK || fileSize == 0) {
-    DEBUG_PRINT("[PlaylistUtils] Datei leer oder ungueltig: %s\n",
-                dirPath.Path());
-    return items;
-  }
+  BString newFile = PlaylistFileName(newName);
+  newFile << ext;
+  BPath newPath(GetPlaylistDirectory().Path(), newFile.String());
 
-  char *buffer = new char[fileSize + 1];
-  if (file.Read(buffer, fileSize) != fileSize) {
-    DEBUG_PRINT("[PlaylistUtils] Fehler beim Lesen der Datei: %s\n",
-                dirPath.Path());
-    delete[] buffer;
-    return items;
+  if (entry.Rename(newPath.Path()) != B_OK) {
+    DEBUG_PRINT("[PlaylistUtils] Umbenennen von '%s' fehlgeschlagen\n",
+                oldName.String());
+    return false;
   }
 
-  buffer[fileSize] = '\0';
-  BString content(buffer);
-  delete[] buffer;
+  PlaylistIndex::RenamePlaylist(oldName, newName);
+  return true;
+}
 
-  BStringList lines;
-  content.Split("\n", true, lines);
+/**
+ * @brief Loads all entries from a playlist file.
+ *
+ * M3U, extended M3U and PLS files are supported; see PlaylistFile.
+ *
+ * @param name Name of the playlist.
+ * @return Entries in playlist order.
+ */
+std::vector<PlaylistEntry> LoadPlaylistEntries(const BString &name) {
+  std::vector<PlaylistEntry> entries;
+  BString filePath = PlaylistPathFor(name);
 
-  for (int32 i = 0; i < lines.CountStrings(); ++i) {
-    BString line = lines.StringAt(i);
-    line.RemoveAll("\r");
-    if (!line.IsEmpty()) {
-      items.push_back(line);
-      DEBUG_PRINT("[PlaylistUtils] Eingelesen: %s\n", line.String());
-    }
+  if (!PlaylistFile::Read(filePath.String(), entries)) {
+    DEBUG_PRINT("[PlaylistUtils] Datei konnte nicht geoeffnet werden: %s\n",
+                filePath.String());
   }
+  return entries;
+}
+
+/**
+ * @brief Loads all track paths from a playlist file.
+ * @param name Name of the playlist.
+ * @return Vector of file path strings.
+ */
+std::vector<BString> LoadPlaylist(const BString &name) {
+  std::vector<PlaylistEntry> entries = LoadPlaylistEntries(name);
+
+  std::vector<BString> items;
+  items.reserve(entries.size());
+  for (auto &e : entries)
+    items.push_back(std::move(e.path));
 
   DEBUG_PRINT("[PlaylistUtils] %zu Eintraege geladen aus Playlist '%s'\n",
               items.size(), name.String());
@@ -173,12 +408,45 @@ std::vector<BString> LoadPlaylist(const BString &name) {
 /**
  * @brief Saves a list of paths to a playlist file.
  *
- * Overwrites the existing file. Creates the directory if it doesn't exist.
+ * Paths the library knows get its metadata; the others keep what the file
+ * already stored for them.
  *
  * @param name Name of the playlist.
  * @param paths Vector of path strings to save.
+ * @return True on success.
  */
-void SavePlaylist(const BString &name, const std::vector<BString> &paths) {
+bool SavePlaylist(const BString &name, const std::vector<BString> &paths) {
+  BStringMap<PlaylistEntry> existing;
+  if (!paths.empty()) {
+    for (auto &e : LoadPlaylistEntries(name)) {
+      BString path = e.path;
+      existing.emplace(std::move(path), std::move(e));
+    }
+  }
+
+  std::vector<PlaylistEntry> entries;
+  entries.reserve(paths.size());
+  for (const auto &path : paths) {
+    auto it = existing.find(path);
+    if (it != existing.end())
+      entries.push_back(it->second);
+    else
+      entries.emplace_back(path);
+  }
+  return SavePlaylistEntries(name, std::move(entries));
+}
+
+/**
+ * @brief Saves playlist entries to a playlist file.
+ *
+ * Overwrites the existing file. Creates the directory if it doesn't exist.
+ *
+ * @param name Name of the playlist.
+ * @param entries Entries to save; the library's metadata replaces theirs.
+ * @return True on success.
+ */
+bool SavePlaylistEntries(const BString &name,
+                         std::vector<PlaylistEntry> entries) {
   BPath dirPath = GetPlaylistDirectory();
 
   BDirectory dir(dirPath.Path());
@@ -186,24 +454,86 @@ void SavePlaylist(const BString &name, const std::vector<BString> &paths) {
     create_directory(dirPath.Path(), 0777);
   }
 
-  BString fileName = name;
-  fileName += ".m3u";
-  dirPath.Append(fileName.String());
+  BString filePath = PlaylistPathFor(name);
+  ForgetMembership(filePath);
 
-  BFile file(dirPath.Path(), B_WRITE_ONLY | B_CREATE_FILE | B_ERASE_FILE);
-  if (file.InitCheck() != B_OK) {
-    DEBUG_PRINT(
-        "[PlaylistUtils-ERROR] Konnte Playlist-Datei nicht oeffnen: %s\n",
-        dirPath.Path());
-    return;
+  std::vector<BString> paths;
+  paths.reserve(entries.size());
+  for (auto &e : entries) {
+    ApplyLibraryMetadata(e);
+    paths.push_back(e.path);
   }
 
-  for (const auto &path : paths) {
-    file.Write(path.String(), path.Length());
-    file.Write("\n", 1);
-    DEBUG_PRINT("-> geschrieben: %s\n", path.String());
+  PlaylistFormat format = PlaylistFile::FormatForPath(filePath.String());
+  if (format == PlaylistFormat::M3U)
+    format = PlaylistFormat::ExtendedM3U;
+  if (!PlaylistFile::Write(filePath.String(), entries, format)) {
+    DEBUG_PRINT(
+        "[PlaylistUtils-ERROR] Konnte Playlist-Datei nicht schreiben: %s\n",
+        filePath.String());
+    return false;
   }
 
+  PlaylistIndex::SetPlaylist(name, paths);
+
   DEBUG_PRINT("Playlist '%s' gespeichert (%zu Eintraege)\n", name.String(),
               paths.size());
+  return true;
+}
+
+/**
+ * @brief Replaces moved or renamed track paths in all playlists.
+ *
+ * Only the playlists that the reverse index lists for one of the old paths
+ * are opened and rewritten. #EXTINF / PLS metadata is kept.
+ *
+ * @param moves Map from old to new absolute path.
+ * @return Number of playlists rewritten.
+ */
+int32 RewritePlaylistPaths(const BStringMap<BString> &moves) {
+  if (moves.empty())
+    return 0;
+
+  std::vector<BString> oldPaths;
+  oldPaths.reserve(moves.size());
+  for (const auto &kv : moves)
+    oldPaths.push_back(kv.first);
+
+  int32 rewritten = 0;
+  for (const auto &name : PlaylistIndex::PlaylistsContainingAny(oldPaths)) {
+    BString filePath = PlaylistPathFor(name);
+
+    std::vector<PlaylistEntry> entries;
+    PlaylistFormat format;
+    if (!PlaylistFile::Read(filePath.String(), entries, &format))
+      continue;
+
+    bool changed = false;
+    for (auto &e : entries) {
+      auto it = moves.find(e.path);
+      if (it != moves.end()) {
+        e.path = it->second;
+        changed = true;
+      }
+    }
+    if (!changed)
+      continue;
+
+    ForgetMembership(filePath);
+    if (!PlaylistFile::Write(filePath.String(), entries, format))
+      continue;
+
+    std::vector<BString> paths;
+    paths.reserve(entries.size());
+    for (const auto &e : entries)
+      paths.push_back(e.path);
+    PlaylistIndex::SetPlaylist(name, paths);
+
+    NotifyPlaylistChanged(name);
+    rewritten++;
+  }
+
+  DEBUG_PRINT("[PlaylistUtils] %ld Playlists nach Verschieben angepasst\n",
+              (long)rewritten);
+  return rewritten;
 }
@@ -1,22 +1,145 @@
 #ifndef PLAYLIST_UTILS_H
 #define PLAYLIST_UTILS_H
 
+#include "HashUtils.h"
+#include "PlaylistFile.h"
+
+#include <Messenger.h>
 #include <String.h>
+#include <functional>
 #include <vector>
 
+/**
+ * @brief Fills in the #EXTINF metadata (artist, title, duration, inode) of an
+ * entry from its path.
+ * @return False if nothing is known about the track.
+ */
+typedef std::function<bool(const BString &path, PlaylistEntry &entry)>
+    PlaylistMetadataLookup;
+
+/**
+ * @brief Sets the source of metadata for tracks written to playlists.
+ *
+ * Saved M3U playlists are written as extended M3U, so they can be shown
+ * without reading the tracks; the lookup supplies the #EXTINF data. It is
+ * called from the thread that saves, which is the main window's thread.
+ */
+void SetPlaylistMetadataLookup(PlaylistMetadataLookup lookup);
+
+/**
+ * @brief Sets who is told with MSG_PLAYLIST_CHANGED when a function here
+ * rewrites or extends a playlist.
+ */
+void SetPlaylistChangeTarget(const BMessenger &target);
+
+/**
+ * @brief Sets the folder in which playlists are stored.
+ *
+ * All playlist functions below resolve names relative to this folder. If it
+ * is never set, `settings/BeTon/Playlists` is used.
+ *
+ * @param path Absolute path of the playlist folder.
+ */
+void SetPlaylistDirectory(const BString &path);
+
+/**
+ * @brief Returns the folder in which playlists are stored.
+ */
+BString PlaylistDirectory();
+
+/**
+ * @brief Returns true if the file name has a supported playlist extension
+ * (.m3u, .m3u8 or .pls).
+ */
+bool IsPlaylistFileName(const char *leaf);
+
+/**
+ * @brief Strips a supported playlist extension from a file name.
+ */
+BString PlaylistNameFromFileName(const char *leaf);
+
+/**
+ * @brief Turns a playlist name into a file name without extension.
+ *
+ * Slashes become underscores, names the file system reserves ("", "." and
+ * "..") get a leading underscore, and overlong names are cut at a UTF-8
+ * character boundary.
+ */
+BString PlaylistFileName(const BString &name);
+
+/**
+ * @brief Resolves a playlist name to the file backing it.
+ *
+ * Existing .m3u, .m3u8 and .pls files are tried in that order. If none
+ * exists, the path of a new .m3u file is returned.
+ *
+ * @param name The name of the playlist (without extension).
+ * @return Absolute path of the playlist file.
+ */
+BString PlaylistPathFor(const BString &name);
+
+/**
+ * @brief Returns a playlist name that no file uses yet.
+ *
+ * @p name itself if it is free, otherwise "name 2", "name 3" and so on.
+ */
+BString UnusedPlaylistName(const BString &name);
+
 /**
  * @brief Loads the contents of a playlist file.
- * @param name The name of the playlist (without .m3u extension).
+ * @param name The name of the playlist (without extension).
  * @return A vector of file paths contained in the playlist.
  */
 std::vector<BString> LoadPlaylist(const BString &name);
 
+/**
+ * @brief Loads a playlist including the #EXTINF / PLS metadata.
+ * @param name The name of the playlist (without extension).
+ * @return The entries in playlist order.
+ */
+std::vector<PlaylistEntry> LoadPlaylistEntries(const BString &name);
+
 /**
  * @brief Saves a list of paths to a playlist file.
- * @param name The name of the playlist (without .m3u extension).
+ *
+ * M3U playlists are written as extended M3U; .pls files stay PLS. Paths
+ * the library knows are written with its current metadata; only the
+ * others keep what the file stored, so tracks the library does not know
+ * lose nothing. See SavePlaylistEntries().
+ *
+ * @param name The name of the playlist (without extension).
  * @param paths The list of file paths to save.
+ * @return True on success.
  */
-void SavePlaylist(const BString &name, const std::vector<BString> &paths);
+bool SavePlaylist(const BString &name, const std::vector<BString> &paths);
+
+/**
+ * @brief Saves playlist entries to a playlist file.
+ *
+ * Entries whose path the library knows are written with the library's
+ * metadata; the others are written as given.
+ *
+ * @param name The name of the playlist (without extension).
+ * @param entries The entries to save, in playlist order.
+ * @return True on success.
+ */
+bool SavePlaylistEntries(const BString &name,
+                         std::vector<PlaylistEntry> entries);
+
+/**
+ * @brief Appends items to a playlist in one write.
+ *
+ * Items already present are skipped. Duplicates are detected with a cached
+ * hash set per playlist, and new items are appended to the end of the file
+ * instead of rewriting it. Posts MSG_PLAYLIST_CHANGED to the main window if
+ * anything was added.
+ *
+ * @param paths The file paths of the items to add.
+ * @param playlist The name of the target playlist.
+ * @return Number of items actually added.
+ */
+int32 AddItemsToPlaylist(const std::vector<BString> &paths,
+                         const BString &playlist);
 
 /**
  * @brief Appends a single item to an existing playlist.
@@ -40,4 +163,23 @@ void CreatePlaylist(const BString &name);
  */
 void DeletePlaylist(const BString &name);
 
+/**
+ * @brief Renames a playlist file, keeping its extension.
+ * @param oldName Current playlist name.
+ * @param newName New playlist name.
+ * @return True if the file was renamed.
+ */
+bool RenamePlaylistFile(const BString &oldName, const BString &newName);
+
+/**
+ * @brief Replaces moved or renamed track paths in all affected playlists.
+ *
+ * Uses the PlaylistIndex to open only the playlists that reference one of
+ * the old paths.
+ *
+ * @param moves Map from old to new absolute path.
+ * @return Number of playlists rewritten.
+ */
+int32 RewritePlaylistPaths(const BStringMap<BString> &moves);
+
 #endif // PLAYLIST_UTILS_H
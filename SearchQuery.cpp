@@ -0,0 +1,289 @@
+#include "SearchQuery.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+
+namespace {
+
+struct FieldName {
+  const char *name;
+  SearchTerm::Field field;
+};
+
+const FieldName kFieldNames[] = {
+    {"title", SearchTerm::kTitle},
+    {"artist", SearchTerm::kArtist},
+    {"album", SearchTerm::kAlbum},
+    {"albumartist", SearchTerm::kAlbumArtist},
+    {"genre", SearchTerm::kGenre},
+    {"composer", SearchTerm::kComposer},
+    {"comment", SearchTerm::kComment},
+    {"path", SearchTerm::kPath},
+    {"year", SearchTerm::kYear},
+    {"duration", SearchTerm::kDuration},
+    {"length", SearchTerm::kDuration},
+    {"bitrate", SearchTerm::kBitrate},
+    {"track", SearchTerm::kTrack},
+    {"disc", SearchTerm::kDisc},
+};
+
+bool FindField(const char *name, size_t length, SearchTerm::Field &field) {
+  for (const FieldName &f : kFieldNames) {
+    if (strlen(f.name) == length && strncasecmp(f.name, name, length) == 0) {
+      field = f.field;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Reads a word, or a phrase in quotes, starting at @p p.
+ * @return The position after it.
+ */
+const char *ReadValue(const char *p, BString &value) {
+  if (*p == '"') {
+    const char *end = strchr(p + 1, '"');
+    if (!end)
+      end = p + strlen(p);
+    value.SetTo(p + 1, (int32)(end - p - 1));
+    return *end ? end + 1 : end;
+  }
+
+  const char *end = p;
+  while (*end && !isspace((unsigned char)*end))
+    end++;
+  value.SetTo(p, (int32)(end - p));
+  return end;
+}
+
+/** @brief @p value + @p delta, held at the limits of int64. */
+int64 AddSaturated(int64 value, int64 delta) {
+  if (delta > 0 && value > INT64_MAX - delta)
+    return INT64_MAX;
+  if (delta < 0 && value < INT64_MIN - delta)
+    return INT64_MIN;
+  return value + delta;
+}
+
+/**
+ * @brief Parses one number of a number field.
+ *
+ * Numbers too large for int64, in the given unit or at all, are rejected.
+ *
+ * @param[out] unit How many of the field's units the value spans, e.g. 60
+ * for a duration in minutes.
+ */
+bool ParseNumber(const char *s, SearchTerm::Field field, int64 &value,
+                 int64 &unit) {
+  char *end;
+  errno = 0;
+  value = strtoll(s, &end, 10);
+  if (end == s || *s == '-' || *s == '+' || errno == ERANGE)
+    return false;
+
+  unit = 1;
+  if (field == SearchTerm::kDuration) {
+    if (*end == ':') {
+      const char *start = end + 1;
+      const int64 seconds = strtoll(start, &end, 10);
+      if (end == start || *start == '-' || seconds > 59 ||
+          value > (INT64_MAX - 59) / 60)
+        return false;
+      value = value * 60 + seconds;
+    } else if (*end == 'h') {
+      unit = 3600;
+      end++;
+    } else if (*end == 'm') {
+      unit = 60;
+      end++;
+    } else if (*end == 's') {
+      end++;
+    }
+    if (value > INT64_MAX / unit)
+      return false;
+    value *= unit;
+  } else if (field == SearchTerm::kBitrate) {
+    if (strcasecmp(end, "k") == 0 || strcasecmp(end, "kbps") == 0)
+      end += strlen(end);
+  }
+  return *end == '\0';
+}
+
+/**
+ * @brief Parses the value of a number field into an inclusive range.
+ *
+ * Comparisons take the value as a point; a plain value or a range end
+ * covers its whole unit.
+ */
+bool ParseRange(const BString &text, SearchTerm::Field field, int64 &low,
+                int64 &high) {
+  const char *s = text.String();
+  int64 value, unit;
+
+  if (*s == '>' || *s == '<') {
+    const bool greater = *s == '>';
+    const bool orEqual = s[1] == '=';
+    if (!ParseNumber(s + (orEqual ? 2 : 1), field, value, unit))
+      return false;
+    if (greater)
+      low = orEqual ? value : AddSaturated(value, 1);
+    else
+      high = orEqual ? value : AddSaturated(value, -1);
+    return true;
+  }
+
+  if (*s == '=')
+    s++;
+
+  const char *dots = strstr(s, "..");
+  if (!dots) {
+    if (!ParseNumber(s, field, value, unit))
+      return false;
+    low = value;
+    high = AddSaturated(value, unit - 1);
+    return true;
+  }
+
+  const BString from(s, (int32)(dots - s));
+  const char *to = dots + 2;
+  if (from.IsEmpty() && *to == '\0')
+    return false;
+  if (!from.IsEmpty()) {
+    if (!ParseNumber(from.String(), field, value, unit))
+      return false;
+    low = value;
+  }
+  if (*to != '\0') {
+    if (!ParseNumber(to, field, value, unit))
+      return false;
+    high = AddSaturated(value, unit - 1);
+  }
+  return true;
+}
+
+const BString *TextOf(SearchTerm::Field field, const MediaItem &item) {
+  switch (field) {
+  case SearchTerm::kTitle:
+    return &item.title;
+  case SearchTerm::kArtist:
+    return &item.artist;
+  case SearchTerm::kAlbum:
+    return &item.album;
+  case SearchTerm::kAlbumArtist:
+    return &item.albumArtist;
+  case SearchTerm::kGenre:
+    return &item.genre;
+  case SearchTerm::kComposer:
+    return &item.composer;
+  case SearchTerm::kComment:
+    return &item.comment;
+  case SearchTerm::kPath:
+    return &item.path;
+  default:
+    return nullptr;
+  }
+}
+
+int64 NumberOf(SearchTerm::Field field, const MediaItem &item) {
+  switch (field) {
+  case SearchTerm::kYear:
+    return item.year;
+  case SearchTerm::kDuration:
+    return item.duration;
+  case SearchTerm::kBitrate:
+    return item.bitrate;
+  case SearchTerm::kTrack:
+    return item.track;
+  case SearchTerm::kDisc:
+  default:
+    return item.disc;
+  }
+}
+
+} // namespace
+
+bool SearchTerm::Matches(const MediaItem &item) const {
+  bool match;
+  if (IsNumber()) {
+    const int64 value = NumberOf(field, item);
+    match = value >= low && value <= high;
+  } else if (field == kAny) {
+    match = item.title.IFindFirst(text) >= 0 ||
+            item.artist.IFindFirst(text) >= 0 ||
+            item.album.IFindFirst(text) >= 0;
+  } else {
+    match = TextOf(field, item)->IFindFirst(text) >= 0;
+  }
+  return match != negated;
+}
+
+int32 SearchTerm::Cost() const {
+  if (IsNumber())
+    return 1;
+  return field == kAny ? 12 : 4;
+}
+
+void SearchQuery::Parse(const BString &text) {
+  fTerms.clear();
+
+  const char *p = text.String();
+  while (*p) {
+    if (isspace((unsigned char)*p)) {
+      p++;
+      continue;
+    }
+
+    SearchTerm term;
+    term.negated = *p == '-' && p[1] && !isspace((unsigned char)p[1]);
+    if (term.negated)
+      p++;
+    const char *start = p;
+
+    const char *colon = p;
+    while (isalpha((unsigned char)*colon))
+      colon++;
+    BString value;
+    if (*colon == ':' && colon > p &&
+        FindField(p, (size_t)(colon - p), term.field)) {
+      p = ReadValue(colon + 1, value);
+      if (term.IsNumber()
+              ? ParseRange(value, term.field, term.low, term.high)
+              : !value.IsEmpty()) {
+        if (!term.IsNumber())
+          term.text = value;
+        fTerms.push_back(term);
+        continue;
+      }
+      // Not a field term after all: search for the text as typed.
+      const bool negated = term.negated;
+      term = SearchTerm();
+      term.negated = negated;
+      value.SetTo(start, (int32)(p - start));
+    } else {
+      p = ReadValue(p, value);
+    }
+
+    if (!value.IsEmpty()) {
+      term.text = value;
+      fTerms.push_back(term);
+    }
+  }
+
+  std::stable_sort(fTerms.begin(), fTerms.end(),
+                   [](const SearchTerm &a, const SearchTerm &b) {
+                     return a.Cost() < b.Cost();
+                   });
+}
+
+bool SearchQuery::Matches(const MediaItem &item) const {
+  for (const SearchTerm &term : fTerms) {
+    if (!term.Matches(item))
+      return false;
+  }
+  return true;
+}
@@ -0,0 +1,91 @@
+#ifndef SEARCH_QUERY_H
+#define SEARCH_QUERY_H
+
+#include "MediaItem.h"
+
+#include <String.h>
+#include <SupportDefs.h>
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @struct SearchTerm
+ * @brief One condition of a search: a field against a text or a range.
+ */
+struct SearchTerm {
+  enum Field {
+    kAny, ///< Title, artist or album.
+    kTitle,
+    kArtist,
+    kAlbum,
+    kAlbumArtist,
+    kGenre,
+    kComposer,
+    kComment,
+    kPath,
+    // Number fields from here on
+    kYear,
+    kDuration, ///< Seconds.
+    kBitrate,  ///< kbps.
+    kTrack,
+    kDisc
+  };
+
+  Field field = kAny;
+  BString text;              ///< Text fields: case-insensitive substring.
+  int64 low = INT64_MIN;     ///< Number fields: inclusive lower bound.
+  int64 high = INT64_MAX;    ///< Number fields: inclusive upper bound.
+  bool negated = false;
+
+  bool IsNumber() const { return field >= kYear; }
+
+  /** @brief Whether the track meets the condition, negation included. */
+  bool Matches(const MediaItem &item) const;
+
+  /** Relative cost of Matches(), used to test cheap terms first. */
+  int32 Cost() const;
+};
+
+/**
+ * @class SearchQuery
+ * @brief The search field's text, parsed into terms that must all match.
+ *
+ * Words match title, artist or album, each on its own: `Re: Stacks` finds
+ * tracks with both "Re:" and "Stacks" somewhere, while `"Re: Stacks"`
+ * searches for the phrase. A field name and colon restrict a word to one
+ * field, quotes keep spaces, and a leading minus negates:
+ *
+ *     artist:"Miles Davis" year:1955..1965 genre:jazz -live
+ *     duration:>10m bitrate:>=256
+ *
+ * Text fields are title, artist, album, albumartist, genre, composer,
+ * comment and path. Number fields are year, duration, bitrate, track and
+ * disc; they take a value, a range "a..b" (either end may be left out), or
+ * a comparison with >, >=, < or <=. Durations are seconds, or use the units
+ * s, m and h, or m:ss; a value in a unit covers the whole unit, so
+ * "duration:4m" is 4:00 to 4:59.
+ *
+ * Anything that does not parse as a field term is searched as a word.
+ */
+class SearchQuery {
+public:
+  SearchQuery() = default;
+  explicit SearchQuery(const BString &text) { Parse(text); }
+
+  /** @brief Replaces the terms by those of @p text. */
+  void Parse(const BString &text);
+
+  bool IsEmpty() const { return fTerms.empty(); }
+
+  /** @brief The terms, cheapest first. */
+  const std::vector<SearchTerm> &Terms() const { return fTerms; }
+
+  /** @brief Whether the track meets every term. */
+  bool Matches(const MediaItem &item) const;
+
+private:
+  std::vector<SearchTerm> fTerms;
+};
+
+#endif // SEARCH_QUERY_H
@@ -1,5 +1,6 @@
 #include "SimpleColumnView.h"
 #include "Debug.h"
+#include "MemoryReport.h"
 
 #include <Font.h>
 #include <ScrollBar.h>
@@ -43,16 +44,74 @@ void SimpleColumnView::AddItem(const BString &text) {
  * @param path The hidden value/path associated with the item.
  */
 void SimpleColumnView::AddItem(const BString &text, const BString &path) {
-  fItems.push_back({text, path, false});
+  fItems.push_back({text, path, false, _IdFor(text)});
   UpdateScrollbars();
   Invalidate();
 }
 
+bool SimpleColumnView::SetItemText(int32 index, const BString &text) {
+  if (index < 0 || index >= (int32)fItems.size())
+    return false;
+  SimpleItem &item = fItems[index];
+  if (item.text == text)
+    return true;
+  if (Contains(text))
+    return false;
+
+  fIds.erase(item.text);
+  fIds.emplace(text, item.id);
+  item.text = text;
+  Invalidate();
+  return true;
+}
+
+bool SimpleColumnView::SetItems(std::vector<SimpleItem> items) {
+  bool changed = items.size() != fItems.size();
+  for (size_t i = 0; !changed && i < items.size(); i++) {
+    changed = items[i].text != fItems[i].text ||
+              items[i].path != fItems[i].path ||
+              items[i].count != fItems[i].count;
+  }
+  if (!changed)
+    return false;
+
+  const uint32 anchorId =
+      fCurrentSelection >= 0 ? fItems[fCurrentSelection].id : 0;
+  std::vector<uint32> selectedIds;
+  for (const SimpleItem &item : fItems) {
+    if (item.selected)
+      selectedIds.push_back(item.id);
+  }
+  std::sort(selectedIds.begin(), selectedIds.end());
+  fCurrentSelection = -1;
+
+  BStringMap<uint32> ids;
+  ids.reserve(items.size());
+  for (size_t i = 0; i < items.size(); i++) {
+    SimpleItem &item = items[i];
+    auto known = fIds.find(item.text);
+    item.id = known != fIds.end() ? known->second : fNextId++;
+    item.selected =
+        std::binary_search(selectedIds.begin(), selectedIds.end(), item.id);
+    if (item.selected && item.id == anchorId)
+      fCurrentSelection = (int32)i;
+    ids.emplace(item.text, item.id);
+  }
+
+  fItems = std::move(items);
+  fIds = std::move(ids);
+  if (fCurrentSelection < 0)
+    fCurrentSelection = _FirstSelected();
+  UpdateScrollbars();
+  return true;
+}
+
 /**
  * @brief Removes all items from the list.
  */
 void SimpleColumnView::Clear() {
   fItems.clear();
+  fIds.clear();
   fCurrentSelection = -1;
   UpdateScrollbars();
   Invalidate();
@@ -83,18 +142,49 @@ const BString &SimpleColumnView::PathAt(int32 index) const {
   return fItems[index].path;
 }
 
+/**
+ * @return The ID of the item at the specified index, or 0.
+ */
+uint32 SimpleColumnView::IdAt(int32 index) const {
+  if (index < 0 || index >= (int32)fItems.size())
+    return 0;
+  return fItems[index].id;
+}
+
+bool SimpleColumnView::Contains(const BString &text) const {
+  return fIds.find(text) != fIds.end();
+}
+
 /**
  * @return The index of the currently selected item, or -1 if none.
  */
 int32 SimpleColumnView::CurrentSelection() const { return fCurrentSelection; }
 
+bool SimpleColumnView::IsSelected(int32 index) const {
+  return index >= 0 && index < (int32)fItems.size() && fItems[index].selected;
+}
+
+std::vector<int32> SimpleColumnView::Selection() const {
+  std::vector<int32> selection;
+  for (int32 i = 0; i < (int32)fItems.size(); i++) {
+    if (fItems[i].selected)
+      selection.push_back(i);
+  }
+  return selection;
+}
+
 /**
  * @brief Removes the item at the specified index.
  */
 void SimpleColumnView::RemoveItemAt(int32 index) {
   if (index >= 0 && index < (int32)fItems.size()) {
+    fIds.erase(fItems[index].text);
     fItems.erase(fItems.begin() + index);
-    Invalidate();
+    if (fCurrentSelection == index)
+      fCurrentSelection = _FirstSelected();
+    else if (fCurrentSelection > index)
+      fCurrentSelection--;
+    UpdateScrollbars();
   }
 }
 
@@ -105,14 +195,24 @@ void SimpleColumnView::RemoveItemAt(int32 index) {
 void SimpleColumnView::Select(int32 index) {
   if (index < 0 || index >= (int32)fItems.size())
     return;
-  if (fCurrentSelection >= 0 && fCurrentSelection < (int32)fItems.size())
-    fItems[fCurrentSelection].selected = false;
+  for (SimpleItem &item : fItems)
+    item.selected = false;
 
   fCurrentSelection = index;
   fItems[index].selected = true;
   Invalidate();
 }
 
+/**
+ * @brief Clears the selection without notifying the target.
+ */
+void SimpleColumnView::DeselectAll() {
+  for (SimpleItem &item : fItems)
+    item.selected = false;
+  fCurrentSelection = -1;
+  Invalidate();
+}
+
 /**
  * @brief Scrolls the view to ensure the selected item is visible.
  */
@@ -182,9 +282,10 @@ float SimpleColumnView::LineHeight() const {
 
 void SimpleColumnView::Draw(BRect updateRect) {
   BRect bounds = Bounds();
-  int32 first = (int32)(updateRect.top / fItemHeight);
-  int32 last = (int32)(updateRect.bottom / fItemHeight);
-  int32 maxRow = std::max(last, (int32)fItems.size() - 1);
+  // Only the rows in the update rect; the background stripes continue past
+  // the last item.
+  int32 first = std::max((int32)0, (int32)(updateRect.top / fItemHeight));
+  int32 maxRow = (int32)(updateRect.bottom / fItemHeight);
 
   rgb_color base = ui_color(B_LIST_BACKGROUND_COLOR);
 
@@ -195,19 +296,18 @@ void SimpleColumnView::Draw(BRect updateRect) {
     float top = i * fItemHeight;
     BRect rowRect(bounds.left, top, bounds.right, top + fItemHeight - 1);
 
-    if ((i & 1) == 0) {
-      SetHighColor(base);
-    } else {
-      if (isDark)
-        SetHighColor(tint_color(base, 0.90));
-      else
-        SetHighColor(tint_color(base, 1.05));
-    }
+    rgb_color background = base;
+    if ((i & 1) != 0)
+      background = tint_color(base, isDark ? 0.90 : 1.05);
+    SetHighColor(background);
     FillRect(rowRect);
 
     if (i < (int32)fItems.size()) {
 
       if (fItems[i].selected) {
+        background = fUseCustomColor
+                         ? fSelectionColor
+                         : ui_color(B_LIST_SELECTED_BACKGROUND_COLOR);
         if (fUseCustomColor) {
           SetHighColor(fSelectionColor);
           FillRect(rowRect);
@@ -236,7 +336,22 @@ void SimpleColumnView::Draw(BRect updateRect) {
                        floorf((rowRect.Height() - textHeight) / 2.0f) +
                        fh.ascent;
 
-      DrawString(fItems[i].text.String(), BPoint(rowRect.left + 5, baseline));
+      float textRight = rowRect.right - 5;
+      if (fItems[i].count >= 0) {
+        BString count;
+        count << fItems[i].count;
+        const float countWidth = StringWidth(count.String());
+        const rgb_color textColor = HighColor();
+        SetHighColor(mix_color(textColor, background, 96));
+        DrawString(count.String(),
+                   BPoint(rowRect.right - 5 - countWidth, baseline));
+        SetHighColor(textColor);
+        textRight -= countWidth + 10;
+      }
+
+      BString text(fItems[i].text);
+      TruncateString(&text, B_TRUNCATE_END, textRight - (rowRect.left + 5));
+      DrawString(text.String(), BPoint(rowRect.left + 5, baseline));
     }
   }
 }
@@ -249,9 +364,43 @@ void SimpleColumnView::MouseDown(BPoint where) {
   MakeFocus(true);
   int32 index = (int32)(where.y / fItemHeight);
 
-  if (index >= 0 && index < (int32)fItems.size()) {
+  if (index < 0 || index >= (int32)fItems.size())
+    return;
+
+  const uint32 mods = fMultipleSelection ? modifiers() : 0;
+  if ((mods & B_COMMAND_KEY) != 0)
+    _Toggle(index);
+  else if ((mods & B_SHIFT_KEY) != 0 && fCurrentSelection >= 0)
+    _SelectRange(fCurrentSelection, index);
+  else
     Select(index);
-    SelectionChanged(index);
+  SelectionChanged(index);
+}
+
+/**
+ * @brief Jumps to the first item starting with the text typed so far.
+ */
+void SimpleColumnView::KeyDown(const char *bytes, int32 numBytes) {
+  if (numBytes < 1 || (uint8)bytes[0] < B_SPACE || bytes[0] == B_DELETE) {
+    BView::KeyDown(bytes, numBytes);
+    return;
+  }
+
+  const bigtime_t now = system_time();
+  if (now - fLastKeyTime > kTypeAheadTimeout)
+    fTypedText = "";
+  fLastKeyTime = now;
+  fTypedText.Append(bytes, numBytes);
+
+  for (int32 i = 0; i < (int32)fItems.size(); i++) {
+    if (fItems[i].text.ICompare(fTypedText, fTypedText.Length()) == 0) {
+      if (i != fCurrentSelection) {
+        Select(i);
+        ScrollToSelection();
+        SelectionChanged(i);
+      }
+      return;
+    }
   }
 }
 
@@ -279,6 +428,10 @@ void SimpleColumnView::SetSelectionMessage(uint32 what) {
   fSelectionWhat = what;
 }
 
+void SimpleColumnView::SetMultipleSelection(bool multiple) {
+  fMultipleSelection = multiple;
+}
+
 /**
  * @brief Sets the target messenger for selection change notifications.
  */
@@ -314,3 +467,56 @@ void SimpleColumnView::SetSelectionColor(rgb_color color) {
   fUseCustomColor = true;
   Invalidate();
 }
+
+uint32 SimpleColumnView::_IdFor(const BString &text) {
+  auto it = fIds.find(text);
+  if (it != fIds.end())
+    return it->second;
+
+  const uint32 id = fNextId++;
+  fIds.emplace(text, id);
+  return id;
+}
+
+/**
+ * @brief Adds or removes one item; the item becomes the anchor if it was
+ * added.
+ */
+void SimpleColumnView::_Toggle(int32 index) {
+  SimpleItem &item = fItems[index];
+  item.selected = !item.selected;
+  if (item.selected)
+    fCurrentSelection = index;
+  else if (fCurrentSelection == index)
+    fCurrentSelection = _FirstSelected();
+  Invalidate();
+}
+
+/**
+ * @brief Selects the items from @p from to @p to, keeping the anchor.
+ */
+void SimpleColumnView::_SelectRange(int32 from, int32 to) {
+  for (int32 i = std::min(from, to); i <= std::max(from, to); i++)
+    fItems[i].selected = true;
+  Invalidate();
+}
+
+int32 SimpleColumnView::_FirstSelected() const {
+  for (int32 i = 0; i < (int32)fItems.size(); i++) {
+    if (fItems[i].selected)
+      return i;
+  }
+  return -1;
+}
+
+void SimpleColumnView::AccountMemory(MemoryReport &report,
+                                     const char *component) const {
+  size_t bytes = fItems.capacity() * sizeof(SimpleItem);
+  for (const SimpleItem &item : fItems)
+    bytes += report.String(item.text) + report.String(item.path);
+  // The keys share their buffers with the item texts.
+  bytes += fIds.size() * (MemoryReport::kHashNode + MemoryReport::kAllocation +
+                          sizeof(std::pair<const BString, uint32>)) +
+           fIds.bucket_count() * MemoryReport::kHashBucket;
+  report.Add(MEMORY_VIEW_ROWS, component, fItems.size(), bytes);
+}
@@ -1,6 +1,8 @@
 #ifndef SIMPLE_COLUMN_VIEW_H
 #define SIMPLE_COLUMN_VIEW_H
 
+#include "HashUtils.h"
+
 #include <Message.h>
 #include <Messenger.h>
 #include <Rect.h>
@@ -10,6 +12,8 @@
 
 #include <vector>
 
+class MemoryReport;
+
 /**
  * @struct SimpleItem
  * @brief Represents a single item in the SimpleColumnView.
@@ -18,15 +22,26 @@ struct SimpleItem {
   BString text;          ///< The display text of the item.
   BString path;          ///< An associated hidden path or value (optional).
   bool selected = false; ///< Selection state of the item.
+  uint32 id = 0;         ///< Stays the same while the text is listed.
+  int32 count = -1;      ///< Shown right-aligned if not negative.
 };
 
 /**
  * @class SimpleColumnView
- * @brief A lightweight, custom list view that supports single selection.
+ * @brief A lightweight, custom list view that supports multiple selection.
  *
  * This view renders a list of strings (with optional associated paths) in a
  * vertical column. It handles drawing, scrollbar updates, and mouse interaction
  * for selection. It sends a message to a target when the selection changes.
+ * A click selects one item. With multiple selection enabled, Command-click
+ * toggles an item and Shift-click extends the selection from the last
+ * clicked item, the anchor.
+ *
+ * Texts are unique within a view and are looked up through a hash table.
+ * Each item keeps an ID for as long as its text is listed, which lets
+ * SetItems() replace the contents while keeping the selection and the
+ * scroll position. Typing jumps to the first item starting with the typed
+ * text.
  */
 class SimpleColumnView : public BView {
 public:
@@ -49,6 +64,23 @@ public:
    */
   void AddItem(const BString &text, const BString &path);
 
+  /**
+   * @brief Changes the text of the item at @p index; it keeps its ID and
+   * selection.
+   * @return False if the index is out of range or another item has the text.
+   */
+  bool SetItemText(int32 index, const BString &text);
+
+  /**
+   * @brief Replaces all items by @p items, which must have unique texts.
+   *
+   * Items whose text was listed before keep their ID, and the selected
+   * ones stay selected. Nothing is redrawn if the items are unchanged.
+   *
+   * @return True if anything changed.
+   */
+  bool SetItems(std::vector<SimpleItem> items);
+
   /**
    * @brief Removes all items from the list and clears selection.
    */
@@ -57,8 +89,16 @@ public:
   int32 CountItems() const;
   const BString &ItemAt(int32 index) const;
   const BString &PathAt(int32 index) const;
+  uint32 IdAt(int32 index) const;
+  bool Contains(const BString &text) const;
+  /** @return The anchor of the selection, or -1 if nothing is selected. */
   int32 CurrentSelection() const;
+  bool IsSelected(int32 index) const;
+  /** @return The indices of all selected items, ascending. */
+  std::vector<int32> Selection() const;
+  /** @brief Selects only the item at @p index. */
   void Select(int32 index);
+  void DeselectAll();
   void RemoveItemAt(int32 index);
   void ScrollToSelection();
 
@@ -68,6 +108,7 @@ public:
   void Draw(BRect updateRect) override;
   void FrameResized(float width, float height) override;
   void MouseDown(BPoint where) override;
+  void KeyDown(const char *bytes, int32 numBytes) override;
   void MessageReceived(BMessage *msg) override;
 
   /**
@@ -76,6 +117,11 @@ public:
    */
   void SetSelectionMessage(uint32 what);
 
+  /**
+   * @brief Lets Command- and Shift-clicks select several items.
+   */
+  void SetMultipleSelection(bool multiple);
+
   /**
    * @brief Sets the target messenger that receives selection notifications.
    * @param target The BMessenger to send messages to.
@@ -96,14 +142,35 @@ public:
    */
   void SetSelectionColor(rgb_color color);
 
+  /**
+   * @brief Adds the estimated size of the items to @p report.
+   */
+  void AccountMemory(MemoryReport &report, const char *component) const;
+
 protected:
   /** @name Data */
   ///@{
   std::vector<SimpleItem> fItems;
+  BStringMap<uint32> fIds; ///< Text -> ID of every item.
+  uint32 fNextId = 1;
   float fItemHeight;
   int32 fCurrentSelection;
+  bool fMultipleSelection = false;
   ///@}
 
+  /** @name Type-ahead */
+  ///@{
+  BString fTypedText;
+  bigtime_t fLastKeyTime = 0;
+  /** Keys further apart than this start a new search. */
+  static const bigtime_t kTypeAheadTimeout = 1000000;
+  ///@}
+
+  uint32 _IdFor(const BString &text);
+  void _Toggle(int32 index);
+  void _SelectRange(int32 from, int32 to);
+  int32 _FirstSelected() const;
+
   /** @name Notification */
   ///@{
   uint32 fSelectionWhat = 0;
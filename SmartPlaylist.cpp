@@ -0,0 +1,518 @@
+#include "SmartPlaylist.h"
+#include "Debug.h"
+#include "MemoryReport.h"
+#include "PlaylistUtils.h"
+
+#include <Directory.h>
+#include <Entry.h>
+#include <File.h>
+#include <FindDirectory.h>
+#include <OS.h>
+#include <Path.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+
+/** Below this many items per thread, spawning threads does not pay off. */
+static const size_t kMinItemsPerThread = 4096;
+
+static BPath DefinitionDirectory() {
+  BPath path;
+  if (find_directory(B_USER_SETTINGS_DIRECTORY, &path) == B_OK)
+    path.Append("BeTon/SmartPlaylists");
+  return path;
+}
+
+/** The definition is stored under the same file name as the playlist. */
+static BPath DefinitionPath(const BString &name) {
+  return BPath(DefinitionDirectory().Path(), PlaylistFileName(name).String());
+}
+
+void SmartPlaylistDefinition::Archive(BMessage &into) const {
+  into.AddString("name", name);
+  for (const auto &r : rules) {
+    BMessage ruleMsg;
+    ruleMsg.AddInt32("type", r.type);
+    ruleMsg.AddString("val1", r.value);
+    ruleMsg.AddString("val2", r.value2);
+    ruleMsg.AddBool("exclude", r.exclude);
+    into.AddMessage("rule", &ruleMsg);
+  }
+  into.AddBool("shuffle", shuffle);
+  into.AddInt32("limit_mode", limitMode);
+  into.AddInt32("limit_value", limitValue);
+  into.AddBool("live", live);
+}
+
+SmartPlaylistDefinition
+SmartPlaylistDefinition::FromMessage(const BMessage &msg) {
+  SmartPlaylistDefinition def;
+  def.name = msg.GetString("name", "");
+
+  BMessage ruleMsg;
+  for (int32 i = 0; msg.FindMessage("rule", i, &ruleMsg) == B_OK; i++) {
+    Rule r;
+    r.type = ruleMsg.GetInt32("type", kRuleGenre);
+    r.value = ruleMsg.GetString("val1", "");
+    r.value2 = ruleMsg.GetString("val2", "");
+    r.exclude = ruleMsg.GetBool("exclude", false);
+    def.rules.push_back(r);
+  }
+
+  def.shuffle = msg.GetBool("shuffle", false);
+  def.limitMode = msg.GetInt32("limit_mode", 0);
+  def.limitValue = msg.GetInt32("limit_value", 0);
+  def.live = msg.GetBool("live", true);
+  return def;
+}
+
+namespace {
+
+class MatchAll : public SmartPredicate {
+public:
+  bool Matches(const MediaItem &) const override { return true; }
+  int32 Cost() const override { return 0; }
+};
+
+class AllOf : public SmartPredicate {
+public:
+  explicit AllOf(std::vector<std::unique_ptr<SmartPredicate>> &&children)
+      : fChildren(std::move(children)) {
+    std::stable_sort(fChildren.begin(), fChildren.end(),
+                     [](const auto &a, const auto &b) {
+                       return a->Cost() < b->Cost();
+                     });
+  }
+
+  bool Matches(const MediaItem &item) const override {
+    for (const auto &c : fChildren) {
+      if (!c->Matches(item))
+        return false;
+    }
+    return true;
+  }
+
+  int32 Cost() const override {
+    int32 cost = 0;
+    for (const auto &c : fChildren)
+      cost += c->Cost();
+    return cost;
+  }
+
+private:
+  std::vector<std::unique_ptr<SmartPredicate>> fChildren;
+};
+
+class Not : public SmartPredicate {
+public:
+  explicit Not(std::unique_ptr<SmartPredicate> &&child)
+      : fChild(std::move(child)) {}
+
+  bool Matches(const MediaItem &item) const override {
+    return !fChild->Matches(item);
+  }
+  int32 Cost() const override { return fChild->Cost(); }
+
+private:
+  std::unique_ptr<SmartPredicate> fChild;
+};
+
+class StringEquals : public SmartPredicate {
+public:
+  StringEquals(BString MediaItem::*field, const BString &value)
+      : fField(field), fValue(value) {}
+
+  bool Matches(const MediaItem &item) const override {
+    return (item.*fField).ICompare(fValue) == 0;
+  }
+  int32 Cost() const override { return 2; }
+
+private:
+  BString MediaItem::*fField;
+  BString fValue;
+};
+
+class StringContains : public SmartPredicate {
+public:
+  StringContains(BString MediaItem::*field, const BString &value)
+      : fField(field), fValue(value) {}
+
+  bool Matches(const MediaItem &item) const override {
+    return (item.*fField).IFindFirst(fValue) >= 0;
+  }
+  int32 Cost() const override { return 4; }
+
+private:
+  BString MediaItem::*fField;
+  BString fValue;
+};
+
+class IntRange : public SmartPredicate {
+public:
+  IntRange(int32 MediaItem::*field, int32 lo, int32 hi, int32 scale)
+      : fField(field), fLo(lo), fHi(hi), fScale(scale) {}
+
+  bool Matches(const MediaItem &item) const override {
+    int32 v = item.*fField;
+    if (fLo > 0 && v < fLo * fScale)
+      return false;
+    if (fHi > 0 && v > fHi * fScale)
+      return false;
+    return true;
+  }
+
+private:
+  int32 MediaItem::*fField;
+  int32 fLo, fHi, fScale;
+};
+
+/** An empty text rule matches nothing, as in the original generator. */
+class MatchNone : public SmartPredicate {
+public:
+  bool Matches(const MediaItem &) const override { return false; }
+  int32 Cost() const override { return 0; }
+};
+
+std::unique_ptr<SmartPredicate> CompileRule(const Rule &r) {
+  switch (r.type) {
+  case kRuleGenre:
+    if (r.value.IsEmpty())
+      return std::make_unique<MatchNone>();
+    return std::make_unique<StringEquals>(&MediaItem::genre, r.value);
+  case kRuleArtist:
+  case kRuleAlbum:
+  case kRuleTitle: {
+    if (r.value.IsEmpty())
+      return std::make_unique<MatchNone>();
+    BString MediaItem::*field = r.type == kRuleArtist  ? &MediaItem::artist
+                                : r.type == kRuleAlbum ? &MediaItem::album
+                                                       : &MediaItem::title;
+    return std::make_unique<StringContains>(field, r.value);
+  }
+  case kRuleYear:
+    return std::make_unique<IntRange>(&MediaItem::year, atoi(r.value.String()),
+                                      atoi(r.value2.String()), 1);
+  case kRuleDuration:
+    return std::make_unique<IntRange>(&MediaItem::duration,
+                                      atoi(r.value.String()),
+                                      atoi(r.value2.String()), 60);
+  default:
+    return std::make_unique<MatchNone>();
+  }
+}
+
+struct EvalChunk {
+  const SmartPredicate *predicate;
+  const std::vector<MediaItem> *library;
+  size_t begin;
+  size_t end;
+  std::vector<size_t> matches;
+};
+
+status_t EvalChunkThread(void *data) {
+  EvalChunk *chunk = static_cast<EvalChunk *>(data);
+  const auto &library = *chunk->library;
+  for (size_t i = chunk->begin; i < chunk->end; i++) {
+    if (chunk->predicate->Matches(library[i]))
+      chunk->matches.push_back(i);
+  }
+  return B_OK;
+}
+
+} // namespace
+
+std::unique_ptr<SmartPredicate>
+SmartPredicate::Compile(const std::vector<Rule> &rules) {
+  if (rules.empty())
+    return std::make_unique<MatchAll>();
+
+  std::vector<std::unique_ptr<SmartPredicate>> nodes;
+  nodes.reserve(rules.size());
+  for (const auto &r : rules) {
+    auto node = CompileRule(r);
+    if (r.exclude)
+      node = std::make_unique<Not>(std::move(node));
+    nodes.push_back(std::move(node));
+  }
+
+  if (nodes.size() == 1)
+    return std::move(nodes.front());
+  return std::make_unique<AllOf>(std::move(nodes));
+}
+
+SmartPlaylistManager::SmartPlaylistManager() {}
+
+SmartPlaylistManager::~SmartPlaylistManager() {}
+
+std::vector<size_t>
+SmartPlaylistManager::Evaluate(const SmartPredicate &predicate,
+                               const std::vector<MediaItem> &library) {
+  system_info info;
+  size_t cpus = 1;
+  if (get_system_info(&info) == B_OK && info.cpu_count > 0)
+    cpus = info.cpu_count;
+
+  size_t threads = std::min(cpus, library.size() / kMinItemsPerThread);
+  if (threads < 2) {
+    EvalChunk chunk{&predicate, &library, 0, library.size(), {}};
+    EvalChunkThread(&chunk);
+    return std::move(chunk.matches);
+  }
+
+  std::vector<EvalChunk> chunks(threads);
+  std::vector<thread_id> ids(threads, -1);
+  size_t per = (library.size() + threads - 1) / threads;
+  for (size_t t = 0; t < threads; t++) {
+    chunks[t].predicate = &predicate;
+    chunks[t].library = &library;
+    chunks[t].begin = t * per;
+    chunks[t].end = std::min(library.size(), (t + 1) * per);
+
+    // The first chunk runs on the calling thread.
+    if (t == 0)
+      continue;
+    ids[t] = spawn_thread(EvalChunkThread, "SmartPlaylistEval",
+                          B_NORMAL_PRIORITY, &chunks[t]);
+    if (ids[t] >= 0)
+      resume_thread(ids[t]);
+    else
+      EvalChunkThread(&chunks[t]);
+  }
+
+  EvalChunkThread(&chunks[0]);
+
+  std::vector<size_t> result;
+  for (size_t t = 0; t < threads; t++) {
+    if (ids[t] >= 0) {
+      status_t exitValue;
+      wait_for_thread(ids[t], &exitValue);
+    }
+    result.insert(result.end(), chunks[t].matches.begin(),
+                  chunks[t].matches.end());
+  }
+  return result;
+}
+
+void SmartPlaylistManager::LoadDefinitions() {
+  fEntries.clear();
+
+  BDirectory dir(DefinitionDirectory().Path());
+  if (dir.InitCheck() != B_OK)
+    return;
+
+  BEntry entry;
+  while (dir.GetNextEntry(&entry) == B_OK) {
+    BFile file(&entry, B_READ_ONLY);
+    BMessage archive;
+    if (file.InitCheck() != B_OK || archive.Unflatten(&file) != B_OK)
+      continue;
+
+    Entry e;
+    e.def = SmartPlaylistDefinition::FromMessage(archive);
+    if (e.def.name.IsEmpty())
+      continue;
+
+    e.predicate = SmartPredicate::Compile(e.def.rules);
+    e.paths = LoadPlaylist(e.def.name);
+    e.members.insert(e.paths.begin(), e.paths.end());
+
+    BString name = e.def.name;
+    fEntries[name] = std::move(e);
+  }
+
+  _PruneDeleted();
+  DEBUG_PRINT("[SmartPlaylist] %zu Smart-Playlists geladen\n",
+              fEntries.size());
+}
+
+size_t SmartPlaylistManager::Create(const SmartPlaylistDefinition &def,
+                                    const std::vector<MediaItem> &library) {
+  Entry e;
+  e.def = def;
+  e.predicate = SmartPredicate::Compile(def.rules);
+
+  std::vector<size_t> matches = Evaluate(*e.predicate, library);
+
+  if (def.shuffle) {
+    std::random_device rd;
+    std::mt19937 g(rd());
+    std::shuffle(matches.begin(), matches.end(), g);
+  }
+
+  if (def.limitMode == 1) {
+    if (def.limitValue >= 0 && matches.size() > (size_t)def.limitValue)
+      matches.resize(def.limitValue);
+  } else if (def.limitMode == 2) {
+    int64 maxSeconds = (int64)def.limitValue * 60;
+    int64 currentSeconds = 0;
+    for (size_t k = 0; k < matches.size(); ++k) {
+      currentSeconds += library[matches[k]].duration;
+      if (currentSeconds > maxSeconds) {
+        matches.resize(k);
+        break;
+      }
+    }
+  }
+
+  e.paths.reserve(matches.size());
+  for (size_t idx : matches)
+    e.paths.push_back(library[idx].path);
+  e.members.insert(e.paths.begin(), e.paths.end());
+
+  SavePlaylist(def.name, e.paths);
+  _SaveDefinition(def);
+
+  size_t count = e.paths.size();
+  fEntries[def.name] = std::move(e);
+
+  DEBUG_PRINT("[SmartPlaylist] '%s' erzeugt: %zu Titel\n", def.name.String(),
+              count);
+  return count;
+}
+
+void SmartPlaylistManager::ItemsChanged(
+    const std::vector<const MediaItem *> &changed,
+    std::vector<BString> &outChanged) {
+  if (changed.empty() || fEntries.empty())
+    return;
+
+  _PruneDeleted();
+
+  for (auto &[name, e] : fEntries) {
+    if (!e.def.IsLive())
+      continue;
+
+    // The playlist may have been edited since it was loaded or written:
+    // rows reordered, removed or added. Apply the changes to what the file
+    // holds now, but only read it if a changed track could matter.
+    bool relevant = false;
+    for (const MediaItem *item : changed) {
+      if (e.members.count(item->path) > 0 || e.predicate->Matches(*item)) {
+        relevant = true;
+        break;
+      }
+    }
+    if (!relevant)
+      continue;
+
+    e.paths = LoadPlaylist(name);
+    e.members.clear();
+    e.members.insert(e.paths.begin(), e.paths.end());
+
+    BStringSet removed;
+    bool dirty = false;
+    for (const MediaItem *item : changed) {
+      bool match = e.predicate->Matches(*item);
+      bool member = e.members.count(item->path) > 0;
+      if (match && !member) {
+        e.members.insert(item->path);
+        e.paths.push_back(item->path);
+        dirty = true;
+      } else if (!match && member) {
+        e.members.erase(item->path);
+        removed.insert(item->path);
+        dirty = true;
+      }
+    }
+
+    if (!dirty)
+      continue;
+
+    if (!removed.empty()) {
+      e.paths.erase(std::remove_if(e.paths.begin(), e.paths.end(),
+                                   [&](const BString &p) {
+                                     return removed.count(p) > 0;
+                                   }),
+                    e.paths.end());
+    }
+
+    SavePlaylist(name, e.paths);
+    outChanged.push_back(name);
+    DEBUG_PRINT("[SmartPlaylist] '%s' aktualisiert: %zu Titel\n",
+                name.String(), e.paths.size());
+  }
+}
+
+void SmartPlaylistManager::Rename(const BString &oldName,
+                                  const BString &newName) {
+  auto it = fEntries.find(oldName);
+  if (it == fEntries.end())
+    return;
+
+  Entry e = std::move(it->second);
+  fEntries.erase(it);
+  _RemoveDefinition(oldName);
+
+  e.def.name = newName;
+  _SaveDefinition(e.def);
+  fEntries[newName] = std::move(e);
+}
+
+void SmartPlaylistManager::PathsMoved(const BStringMap<BString> &moves) {
+  for (auto &[name, e] : fEntries) {
+    for (auto &path : e.paths) {
+      auto it = moves.find(path);
+      if (it == moves.end())
+        continue;
+      e.members.erase(path);
+      path = it->second;
+      e.members.insert(path);
+    }
+  }
+}
+
+bool SmartPlaylistManager::IsSmart(const BString &name) const {
+  return fEntries.find(name) != fEntries.end();
+}
+
+void SmartPlaylistManager::AccountMemory(MemoryReport &report) const {
+  size_t tracks = 0;
+  size_t bytes = 0;
+  for (const auto &[name, entry] : fEntries) {
+    tracks += entry.paths.size();
+    bytes += MemoryReport::kMapNode + MemoryReport::kAllocation +
+             sizeof(BString) + sizeof(Entry) + report.String(name) +
+             report.Strings(entry.paths) + report.Strings(entry.members);
+  }
+  if (!fEntries.empty())
+    report.Add(MEMORY_PLAYLISTS, "Smart playlist members", tracks, bytes);
+}
+
+void SmartPlaylistManager::_SaveDefinition(
+    const SmartPlaylistDefinition &def) const {
+  create_directory(DefinitionDirectory().Path(), 0777);
+
+  BPath path = DefinitionPath(def.name);
+  BFile file(path.Path(), B_WRITE_ONLY | B_CREATE_FILE | B_ERASE_FILE);
+  if (file.InitCheck() != B_OK) {
+    DEBUG_PRINT("[SmartPlaylist] Kann %s nicht schreiben\n", path.Path());
+    return;
+  }
+
+  BMessage archive;
+  def.Archive(archive);
+  archive.Flatten(&file);
+}
+
+void SmartPlaylistManager::_RemoveDefinition(const BString &name) const {
+  BEntry entry(DefinitionPath(name).Path());
+  entry.Remove();
+}
+
+/**
+ * @brief Drops definitions whose playlist file was deleted.
+ */
+void SmartPlaylistManager::_PruneDeleted() {
+  for (auto it = fEntries.begin(); it != fEntries.end();) {
+    BEntry entry(PlaylistPathFor(it->first).String());
+    if (!entry.Exists()) {
+      DEBUG_PRINT("[SmartPlaylist] '%s' wurde geloescht\n",
+                  it->first.String());
+      _RemoveDefinition(it->first);
+      it = fEntries.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
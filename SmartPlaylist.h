@@ -0,0 +1,183 @@
+#ifndef SMART_PLAYLIST_H
+#define SMART_PLAYLIST_H
+
+#include "HashUtils.h"
+#include "MediaItem.h"
+
+#include <Message.h>
+#include <String.h>
+#include <SupportDefs.h>
+
+#include <map>
+#include <memory>
+#include <vector>
+
+class MemoryReport;
+
+/**
+ * @enum RuleType
+ * @brief Criteria a smart playlist rule can test.
+ */
+enum RuleType : int32 {
+  kRuleGenre = 0,    ///< Genre equals value (case-insensitive).
+  kRuleArtist = 1,   ///< Artist contains value.
+  kRuleYear = 2,     ///< Year within [value, value2]; empty bound is open.
+  kRuleAlbum = 3,    ///< Album contains value.
+  kRuleTitle = 4,    ///< Title contains value.
+  kRuleDuration = 5, ///< Duration in minutes within [value, value2].
+  kRuleTypeCount
+};
+
+/**
+ * @struct Rule
+ * @brief Represents a single filtering rule for playlist generation.
+ */
+struct Rule {
+  int32 type;     ///< One of RuleType.
+  BString value;  ///< Primary search value (e.g. "Rock", "Metallica", "1990").
+  BString value2; ///< Secondary value (e.g. "2000" for year range).
+  bool exclude;   ///< If true, the rule is negated (NOT).
+
+  /**
+   * @brief Formats the rule as a human-readable string.
+   */
+  BString ToString() const;
+};
+
+/**
+ * @struct SmartPlaylistDefinition
+ * @brief The stored description of a smart playlist.
+ *
+ * All rules must match (AND). Live playlists are kept up to date as the
+ * library changes; shuffled or limited playlists are always generated once,
+ * since re-evaluating them would reorder or re-cut the whole list.
+ */
+struct SmartPlaylistDefinition {
+  BString name;
+  std::vector<Rule> rules;
+  bool shuffle = false;
+  int32 limitMode = 0;  ///< 0 = none, 1 = max. tracks, 2 = max. minutes.
+  int32 limitValue = 0; ///< Value for limitMode.
+  bool live = true;     ///< Re-evaluate when tracks change.
+
+  bool IsLive() const { return live && !shuffle && limitMode == 0; }
+
+  void Archive(BMessage &into) const;
+  static SmartPlaylistDefinition FromMessage(const BMessage &msg);
+};
+
+/**
+ * @class SmartPredicate
+ * @brief Node of a compiled rule tree.
+ *
+ * Rule definitions are parsed once into typed nodes, so evaluating a track
+ * involves no message lookups or string-to-number conversions.
+ */
+class SmartPredicate {
+public:
+  virtual ~SmartPredicate() = default;
+  virtual bool Matches(const MediaItem &item) const = 0;
+
+  /** Relative evaluation cost, used to test cheap nodes first. */
+  virtual int32 Cost() const { return 1; }
+
+  /**
+   * @brief Compiles rule definitions into a predicate tree.
+   * @return The root node; an empty rule list matches everything.
+   */
+  static std::unique_ptr<SmartPredicate>
+  Compile(const std::vector<Rule> &rules);
+};
+
+/**
+ * @class SmartPlaylistManager
+ * @brief Stores, evaluates and live-updates smart playlists.
+ *
+ * Definitions are kept as flattened BMessages in
+ * `settings/BeTon/SmartPlaylists`. The generated track list is written to a
+ * regular playlist file so that playback and the sidebar need no special
+ * handling. Must be used from the main window's thread.
+ */
+class SmartPlaylistManager {
+public:
+  SmartPlaylistManager();
+  ~SmartPlaylistManager();
+
+  /**
+   * @brief Loads all stored definitions and their current membership.
+   */
+  void LoadDefinitions();
+
+  /**
+   * @brief Stores a definition, evaluates it and writes the playlist.
+   * @param def The definition (replaces one with the same name).
+   * @param library All library items.
+   * @return Number of matching tracks written.
+   */
+  size_t Create(const SmartPlaylistDefinition &def,
+                const std::vector<MediaItem> &library);
+
+  /**
+   * @brief Re-tests changed tracks against all live smart playlists.
+   *
+   * Only the changed tracks are evaluated. A playlist that one of them may
+   * join or leave is re-read first, so edits made to it since are kept,
+   * and rewritten if its membership changes. Pending playlist writes must
+   * have been flushed.
+   *
+   * @param changed Tracks that were added or whose tags changed.
+   * @param outChanged Receives the names of rewritten playlists.
+   */
+  void ItemsChanged(const std::vector<const MediaItem *> &changed,
+                    std::vector<BString> &outChanged);
+
+  /**
+   * @brief Follows tracks that were moved or renamed on disk.
+   *
+   * Only the in-memory membership is updated; the playlist files themselves
+   * are rewritten together with regular playlists by RewritePlaylistPaths().
+   *
+   * @param moves Map from old to new absolute path.
+   */
+  void PathsMoved(const BStringMap<BString> &moves);
+
+  /**
+   * @brief Follows a renamed playlist.
+   */
+  void Rename(const BString &oldName, const BString &newName);
+
+  /**
+   * @brief Returns true if the named playlist is a smart playlist.
+   */
+  bool IsSmart(const BString &name) const;
+
+  /**
+   * @brief Adds the membership of all smart playlists to @p report.
+   */
+  void AccountMemory(MemoryReport &report) const;
+
+  /**
+   * @brief Evaluates a predicate over the library using all CPUs.
+   * @return Indices of matching items, in library order.
+   */
+  static std::vector<size_t> Evaluate(const SmartPredicate &predicate,
+                                      const std::vector<MediaItem> &library);
+
+private:
+  struct Entry {
+    SmartPlaylistDefinition def;
+    std::unique_ptr<SmartPredicate> predicate;
+    /** Content in playlist order as last read or written; the file may
+     * have been edited since. */
+    std::vector<BString> paths;
+    BStringSet members; ///< Same content, for lookups.
+  };
+
+  void _SaveDefinition(const SmartPlaylistDefinition &def) const;
+  void _RemoveDefinition(const BString &name) const;
+  void _PruneDeleted();
+
+  std::map<BString, Entry> fEntries;
+};
+
+#endif // SMART_PLAYLIST_H
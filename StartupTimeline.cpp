@@ -0,0 +1,64 @@
+#include "StartupTimeline.h"
+
+#include <cstring>
+#include <mutex>
+
+namespace {
+
+struct Milestone {
+  const char *phase;
+  bigtime_t time;
+};
+
+const int32 kMaxMilestones = 16;
+
+/** Initialized before main() runs. */
+const bigtime_t sProcessStart = system_time();
+
+std::mutex sLock;
+Milestone sMilestones[kMaxMilestones];
+int32 sCount = 0;
+
+/** Caller holds sLock. */
+const Milestone *FindMilestone(const char *phase) {
+  for (int32 i = 0; i < sCount; i++) {
+    if (strcmp(sMilestones[i].phase, phase) == 0)
+      return &sMilestones[i];
+  }
+  return nullptr;
+}
+
+} // namespace
+
+bool StartupTimeline::Mark(const char *phase) {
+  const bigtime_t now = system_time();
+  std::lock_guard<std::mutex> lock(sLock);
+  if (sCount == kMaxMilestones || FindMilestone(phase))
+    return false;
+
+  sMilestones[sCount++] = {phase, now};
+  return true;
+}
+
+bigtime_t StartupTimeline::Elapsed(const char *phase) {
+  std::lock_guard<std::mutex> lock(sLock);
+  const Milestone *milestone = FindMilestone(phase);
+  return milestone ? milestone->time - sProcessStart : -1;
+}
+
+BString StartupTimeline::Report() {
+  std::lock_guard<std::mutex> lock(sLock);
+
+  BString out("Startup timeline (ms since process start)\n");
+  BString line;
+  bigtime_t previous = sProcessStart;
+  for (int32 i = 0; i < sCount; i++) {
+    const Milestone &milestone = sMilestones[i];
+    line.SetToFormat("  %-28s %8.1f  (+%.1f)\n", milestone.phase,
+                     (milestone.time - sProcessStart) / 1000.0,
+                     (milestone.time - previous) / 1000.0);
+    out << line;
+    previous = milestone.time;
+  }
+  return out;
+}
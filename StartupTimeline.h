@@ -0,0 +1,47 @@
+#ifndef STARTUP_TIMELINE_H
+#define STARTUP_TIMELINE_H
+
+#include <OS.h>
+#include <String.h>
+#include <SupportDefs.h>
+
+/** @name Startup phases, in the order they are normally reached */
+///@{
+#define STARTUP_MAIN "main() entered"
+#define STARTUP_WINDOW_BUILT "Window constructed"
+#define STARTUP_FIRST_FRAME "First frame drawn"
+#define STARTUP_CACHE_LOADED "Cache loaded"
+#define STARTUP_FIRST_ROWS "First rows visible"
+///@}
+
+/** Time the first frame should be drawn within, measured from process start. */
+static const bigtime_t kStartupFrameBudget = 200000;
+
+/**
+ * @namespace StartupTimeline
+ * @brief Milestones of the application start, relative to process start.
+ *
+ * The process start is taken during static initialization, before main().
+ * Each phase is recorded the first time it is reached; later marks of the
+ * same phase are ignored, so callers need not track whether they already
+ * marked it. Phase names must be string literals.
+ */
+namespace StartupTimeline {
+
+/**
+ * @brief Records that @p phase has been reached.
+ * @return True if this was the first mark of the phase.
+ */
+bool Mark(const char *phase);
+
+/**
+ * @brief Microseconds from process start to @p phase, or -1 if not reached.
+ */
+bigtime_t Elapsed(const char *phase);
+
+/** @brief Table of the reached phases with their offsets and deltas. */
+BString Report();
+
+} // namespace StartupTimeline
+
+#endif // STARTUP_TIMELINE_H
@@ -0,0 +1,154 @@
+#include "TextSearch.h"
+#include "MemoryReport.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+inline char Fold(char c) { return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c; }
+
+/**
+ * @brief Position of the first occurrence of @p needle in @p text at or
+ * after @p from.
+ * @return The position, or @p size if there is none.
+ */
+typedef size_t (*FindFunction)(const char *text, size_t from, size_t size,
+                               const char *needle, size_t length);
+
+size_t FindScalar(const char *text, size_t from, size_t size,
+                  const char *needle, size_t length) {
+  const char first = needle[0];
+  const char last = needle[length - 1];
+  for (size_t i = from; i + length <= size; i++) {
+    if (text[i] == first && text[i + length - 1] == last &&
+        memcmp(text + i + 1, needle + 1, length - 1) == 0)
+      return i;
+  }
+  return size;
+}
+
+#if defined(__SSE2__)
+size_t FindSSE2(const char *text, size_t from, size_t size,
+                const char *needle, size_t length) {
+  const __m128i first = _mm_set1_epi8(needle[0]);
+  const __m128i last = _mm_set1_epi8(needle[length - 1]);
+
+  size_t i = from;
+  for (; i + length - 1 + 16 <= size; i += 16) {
+    const __m128i a = _mm_loadu_si128((const __m128i *)(text + i));
+    const __m128i b =
+        _mm_loadu_si128((const __m128i *)(text + i + length - 1));
+    uint32 mask = (uint32)_mm_movemask_epi8(
+        _mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+    for (; mask != 0; mask &= mask - 1) {
+      const size_t at = i + (size_t)__builtin_ctz(mask);
+      if (memcmp(text + at + 1, needle + 1, length - 1) == 0)
+        return at;
+    }
+  }
+  return FindScalar(text, i, size, needle, length);
+}
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2"))) size_t FindAVX2(const char *text,
+                                                size_t from, size_t size,
+                                                const char *needle,
+                                                size_t length) {
+  const __m256i first = _mm256_set1_epi8(needle[0]);
+  const __m256i last = _mm256_set1_epi8(needle[length - 1]);
+
+  size_t i = from;
+  for (; i + length - 1 + 32 <= size; i += 32) {
+    const __m256i a = _mm256_loadu_si256((const __m256i *)(text + i));
+    const __m256i b =
+        _mm256_loadu_si256((const __m256i *)(text + i + length - 1));
+    uint32 mask = (uint32)_mm256_movemask_epi8(_mm256_and_si256(
+        _mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last)));
+    for (; mask != 0; mask &= mask - 1) {
+      const size_t at = i + (size_t)__builtin_ctz(mask);
+      if (memcmp(text + at + 1, needle + 1, length - 1) == 0)
+        return at;
+    }
+  }
+  return FindScalar(text, i, size, needle, length);
+}
+#endif
+
+FindFunction ChooseFind() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return FindAVX2;
+#endif
+#if defined(__SSE2__)
+  return FindSSE2;
+#else
+  return FindScalar;
+#endif
+}
+
+} // namespace
+
+void TextSearch::Add(std::initializer_list<const BString *> texts) {
+  fStarts.push_back((uint32)fText.size());
+  for (const BString *text : texts) {
+    const char *s = text->String();
+    const size_t length = (size_t)text->Length();
+    const size_t at = fText.size();
+    fText.resize(at + length + 1);
+    char *out = fText.data() + at;
+    for (size_t i = 0; i < length; i++)
+      out[i] = Fold(s[i]);
+    out[length] = '\0';
+  }
+}
+
+void TextSearch::Clear() {
+  fText.clear();
+  fStarts.clear();
+}
+
+void TextSearch::Find(const BString &text,
+                      std::vector<uint32> &entries) const {
+  static const FindFunction find = ChooseFind();
+
+  entries.clear();
+  const size_t length = (size_t)text.Length();
+  if (length == 0) {
+    entries.resize(Count());
+    std::iota(entries.begin(), entries.end(), 0);
+    return;
+  }
+
+  std::vector<char> needle(text.String(), text.String() + length);
+  std::transform(needle.begin(), needle.end(), needle.begin(), Fold);
+
+  const size_t size = fText.size();
+  size_t from = 0;
+  auto entry = fStarts.begin();
+  for (;;) {
+    const size_t at = find(fText.data(), from, size, needle.data(), length);
+    if (at >= size)
+      break;
+
+    // The entry starting last at or before the match; one match per entry
+    // is enough, so go on with the next.
+    entry = std::upper_bound(entry, fStarts.end(), (uint32)at) - 1;
+    entries.push_back((uint32)(entry - fStarts.begin()));
+    if (++entry == fStarts.end())
+      break;
+    from = *entry;
+  }
+}
+
+void TextSearch::AccountMemory(MemoryReport &report) const {
+  report.Add(MEMORY_LIBRARY, "Search text", Count(),
+             fText.capacity() + fStarts.capacity() * sizeof(uint32));
+}
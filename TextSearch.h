@@ -0,0 +1,50 @@
+#ifndef TEXT_SEARCH_H
+#define TEXT_SEARCH_H
+
+#include <String.h>
+#include <SupportDefs.h>
+
+#include <initializer_list>
+#include <vector>
+
+class MemoryReport;
+
+/**
+ * @class TextSearch
+ * @brief Case-insensitive substring search over the texts of many entries.
+ *
+ * The texts are stored folded to lower case, back to back in one buffer
+ * and separated by NUL bytes, so a search is a single pass over memory
+ * that never matches across two texts. The pass compares the first and the
+ * last byte of the searched text at 16 or 32 positions at once (SSE2 or
+ * AVX2, whichever the CPU has; bytewise elsewhere) and only compares the
+ * rest where both agree.
+ *
+ * Folding covers ASCII letters, like BString::IFindFirst().
+ */
+class TextSearch {
+public:
+  /**
+   * @brief Appends an entry made of the given texts; entries are numbered
+   * from 0 in the order they are added.
+   */
+  void Add(std::initializer_list<const BString *> texts);
+
+  void Clear();
+
+  size_t Count() const { return fStarts.size(); }
+
+  /**
+   * @brief Finds the entries with @p text in one of their texts.
+   * @param[out] entries Their numbers, ascending.
+   */
+  void Find(const BString &text, std::vector<uint32> &entries) const;
+
+  void AccountMemory(MemoryReport &report) const;
+
+private:
+  std::vector<char> fText;     ///< Folded texts, each followed by a NUL.
+  std::vector<uint32> fStarts; ///< Offset of each entry's first text.
+};
+
+#endif // TEXT_SEARCH_H
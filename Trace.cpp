@@ -0,0 +1,206 @@
+#include "Trace.h"
+#include "Debug.h"
+
+#include <Autolock.h>
+#include <FindDirectory.h>
+#include <Locker.h>
+#include <Path.h>
+#include <String.h>
+
+#include <map>
+#include <new>
+#include <unistd.h>
+#include <vector>
+
+std::atomic<bool> gIsTracing(false);
+
+/** Events kept per thread; a power of two. */
+static const uint32 kBufferCapacity = 8192;
+
+/**
+ * @struct TraceEvent
+ * @brief One recorded event.
+ */
+struct TraceEvent {
+  const char *category;
+  const char *name;
+  bigtime_t start;
+  bigtime_t duration; ///< For spans ('X').
+  int64 value;        ///< For counters ('C').
+  thread_id thread;
+  char phase; ///< 'X' span, 'C' counter or 'i' instant.
+};
+
+/**
+ * @struct ThreadBuffer
+ * @brief Ring buffer written by exactly one thread at a time.
+ */
+struct ThreadBuffer {
+  TraceEvent events[kBufferCapacity];
+  std::atomic<uint64> written{0}; ///< Total events ever recorded.
+  std::atomic<bool> inUse{false};
+};
+
+/**
+ * @brief Releases the buffer of an ending thread for reuse.
+ */
+struct BufferHandle {
+  ThreadBuffer *buffer = nullptr;
+  ~BufferHandle() {
+    if (buffer)
+      buffer->inUse.store(false, std::memory_order_release);
+  }
+};
+
+static BLocker sLock("trace buffers");
+static std::vector<ThreadBuffer *> sBuffers;
+static std::map<thread_id, BString> sThreadNames;
+static thread_local BufferHandle tBuffer;
+
+/**
+ * @brief Returns the calling thread's buffer, registering one on first use.
+ */
+static ThreadBuffer *CurrentBuffer() {
+  if (tBuffer.buffer)
+    return tBuffer.buffer;
+
+  BAutolock lock(sLock);
+  ThreadBuffer *buffer = nullptr;
+  for (auto *b : sBuffers) {
+    if (!b->inUse.load(std::memory_order_acquire)) {
+      buffer = b;
+      break;
+    }
+  }
+  if (!buffer) {
+    buffer = new (std::nothrow) ThreadBuffer;
+    if (!buffer)
+      return nullptr;
+    sBuffers.push_back(buffer);
+  }
+  buffer->inUse.store(true, std::memory_order_relaxed);
+
+  thread_info info;
+  if (get_thread_info(find_thread(NULL), &info) == B_OK)
+    sThreadNames[info.thread] = info.name;
+
+  tBuffer.buffer = buffer;
+  return buffer;
+}
+
+static void Record(const TraceEvent &event) {
+  ThreadBuffer *buffer = CurrentBuffer();
+  if (!buffer)
+    return;
+
+  const uint64 n = buffer->written.load(std::memory_order_relaxed);
+  buffer->events[n & (kBufferCapacity - 1)] = event;
+  buffer->written.store(n + 1, std::memory_order_release);
+}
+
+void Trace::Complete(const char *category, const char *name, bigtime_t start,
+                     bigtime_t end) {
+  Record({category, name, start, end - start, 0, find_thread(NULL), 'X'});
+}
+
+void Trace::Counter(const char *category, const char *name, int64 value) {
+  Record({category, name, system_time(), 0, value, find_thread(NULL), 'C'});
+}
+
+void Trace::Instant(const char *category, const char *name) {
+  Record({category, name, system_time(), 0, 0, find_thread(NULL), 'i'});
+}
+
+void Trace::Clear() {
+  BAutolock lock(sLock);
+  for (auto *b : sBuffers)
+    b->written.store(0, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Writes @p s as a JSON string literal.
+ */
+static void WriteJsonString(FILE *out, const char *s) {
+  fputc('"', out);
+  for (; s && *s; s++) {
+    const unsigned char c = (unsigned char)*s;
+    if (c == '"' || c == '\\')
+      fprintf(out, "\\%c", c);
+    else if (c < 0x20)
+      fprintf(out, "\\u%04x", c);
+    else
+      fputc(c, out);
+  }
+  fputc('"', out);
+}
+
+status_t Trace::Export(const char *path) {
+  FILE *out = fopen(path, "w");
+  if (!out)
+    return B_ERROR;
+
+  const pid_t pid = getpid();
+  size_t exported = 0;
+  bool first = true;
+  auto separator = [&]() {
+    fputs(first ? "\n" : ",\n", out);
+    first = false;
+  };
+
+  fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", out);
+
+  BAutolock lock(sLock);
+  for (const auto &[thread, name] : sThreadNames) {
+    separator();
+    fprintf(out,
+            "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+            "\"args\":{\"name\":",
+            (int)pid, (int)thread);
+    WriteJsonString(out, name.String());
+    fputs("}}", out);
+  }
+
+  for (const auto *buffer : sBuffers) {
+    const uint64 written = buffer->written.load(std::memory_order_acquire);
+    const uint64 begin =
+        written > kBufferCapacity ? written - kBufferCapacity : 0;
+
+    for (uint64 i = begin; i < written; i++) {
+      const TraceEvent &e = buffer->events[i & (kBufferCapacity - 1)];
+      separator();
+      fputs("{\"name\":", out);
+      WriteJsonString(out, e.name);
+      fputs(",\"cat\":", out);
+      WriteJsonString(out, e.category);
+      fprintf(out, ",\"ph\":\"%c\",\"ts\":%lld,\"pid\":%d,\"tid\":%d", e.phase,
+              (long long)e.start, (int)pid, (int)e.thread);
+      if (e.phase == 'X')
+        fprintf(out, ",\"dur\":%lld", (long long)e.duration);
+      else if (e.phase == 'C')
+        fprintf(out, ",\"args\":{\"value\":%lld}", (long long)e.value);
+      else
+        fputs(",\"s\":\"t\"", out);
+      fputc('}', out);
+      exported++;
+    }
+  }
+
+  fputs("\n]}\n", out);
+  const bool ok = (fclose(out) == 0);
+
+  DEBUG_PRINT("[Trace] %zu Ereignisse nach %s geschrieben\n", exported, path);
+  return ok ? B_OK : B_ERROR;
+}
+
+const char *Trace::DefaultPath() {
+  static BString sPath;
+  if (sPath.IsEmpty()) {
+    BPath path;
+    if (find_directory(B_DESKTOP_DIRECTORY, &path) == B_OK &&
+        path.Append("BeTon-trace.json") == B_OK)
+      sPath = path.Path();
+    else
+      sPath = "/tmp/BeTon-trace.json";
+  }
+  return sPath.String();
+}
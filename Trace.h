@@ -0,0 +1,120 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <OS.h>
+#include <SupportDefs.h>
+
+#include <atomic>
+
+/**
+ * @brief Global tracing flag.
+ * Set by --trace or Help > Record Trace. While false, a trace point costs a
+ * single relaxed load.
+ */
+extern std::atomic<bool> gIsTracing;
+
+/**
+ * @namespace Trace
+ * @brief Low-overhead event recorder with Chrome trace export.
+ *
+ * Every thread records into its own fixed-size ring buffer, so recording
+ * takes no lock; only the first event of a thread registers its buffer.
+ * When a buffer is full the oldest events are overwritten. Buffers of ended
+ * threads are reused by new ones.
+ *
+ * Category and name arguments must be string literals or otherwise outlive
+ * the export, as only the pointers are stored.
+ *
+ * The export is the JSON trace event format understood by chrome://tracing
+ * and Perfetto.
+ */
+namespace Trace {
+
+inline bool Enabled() { return gIsTracing.load(std::memory_order_relaxed); }
+
+/**
+ * @brief Records a finished span.
+ */
+void Complete(const char *category, const char *name, bigtime_t start,
+              bigtime_t end);
+
+/**
+ * @brief Records the current value of a counter.
+ */
+void Counter(const char *category, const char *name, int64 value);
+
+/**
+ * @brief Records a point in time on the calling thread.
+ */
+void Instant(const char *category, const char *name);
+
+/**
+ * @brief Discards all recorded events.
+ *
+ * Events recorded concurrently may survive.
+ */
+void Clear();
+
+/**
+ * @brief Writes all recorded events as Chrome trace JSON.
+ *
+ * May be called while other threads keep recording; events being
+ * overwritten during the export can be missing or torn.
+ *
+ * @param path Output file, replaced if it exists.
+ */
+status_t Export(const char *path);
+
+/**
+ * @brief Returns the file used when no trace file was given.
+ */
+const char *DefaultPath();
+
+/**
+ * @class Span
+ * @brief Records the lifetime of a scope as a span.
+ */
+class Span {
+public:
+  Span(const char *category, const char *name)
+      : fCategory(category), fName(name),
+        fStart(Enabled() ? system_time() : 0) {}
+
+  ~Span() {
+    if (fStart > 0 && Enabled())
+      Complete(fCategory, fName, fStart, system_time());
+  }
+
+  Span(const Span &) = delete;
+  Span &operator=(const Span &) = delete;
+
+private:
+  const char *fCategory;
+  const char *fName;
+  bigtime_t fStart;
+};
+
+} // namespace Trace
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+/**
+ * @brief Traces the enclosing scope.
+ * Usage: TRACE_SPAN("scanner", "ProcessFile");
+ */
+#define TRACE_SPAN(category, name)                                             \
+  Trace::Span TRACE_CONCAT(_traceSpan, __LINE__)(category, name)
+
+/**
+ * @brief Records a counter value if tracing is enabled.
+ * Usage: TRACE_COUNTER("cache", "entries", fEntries.size());
+ */
+#define TRACE_COUNTER(category, name, value)                                   \
+  do {                                                                         \
+    if (Trace::Enabled()) {                                                    \
+      Trace::Counter(category, name, (int64)(value));                          \
+    }                                                                          \
+  } while (0)
+
+#endif // TRACE_H
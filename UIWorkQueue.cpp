@@ -0,0 +1,96 @@
+#include "UIWorkQueue.h"
+#include "Trace.h"
+
+#include <AppDefs.h>
+#include <Looper.h>
+#include <MessageQueue.h>
+
+#include <algorithm>
+#include <cstring>
+
+UIWorkQueue::UIWorkQueue(bigtime_t budget)
+    : BHandler("UIWorkQueue"), fBudget(budget) {}
+
+void UIWorkQueue::Add(const char *key, Job job) {
+  Cancel(key);
+  fJobs.push_back({key, std::move(job)});
+  _Schedule();
+}
+
+void UIWorkQueue::Cancel(const char *key) {
+  fJobs.erase(std::remove_if(fJobs.begin(), fJobs.end(),
+                             [key](const Entry &entry) {
+                               return strcmp(entry.key, key) == 0;
+                             }),
+              fJobs.end());
+}
+
+bool UIWorkQueue::IsPending(const char *key) const {
+  return std::any_of(fJobs.begin(), fJobs.end(), [key](const Entry &entry) {
+    return strcmp(entry.key, key) == 0;
+  });
+}
+
+void UIWorkQueue::MessageReceived(BMessage *msg) {
+  if (msg->what == kMsgRun) {
+    fScheduled = false;
+    _Run();
+    return;
+  }
+  BHandler::MessageReceived(msg);
+}
+
+/**
+ * @brief Gives each pending job an equal share of what is left of the
+ * budget, round robin, until the budget is used up or input arrives.
+ */
+void UIWorkQueue::_Run() {
+  TRACE_SPAN("ui", "WorkQueue");
+  const bigtime_t end = system_time() + fBudget;
+
+  bigtime_t now;
+  while (!fJobs.empty() && (now = system_time()) < end) {
+    Entry entry = std::move(fJobs.front());
+    fJobs.pop_front();
+
+    const bigtime_t deadline =
+        std::min(end, now + (end - now) / (bigtime_t)(fJobs.size() + 1));
+    // A job may add jobs, including one with its own key, which replaces it.
+    const bool more = entry.job(deadline);
+    if (more && !IsPending(entry.key))
+      fJobs.push_back(std::move(entry));
+
+    if (_InputPending())
+      break;
+  }
+
+  if (!fJobs.empty())
+    _Schedule();
+}
+
+void UIWorkQueue::_Schedule() {
+  if (fScheduled || !Looper())
+    return;
+  fScheduled = Looper()->PostMessage(kMsgRun, this) == B_OK;
+}
+
+/**
+ * @brief Whether a key or mouse event is waiting in the looper's queue.
+ */
+bool UIWorkQueue::_InputPending() const {
+  BMessageQueue *queue = Looper() ? Looper()->MessageQueue() : nullptr;
+  if (!queue || !queue->Lock())
+    return false;
+
+  static const uint32 kInput[] = {B_KEY_DOWN, B_MOUSE_DOWN, B_MOUSE_UP,
+                                  B_MOUSE_WHEEL_CHANGED};
+  bool pending = false;
+  for (uint32 what : kInput) {
+    if (queue->FindMessage(what, 0)) {
+      pending = true;
+      break;
+    }
+  }
+  queue->Unlock();
+  return pending;
+}
@@ -0,0 +1,70 @@
+#ifndef UI_WORK_QUEUE_H
+#define UI_WORK_QUEUE_H
+
+#include <Handler.h>
+#include <OS.h>
+#include <String.h>
+
+#include <deque>
+#include <functional>
+
+/**
+ * @class UIWorkQueue
+ * @brief Runs long UI jobs in slices between the window's other messages.
+ *
+ * A job is a function that does some work and returns true while more is
+ * left. It gets a deadline and should return soon after it has passed,
+ * keeping its position for the next call. Jobs are run from a message to
+ * this handler: each run gives every pending job a share of the frame
+ * budget, then re-posts itself, so input and drawing messages that arrived
+ * meanwhile are handled first. A run also ends early when input is waiting.
+ *
+ * Jobs have a key; adding a job replaces a pending one with the same key,
+ * so restarting a job (e.g. refilling the track list) drops the old one.
+ *
+ * Must be added to a looper before jobs are added, and only be used from
+ * that looper's thread.
+ */
+class UIWorkQueue : public BHandler {
+public:
+  /**
+   * @param budget Time per run for all jobs together, in microseconds.
+   */
+  explicit UIWorkQueue(bigtime_t budget = kDefaultBudget);
+
+  typedef std::function<bool(bigtime_t deadline)> Job;
+
+  /**
+   * @brief Queues @p job, replacing a pending job with the same key.
+   * @param key String literal naming the job.
+   */
+  void Add(const char *key, Job job);
+
+  /** @brief Drops the pending job with this key, if any. */
+  void Cancel(const char *key);
+
+  bool IsPending(const char *key) const;
+
+  void MessageReceived(BMessage *msg) override;
+
+  /** About half a frame at 60 Hz, leaving time for drawing. */
+  static const bigtime_t kDefaultBudget = 8000;
+
+private:
+  struct Entry {
+    const char *key;
+    Job job;
+  };
+
+  void _Run();
+  void _Schedule();
+  bool _InputPending() const;
+
+  std::deque<Entry> fJobs;
+  bigtime_t fBudget;
+  bool fScheduled = false;
+
+  static constexpr uint32 kMsgRun = 'uiwq';
+};
+
+#endif // UI_WORK_QUEUE_H
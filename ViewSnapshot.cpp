@@ -0,0 +1,53 @@
+#include "ViewSnapshot.h"
+#include "CacheManager.h"
+
+#include <File.h>
+#include <Message.h>
+
+status_t ViewSnapshot::Save(const char *path) const {
+  BMessage archive;
+  archive.AddString("playlist", playlist);
+  for (const BString &selected : selectedPaths)
+    archive.AddString("selected", selected);
+  archive.AddFloat("scroll", scrollOffset);
+  for (const MediaItem &row : rows) {
+    BMessage item;
+    CacheManager::ArchiveEntry(row, item);
+    archive.AddMessage("row", &item);
+  }
+
+  BFile file(path, B_WRITE_ONLY | B_CREATE_FILE | B_ERASE_FILE);
+  status_t status = file.InitCheck();
+  if (status != B_OK)
+    return status;
+  return archive.Flatten(&file);
+}
+
+status_t ViewSnapshot::Load(const char *path) {
+  BFile file(path, B_READ_ONLY);
+  status_t status = file.InitCheck();
+  if (status != B_OK)
+    return status;
+
+  BMessage archive;
+  status = archive.Unflatten(&file);
+  if (status != B_OK)
+    return status;
+
+  playlist = archive.GetString("playlist", "");
+  selectedPaths.clear();
+  BString selected;
+  for (int32 i = 0; archive.FindString("selected", i, &selected) == B_OK; i++)
+    selectedPaths.push_back(selected);
+  scrollOffset = archive.GetFloat("scroll", 0.0f);
+
+  rows.clear();
+  BMessage item;
+  for (int32 i = 0;
+       i < kMaxRows && archive.FindMessage("row", i, &item) == B_OK; i++) {
+    MediaItem row;
+    CacheManager::UnarchiveEntry(item, row);
+    rows.push_back(row);
+  }
+  return B_OK;
+}
@@ -0,0 +1,37 @@
+#ifndef VIEW_SNAPSHOT_H
+#define VIEW_SNAPSHOT_H
+
+#include "MediaItem.h"
+
+#include <String.h>
+#include <SupportDefs.h>
+
+#include <vector>
+
+/**
+ * @struct ViewSnapshot
+ * @brief What the track list showed when the application was last closed.
+ *
+ * Holds the shown playlist, the selection, the scroll position and copies of
+ * the rows that were on screen. At startup these rows are shown before the
+ * cache is loaded, so the first frame looks like the last one; the full
+ * list replaces them once the library is in.
+ */
+struct ViewSnapshot {
+  /** At most this many rows are stored. */
+  static const int32 kMaxRows = 200;
+
+  BString playlist; ///< Shown playlist, empty for the library.
+  /** Selected tracks in view order; a path selected twice is listed
+   * twice. */
+  std::vector<BString> selectedPaths;
+  float scrollOffset = 0.0f;
+  std::vector<MediaItem> rows; ///< Visible rows, in view order.
+
+  bool IsEmpty() const { return rows.empty() && playlist.IsEmpty(); }
+
+  status_t Save(const char *path) const;
+  status_t Load(const char *path);
+};
+
+#endif // VIEW_SNAPSHOT_H
@@ -0,0 +1,154 @@
+#include "Benchmark.h"
+#include "BenchmarkSuites.h"
+#include "Debug.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <string>
+#include <unistd.h>
+
+static void PrintUsage() {
+  fprintf(stderr,
+          "Usage: beton-bench [options]\n"
+          "  --sizes=N,N,...        library sizes (10000,100000,1000000)\n"
+          "  --filter=TEXT          only run benchmarks whose name contains "
+          "TEXT\n"
+          "  --json=FILE            write the results as JSON ('-' for "
+          "stdout)\n"
+          "  --baseline=FILE        compare with stored results, exit 1 on a "
+          "regression or a missing result\n"
+          "  --tolerance=F          allowed slowdown of the median (0.15)\n"
+          "  --tolerance=PREFIX=F   allowed slowdown for names starting with "
+          "PREFIX\n"
+          "  --min-delta=US         ignore slowdowns below US microseconds "
+          "(20)\n"
+          "  --iterations=MIN,MAX   timed runs per benchmark and size (3,15)\n"
+          "  --scan-dir=DIR         folder with audio files for the scan "
+          "benchmarks\n"
+          "  --tag-file=FILE        audio file for the tag benchmarks\n"
+          "  --debug                print the core library's debug output\n");
+}
+
+/** Removes the scratch directory and the files the benchmarks left in it. */
+static void RemoveTempDir(const char *path) {
+  DIR *dir = opendir(path);
+  if (dir) {
+    while (struct dirent *entry = readdir(dir)) {
+      if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+        continue;
+      BString file(path);
+      file << "/" << entry->d_name;
+      unlink(file.String());
+    }
+    closedir(dir);
+  }
+  rmdir(path);
+}
+
+int main(int argc, char **argv) {
+  Bench::Options options;
+  Bench::Comparison comparison;
+  BenchConfig config;
+  const char *jsonPath = nullptr;
+  const char *baselinePath = nullptr;
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    if (strncmp(arg, "--sizes=", 8) == 0) {
+      options.sizes.clear();
+      std::string list(arg + 8);
+      char *save = nullptr;
+      for (char *s = strtok_r(&list[0], ",", &save); s;
+           s = strtok_r(nullptr, ",", &save)) {
+        options.sizes.push_back(strtoul(s, nullptr, 10));
+      }
+    } else if (strncmp(arg, "--filter=", 9) == 0) {
+      options.filter = arg + 9;
+    } else if (strncmp(arg, "--json=", 7) == 0) {
+      jsonPath = arg + 7;
+    } else if (strncmp(arg, "--baseline=", 11) == 0) {
+      baselinePath = arg + 11;
+    } else if (strncmp(arg, "--tolerance=", 12) == 0) {
+      const char *value = arg + 12;
+      const char *split = strrchr(value, '=');
+      if (split)
+        comparison.tolerances[BString(value, split - value)] = atof(split + 1);
+      else
+        comparison.defaultTolerance = atof(value);
+    } else if (strncmp(arg, "--min-delta=", 12) == 0) {
+      comparison.minDeltaUs = atof(arg + 12);
+    } else if (strncmp(arg, "--iterations=", 13) == 0) {
+      int minimum = 0, maximum = 0;
+      if (sscanf(arg + 13, "%d,%d", &minimum, &maximum) != 2 ||
+          minimum < 1 || maximum < minimum) {
+        PrintUsage();
+        return 2;
+      }
+      options.minIterations = minimum;
+      options.maxIterations = maximum;
+    } else if (strncmp(arg, "--scan-dir=", 11) == 0) {
+      config.scanDir = arg + 11;
+    } else if (strncmp(arg, "--tag-file=", 11) == 0) {
+      config.tagFile = arg + 11;
+    } else if (strcmp(arg, "--debug") == 0) {
+      gIsDebug = true;
+    } else {
+      PrintUsage();
+      return strcmp(arg, "--help") == 0 ? 0 : 2;
+    }
+  }
+  if (options.sizes.empty()) {
+    PrintUsage();
+    return 2;
+  }
+
+  char tempDir[] = "/tmp/beton-bench-XXXXXX";
+  if (!mkdtemp(tempDir)) {
+    perror("mkdtemp");
+    return 2;
+  }
+  config.tempDir = tempDir;
+
+  RegisterCoreBenchmarks(config);
+#ifdef __HAIKU__
+  RegisterHaikuBenchmarks(config);
+#endif
+
+  const std::vector<Bench::Result> results = Bench::RunAll(options);
+  RemoveTempDir(tempDir);
+
+  if (!jsonPath && !baselinePath)
+    jsonPath = "-";
+  if (jsonPath && !Bench::WriteJson(jsonPath, results)) {
+    fprintf(stderr, "Could not write %s\n", jsonPath);
+    return 2;
+  }
+
+  if (baselinePath) {
+    std::vector<Bench::Result> baseline;
+    std::map<BString, double> stored;
+    if (!Bench::ReadJson(baselinePath, baseline, stored)) {
+      fprintf(stderr, "Could not read baseline %s\n", baselinePath);
+      return 2;
+    }
+    // Tolerances given on the command line win over the stored ones.
+    for (const auto &[prefix, value] : comparison.tolerances)
+      stored[prefix] = value;
+    comparison.tolerances = stored;
+    comparison.filter = options.filter;
+    comparison.sizes = options.sizes;
+
+    // Keep the JSON on stdout parseable.
+    FILE *report = jsonPath && strcmp(jsonPath, "-") == 0 ? stderr : stdout;
+    const int32 failures =
+        Bench::Compare(baseline, results, comparison, report);
+    if (failures > 0) {
+      fprintf(report, "%d regression(s) or missing result(s)\n",
+              (int)failures);
+      return 1;
+    }
+  }
+  return 0;
+}
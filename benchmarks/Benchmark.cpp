@@ -0,0 +1,395 @@
+#include "Benchmark.h"
+
+#include <OS.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace Bench {
+
+struct Entry {
+  BString name;
+  Setup setup;
+  bool sized;
+};
+
+static std::vector<Entry> &Registry() {
+  static std::vector<Entry> sEntries;
+  return sEntries;
+}
+
+void Register(const char *name, Setup setup, bool sized) {
+  Registry().push_back({name, std::move(setup), sized});
+}
+
+static volatile size_t sConsumed;
+
+void Consume(size_t value) { sConsumed = sConsumed + value; }
+
+static double Quantile(std::vector<double> sorted, double q) {
+  std::sort(sorted.begin(), sorted.end());
+  const size_t index = std::min(sorted.size() - 1,
+                                (size_t)std::ceil(q * sorted.size()) - 1);
+  return sorted[index];
+}
+
+static Result Run(const Entry &entry, size_t size, const Options &options) {
+  Body body = entry.setup(size);
+
+  // Warm-up, also catches benchmarks whose first run is far slower.
+  bigtime_t start = system_time();
+  body();
+  const bigtime_t first = system_time() - start;
+
+  std::vector<double> samples;
+  bigtime_t spent = 0;
+  while ((int32)samples.size() < options.maxIterations &&
+         ((int32)samples.size() < options.minIterations ||
+          spent + first < options.timeBudget)) {
+    start = system_time();
+    body();
+    const bigtime_t elapsed = system_time() - start;
+    samples.push_back((double)elapsed);
+    spent += elapsed;
+  }
+
+  Result result;
+  result.name = entry.name;
+  result.size = size;
+  result.iterations = (int32)samples.size();
+  result.medianUs = Quantile(samples, 0.5);
+  result.minUs = *std::min_element(samples.begin(), samples.end());
+  result.p90Us = Quantile(samples, 0.9);
+  return result;
+}
+
+std::vector<Result> RunAll(const Options &options) {
+  std::vector<Result> results;
+  for (const Entry &entry : Registry()) {
+    if (!options.filter.IsEmpty() &&
+        entry.name.FindFirst(options.filter.String()) < 0)
+      continue;
+
+    std::vector<size_t> sizes = options.sizes;
+    if (!entry.sized)
+      sizes = {0};
+
+    for (size_t size : sizes) {
+      Result result = Run(entry, size, options);
+      fprintf(stderr, "%-28s %8zu %12.0f us (min %.0f, p90 %.0f, n=%d)\n",
+              result.name.String(), result.size, result.medianUs,
+              result.minUs, result.p90Us, (int)result.iterations);
+      results.push_back(result);
+    }
+  }
+  return results;
+}
+
+// --- JSON ---
+
+static void AppendEscaped(std::string &out, const char *s) {
+  out += '"';
+  for (; *s; s++) {
+    const unsigned char c = (unsigned char)*s;
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += (char)c;
+    } else if (c < 0x20) {
+      char buf[8];
+      snprintf(buf, sizeof(buf), "\\u%04x", c);
+      out += buf;
+    } else {
+      out += (char)c;
+    }
+  }
+  out += '"';
+}
+
+bool WriteJson(const char *path, const std::vector<Result> &results) {
+  std::string out = "{\n  \"version\": 1,\n  \"results\": [\n";
+  for (size_t i = 0; i < results.size(); i++) {
+    const Result &r = results[i];
+    char numbers[192];
+    snprintf(numbers, sizeof(numbers),
+             ", \"size\": %zu, \"iterations\": %d, \"median_us\": %.1f, "
+             "\"min_us\": %.1f, \"p90_us\": %.1f}",
+             r.size, (int)r.iterations, r.medianUs, r.minUs, r.p90Us);
+    out += "    {\"name\": ";
+    AppendEscaped(out, r.name.String());
+    out += numbers;
+    out += i + 1 < results.size() ? ",\n" : "\n";
+  }
+  out += "  ]\n}\n";
+
+  FILE *file = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+  if (!file)
+    return false;
+  const bool ok = fwrite(out.data(), 1, out.size(), file) == out.size();
+  if (file != stdout)
+    fclose(file);
+  return ok;
+}
+
+/**
+ * @brief Just enough of a JSON reader for results files: objects, arrays,
+ * strings, numbers and literals, without \u escapes beyond ASCII.
+ */
+class JsonReader {
+public:
+  struct Value {
+    enum Type { kNull, kNumber, kString, kArray, kObject } type = kNull;
+    double number = 0;
+    std::string string;
+    std::vector<Value> items;
+    std::vector<std::pair<std::string, Value>> members;
+
+    const Value *Member(const char *name) const {
+      for (const auto &[key, value] : members) {
+        if (key == name)
+          return &value;
+      }
+      return nullptr;
+    }
+  };
+
+  JsonReader(const std::string &text) : fText(text) {}
+
+  bool Parse(Value &out) {
+    if (!_Value(out))
+      return false;
+    _SkipSpace();
+    return fPos == fText.size();
+  }
+
+private:
+  void _SkipSpace() {
+    while (fPos < fText.size() && isspace((unsigned char)fText[fPos]))
+      fPos++;
+  }
+
+  bool _Consume(char c) {
+    _SkipSpace();
+    if (fPos < fText.size() && fText[fPos] == c) {
+      fPos++;
+      return true;
+    }
+    return false;
+  }
+
+  bool _String(std::string &out) {
+    if (!_Consume('"'))
+      return false;
+    out.clear();
+    while (fPos < fText.size()) {
+      char c = fText[fPos++];
+      if (c == '"')
+        return true;
+      if (c == '\\') {
+        if (fPos >= fText.size())
+          return false;
+        c = fText[fPos++];
+        switch (c) {
+        case 'n':
+          c = '\n';
+          break;
+        case 't':
+          c = '\t';
+          break;
+        case 'u':
+          if (fPos + 4 > fText.size())
+            return false;
+          c = (char)strtol(fText.substr(fPos, 4).c_str(), nullptr, 16);
+          fPos += 4;
+          break;
+        default:
+          break;
+        }
+      }
+      out += c;
+    }
+    return false;
+  }
+
+  bool _Value(Value &out) {
+    _SkipSpace();
+    if (fPos >= fText.size())
+      return false;
+
+    const char c = fText[fPos];
+    if (c == '{') {
+      fPos++;
+      out.type = Value::kObject;
+      if (_Consume('}'))
+        return true;
+      do {
+        std::pair<std::string, Value> member;
+        if (!_String(member.first) || !_Consume(':') ||
+            !_Value(member.second))
+          return false;
+        out.members.push_back(std::move(member));
+      } while (_Consume(','));
+      return _Consume('}');
+    }
+    if (c == '[') {
+      fPos++;
+      out.type = Value::kArray;
+      if (_Consume(']'))
+        return true;
+      do {
+        out.items.emplace_back();
+        if (!_Value(out.items.back()))
+          return false;
+      } while (_Consume(','));
+      return _Consume(']');
+    }
+    if (c == '"') {
+      out.type = Value::kString;
+      return _String(out.string);
+    }
+    for (const char *literal : {"null", "true", "false"}) {
+      if (fText.compare(fPos, strlen(literal), literal) == 0) {
+        fPos += strlen(literal);
+        out.type = Value::kNull;
+        return true;
+      }
+    }
+
+    char *end = nullptr;
+    out.number = strtod(fText.c_str() + fPos, &end);
+    if (end == fText.c_str() + fPos)
+      return false;
+    out.type = Value::kNumber;
+    fPos = end - fText.c_str();
+    return true;
+  }
+
+  const std::string &fText;
+  size_t fPos = 0;
+};
+
+bool ReadJson(const char *path, std::vector<Result> &results,
+              std::map<BString, double> &tolerances) {
+  FILE *file = fopen(path, "r");
+  if (!file)
+    return false;
+  std::string text;
+  char buffer[4096];
+  size_t n;
+  while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    text.append(buffer, n);
+  fclose(file);
+
+  JsonReader::Value root;
+  if (!JsonReader(text).Parse(root) || root.type != JsonReader::Value::kObject)
+    return false;
+
+  const JsonReader::Value *list = root.Member("results");
+  if (list && list->type == JsonReader::Value::kArray) {
+    for (const auto &item : list->items) {
+      const JsonReader::Value *name = item.Member("name");
+      const JsonReader::Value *median = item.Member("median_us");
+      if (!name || !median)
+        continue;
+      Result r;
+      r.name = name->string.c_str();
+      r.medianUs = median->number;
+      if (const JsonReader::Value *v = item.Member("size"))
+        r.size = (size_t)v->number;
+      if (const JsonReader::Value *v = item.Member("min_us"))
+        r.minUs = v->number;
+      if (const JsonReader::Value *v = item.Member("p90_us"))
+        r.p90Us = v->number;
+      if (const JsonReader::Value *v = item.Member("iterations"))
+        r.iterations = (int32)v->number;
+      results.push_back(r);
+    }
+  }
+
+  const JsonReader::Value *limits = root.Member("tolerances");
+  if (limits && limits->type == JsonReader::Value::kObject) {
+    for (const auto &[prefix, value] : limits->members)
+      tolerances[prefix.c_str()] = value.number;
+  }
+  return true;
+}
+
+// --- Comparison ---
+
+/** Longest matching prefix wins, so "scan/noop" can override "scan/". */
+static double ToleranceFor(const BString &name, const Comparison &comparison) {
+  double tolerance = comparison.defaultTolerance;
+  int32 longest = -1;
+  for (const auto &[prefix, value] : comparison.tolerances) {
+    if (name.StartsWith(prefix.String()) && prefix.Length() > longest) {
+      longest = prefix.Length();
+      tolerance = value;
+    }
+  }
+  return tolerance;
+}
+
+/** Whether the run selected by @p comparison includes @p result. */
+static bool InRun(const Result &result, const Comparison &comparison) {
+  if (!comparison.filter.IsEmpty() &&
+      result.name.FindFirst(comparison.filter.String()) < 0)
+    return false;
+  // Benchmarks that do not depend on the size run once with size 0.
+  return result.size == 0 ||
+         std::find(comparison.sizes.begin(), comparison.sizes.end(),
+                   result.size) != comparison.sizes.end();
+}
+
+int32 Compare(const std::vector<Result> &baseline,
+              const std::vector<Result> &current,
+              const Comparison &comparison, FILE *out) {
+  int32 regressions = 0;
+  fprintf(out, "%-28s %8s %12s %12s %8s\n", "benchmark", "size",
+          "baseline us", "current us", "change");
+
+  for (const Result &now : current) {
+    auto it = std::find_if(baseline.begin(), baseline.end(),
+                           [&](const Result &r) {
+                             return r.name == now.name && r.size == now.size;
+                           });
+    if (it == baseline.end()) {
+      fprintf(out, "%-28s %8zu %12s %12.0f %8s\n", now.name.String(),
+              now.size, "-", now.medianUs, "new");
+      continue;
+    }
+
+    const double change =
+        it->medianUs > 0 ? now.medianUs / it->medianUs - 1.0 : 0.0;
+    const bool regressed =
+        change > ToleranceFor(now.name, comparison) &&
+        now.medianUs - it->medianUs > comparison.minDeltaUs;
+    if (regressed)
+      regressions++;
+
+    fprintf(out, "%-28s %8zu %12.0f %12.0f %+7.1f%%%s\n", now.name.String(),
+            now.size, it->medianUs, now.medianUs, change * 100.0,
+            regressed ? "  REGRESSION" : "");
+  }
+
+  for (const Result &then : baseline) {
+    if (!InRun(then, comparison))
+      continue;
+    auto it = std::find_if(current.begin(), current.end(),
+                           [&](const Result &r) {
+                             return r.name == then.name && r.size == then.size;
+                           });
+    if (it != current.end())
+      continue;
+
+    regressions++;
+    fprintf(out, "%-28s %8zu %12.0f %12s %8s  MISSING\n", then.name.String(),
+            then.size, then.medianUs, "-", "-");
+  }
+  return regressions;
+}
+
+} // namespace Bench
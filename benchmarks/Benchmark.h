@@ -0,0 +1,103 @@
+#ifndef BETON_BENCHMARK_H
+#define BETON_BENCHMARK_H
+
+#include <String.h>
+#include <SupportDefs.h>
+
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <vector>
+
+/**
+ * @namespace Bench
+ * @brief Minimal benchmark runner for the core library.
+ *
+ * A benchmark is registered with a setup function that prepares its input
+ * for a library size (untimed) and returns the body that is timed. Results
+ * are written as JSON and can be compared against a stored baseline.
+ */
+namespace Bench {
+
+/** Timed part of a benchmark; called once per iteration. */
+typedef std::function<void()> Body;
+
+/** Prepares the input for @p size tracks and returns the timed body. */
+typedef std::function<Body(size_t size)> Setup;
+
+/**
+ * @brief Registers a benchmark.
+ * @param name Unique name, "<area>/<case>" (e.g. "filter/genre").
+ * @param setup Builds the input and returns the body.
+ * @param sized False if the input does not depend on the library size
+ * (scans of a real folder, tag I/O); such benchmarks run once with size 0.
+ */
+void Register(const char *name, Setup setup, bool sized = true);
+
+/** Keeps the compiler from discarding a computed value. */
+void Consume(size_t value);
+
+struct Result {
+  BString name;
+  size_t size = 0;
+  int32 iterations = 0;
+  double medianUs = 0;
+  double minUs = 0;
+  double p90Us = 0;
+};
+
+struct Options {
+  std::vector<size_t> sizes{10000, 100000, 1000000};
+  BString filter;                ///< Only run names containing this.
+  int32 minIterations = 3;
+  int32 maxIterations = 15;
+  bigtime_t timeBudget = 1000000; ///< Per benchmark and size, after warm-up.
+};
+
+/** Runs all registered benchmarks, printing a line per result to stderr. */
+std::vector<Result> RunAll(const Options &options);
+
+/** @name Results files */
+///@{
+bool WriteJson(const char *path, const std::vector<Result> &results);
+
+/**
+ * @brief Reads results and tolerances written by WriteJson or by hand.
+ *
+ * The optional "tolerances" object maps a name prefix ("scan/", or a full
+ * name) to the allowed slowdown as a fraction.
+ */
+bool ReadJson(const char *path, std::vector<Result> &results,
+              std::map<BString, double> &tolerances);
+///@}
+
+struct Comparison {
+  double defaultTolerance = 0.15; ///< Allowed slowdown of the median.
+  double minDeltaUs = 20;         ///< Differences below this are noise.
+  std::map<BString, double> tolerances; ///< Name prefix -> tolerance.
+
+  /** @name The run's selection
+   * Baseline results outside it are not expected in the current run.
+   */
+  ///@{
+  BString filter;
+  std::vector<size_t> sizes;
+  ///@}
+};
+
+/**
+ * @brief Compares results with a baseline and prints a report.
+ *
+ * Baseline results the run should have repeated but did not are reported
+ * as missing and count as failures.
+ *
+ * @param out Stream for the report.
+ * @return Number of regressions and missing results.
+ */
+int32 Compare(const std::vector<Result> &baseline,
+              const std::vector<Result> &current,
+              const Comparison &comparison, FILE *out = stdout);
+
+} // namespace Bench
+
+#endif // BETON_BENCHMARK_H
@@ -0,0 +1,24 @@
+#ifndef BETON_BENCHMARK_SUITES_H
+#define BETON_BENCHMARK_SUITES_H
+
+#include <String.h>
+
+/**
+ * @struct BenchConfig
+ * @brief Inputs the benchmarks take from the command line.
+ */
+struct BenchConfig {
+  BString tempDir; ///< Scratch directory for playlists, caches and copies.
+  BString scanDir; ///< Folder with audio files for the scan benchmarks.
+  BString tagFile; ///< Audio file for the tag benchmarks (copied first).
+};
+
+/** @brief Library, filter, search, sort, playlist and matching benchmarks. */
+void RegisterCoreBenchmarks(const BenchConfig &config);
+
+#ifdef __HAIKU__
+/** @brief Cache load/save, folder scans and tag I/O; need the Haiku API. */
+void RegisterHaikuBenchmarks(const BenchConfig &config);
+#endif
+
+#endif // BETON_BENCHMARK_SUITES_H
@@ -0,0 +1,340 @@
+#include "Benchmark.h"
+#include "BenchmarkSuites.h"
+#include "FacetIndex.h"
+#include "LibraryFilter.h"
+#include "LibraryGenerator.h"
+#include "MatchingUtils.h"
+#include "MediaLibrary.h"
+#include "PlaylistFile.h"
+#include "TextSearch.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+
+/**
+ * Libraries are generated once per size and shared by all benchmarks. They
+ * go through a MediaLibrary, so their tracks are filed under albums.
+ */
+static const std::vector<MediaItem> &LibraryOfSize(size_t size) {
+  static std::map<size_t, MediaLibrary> sLibraries;
+  auto it = sLibraries.find(size);
+  if (it == sLibraries.end()) {
+    it = sLibraries.emplace(size, MediaLibrary()).first;
+    it->second.Assign(LibraryGenerator().Generate(size));
+  }
+  return it->second.Items();
+}
+
+static std::shared_ptr<std::vector<const MediaItem *>>
+PointersTo(const std::vector<MediaItem> &items) {
+  auto pointers = std::make_shared<std::vector<const MediaItem *>>();
+  pointers->reserve(items.size());
+  for (const MediaItem &item : items)
+    pointers->push_back(&item);
+  return pointers;
+}
+
+static void RegisterLibrary() {
+  Bench::Register("library/assign", [](size_t size) -> Bench::Body {
+    const std::vector<MediaItem> &items = LibraryOfSize(size);
+    auto library = std::make_shared<MediaLibrary>();
+    return [&items, library]() {
+      std::vector<MediaItem> copy(items);
+      library->Assign(std::move(copy));
+      Bench::Consume(library->Count());
+    };
+  });
+
+  Bench::Register("library/lookup", [](size_t size) -> Bench::Body {
+    auto library = std::make_shared<MediaLibrary>();
+    library->Assign(std::vector<MediaItem>(LibraryOfSize(size)));
+    return [library]() {
+      size_t found = 0;
+      for (const MediaItem &item : *library)
+        found += library->IndexOf(item.path) >= 0;
+      Bench::Consume(found);
+    };
+  });
+}
+
+static void RegisterFilter() {
+  auto filter = [](LibraryQuery query) {
+    return [query](size_t size) -> Bench::Body {
+      auto source = PointersTo(LibraryOfSize(size));
+      return [source, query]() {
+        LibraryFilterResult result;
+        LibraryFilter::Apply(*source, query, result);
+        Bench::Consume(result.items.size());
+      };
+    };
+  };
+
+  auto indexed = [](LibraryQuery query) {
+    return [query](size_t size) -> Bench::Body {
+      auto index = std::make_shared<FacetIndex>();
+      index->Build(*PointersTo(LibraryOfSize(size)));
+      return [index, query]() {
+        LibraryFilterResult result;
+        LibraryFilter::Apply(*index, query, result);
+        Bench::Consume(result.items.size());
+      };
+    };
+  };
+
+  LibraryQuery all;
+  Bench::Register("filter/all", filter(all));
+  Bench::Register("filter/indexed_all", indexed(all));
+
+  LibraryQuery genre;
+  genre.genre.values.push_back({"Rock"});
+  Bench::Register("filter/genre", filter(genre));
+  Bench::Register("filter/indexed_genre", indexed(genre));
+
+  LibraryQuery genres;
+  genres.genre.values = {{"Rock"}, {"Jazz"}, {"Pop"}};
+  genres.artist.untagged = true;
+  Bench::Register("filter/multi_select", filter(genres));
+  Bench::Register("filter/indexed_multi_select", indexed(genres));
+
+  // One album, picked by its ID as the column browser does
+  auto album = [](size_t size) {
+    LibraryQuery query;
+    for (const MediaItem &item : LibraryOfSize(size)) {
+      if (item.albumId != AlbumTable::kNoAlbum) {
+        query.album.values.push_back({item.album, item.year, item.albumId});
+        break;
+      }
+    }
+    return query;
+  };
+  Bench::Register("filter/album", [filter, album](size_t size) {
+    return filter(album(size))(size);
+  });
+  Bench::Register("filter/indexed_album", [indexed, album](size_t size) {
+    return indexed(album(size))(size);
+  });
+
+  LibraryQuery untagged;
+  untagged.artist.untagged = true;
+  Bench::Register("filter/untagged_artist", filter(untagged));
+
+  LibraryQuery hit;
+  hit.search.Parse("love");
+  Bench::Register("search/common_word", filter(hit));
+  Bench::Register("search/indexed_common_word", indexed(hit));
+
+  LibraryQuery miss;
+  miss.search.Parse("zzyzx");
+  Bench::Register("search/no_match", filter(miss));
+
+  LibraryQuery fields;
+  fields.search.Parse("genre:rock year:1970..1979 duration:>4m -live love");
+  Bench::Register("search/fields", filter(fields));
+  Bench::Register("search/indexed_fields", indexed(fields));
+
+  Bench::Register("filter/index_build", [](size_t size) -> Bench::Body {
+    auto source = PointersTo(LibraryOfSize(size));
+    return [source]() {
+      FacetIndex index;
+      index.Build(*source);
+      Bench::Consume(index.CountValues(FacetIndex::kArtist));
+    };
+  });
+}
+
+/** Free-word search alone: the IFindFirst() loop against TextSearch. */
+static void RegisterTextSearch() {
+  for (const char *word : {"love", "zzyzx"}) {
+    const std::string suffix = std::string("_") + word;
+
+    Bench::Register(("search/ifindfirst" + suffix).c_str(),
+                    [word](size_t size) -> Bench::Body {
+                      auto source = PointersTo(LibraryOfSize(size));
+                      const BString text(word);
+                      return [source, text]() {
+                        size_t found = 0;
+                        for (const MediaItem *item : *source) {
+                          found += item->title.IFindFirst(text) >= 0 ||
+                                   item->artist.IFindFirst(text) >= 0 ||
+                                   item->album.IFindFirst(text) >= 0;
+                        }
+                        Bench::Consume(found);
+                      };
+                    });
+
+    Bench::Register(("search/text_search" + suffix).c_str(),
+                    [word](size_t size) -> Bench::Body {
+                      auto search = std::make_shared<TextSearch>();
+                      for (const MediaItem &item : LibraryOfSize(size))
+                        search->Add({&item.title, &item.artist, &item.album});
+                      const BString text(word);
+                      return [search, text]() {
+                        std::vector<uint32> found;
+                        search->Find(text, found);
+                        Bench::Consume(found.size());
+                      };
+                    });
+  }
+}
+
+static void RegisterSort() {
+  Bench::Register("sort/artist_album_track", [](size_t size) -> Bench::Body {
+    auto source = PointersTo(LibraryOfSize(size));
+    return [source]() {
+      std::vector<const MediaItem *> sorted(*source);
+      std::sort(sorted.begin(), sorted.end(),
+                [](const MediaItem *a, const MediaItem *b) {
+                  if (int c = a->artist.ICompare(b->artist))
+                    return c < 0;
+                  if (int c = a->album.ICompare(b->album))
+                    return c < 0;
+                  if (a->disc != b->disc)
+                    return a->disc < b->disc;
+                  return a->track < b->track;
+                });
+      Bench::Consume(sorted.size());
+    };
+  });
+
+  Bench::Register("sort/title", [](size_t size) -> Bench::Body {
+    auto source = PointersTo(LibraryOfSize(size));
+    return [source]() {
+      std::vector<const MediaItem *> sorted(*source);
+      std::sort(sorted.begin(), sorted.end(),
+                [](const MediaItem *a, const MediaItem *b) {
+                  return a->title.ICompare(b->title) < 0;
+                });
+      Bench::Consume(sorted.size());
+    };
+  });
+}
+
+static std::vector<PlaylistEntry> EntriesFor(size_t size) {
+  std::vector<PlaylistEntry> entries;
+  entries.reserve(size);
+  for (const MediaItem &item : LibraryOfSize(size)) {
+    PlaylistEntry entry(item.path);
+    entry.artist = item.artist;
+    entry.title = item.title;
+    entry.duration = item.duration;
+    entry.inode = item.inode;
+    entries.push_back(entry);
+  }
+  return entries;
+}
+
+static void RegisterPlaylists(const BenchConfig &config) {
+  Bench::Register("playlist/format", [](size_t size) -> Bench::Body {
+    auto entries = std::make_shared<std::vector<PlaylistEntry>>(
+        EntriesFor(size));
+    return [entries]() {
+      std::string text;
+      PlaylistFile::Format(*entries, PlaylistFormat::ExtendedM3U, text);
+      Bench::Consume(text.size());
+    };
+  });
+
+  Bench::Register("playlist/parse", [](size_t size) -> Bench::Body {
+    auto text = std::make_shared<std::string>();
+    PlaylistFile::Format(EntriesFor(size), PlaylistFormat::ExtendedM3U, *text);
+    return [text]() {
+      std::vector<PlaylistEntry> entries;
+      PlaylistFile::Parse(text->data(), text->size(), "/music", entries);
+      Bench::Consume(entries.size());
+    };
+  });
+
+  BString path(config.tempDir);
+  path << "/bench.m3u";
+  Bench::Register("playlist/save", [path](size_t size) -> Bench::Body {
+    auto entries = std::make_shared<std::vector<PlaylistEntry>>(
+        EntriesFor(size));
+    return [entries, path]() {
+      Bench::Consume(PlaylistFile::Write(path.String(), *entries,
+                                         PlaylistFormat::ExtendedM3U));
+    };
+  });
+
+  Bench::Register("playlist/load", [path](size_t size) -> Bench::Body {
+    PlaylistFile::Write(path.String(), EntriesFor(size),
+                        PlaylistFormat::ExtendedM3U);
+    return [path]() {
+      std::vector<PlaylistEntry> entries;
+      PlaylistFile::Read(path.String(), entries);
+      Bench::Consume(entries.size());
+    };
+  });
+}
+
+/** Matching runs per release; one 12-track release per 100 library tracks. */
+static const size_t kTracksPerRelease = 12;
+static const size_t kLibraryTracksPerRelease = 100;
+
+static void RegisterMatching() {
+  Bench::Register("match/levenshtein", [](size_t size) -> Bench::Body {
+    auto titles = std::make_shared<std::vector<BString>>();
+    for (const MediaItem &item : LibraryOfSize(size))
+      titles->push_back(item.title);
+    return [titles]() {
+      size_t total = 0;
+      for (size_t i = 1; i < titles->size(); i++) {
+        total += MatchingUtils::LevenshteinDistance((*titles)[i - 1].String(),
+                                                    (*titles)[i].String());
+      }
+      Bench::Consume(total);
+    };
+  });
+
+  Bench::Register("match/assign_tracks", [](size_t size) -> Bench::Body {
+    typedef std::pair<std::vector<MatchFile>, std::vector<MatchTrack>> Release;
+    auto releases = std::make_shared<std::vector<Release>>();
+
+    // Files named like a rip of the release, in shuffled order and with
+    // slightly different lengths, as the matcher sees them.
+    LibraryGenerator generator(7);
+    const size_t count = std::max<size_t>(1, size / kLibraryTracksPerRelease);
+    for (size_t r = 0; r < count; r++) {
+      Release release;
+      for (size_t t = 0; t < kTracksPerRelease; t++) {
+        MatchTrack track;
+        track.index = (int)t + 1;
+        track.name = generator.Title();
+        track.durationSec = 120 + (int)generator.Next(300);
+        release.second.push_back(track);
+      }
+      for (size_t t = 0; t < kTracksPerRelease; t++) {
+        const MatchTrack &track =
+            release.second[(t * 5 + r) % kTracksPerRelease];
+        MatchFile file;
+        file.durationSec = track.durationSec + (int)generator.Next(3) - 1;
+        file.trackNum = generator.Next(4) == 0 ? 0 : track.index;
+        BString leaf;
+        leaf.SetToFormat("%02d - %s.mp3", track.index, track.name.String());
+        file.cleanName = MatchingUtils::CleanFileName(leaf.String());
+        release.first.push_back(file);
+      }
+      releases->push_back(release);
+    }
+
+    return [releases]() {
+      size_t matched = 0;
+      for (const Release &release : *releases) {
+        for (int index :
+             MatchingUtils::AssignTracks(release.first, release.second))
+          matched += index >= 0;
+      }
+      Bench::Consume(matched);
+    };
+  });
+}
+
+void RegisterCoreBenchmarks(const BenchConfig &config) {
+  RegisterLibrary();
+  RegisterFilter();
+  RegisterTextSearch();
+  RegisterSort();
+  RegisterPlaylists(config);
+  RegisterMatching();
+}
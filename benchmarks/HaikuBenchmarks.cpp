@@ -0,0 +1,210 @@
+#include "Benchmark.h"
+#include "BenchmarkSuites.h"
+#include "CacheManager.h"
+#include "LibraryGenerator.h"
+#include "MediaScanner.h"
+#include "Messages.h"
+#include "TagSync.h"
+
+#include <Entry.h>
+#include <File.h>
+#include <Looper.h>
+#include <OS.h>
+#include <Path.h>
+
+#include <cstdio>
+#include <map>
+#include <memory>
+
+/**
+ * @class ScanSink
+ * @brief Stands in for the CacheManager during scan benchmarks.
+ *
+ * Collects the batches a MediaScanner sends and signals when it is done.
+ */
+class ScanSink : public BLooper {
+public:
+  ScanSink() : BLooper("ScanSink"), fDone(create_sem(0, "scan done")) {}
+  ~ScanSink() override { delete_sem(fDone); }
+
+  void MessageReceived(BMessage *msg) override {
+    switch (msg->what) {
+    case MSG_MEDIA_BATCH: {
+      const char *path;
+      for (int32 i = 0; msg->FindString("path", i, &path) == B_OK; i++) {
+        MediaItem &item = fItems[path];
+        item.path = path;
+        msg->FindInt64("size", i, &item.size);
+        msg->FindInt64("mtime", i, &item.mtime);
+        msg->FindInt64("inode", i, &item.inode);
+        msg->FindInt64("partial_hash", i, &item.partialHash);
+      }
+      break;
+    }
+    case MSG_SCAN_DONE:
+      release_sem(fDone);
+      break;
+    default:
+      BLooper::MessageReceived(msg);
+    }
+  }
+
+  /**
+   * @brief Scans @p dir with @p cache and waits until the scanner is done.
+   * @return The files reported by the scanner (all of them on a full scan).
+   */
+  std::map<BString, MediaItem> Scan(const entry_ref &dir,
+                                    const std::map<BString, MediaItem> &cache) {
+    Lock();
+    fItems.clear();
+    Unlock();
+
+    // The scanner quits itself once it has finished.
+    MediaScanner *scanner =
+        new MediaScanner(dir, BMessenger(this), BMessenger());
+    scanner->SetCache(cache);
+    scanner->Run();
+    scanner->PostMessage(MSG_START_SCAN);
+    acquire_sem(fDone);
+
+    Lock();
+    std::map<BString, MediaItem> items = fItems;
+    Unlock();
+    return items;
+  }
+
+private:
+  sem_id fDone;
+  std::map<BString, MediaItem> fItems;
+};
+
+/** Deletes a looper whether or not it was started. */
+static void QuitLooper(BLooper *looper) {
+  if (looper->LockLooper())
+    looper->Quit();
+}
+
+static void RegisterCache(const BenchConfig &config) {
+  BString cachePath(config.tempDir);
+  cachePath << "/media.cache";
+
+  auto managerOfSize = [cachePath](size_t size) {
+    std::shared_ptr<CacheManager> cache(new CacheManager(BMessenger()),
+                                        QuitLooper);
+    cache->SetCachePath(cachePath);
+    for (const MediaItem &item : LibraryGenerator().Generate(size))
+      cache->AddOrUpdateEntry(item);
+    return cache;
+  };
+
+  Bench::Register("cache/save", [managerOfSize](size_t size) -> Bench::Body {
+    auto cache = managerOfSize(size);
+    return [cache]() {
+      cache->SaveCache();
+      Bench::Consume(cache->Entries().size());
+    };
+  });
+
+  // Both loads read through the file system cache; "cold" starts from an
+  // empty CacheManager like the first load after launch, "warm" replaces a
+  // loaded library like a reload.
+  Bench::Register("cache/load_cold",
+                  [managerOfSize, cachePath](size_t size) -> Bench::Body {
+                    managerOfSize(size)->SaveCache();
+                    return [cachePath]() {
+                      std::shared_ptr<CacheManager> cache(
+                          new CacheManager(BMessenger()), QuitLooper);
+                      cache->SetCachePath(cachePath);
+                      cache->LoadCache();
+                      Bench::Consume(cache->Entries().size());
+                    };
+                  });
+
+  Bench::Register("cache/load_warm",
+                  [managerOfSize](size_t size) -> Bench::Body {
+                    auto cache = managerOfSize(size);
+                    cache->SaveCache();
+                    return [cache]() {
+                      cache->LoadCache();
+                      Bench::Consume(cache->Entries().size());
+                    };
+                  });
+}
+
+static void RegisterScan(const BenchConfig &config) {
+  entry_ref dir;
+  if (config.scanDir.IsEmpty() ||
+      get_ref_for_path(config.scanDir.String(), &dir) != B_OK) {
+    fprintf(stderr, "No --scan-dir given, skipping the scan benchmarks\n");
+    return;
+  }
+
+  std::shared_ptr<ScanSink> sink(new ScanSink, QuitLooper);
+  sink->Run();
+
+  Bench::Register(
+      "scan/full",
+      [sink, dir](size_t) -> Bench::Body {
+        return [sink, dir]() {
+          Bench::Consume(sink->Scan(dir, {}).size());
+        };
+      },
+      false);
+
+  Bench::Register(
+      "scan/noop",
+      [sink, dir](size_t) -> Bench::Body {
+        auto cache = std::make_shared<std::map<BString, MediaItem>>(
+            sink->Scan(dir, {}));
+        return [sink, dir, cache]() {
+          Bench::Consume(sink->Scan(dir, *cache).size());
+        };
+      },
+      false);
+}
+
+static void RegisterTags(const BenchConfig &config) {
+  if (config.tagFile.IsEmpty()) {
+    fprintf(stderr, "No --tag-file given, skipping the tag benchmarks\n");
+    return;
+  }
+
+  // Work on a copy; the write benchmark rewrites the file each iteration.
+  BPath copy(config.tempDir.String());
+  copy.Append(BPath(config.tagFile.String()).Leaf());
+  {
+    BFile in(config.tagFile.String(), B_READ_ONLY);
+    BFile out(copy.Path(), B_WRITE_ONLY | B_CREATE_FILE | B_ERASE_FILE);
+    char buffer[64 * 1024];
+    ssize_t read;
+    while ((read = in.Read(buffer, sizeof(buffer))) > 0)
+      out.Write(buffer, read);
+  }
+
+  Bench::Register(
+      "tags/read",
+      [copy](size_t) -> Bench::Body {
+        return [copy]() {
+          TagData tags;
+          Bench::Consume(TagSync::ReadTags(copy, tags));
+        };
+      },
+      false);
+
+  Bench::Register(
+      "tags/write",
+      [copy](size_t) -> Bench::Body {
+        auto tags = std::make_shared<TagData>();
+        TagSync::ReadTags(copy, *tags);
+        return [copy, tags]() {
+          Bench::Consume(TagSync::WriteTags(copy, *tags));
+        };
+      },
+      false);
+}
+
+void RegisterHaikuBenchmarks(const BenchConfig &config) {
+  RegisterCache(config);
+  RegisterScan(config);
+  RegisterTags(config);
+}
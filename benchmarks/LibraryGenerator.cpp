@@ -0,0 +1,104 @@
+#include "LibraryGenerator.h"
+
+static const char *kWords[] = {
+    "love",    "night",  "blue",  "river",  "fire",   "dream",   "city",
+    "heart",   "rain",   "light", "summer", "shadow", "electric", "road",
+    "golden",  "silent", "storm", "ocean",  "wild",   "midnight", "song",
+    "morning", "black",  "star",  "winter", "ghost",  "paper",   "stone",
+    "echo",    "velvet", "north", "glass",  "sugar",  "thunder", "home",
+    "crystal", "dance",  "devil", "angel",  "empire"};
+static const size_t kWordCount = sizeof(kWords) / sizeof(kWords[0]);
+
+static const char *kGenres[] = {
+    "Rock",       "Pop",    "Jazz",      "Blues",      "Classical",
+    "Electronic", "Hip-Hop", "Metal",    "Folk",       "Country",
+    "Reggae",     "Soul",   "Funk",      "Punk",       "Ambient",
+    "Techno",     "House",  "Indie",     "Alternative", "Soundtrack",
+    "World",      "Latin",  "R&B",       "Gospel",     "Krautrock",
+    "Schlager",   "Ska",    "Grunge",    "Disco",      "Trance"};
+static const size_t kGenreCount = sizeof(kGenres) / sizeof(kGenres[0]);
+
+uint32 LibraryGenerator::Next(uint32 bound) {
+  // xorshift32
+  fState ^= fState << 13;
+  fState ^= fState >> 17;
+  fState ^= fState << 5;
+  return bound ? fState % bound : fState;
+}
+
+BString LibraryGenerator::Title() {
+  BString title;
+  const uint32 words = 1 + Next(4);
+  for (uint32 i = 0; i < words; i++) {
+    BString word(kWords[Next(kWordCount)]);
+    if (i == 0)
+      word.Capitalize();
+    if (i > 0)
+      title << " ";
+    title << word;
+  }
+  return title;
+}
+
+std::vector<MediaItem> LibraryGenerator::Generate(size_t count,
+                                                  const char *root) {
+  std::vector<MediaItem> items;
+  items.reserve(count);
+
+  int32 artistNo = 0;
+  int32 albumNo = 0;
+  while (items.size() < count) {
+    BString artist = Title();
+    artist << " " << ++artistNo;
+    if (Next(100) == 0)
+      artist = "";
+
+    const uint32 albums = 1 + Next(15);
+    for (uint32 a = 0; a < albums && items.size() < count; a++) {
+      BString album = Title();
+      album << " " << ++albumNo;
+      if (Next(200) == 0)
+        album = "";
+      BString genre = kGenres[Next(kGenreCount)];
+      if (Next(30) == 0)
+        genre = "";
+      const int32 year = 1960 + (int32)Next(65);
+
+      // Untagged albums still get their own folder, keeping paths unique.
+      BString dir(root);
+      dir << "/" << (artist.IsEmpty() ? "Unknown" : artist.String()) << "/";
+      if (album.IsEmpty())
+        dir << "Unknown " << albumNo;
+      else
+        dir << album;
+
+      const uint32 tracks = 6 + Next(13);
+      for (uint32 t = 1; t <= tracks && items.size() < count; t++) {
+        MediaItem item;
+        item.title = Title();
+        item.artist = artist;
+        item.album = album;
+        item.albumArtist = artist;
+        item.genre = genre;
+        item.year = year;
+        item.track = (int32)t;
+        item.trackTotal = (int32)tracks;
+        item.disc = 1;
+        item.duration = 120 + (int32)Next(300);
+        item.bitrate = 320;
+        item.size = (int64)item.duration * 40000;
+        item.mtime = 1500000000 + (int64)Next(200000000);
+        item.inode = (int64)items.size() + 1000;
+        item.device = 3;
+        item.base = dir;
+
+        BString path;
+        path.SetToFormat("%s/%02u %s.flac", dir.String(), (unsigned)t,
+                         item.title.String());
+        item.path = path;
+        items.push_back(item);
+      }
+    }
+  }
+  return items;
+}
@@ -0,0 +1,40 @@
+#ifndef BETON_LIBRARY_GENERATOR_H
+#define BETON_LIBRARY_GENERATOR_H
+
+#include "MediaItem.h"
+
+#include <SupportDefs.h>
+
+#include <vector>
+
+/**
+ * @class LibraryGenerator
+ * @brief Builds reproducible synthetic libraries for the benchmarks.
+ *
+ * Proportions follow a typical collection: about 12 tracks per album, 8
+ * albums per artist and a few dozen genres, with a small share of untagged
+ * genres, artists and albums. The same seed always yields the same library.
+ */
+class LibraryGenerator {
+public:
+  explicit LibraryGenerator(uint32 seed = 1) : fState(seed ? seed : 1) {}
+
+  /**
+   * @brief Creates @p count tracks below @p root ("/music" by default).
+   *
+   * Paths look like "<root>/<Artist>/<Album>/07 <Title>.flac"; file stats
+   * (size, mtime, inode) are filled in but refer to no real file.
+   */
+  std::vector<MediaItem> Generate(size_t count, const char *root = "/music");
+
+  /** @brief A title-like string of 1 to 4 words. */
+  BString Title();
+
+  /** @brief Uniform random number in [0, bound). */
+  uint32 Next(uint32 bound);
+
+private:
+  uint32 fState;
+};
+
+#endif // BETON_LIBRARY_GENERATOR_H
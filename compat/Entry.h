@@ -0,0 +1,43 @@
+#ifndef BETON_COMPAT_ENTRY_H
+#define BETON_COMPAT_ENTRY_H
+
+#include "SupportDefs.h"
+
+#include <cstdio>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @class BEntry
+ * @brief Path based stand-in for the Haiku BEntry.
+ */
+class BEntry {
+public:
+  BEntry() = default;
+  explicit BEntry(const char *path) : fPath(path ? path : "") {}
+
+  status_t InitCheck() const { return fPath.empty() ? B_NO_INIT : B_OK; }
+  bool Exists() const {
+    struct stat st;
+    return !fPath.empty() && stat(fPath.c_str(), &st) == 0;
+  }
+  status_t GetStat(struct stat *st) const {
+    return stat(fPath.c_str(), st) == 0 ? B_OK : B_ENTRY_NOT_FOUND;
+  }
+  status_t Remove() { return unlink(fPath.c_str()) == 0 ? B_OK : B_ERROR; }
+  status_t Rename(const char *path, bool clobber = false) {
+    struct stat st;
+    if (!clobber && stat(path, &st) == 0)
+      return B_ERROR;
+    if (rename(fPath.c_str(), path) != 0)
+      return B_ERROR;
+    fPath = path;
+    return B_OK;
+  }
+
+private:
+  std::string fPath;
+};
+
+#endif // BETON_COMPAT_ENTRY_H
@@ -0,0 +1,61 @@
+#ifndef BETON_COMPAT_FILE_H
+#define BETON_COMPAT_FILE_H
+
+#include "SupportDefs.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define B_READ_ONLY O_RDONLY
+#define B_WRITE_ONLY O_WRONLY
+#define B_READ_WRITE O_RDWR
+#define B_CREATE_FILE O_CREAT
+#define B_ERASE_FILE O_TRUNC
+#define B_OPEN_AT_END O_APPEND
+
+/**
+ * @class BFile
+ * @brief POSIX file descriptor wrapper standing in for the Haiku BFile.
+ */
+class BFile {
+public:
+  BFile() = default;
+  BFile(const char *path, uint32 openMode) { SetTo(path, openMode); }
+  ~BFile() { Unset(); }
+
+  BFile(const BFile &) = delete;
+  BFile &operator=(const BFile &) = delete;
+
+  status_t SetTo(const char *path, uint32 openMode) {
+    Unset();
+    fFd = open(path, (int)openMode, 0644);
+    return InitCheck();
+  }
+  void Unset() {
+    if (fFd >= 0)
+      close(fFd);
+    fFd = -1;
+  }
+  status_t InitCheck() const { return fFd >= 0 ? B_OK : B_ENTRY_NOT_FOUND; }
+
+  ssize_t Read(void *buffer, size_t size) { return read(fFd, buffer, size); }
+  ssize_t ReadAt(off_t pos, void *buffer, size_t size) {
+    return pread(fFd, buffer, size, pos);
+  }
+  ssize_t Write(const void *buffer, size_t size) {
+    return write(fFd, buffer, size);
+  }
+  status_t GetSize(off_t *size) const {
+    struct stat st;
+    if (fstat(fFd, &st) != 0)
+      return B_FILE_ERROR;
+    *size = st.st_size;
+    return B_OK;
+  }
+
+private:
+  int fFd = -1;
+};
+
+#endif // BETON_COMPAT_FILE_H
@@ -0,0 +1,25 @@
+#ifndef BETON_COMPAT_OS_H
+#define BETON_COMPAT_OS_H
+
+#include "SupportDefs.h"
+
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+/** Microseconds since an arbitrary fixed point, like Haiku's system_time(). */
+inline bigtime_t system_time() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (bigtime_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+inline status_t snooze(bigtime_t amount) {
+  return usleep((useconds_t)amount) == 0 ? B_OK : B_ERROR;
+}
+
+inline thread_id find_thread(const char *) {
+  return (thread_id)(uintptr_t)pthread_self();
+}
+
+#endif // BETON_COMPAT_OS_H
@@ -0,0 +1,173 @@
+#ifndef BETON_COMPAT_STRING_H
+#define BETON_COMPAT_STRING_H
+
+#include "SupportDefs.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <strings.h>
+
+/**
+ * @class BString
+ * @brief std::string based stand-in for the Haiku BString.
+ *
+ * Covers the members the portable core modules use, with Haiku's semantics
+ * (byte offsets, -1 for "not found", case-insensitive I* variants).
+ */
+class BString {
+public:
+  BString() = default;
+  BString(const char *s) : fData(s ? s : "") {}
+  BString(const char *s, int32 length) { SetTo(s, length); }
+  BString(const std::string &s) : fData(s) {}
+
+  const char *String() const { return fData.c_str(); }
+  int32 Length() const { return (int32)fData.size(); }
+  bool IsEmpty() const { return fData.empty(); }
+  char operator[](int32 index) const { return fData[index]; }
+  char ByteAt(int32 index) const {
+    return index >= 0 && index < Length() ? fData[index] : 0;
+  }
+
+  BString &SetTo(const char *s) {
+    fData = s ? s : "";
+    return *this;
+  }
+  BString &SetTo(const char *s, int32 length) {
+    if (!s)
+      fData.clear();
+    else
+      fData.assign(s, strnlen(s, (size_t)std::max<int32>(length, 0)));
+    return *this;
+  }
+  BString &SetToFormat(const char *format, ...)
+      __attribute__((format(printf, 2, 3))) {
+    va_list args;
+    va_start(args, format);
+    va_list copy;
+    va_copy(copy, args);
+    const int length = vsnprintf(nullptr, 0, format, copy);
+    va_end(copy);
+    fData.resize(length > 0 ? length : 0);
+    if (length > 0)
+      vsnprintf(&fData[0], length + 1, format, args);
+    va_end(args);
+    return *this;
+  }
+
+  BString &Truncate(int32 newLength) {
+    if (newLength >= 0 && newLength < Length())
+      fData.resize(newLength);
+    return *this;
+  }
+  BString &ToLower() {
+    for (auto &c : fData)
+      c = (char)tolower((unsigned char)c);
+    return *this;
+  }
+  BString &Capitalize() {
+    ToLower();
+    if (!fData.empty())
+      fData[0] = (char)toupper((unsigned char)fData[0]);
+    return *this;
+  }
+  BString &Trim() {
+    const char *ws = " \t\r\n";
+    const size_t first = fData.find_first_not_of(ws);
+    if (first == std::string::npos) {
+      fData.clear();
+      return *this;
+    }
+    fData = fData.substr(first, fData.find_last_not_of(ws) - first + 1);
+    return *this;
+  }
+  BString &CopyInto(BString &into, int32 from, int32 length) const {
+    into.fData = fData.substr(from, length);
+    return into;
+  }
+
+  int32 FindFirst(const char *s, int32 from = 0) const {
+    return _Pos(fData.find(s, from));
+  }
+  int32 FindFirst(char c, int32 from = 0) const {
+    return _Pos(fData.find(c, from));
+  }
+  int32 FindLast(const char *s) const { return _Pos(fData.rfind(s)); }
+  int32 FindLast(char c) const { return _Pos(fData.rfind(c)); }
+  int32 IFindFirst(const BString &s, int32 from = 0) const {
+    return IFindFirst(s.String(), from);
+  }
+  int32 IFindFirst(const char *s, int32 from = 0) const {
+    auto it = std::search(
+        fData.begin() + std::min<size_t>(from, fData.size()), fData.end(), s,
+        s + strlen(s), [](char a, char b) {
+          return tolower((unsigned char)a) == tolower((unsigned char)b);
+        });
+    return it == fData.end() && *s ? -1 : (int32)(it - fData.begin());
+  }
+
+  bool StartsWith(const char *s) const {
+    return fData.compare(0, strlen(s), s) == 0;
+  }
+  bool EndsWith(const char *s) const {
+    const size_t n = strlen(s);
+    return n <= fData.size() && fData.compare(fData.size() - n, n, s) == 0;
+  }
+  bool IEndsWith(const char *s) const {
+    const size_t n = strlen(s);
+    return n <= fData.size() &&
+           strcasecmp(fData.c_str() + fData.size() - n, s) == 0;
+  }
+  int ICompare(const BString &other) const {
+    return strcasecmp(String(), other.String());
+  }
+
+  BString &operator+=(const char *s) {
+    fData += s;
+    return *this;
+  }
+  BString &operator+=(const BString &s) {
+    fData += s.fData;
+    return *this;
+  }
+  BString &operator+=(char c) {
+    fData += c;
+    return *this;
+  }
+
+  BString &operator<<(const char *s) { return *this += s; }
+  BString &operator<<(const BString &s) { return *this += s; }
+  BString &operator<<(char c) { return *this += c; }
+  BString &operator<<(int32 i) { return *this += std::to_string(i).c_str(); }
+  BString &operator<<(uint32 i) { return *this += std::to_string(i).c_str(); }
+  BString &operator<<(int64 i) { return *this += std::to_string(i).c_str(); }
+  BString &operator<<(uint64 i) { return *this += std::to_string(i).c_str(); }
+  BString &operator<<(float f) {
+    BString s;
+    s.SetToFormat("%.2f", f);
+    return *this += s;
+  }
+
+  bool operator==(const BString &o) const { return fData == o.fData; }
+  bool operator!=(const BString &o) const { return fData != o.fData; }
+  bool operator<(const BString &o) const { return fData < o.fData; }
+  bool operator>(const BString &o) const { return fData > o.fData; }
+  bool operator==(const char *s) const { return fData == (s ? s : ""); }
+  bool operator!=(const char *s) const { return !(*this == s); }
+
+private:
+  static int32 _Pos(size_t pos) {
+    return pos == std::string::npos ? -1 : (int32)pos;
+  }
+
+  std::string fData;
+};
+
+inline bool operator==(const char *s, const BString &b) { return b == s; }
+inline bool operator!=(const char *s, const BString &b) { return b != s; }
+
+#endif // BETON_COMPAT_STRING_H
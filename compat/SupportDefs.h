@@ -0,0 +1,45 @@
+#ifndef BETON_COMPAT_SUPPORT_DEFS_H
+#define BETON_COMPAT_SUPPORT_DEFS_H
+
+/*
+ * Stand-ins for the parts of the Haiku API used by the portable core
+ * modules, so they can be built and benchmarked on other systems.
+ * Never used on Haiku.
+ */
+
+#include <cinttypes>
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+
+typedef int8_t int8;
+typedef uint8_t uint8;
+typedef int16_t int16;
+typedef uint16_t uint16;
+typedef int32_t int32;
+typedef uint32_t uint32;
+typedef int64_t int64;
+typedef uint64_t uint64;
+
+typedef int32 status_t;
+typedef int64 bigtime_t;
+typedef int32 thread_id;
+
+#define B_PRId32 PRId32
+#define B_PRIu32 PRIu32
+#define B_PRIx32 PRIx32
+#define B_PRId64 PRId64
+#define B_PRIu64 PRIu64
+
+// Only B_OK has a meaningful value; the errors just need to differ from it.
+enum {
+  B_OK = 0,
+  B_ERROR = -1,
+  B_NO_MEMORY = -2,
+  B_BAD_VALUE = -3,
+  B_NO_INIT = -4,
+  B_ENTRY_NOT_FOUND = -5,
+  B_FILE_ERROR = -6,
+};
+
+#endif // BETON_COMPAT_SUPPORT_DEFS_H
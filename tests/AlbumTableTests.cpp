@@ -0,0 +1,126 @@
+#include "Test.h"
+#include "TestSuites.h"
+#include "AlbumTable.h"
+#include "MediaLibrary.h"
+
+#include <vector>
+
+namespace {
+
+MediaItem Track(const char *path, const char *album, const char *albumArtist,
+                int32 year, int32 duration = 200) {
+  MediaItem item;
+  item.path = path;
+  item.album = album;
+  item.albumArtist = albumArtist;
+  item.year = year;
+  item.duration = duration;
+  return item;
+}
+
+} // namespace
+
+void RegisterAlbumTableTests() {
+  Test::Register("albums/keys", [] {
+    AlbumTable table;
+    MediaItem a = Track("/m/1.mp3", "Hits", "Various", 1999);
+    a.artist = "One";
+    MediaItem b = Track("/m/2.mp3", "Hits", "Various", 1999);
+    b.artist = "Two";
+    const uint32 compilation = table.Add(a);
+    CHECK(compilation != AlbumTable::kNoAlbum);
+    CHECK(table.Add(b) == compilation);
+
+    const uint32 otherArtist = table.Add(Track("/m/3.mp3", "Hits", "", 1999));
+    const uint32 otherYear =
+        table.Add(Track("/m/4.mp3", "Hits", "Various", 2001));
+    CHECK(otherArtist != compilation && otherYear != compilation &&
+          otherArtist != otherYear);
+    CHECK(table.Add(Track("/m/5.mp3", "", "Various", 1999)) ==
+          AlbumTable::kNoAlbum);
+
+    CHECK(table.Count() == 3);
+    CHECK(table.IdOf("Hits", "Various", 1999) == compilation);
+    CHECK(table.IdOf("Hits", "Various", 2000) == AlbumTable::kNoAlbum);
+    const Album *album = table.Find(compilation);
+    CHECK(album && album->trackCount == 2 && album->name == "Hits" &&
+          album->artist == "Various" && album->year == 1999);
+  });
+
+  Test::Register("albums/remove", [] {
+    AlbumTable table;
+    std::vector<MediaItem> tracks;
+    for (int32 i = 0; i < 3; i++) {
+      BString path;
+      path << "/m/" << i << ".mp3";
+      tracks.push_back(Track(path.String(), "Blue", "Joni", 1971, 100 + i));
+      tracks.back().disc = 1;
+      tracks.back().discTotal = i == 2 ? 2 : 0;
+      tracks.back().albumId = table.Add(tracks.back());
+    }
+    const uint32 id = tracks[0].albumId;
+    const Album *album = table.Find(id);
+    CHECK(album && album->trackCount == 3 && album->duration == 303 &&
+          album->discCount == 2 && album->coverPath == "/m/0.mp3");
+
+    table.Remove(tracks[0]);
+    album = table.Find(id);
+    CHECK(album && album->trackCount == 2 && album->duration == 203);
+    CHECK(album && album->coverPath.IsEmpty());
+    CHECK(table.Count() == 1);
+
+    table.Remove(tracks[1]);
+    table.Remove(tracks[2]);
+    CHECK(table.Find(id) == nullptr);
+    CHECK(table.Count() == 0);
+    CHECK(table.IdOf("Blue", "Joni", 1971) == AlbumTable::kNoAlbum);
+    int32 visited = 0;
+    table.ForEach([&visited](const Album &) { visited++; });
+    CHECK(visited == 0);
+
+    // Removing again must not drive the counts negative.
+    table.Remove(tracks[2]);
+    CHECK(table.Count() == 0);
+  });
+
+  Test::Register("albums/id_reuse", [] {
+    AlbumTable table;
+    MediaItem first = Track("/m/a.mp3", "Blue", "Joni", 1971);
+    first.albumId = table.Add(first);
+    table.Remove(first);
+
+    // A new album never gets the ID of an emptied one...
+    const uint32 other = table.Add(Track("/m/b.mp3", "Court", "Joni", 1974));
+    CHECK(other != first.albumId);
+
+    // ...and the emptied album gets its own ID back.
+    MediaItem again = Track("/m/c.mp3", "Blue", "Joni", 1971, 150);
+    CHECK(table.Add(again) == first.albumId);
+    const Album *album = table.Find(first.albumId);
+    CHECK(album && album->trackCount == 1 && album->duration == 150 &&
+          album->coverPath == "/m/c.mp3");
+    CHECK(table.Count() == 2);
+  });
+
+  Test::Register("albums/library", [] {
+    MediaLibrary library;
+    library.Put(Track("/m/1.mp3", "Blue", "Joni", 1971));
+    library.Put(Track("/m/2.mp3", "Blue", "Joni", 1971));
+    const uint32 blue = library.Find("/m/1.mp3")->albumId;
+    CHECK(blue != AlbumTable::kNoAlbum);
+    CHECK(library.Find("/m/2.mp3")->albumId == blue);
+
+    // Retagging a track files it under its new album.
+    library.Put(Track("/m/2.mp3", "Court", "Joni", 1974));
+    const uint32 court = library.Find("/m/2.mp3")->albumId;
+    CHECK(court != blue);
+    CHECK(library.Albums().Find(blue)->trackCount == 1);
+
+    CHECK(library.Move("/m/1.mp3", "/m/blue.mp3"));
+    CHECK(library.Albums().Find(blue)->coverPath == "/m/blue.mp3");
+
+    CHECK(library.Remove("/m/blue.mp3"));
+    CHECK(library.Albums().Find(blue) == nullptr);
+    CHECK(library.Albums().Count() == 1);
+  });
+}
@@ -0,0 +1,195 @@
+#include "Test.h"
+#include "TestSuites.h"
+#include "DuplicateFinder.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+const size_t kFileSize = 40000;
+
+/** Writes @p size bytes of a pattern, with @p marker at the middle byte. */
+bool WriteFile(const std::string &path, size_t size, char marker) {
+  std::string data(size, '\0');
+  for (size_t i = 0; i < size; i++)
+    data[i] = (char)('a' + i % 23);
+  data[size / 2] = marker;
+
+  FILE *file = fopen(path.c_str(), "wb");
+  if (!file)
+    return false;
+  const bool written = fwrite(data.data(), 1, size, file) == size;
+  return fclose(file) == 0 && written;
+}
+
+MediaItem Track(const char *artist, const char *title, int32 duration) {
+  MediaItem item;
+  item.artist = artist;
+  item.title = title;
+  item.duration = duration;
+  item.path << "/music/" << artist << "/" << title << " " << duration
+            << ".mp3";
+  return item;
+}
+
+MediaItem File(const std::string &path, int64 size) {
+  MediaItem item;
+  item.path = path.c_str();
+  item.size = size;
+  return item;
+}
+
+/** A word of lower-case letters from a linear congruential sequence. */
+BString RandomWord(uint32 &state) {
+  BString word;
+  for (int i = 0; i < 8; i++) {
+    state = state * 1664525u + 1013904223u;
+    word << (char)('a' + (state >> 24) % 26);
+  }
+  return word;
+}
+
+} // namespace
+
+void RegisterDuplicateFinderTests() {
+  Test::Register("duplicates/exact", [] {
+    char dir[] = "/tmp/beton-test-XXXXXX";
+    CHECK(mkdtemp(dir) != nullptr);
+    const std::string a = std::string(dir) + "/a.mp3";
+    const std::string b = std::string(dir) + "/b.mp3";
+    const std::string c = std::string(dir) + "/c.mp3";
+    CHECK(WriteFile(a, kFileSize, 'x'));
+    CHECK(WriteFile(b, kFileSize, 'x'));
+    CHECK(WriteFile(c, kFileSize, 'y'));
+
+    std::vector<MediaItem> items = {File(c, kFileSize), File(a, kFileSize),
+                                    File(b, kFileSize)};
+    MediaItem gone = File(a, kFileSize);
+    gone.path << ".old";
+    gone.missing = true;
+    items.push_back(gone);
+
+    std::vector<DuplicateGroup> groups = DuplicateFinder::Find(items);
+    CHECK(groups.size() == 1);
+    if (groups.size() == 1) {
+      CHECK(groups[0].exact);
+      CHECK(groups[0].paths.size() == 2);
+      CHECK(groups[0].paths[0] == a.c_str());
+      CHECK(groups[0].paths[1] == b.c_str());
+    }
+
+    // A unique partial hash rules a file out without reading it.
+    items[1].partialHash = 1;
+    items[2].partialHash = 2;
+    items[0].partialHash = 3;
+    CHECK(DuplicateFinder::Find(items).empty());
+
+    // A missing file cannot be hashed and is never grouped.
+    items[1].partialHash = items[2].partialHash = items[0].partialHash = 0;
+    unlink(b.c_str());
+    CHECK(DuplicateFinder::Find(items).empty());
+
+    unlink(a.c_str());
+    unlink(c.c_str());
+    rmdir(dir);
+  });
+
+  Test::Register("duplicates/near", [] {
+    std::vector<MediaItem> items = {
+        Track("Nina Simone", "Feeling Good", 178),
+        Track("Nina Simone", "Sinnerman", 179),
+        Track("NINA SIMONE", "Feeling Good!", 180),
+        Track("Muse", "Feeling Good", 199),
+    };
+    std::vector<DuplicateGroup> groups = DuplicateFinder::Find(items);
+    CHECK(groups.size() == 1);
+    if (groups.size() == 1) {
+      CHECK(!groups[0].exact);
+      CHECK(groups[0].paths.size() == 2);
+      CHECK(groups[0].paths[0] == items[0].path);
+      CHECK(groups[0].paths[1] == items[2].path);
+    }
+
+    DuplicateOptions options;
+    options.nearDuplicates = false;
+    CHECK(DuplicateFinder::Find(items, options).empty());
+  });
+
+  Test::Register("duplicates/duration_window", [] {
+    std::vector<MediaItem> items = {Track("Air", "La Femme d'Argent", 200),
+                                    Track("Air", "La femme d argent", 204)};
+    CHECK(DuplicateFinder::Find(items).empty());
+
+    DuplicateOptions options;
+    options.durationTolerance = 4;
+    CHECK(DuplicateFinder::Find(items, options).size() == 1);
+
+    // 200 and 206 are too far apart, but both are close to 203, so all
+    // three end up in one group.
+    items.push_back(Track("Air", "La Femme d'Argent", 203));
+    items[1].duration = 206;
+    std::vector<DuplicateGroup> groups = DuplicateFinder::Find(items);
+    CHECK(groups.size() == 1);
+    if (groups.size() == 1)
+      CHECK(groups[0].paths.size() == 3);
+  });
+
+  Test::Register("duplicates/buckets", [] {
+    // One LSH bucket far larger than the comparisons allowed per track,
+    // among many tracks that only share an artist.
+    std::vector<MediaItem> items;
+    uint32 state = 42;
+    for (int32 i = 0; i < 3000; i++) {
+      BString title = RandomWord(state);
+      title << " " << RandomWord(state);
+      items.push_back(Track("Various", title.String(), 100 + i % 200));
+      if (i % 10 == 0)
+        items.push_back(Track("Repeated", "Same Old Song", 240));
+    }
+
+    std::vector<DuplicateGroup> groups = DuplicateFinder::Find(items);
+    CHECK(groups.size() == 1);
+    if (groups.size() == 1) {
+      CHECK(groups[0].paths.size() == 300);
+      CHECK(groups[0].paths[0] == items[1].path);
+    }
+  });
+
+  Test::Register("duplicates/mixed", [] {
+    char dir[] = "/tmp/beton-test-XXXXXX";
+    CHECK(mkdtemp(dir) != nullptr);
+    const std::string a = std::string(dir) + "/a.flac";
+    const std::string b = std::string(dir) + "/b.flac";
+    CHECK(WriteFile(a, kFileSize, 'x'));
+    CHECK(WriteFile(b, kFileSize, 'x'));
+
+    // Two copies of a file and an encode of the same recording.
+    std::vector<MediaItem> items(3);
+    items[0] = Track("Portishead", "Roads", 305);
+    items[0].path = a.c_str();
+    items[0].size = kFileSize;
+    items[1] = items[0];
+    items[1].path = b.c_str();
+    items[2] = Track("Portishead", "Roads", 306);
+    items[2].size = kFileSize / 4;
+
+    std::vector<DuplicateGroup> groups = DuplicateFinder::Find(items);
+    CHECK(groups.size() == 1);
+    if (groups.size() == 1) {
+      CHECK(groups[0].paths.size() == 3);
+      CHECK(!groups[0].exact);
+    }
+
+    items.pop_back();
+    groups = DuplicateFinder::Find(items);
+    CHECK(groups.size() == 1 && groups[0].exact);
+
+    unlink(a.c_str());
+    unlink(b.c_str());
+    rmdir(dir);
+  });
+}
@@ -0,0 +1,115 @@
+#include "Test.h"
+#include "TestSuites.h"
+#include "FacetIndex.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+/** Tracks whose year, duration and bitrate come from @p next. */
+template <typename Next>
+std::vector<MediaItem> Tracks(size_t count, Next next) {
+  std::vector<MediaItem> items(count);
+  for (size_t i = 0; i < count; i++) {
+    items[i].path << "/music/" << (int32)i << ".mp3";
+    items[i].year = next();
+    items[i].duration = next();
+    items[i].bitrate = next();
+  }
+  return items;
+}
+
+int32 NumberOf(FacetIndex::Number number, const MediaItem &item) {
+  switch (number) {
+  case FacetIndex::kYear:
+    return item.year;
+  case FacetIndex::kDuration:
+    return item.duration;
+  default:
+    return item.bitrate;
+  }
+}
+
+/** Both range queries agree with a scan of the tracks. */
+bool RangeMatchesScan(const FacetIndex &index, FacetIndex::Number number,
+                      int64 low, int64 high) {
+  const std::vector<const MediaItem *> &tracks = index.Tracks();
+  TrackSet set(tracks.size());
+  index.AddRange(number, low, high, set);
+
+  size_t count = 0;
+  for (size_t t = 0; t < tracks.size(); t++) {
+    const int64 value = NumberOf(number, *tracks[t]);
+    const bool inRange = value >= low && value <= high;
+    if (set.Contains(t) != inRange)
+      return false;
+    count += inRange;
+  }
+  return index.CountInRange(number, low, high) == count;
+}
+
+/** Checks ranges around every value and beyond the ends of the int32s. */
+void CheckRanges(const std::vector<MediaItem> &items) {
+  std::vector<const MediaItem *> tracks;
+  for (const MediaItem &item : items)
+    tracks.push_back(&item);
+  FacetIndex index;
+  index.Build(tracks);
+
+  const int64 kEnds[] = {INT64_MIN, (int64)INT32_MIN - 1, INT32_MIN, 0,
+                         INT32_MAX, (int64)INT32_MAX + 1, INT64_MAX};
+  for (int n = 0; n < FacetIndex::kNumberCount; n++) {
+    const FacetIndex::Number number = (FacetIndex::Number)n;
+    for (int64 low : kEnds) {
+      for (int64 high : kEnds)
+        CHECK(RangeMatchesScan(index, number, low, high));
+    }
+    for (size_t i = 0; i + 1 < items.size(); i += 7) {
+      const int64 a = NumberOf(number, items[i]);
+      const int64 b = NumberOf(number, items[i + 1]);
+      CHECK(RangeMatchesScan(index, number, a, a));
+      CHECK(RangeMatchesScan(index, number, a, b));
+      CHECK(RangeMatchesScan(index, number, a + 1, b - 1));
+      CHECK(RangeMatchesScan(index, number, INT64_MIN, a));
+      CHECK(RangeMatchesScan(index, number, a, INT64_MAX));
+    }
+  }
+}
+
+} // namespace
+
+void RegisterFacetIndexTests() {
+  Test::Register("facets/number_dense", [] {
+    // Values close together are sorted by counting.
+    uint32 state = 7;
+    CheckRanges(Tracks(2000, [&state] {
+      state = state * 1664525u + 1013904223u;
+      return (int32)(1950 + (state >> 16) % 80);
+    }));
+  });
+
+  Test::Register("facets/number_sparse", [] {
+    // Values spread over the whole int32 range are sorted by comparison.
+    uint32 state = 11;
+    int32 i = 0;
+    CheckRanges(Tracks(2000, [&state, &i] {
+      state = state * 1664525u + 1013904223u;
+      switch (i++ % 50) {
+      case 0:
+        return (int32)INT32_MIN;
+      case 1:
+        return (int32)INT32_MAX;
+      default:
+        return (int32)state;
+      }
+    }));
+  });
+
+  Test::Register("facets/number_empty", [] {
+    FacetIndex index;
+    index.Build({});
+    CHECK(index.CountInRange(FacetIndex::kYear, INT64_MIN, INT64_MAX) == 0);
+    CheckRanges(Tracks(1, [] { return 0; }));
+  });
+}
@@ -0,0 +1,129 @@
+#include "Test.h"
+#include "TestSuites.h"
+#include "FacetIndex.h"
+#include "LibraryFilter.h"
+#include "MediaLibrary.h"
+#include "benchmarks/LibraryGenerator.h"
+
+#include <memory>
+
+namespace {
+
+bool SameTotals(const LibraryTotals &a, const LibraryTotals &b) {
+  return a.count == b.count && a.duration == b.duration && a.size == b.size &&
+         a.genres == b.genres && a.artists == b.artists &&
+         a.albums == b.albums;
+}
+
+bool SameResult(const LibraryFilterResult &a, const LibraryFilterResult &b) {
+  return a.items == b.items && a.positions == b.positions &&
+         a.genres == b.genres && a.untaggedGenre == b.untaggedGenre &&
+         a.artists == b.artists && a.untaggedArtist == b.untaggedArtist &&
+         a.albums == b.albums && a.untaggedAlbum == b.untaggedAlbum &&
+         SameTotals(a.totals, b.totals);
+}
+
+/**
+ * @brief A generated library with the pointers and index the filter takes.
+ *
+ * The library lists every tenth track a second time, like a playlist that
+ * holds a track twice.
+ */
+struct Fixture {
+  MediaLibrary library;
+  std::vector<const MediaItem *> source;
+  FacetIndex index;
+
+  Fixture() {
+    library.Assign(LibraryGenerator().Generate(5000));
+    const std::vector<MediaItem> &items = library.Items();
+    for (size_t i = 0; i < items.size(); i++) {
+      source.push_back(&items[i]);
+      if (i % 10 == 0)
+        source.push_back(&items[i]);
+    }
+    index.Build(source);
+  }
+};
+
+const Fixture &SharedFixture() {
+  static std::unique_ptr<Fixture> sFixture(new Fixture);
+  return *sFixture;
+}
+
+/** Column selections built from tracks of the library. */
+LibraryQuery SelectionQuery(const std::vector<MediaItem> &items, int32 q) {
+  LibraryQuery query;
+  if (q % 2)
+    query.genre.values.push_back({items[q * 7].genre});
+  if (q % 3 == 0)
+    query.artist.values.push_back({items[q * 11].artist});
+  if (q % 5 == 0)
+    query.artist.untagged = true;
+  if (q % 4 == 1) {
+    query.album.values.push_back(
+        {items[q * 13].album, q % 8 == 1 ? items[q * 13].year : -1});
+  }
+  if (q % 5 == 2) {
+    query.album.values.push_back(
+        {items[q * 17].album, -1, items[q * 17].albumId});
+  }
+  return query;
+}
+
+const char *kSearches[] = {"",
+                           "lo",
+                           "genre:rock year:1970..1979 duration:>4m -live love",
+                           "-genre:rock",
+                           "year:1999",
+                           "duration:3m..4m bitrate:>=320 artist:night",
+                           "album:\"blue r\" -year:<1980",
+                           "year:..1965 title:love",
+                           "foo:bar",
+                           "duration:>10m",
+                           "genre:o -artist:a year:1980.. heart",
+                           "track:1 disc:1",
+                           "bitrate:320k genre:jazz",
+                           "year:2050",
+                           "-love -night"};
+
+} // namespace
+
+void RegisterLibraryFilterTests() {
+  Test::Register("filter/scan_equals_index", [] {
+    const Fixture &f = SharedFixture();
+    const std::vector<MediaItem> &items = f.library.Items();
+    for (int32 q = 0; q < 60; q++) {
+      for (const char *search : kSearches) {
+        LibraryQuery query = SelectionQuery(items, q);
+        query.search.Parse(search);
+
+        LibraryFilterResult scan, indexed;
+        LibraryFilter::Apply(f.source, query, scan);
+        LibraryFilter::Apply(f.index, query, indexed);
+        CHECK(SameResult(scan, indexed));
+      }
+    }
+  });
+
+  Test::Register("filter/positions", [] {
+    const Fixture &f = SharedFixture();
+    LibraryQuery query;
+    query.search.Parse("lo");
+
+    LibraryFilterResult result;
+    LibraryFilter::Apply(f.index, query, result);
+    CHECK(!result.items.empty());
+    CHECK(result.positions.size() == result.items.size());
+    for (size_t i = 0; i < result.items.size(); i++)
+      CHECK(f.source[result.positions[i]] == result.items[i]);
+  });
+
+  Test::Register("filter/empty_query", [] {
+    const Fixture &f = SharedFixture();
+    LibraryFilterResult result;
+    LibraryFilter::Apply(f.index, LibraryQuery(), result);
+    CHECK(result.items == f.source);
+    CHECK(result.totals.count == (int32)f.source.size());
+  });
+}
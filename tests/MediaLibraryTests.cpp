@@ -0,0 +1,94 @@
+#include "Test.h"
+#include "TestSuites.h"
+#include "MediaLibrary.h"
+
+#include <vector>
+
+namespace {
+
+BString PathOf(int32 i) {
+  BString path;
+  path << "/music/Artist " << i % 7 << "/Track " << i << ".mp3";
+  return path;
+}
+
+/** A library of @p count tracks whose titles follow their paths. */
+void Fill(MediaLibrary &library, int32 count) {
+  std::vector<MediaItem> items(count);
+  for (int32 i = 0; i < count; i++) {
+    items[i].path = PathOf(i);
+    items[i].title << "Track " << i;
+  }
+  library.Assign(std::move(items));
+}
+
+/** Every item is found at its own position, and only there. */
+bool Consistent(const MediaLibrary &library) {
+  for (size_t i = 0; i < library.Count(); i++) {
+    const MediaItem &item = library.ItemAt(i);
+    if (library.IndexOf(item.path) != (ssize_t)i ||
+        library.Find(item.path) != &item)
+      return false;
+  }
+  return true;
+}
+
+} // namespace
+
+void RegisterMediaLibraryTests() {
+  Test::Register("library/remove", [] {
+    MediaLibrary library;
+    Fill(library, 100);
+
+    CHECK(library.Remove(PathOf(10)));
+    CHECK(library.Remove(PathOf(0)));
+    CHECK(library.Remove(PathOf(99)));
+    CHECK(!library.Remove(PathOf(10)));
+    CHECK(!library.Remove("/music/not there.mp3"));
+
+    CHECK(library.Count() == 97);
+    CHECK(library.IndexOf(PathOf(10)) == -1);
+    CHECK(library.Find(PathOf(0)) == nullptr);
+    CHECK(library.ItemAt(0).path == PathOf(1));
+    CHECK(library.IndexOf(PathOf(11)) == 9);
+    CHECK(library.IndexOf(PathOf(98)) == 96);
+    CHECK(Consistent(library));
+  });
+
+  Test::Register("library/move", [] {
+    MediaLibrary library;
+    Fill(library, 100);
+
+    const BString to = "/music/Renamed/Track 42.flac";
+    CHECK(library.Move(PathOf(42), to));
+    CHECK(library.IndexOf(PathOf(42)) == -1);
+    CHECK(library.IndexOf(to) == 42);
+    CHECK(library.ItemAt(42).path == to);
+    CHECK(library.ItemAt(42).title == "Track 42");
+
+    CHECK(!library.Move(PathOf(42), "/music/elsewhere.mp3"));
+    CHECK(!library.Move(PathOf(1), PathOf(2)));
+    CHECK(library.IndexOf(PathOf(1)) == 1);
+    CHECK(library.IndexOf(PathOf(2)) == 2);
+
+    // A moved track is found under its new path after later removals.
+    CHECK(library.Remove(PathOf(3)));
+    CHECK(library.IndexOf(to) == 41);
+    CHECK(library.Remove(to));
+    CHECK(library.Count() == 98);
+    CHECK(Consistent(library));
+  });
+
+  Test::Register("library/assign", [] {
+    MediaLibrary library;
+    Fill(library, 10);
+    Fill(library, 5);
+    CHECK(library.Count() == 5);
+    CHECK(library.IndexOf(PathOf(7)) == -1);
+    CHECK(Consistent(library));
+
+    library.Clear();
+    CHECK(library.IsEmpty());
+    CHECK(library.Find(PathOf(0)) == nullptr);
+  });
+}
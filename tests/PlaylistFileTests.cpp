@@ -0,0 +1,136 @@
+#include "Test.h"
+#include "TestSuites.h"
+#include "PlaylistFile.h"
+
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+
+namespace {
+
+std::vector<PlaylistEntry> Entries() {
+  std::vector<PlaylistEntry> entries(3);
+  entries[0].path = "/music/Miles Davis/Kind of Blue/03 Blue in Green.flac";
+  entries[0].artist = "Miles Davis";
+  entries[0].title = "Blue in Green";
+  entries[0].duration = 337;
+  entries[0].inode = 123456789012LL;
+  entries[1].path = "/music/Untagged/track, with comma.mp3";
+  entries[1].title = "Only a title";
+  entries[1].duration = 61;
+  entries[2].path = "/music/Unknown/no metadata.ogg";
+  return entries;
+}
+
+bool SamePaths(const std::vector<PlaylistEntry> &a,
+               const std::vector<PlaylistEntry> &b) {
+  if (a.size() != b.size())
+    return false;
+  for (size_t i = 0; i < a.size(); i++) {
+    if (a[i].path != b[i].path)
+      return false;
+  }
+  return true;
+}
+
+bool SameEntries(const std::vector<PlaylistEntry> &a,
+                 const std::vector<PlaylistEntry> &b, bool withInode) {
+  if (!SamePaths(a, b))
+    return false;
+  for (size_t i = 0; i < a.size(); i++) {
+    if (a[i].artist != b[i].artist || a[i].title != b[i].title ||
+        a[i].duration != b[i].duration ||
+        (withInode && a[i].inode != b[i].inode))
+      return false;
+  }
+  return true;
+}
+
+std::vector<PlaylistEntry> RoundTrip(const std::vector<PlaylistEntry> &in,
+                                     PlaylistFormat format,
+                                     PlaylistFormat *parsedAs) {
+  std::string data;
+  PlaylistFile::Format(in, format, data);
+  std::vector<PlaylistEntry> out;
+  *parsedAs = PlaylistFile::Parse(data.data(), data.size(), nullptr, out);
+  return out;
+}
+
+} // namespace
+
+void RegisterPlaylistFileTests() {
+  Test::Register("playlist/extended_m3u", [] {
+    PlaylistFormat format;
+    const std::vector<PlaylistEntry> out =
+        RoundTrip(Entries(), PlaylistFormat::ExtendedM3U, &format);
+    CHECK(format == PlaylistFormat::ExtendedM3U);
+    CHECK(SameEntries(Entries(), out, true));
+  });
+
+  Test::Register("playlist/pls", [] {
+    PlaylistFormat format;
+    const std::vector<PlaylistEntry> out =
+        RoundTrip(Entries(), PlaylistFormat::PLS, &format);
+    CHECK(format == PlaylistFormat::PLS);
+    CHECK(SameEntries(Entries(), out, false));
+  });
+
+  Test::Register("playlist/m3u", [] {
+    PlaylistFormat format;
+    const std::vector<PlaylistEntry> out =
+        RoundTrip(Entries(), PlaylistFormat::M3U, &format);
+    CHECK(format == PlaylistFormat::M3U);
+    CHECK(SamePaths(Entries(), out));
+  });
+
+  Test::Register("playlist/paths", [] {
+    const char data[] = "\xef\xbb\xbf"
+                        "file:///music/A%20B/c%2Cd.mp3\r\n"
+                        "../Other/e.mp3\n"
+                        "\n"
+                        "http://radio.example/stream\n";
+    std::vector<PlaylistEntry> out;
+    PlaylistFile::Parse(data, sizeof(data) - 1, "/music/Lists", out);
+    CHECK(out.size() == 3);
+    if (out.size() == 3) {
+      CHECK(out[0].path == "/music/A B/c,d.mp3");
+      CHECK(out[1].path == "/music/Other/e.mp3");
+      CHECK(out[2].path == "http://radio.example/stream");
+    }
+  });
+
+  Test::Register("playlist/files", [] {
+    char dir[] = "/tmp/beton-test-XXXXXX";
+    CHECK(mkdtemp(dir) != nullptr);
+    const std::string m3u = std::string(dir) + "/list.m3u";
+    const std::string pls = std::string(dir) + "/list.pls";
+
+    const std::vector<PlaylistEntry> entries = Entries();
+    const std::vector<PlaylistEntry> first(entries.begin(),
+                                           entries.begin() + 1);
+    const std::vector<PlaylistEntry> rest(entries.begin() + 1, entries.end());
+
+    std::vector<PlaylistEntry> out;
+    PlaylistFormat format;
+    CHECK(PlaylistFile::Write(m3u.c_str(), first,
+                              PlaylistFormat::ExtendedM3U));
+    CHECK(PlaylistFile::Append(m3u.c_str(), rest));
+    CHECK(PlaylistFile::Read(m3u.c_str(), out, &format));
+    CHECK(format == PlaylistFormat::ExtendedM3U);
+    CHECK(SameEntries(entries, out, true));
+
+    CHECK(PlaylistFile::FormatForPath(pls.c_str()) == PlaylistFormat::PLS);
+    CHECK(PlaylistFile::Write(pls.c_str(), first, PlaylistFormat::PLS));
+    CHECK(PlaylistFile::Append(pls.c_str(), rest));
+    CHECK(PlaylistFile::Read(pls.c_str(), out, &format));
+    CHECK(format == PlaylistFormat::PLS);
+    CHECK(SameEntries(entries, out, false));
+
+    const std::string missing = std::string(dir) + "/missing.m3u";
+    CHECK(!PlaylistFile::Read(missing.c_str(), out));
+
+    unlink(m3u.c_str());
+    unlink(pls.c_str());
+    rmdir(dir);
+  });
+}
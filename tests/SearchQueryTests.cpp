@@ -0,0 +1,125 @@
+#include "Test.h"
+#include "TestSuites.h"
+#include "SearchQuery.h"
+
+namespace {
+
+/** The term of @p query on @p field, or null. */
+const SearchTerm *TermOf(const SearchQuery &query, SearchTerm::Field field) {
+  for (const SearchTerm &term : query.Terms()) {
+    if (term.field == field)
+      return &term;
+  }
+  return nullptr;
+}
+
+/** Whether @p text parses to one number term with the given range. */
+bool ParsesToRange(const char *text, SearchTerm::Field field, int64 low,
+                   int64 high) {
+  const SearchQuery query(text);
+  const SearchTerm *term = TermOf(query, field);
+  return query.Terms().size() == 1 && term && term->low == low &&
+         term->high == high;
+}
+
+/** Whether @p text parses to the one free word @p word. */
+bool ParsesToWord(const char *text, const char *word) {
+  const SearchQuery query(text);
+  return query.Terms().size() == 1 &&
+         query.Terms()[0].field == SearchTerm::kAny &&
+         query.Terms()[0].text == word;
+}
+
+MediaItem Track() {
+  MediaItem item("Blue in Green", "/music/Miles Davis/Kind of Blue/03.flac");
+  item.artist = "Miles Davis";
+  item.album = "Kind of Blue";
+  item.genre = "Jazz";
+  item.year = 1959;
+  item.duration = 337;
+  item.bitrate = 320;
+  return item;
+}
+
+} // namespace
+
+void RegisterSearchQueryTests() {
+  Test::Register("search/fields", [] {
+    const SearchQuery query(
+        "artist:\"Miles Davis\" year:1955..1965 genre:jazz -live");
+    CHECK(query.Terms().size() == 4);
+
+    const SearchTerm *artist = TermOf(query, SearchTerm::kArtist);
+    CHECK(artist && artist->text == "Miles Davis" && !artist->negated);
+    const SearchTerm *genre = TermOf(query, SearchTerm::kGenre);
+    CHECK(genre && genre->text == "jazz");
+    const SearchTerm *word = TermOf(query, SearchTerm::kAny);
+    CHECK(word && word->text == "live" && word->negated);
+    const SearchTerm *year = TermOf(query, SearchTerm::kYear);
+    CHECK(year && year->low == 1955 && year->high == 1965);
+  });
+
+  Test::Register("search/ranges", [] {
+    CHECK(ParsesToRange("year:1999", SearchTerm::kYear, 1999, 1999));
+    CHECK(ParsesToRange("year:1980..", SearchTerm::kYear, 1980, INT64_MAX));
+    CHECK(ParsesToRange("year:..1965", SearchTerm::kYear, INT64_MIN, 1965));
+    CHECK(ParsesToRange("duration:4m", SearchTerm::kDuration, 240, 299));
+    CHECK(ParsesToRange("duration:90s", SearchTerm::kDuration, 90, 90));
+    CHECK(ParsesToRange("duration:>10m", SearchTerm::kDuration, 601,
+                        INT64_MAX));
+    CHECK(ParsesToRange("duration:<=3:30", SearchTerm::kDuration, INT64_MIN,
+                        210));
+    CHECK(ParsesToRange("duration:1h", SearchTerm::kDuration, 3600, 7199));
+    CHECK(ParsesToRange("bitrate:>=256k", SearchTerm::kBitrate, 256,
+                        INT64_MAX));
+  });
+
+  Test::Register("search/overflow", [] {
+    CHECK(ParsesToRange("year:9223372036854775807", SearchTerm::kYear,
+                        INT64_MAX, INT64_MAX));
+    CHECK(ParsesToRange("year:>9223372036854775807", SearchTerm::kYear,
+                        INT64_MAX, INT64_MAX));
+    CHECK(ParsesToRange("year:<0", SearchTerm::kYear, INT64_MIN, -1));
+    CHECK(ParsesToRange("year:..9223372036854775807", SearchTerm::kYear,
+                        INT64_MIN, INT64_MAX));
+    CHECK(ParsesToRange("duration:2562047788015215h", SearchTerm::kDuration,
+                        9223372036854774000LL, INT64_MAX));
+
+    // Out of range for int64, or once multiplied by the unit.
+    CHECK(ParsesToWord("year:9223372036854775808", "year:9223372036854775808"));
+    CHECK(ParsesToWord("duration:2562047788015216h",
+                       "duration:2562047788015216h"));
+    CHECK(ParsesToWord("duration:153722867280912931m",
+                       "duration:153722867280912931m"));
+    CHECK(ParsesToWord("duration:153722867280912931:00",
+                       "duration:153722867280912931:00"));
+  });
+
+  Test::Register("search/words", [] {
+    CHECK(ParsesToWord("foo:bar", "foo:bar"));
+    CHECK(ParsesToWord("year:abc", "year:abc"));
+    CHECK(ParsesToWord("duration:4:75", "duration:4:75"));
+    CHECK(ParsesToWord("artist:", "artist:"));
+    CHECK(ParsesToWord("-", "-"));
+    CHECK(SearchQuery("").IsEmpty());
+    CHECK(SearchQuery("   ").IsEmpty());
+
+    // Every word must match, wherever it is.
+    const SearchQuery query("Re: Stacks");
+    CHECK(query.Terms().size() == 2);
+  });
+
+  Test::Register("search/matches", [] {
+    const MediaItem track = Track();
+    CHECK(SearchQuery("blue").Matches(track));
+    CHECK(SearchQuery("miles GREEN").Matches(track));
+    CHECK(!SearchQuery("miles -green").Matches(track));
+    CHECK(SearchQuery("artist:davis year:1950..1959").Matches(track));
+    CHECK(!SearchQuery("title:davis").Matches(track));
+    CHECK(SearchQuery("duration:5m bitrate:>=256").Matches(track));
+    CHECK(!SearchQuery("duration:<5m").Matches(track));
+    CHECK(SearchQuery("path:\"kind of\"").Matches(track));
+    CHECK(!SearchQuery("genre:rock").Matches(track));
+    CHECK(SearchQuery("").Matches(track));
+  });
+}
@@ -0,0 +1,57 @@
+#include "Test.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace Test {
+
+namespace {
+
+struct Entry {
+  std::string name;
+  Body body;
+};
+
+std::vector<Entry> &Registry() {
+  static std::vector<Entry> sRegistry;
+  return sRegistry;
+}
+
+/** Failed checks of the running test. */
+int sFailures = 0;
+
+} // namespace
+
+void Register(const char *name, Body body) {
+  Registry().push_back({name, std::move(body)});
+}
+
+void Fail(const char *file, int line, const char *condition) {
+  fprintf(stderr, "  %s:%d: CHECK(%s) failed\n", file, line, condition);
+  sFailures++;
+}
+
+int RunAll(const char *filter) {
+  int run = 0;
+  int failed = 0;
+  for (const Entry &entry : Registry()) {
+    if (filter && entry.name.find(filter) == std::string::npos)
+      continue;
+
+    sFailures = 0;
+    entry.body();
+    run++;
+    if (sFailures > 0) {
+      failed++;
+      fprintf(stderr, "FAIL %s\n", entry.name.c_str());
+    } else {
+      fprintf(stderr, "ok   %s\n", entry.name.c_str());
+    }
+  }
+  fprintf(stderr, "%d of %d test(s) failed\n", failed, run);
+  return failed;
+}
+
+} // namespace Test
@@ -0,0 +1,43 @@
+#ifndef BETON_TEST_H
+#define BETON_TEST_H
+
+#include <functional>
+
+/**
+ * @namespace Test
+ * @brief Minimal unit test runner for the core library.
+ *
+ * A test is a named function that checks its results with CHECK(). A failed
+ * check is reported with its location and the test goes on, so one run
+ * lists every failure.
+ */
+namespace Test {
+
+/** Body of a test. */
+typedef std::function<void()> Body;
+
+/**
+ * @brief Registers a test.
+ * @param name Unique name, "<area>/<case>" (e.g. "search/ranges").
+ */
+void Register(const char *name, Body body);
+
+/** @brief Records a failed check of the running test. */
+void Fail(const char *file, int line, const char *condition);
+
+/**
+ * @brief Runs the tests whose names contain @p filter (all if null).
+ * @return Number of failed tests.
+ */
+int RunAll(const char *filter);
+
+} // namespace Test
+
+/** Fails the running test if @p condition is false. */
+#define CHECK(condition)                                                       \
+  do {                                                                         \
+    if (!(condition))                                                          \
+      Test::Fail(__FILE__, __LINE__, #condition);                              \
+  } while (0)
+
+#endif // BETON_TEST_H
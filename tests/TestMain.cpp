@@ -0,0 +1,28 @@
+#include "Test.h"
+#include "TestSuites.h"
+
+#include <cstdio>
+#include <cstring>
+
+int main(int argc, char **argv) {
+  const char *filter = nullptr;
+  for (int i = 1; i < argc; i++) {
+    if (strncmp(argv[i], "--filter=", 9) == 0) {
+      filter = argv[i] + 9;
+    } else {
+      fprintf(stderr, "Usage: beton-test [--filter=TEXT]\n");
+      return strcmp(argv[i], "--help") == 0 ? 0 : 2;
+    }
+  }
+
+  RegisterPlaylistFileTests();
+  RegisterMediaLibraryTests();
+  RegisterDuplicateFinderTests();
+  RegisterLibraryFilterTests();
+  RegisterAlbumTableTests();
+  RegisterSearchQueryTests();
+  RegisterFacetIndexTests();
+  RegisterTextSearchTests();
+
+  return Test::RunAll(filter) == 0 ? 0 : 1;
+}
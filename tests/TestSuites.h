@@ -0,0 +1,28 @@
+#ifndef BETON_TEST_SUITES_H
+#define BETON_TEST_SUITES_H
+
+/** @brief Reading and writing M3U, extended M3U and PLS playlists. */
+void RegisterPlaylistFileTests();
+
+/** @brief The path index of the library across removals and moves. */
+void RegisterMediaLibraryTests();
+
+/** @brief Exact and near duplicate grouping. */
+void RegisterDuplicateFinderTests();
+
+/** @brief Scan and indexed filtering give the same results. */
+void RegisterLibraryFilterTests();
+
+/** @brief Album IDs and what the albums add up to. */
+void RegisterAlbumTableTests();
+
+/** @brief Parsing of the search field's query language. */
+void RegisterSearchQueryTests();
+
+/** @brief Number ranges of the column browser index. */
+void RegisterFacetIndexTests();
+
+/** @brief The vectorized substring search against BString::IFindFirst(). */
+void RegisterTextSearchTests();
+
+#endif // BETON_TEST_SUITES_H
@@ -0,0 +1,86 @@
+#include "Test.h"
+#include "TestSuites.h"
+#include "TextSearch.h"
+
+#include <random>
+
+namespace {
+
+/** A random string over a small alphabet, so that matches are frequent. */
+BString RandomText(std::mt19937 &random, int32 maxLength,
+                   const char *alphabet, int32 letters) {
+  BString text;
+  const int32 length = (int32)(random() % (maxLength + 1));
+  for (int32 i = 0; i < length; i++)
+    text << alphabet[random() % letters];
+  return text;
+}
+
+} // namespace
+
+void RegisterTextSearchTests() {
+  Test::Register("text_search/equals_ifindfirst", [] {
+    std::mt19937 random(1);
+    for (int32 round = 0; round < 200; round++) {
+      // Long enough texts to reach the vector loops, and a UTF-8 letter
+      // that must only match itself.
+      const int32 count = (int32)(random() % 200);
+      std::vector<BString> a, b, c;
+      TextSearch search;
+      for (int32 i = 0; i < count; i++) {
+        a.push_back(RandomText(random, 80, "abAB c\xc3\xa9", 8));
+        b.push_back(RandomText(random, 40, "abAB c\xc3\xa9", 8));
+        c.push_back(RandomText(random, 10, "abAB c\xc3\xa9", 8));
+      }
+      for (int32 i = 0; i < count; i++)
+        search.Add({&a[i], &b[i], &c[i]});
+      CHECK(search.Count() == (size_t)count);
+
+      for (int32 q = 0; q < 20; q++) {
+        const BString word = RandomText(random, 6, "abAB c", 6);
+        if (word.IsEmpty())
+          continue;
+
+        std::vector<uint32> found;
+        search.Find(word, found);
+        std::vector<uint32> expected;
+        for (int32 i = 0; i < count; i++) {
+          if (a[i].IFindFirst(word) >= 0 || b[i].IFindFirst(word) >= 0 ||
+              c[i].IFindFirst(word) >= 0)
+            expected.push_back((uint32)i);
+        }
+        CHECK(found == expected);
+      }
+    }
+  });
+
+  Test::Register("text_search/no_match_across_texts", [] {
+    const BString title("Love"), artist("Me Do");
+    TextSearch search;
+    search.Add({&title, &artist});
+
+    std::vector<uint32> found;
+    search.Find("loveme", found);
+    CHECK(found.empty());
+    search.Find("ve", found);
+    CHECK(found.size() == 1);
+  });
+
+  Test::Register("text_search/empty", [] {
+    const BString one("one"), two("two");
+    TextSearch search;
+    std::vector<uint32> found;
+    search.Find("o", found);
+    CHECK(found.empty());
+
+    search.Add({&one});
+    search.Add({&two});
+    search.Find("", found);
+    CHECK(found.size() == 2);
+
+    search.Clear();
+    CHECK(search.Count() == 0);
+    search.Find("o", found);
+    CHECK(found.empty());
+  });
+}